@@ -0,0 +1,362 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/*
+ * Measures the framework's own overhead against the stand-in switch.h in bench/stub.
+ * Every benchmark is run several times and the fastest run is reported, in cycles per
+ * operation where a cycle counter is available and in nanoseconds otherwise.
+ * The output is CSV with a fixed set of rows in a fixed order, so the results of two
+ * releases can be compared line by line:
+ *
+ *   # jvxfs-bench format=1 version=<library version> unit=<cycles|ns>
+ *   benchmark,iterations,per_op
+ *   frame_null_16bit,200000,812.4
+ *   ...
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <switch.h>
+#include "../framework.h"
+#include "../system/view_private.h"
+#include "../utils/observer.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+#else
+#define BENCH_UNIT "ns"
+#endif
+
+#define BENCH_FORMAT 1
+#define BENCH_RUNS 5
+#define BENCH_RATE 8000
+#define BENCH_SAMPLES 160
+#define BENCH_OBSERVERS 4
+#define STFT_TOLERANCE 1e-4
+
+typedef void(*bench_func_t)(void* data, uint32_t iterations);
+
+typedef struct
+{
+    const char* name;
+    bench_func_t func;
+    uint32_t iterations;
+} bench_t;
+
+typedef struct
+{
+    switch_core_session_t* session;
+    switch_frame_t frame;
+    int16_t samples[BENCH_SAMPLES];
+} frame_bench_t;
+
+static jvxfs_module_t* mod = NULL;
+static switch_loadable_module_interface_t* modInterface = NULL;
+static switch_memory_pool_t* pool = NULL;
+static jvxfs_error_t* err = NULL;
+
+static void bench_app(switch_core_session_t* session, const char* data);
+static switch_status_t bench_api(const char* cmd, switch_core_session_t* session, switch_stream_handle_t* stream);
+static switch_status_t discard_write(switch_stream_handle_t* handle, const char* fmt, ...);
+static switch_status_t discard_raw_write(switch_stream_handle_t* handle, uint8_t* data, switch_size_t datalen);
+static void null_construct(void** hdl, jvxfs_sigproc_media_t* media, const char* args);
+static void null_initialize(void* hdl, jvxfs_sigproc_media_t* media);
+static void null_process(void* hdl, jvxfs_sigproc_media_t* media);
+static void null_terminate(void* hdl);
+static void null_directive(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data);
+static void null_observer(jvxfs_observable_t* hdl, void* data);
+static void identity_spectrum(void* hdl, jvxfs_sigproc_spectrum_t* spectrum);
+static bool setup(void);
+static bool check_stft(void);
+static bool check_stft_config(uint32_t size, uint32_t hop, jvxfs_sigproc_window_t window);
+static void teardown(void);
+static uint64_t now(void);
+static double run(const bench_t* bench, void* data);
+static void bench_frame(void* data, uint32_t iterations);
+static void bench_directive(void* data, uint32_t iterations);
+static void bench_observer(void* data, uint32_t iterations);
+static void bench_view_console(void* data, uint32_t iterations);
+static void bench_view_event(void* data, uint32_t iterations);
+static void bench_error(void* data, uint32_t iterations);
+static void bench_histogram(void* data, uint32_t iterations);
+
+
+int main(void)
+{
+    if (!setup()) {
+        fprintf(stderr, "jvxfs-bench: could not start the module.\n");
+        teardown();
+        return 1;
+    }
+    if (!check_stft()) {
+        teardown();
+        return 1;
+    }
+    frame_bench_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.session = stub_session_create(BENCH_RATE, BENCH_SAMPLES, 1);
+    if (!frame.session) {
+        fprintf(stderr, "jvxfs-bench: could not create session.\n");
+        teardown();
+        return 1;
+    }
+    jvxfs_system_load_app(mod, frame.session, "");
+    for (uint32_t i = 0; i < BENCH_SAMPLES; ++i) frame.samples[i] = (int16_t)((i * 97) & 0x3FFF);
+    frame.frame.data = frame.samples;
+    frame.frame.datalen = sizeof(frame.samples);
+    frame.frame.buflen = sizeof(frame.samples);
+    frame.frame.samples = BENCH_SAMPLES;
+    frame.frame.rate = BENCH_RATE;
+    frame.frame.channels = 1;
+
+    jvxfs_observer_handle_t* obs = NULL;
+    jvxfs_observer_create(&obs, mod, err, pool);
+    for (uint32_t i = 0; i < BENCH_OBSERVERS; ++i) jvxfs_observer_add(obs, null_observer, (void*)(uintptr_t)(i + 1));
+
+    /* Rows are compared between releases, only append new ones. */
+    const bench_t benches[] = {
+        { "frame_null_16bit", bench_frame, 200000 },
+        { "directive_dispatch", bench_directive, 200000 },
+        { "observer_notify_4", bench_observer, 1000000 },
+        { "view_write_console", bench_view_console, 200000 },
+        { "view_write_event", bench_view_event, 100000 },
+        { "error_report", bench_error, 1000000 },
+        { "histogram_record", bench_histogram, 1000000 }
+    };
+    void* data[] = { &frame, NULL, obs, NULL, NULL, NULL, NULL };
+
+    printf("# jvxfs-bench format=%d version=%s unit=%s\n", BENCH_FORMAT, JVX_FS_FRAMEWORK_LIBVERSION, BENCH_UNIT);
+    printf("benchmark,iterations,per_op\n");
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); ++i) {
+        double perOp = run(&benches[i], data[i]);
+        printf("%s,%u,%.1f\n", benches[i].name, benches[i].iterations, perOp);
+    }
+
+    jvxfs_observer_destroy(&obs);
+    stub_session_destroy(frame.session);
+    teardown();
+    return 0;
+}
+
+
+void bench_app(switch_core_session_t* session, const char* data)
+{
+    jvxfs_system_load_app(mod, session, data);
+}
+
+switch_status_t bench_api(const char* cmd, switch_core_session_t* session, switch_stream_handle_t* stream)
+{
+    return jvxfs_system_exec_api(mod, cmd, session, stream);
+}
+
+switch_status_t discard_write(switch_stream_handle_t* handle, const char* fmt, ...)
+{
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t discard_raw_write(switch_stream_handle_t* handle, uint8_t* data, switch_size_t datalen)
+{
+    return SWITCH_STATUS_SUCCESS;
+}
+
+void null_construct(void** hdl, jvxfs_sigproc_media_t* media, const char* args)
+{
+    *hdl = (void*)1;
+}
+
+void null_initialize(void* hdl, jvxfs_sigproc_media_t* media)
+{
+}
+
+void null_process(void* hdl, jvxfs_sigproc_media_t* media)
+{
+}
+
+void identity_spectrum(void* hdl, jvxfs_sigproc_spectrum_t* spectrum)
+{
+}
+
+void null_terminate(void* hdl)
+{
+}
+
+void null_directive(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data)
+{
+}
+
+void null_observer(jvxfs_observable_t* hdl, void* data)
+{
+}
+
+bool setup(void)
+{
+    pool = stub_pool_create();
+    if (!pool) return false;
+    jvxfs_status_t res = jvxfs_system_create_module(&mod, &modInterface, pool, "mod_bench", bench_app,
+        bench_api);
+    if (res != JVXFS_STATUS_SUCCESS) return false;
+    err = jvxfs_module_get_error_handler(mod);
+    jvxfs_app_t* app = NULL;
+    res = jvxfs_module_create_sigproc_app(mod, &app, null_construct, null_initialize, null_process,
+        null_terminate, NULL);
+    if (res != JVXFS_STATUS_SUCCESS) return false;
+    jvxfs_sigprog_config_t* conf = NULL;
+    jvxfs_app_get_sigproc_config(app, &conf);
+    jvxfs_sigproc_set_working_channel(conf, JVXFS_SP_UPLINK, JVXFS_SP_DEFAULT);
+    jvxfs_sigproc_set_datatype(conf, JVXFS_SP_16BIT_LE);
+    jvxfs_app_add_directive(app, "null", null_directive, NULL);
+    return jvxfs_system_init_check(mod, "mod_bench") == SWITCH_STATUS_SUCCESS;
+}
+
+bool check_stft(void)
+{
+    /* Spectral algorithms rely on an unmodified spectrum giving back the input, delayed by the latency. */
+    if (!check_stft_config(512, 128, JVXFS_SP_WINDOW_SQRT_HANN) || !check_stft_config(512, 256, JVXFS_SP_WINDOW_HANN) ||
+        !check_stft_config(256, 64, JVXFS_SP_WINDOW_HANN) || !check_stft_config(256, 192, JVXFS_SP_WINDOW_SQRT_HANN) ||
+        !check_stft_config(256, 256, JVXFS_SP_WINDOW_RECTANGULAR)) {
+        return false;
+    }
+    jvxfs_stft_t* stft = NULL;
+    if (jvxfs_stft_create(&stft, 256, 256, JVXFS_SP_WINDOW_HANN, 1, err, pool) == JVXFS_STATUS_SUCCESS) {
+        fprintf(stderr, "jvxfs-bench: STFT accepted a Hann window without overlap.\n");
+        return false;
+    }
+    return true;
+}
+
+bool check_stft_config(uint32_t size, uint32_t hop, jvxfs_sigproc_window_t window)
+{
+    jvxfs_stft_t* stft = NULL;
+    if (jvxfs_stft_create(&stft, size, hop, window, 1, err, pool) != JVXFS_STATUS_SUCCESS) {
+        fprintf(stderr, "jvxfs-bench: could not create STFT of size %u and hop %u.\n", size, hop);
+        return false;
+    }
+    uint32_t latency = jvxfs_stft_get_latency(stft);
+    uint32_t total = 8 * size;
+    float* in = (float*)switch_core_alloc(pool, total * sizeof(float));
+    float* out = (float*)switch_core_alloc(pool, total * sizeof(float));
+    if (!in || !out) return false;
+    for (uint32_t i = 0; i < total; ++i) in[i] = (float)(0.4 * sin(0.031 * i) + 0.3 * sin(0.57 * i + 1.0));
+    memcpy(out, in, total * sizeof(float));
+    jvxfs_sigproc_media_t media;
+    memset(&media, 0, sizeof(media));
+    media.type = JVXFS_SP_FLOAT32_LE;
+    media.samples = hop;
+    media.channels = 1;
+    media.rate = BENCH_RATE;
+    uint32_t processed = total / hop * hop;
+    for (uint32_t pos = 0; pos < processed; pos += hop) {
+        media.data = out + pos;
+        jvxfs_stft_process(stft, NULL, identity_spectrum, &media);
+    }
+    double maxError = 0.0;
+    for (uint32_t i = latency; i < processed; ++i) {
+        double e = fabs((double)out[i] - in[i - latency]);
+        if (e > maxError) maxError = e;
+    }
+    if (maxError > STFT_TOLERANCE) {
+        fprintf(stderr, "jvxfs-bench: STFT of size %u and hop %u does not reconstruct the input, error %g.\n",
+            size, hop, maxError);
+        return false;
+    }
+    return true;
+}
+
+void teardown(void)
+{
+    if (mod) {
+        jvxfs_system_prepare_end(mod);
+        jvxfs_system_terminate(&mod);
+    }
+    stub_pool_destroy(pool);
+    pool = NULL;
+}
+
+uint64_t now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+double run(const bench_t* bench, void* data)
+{
+    /* One short run to warm up caches and lazily allocated state. */
+    bench->func(data, bench->iterations / 10 + 1);
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < BENCH_RUNS; ++i) {
+        uint64_t start = now();
+        bench->func(data, bench->iterations);
+        uint64_t elapsed = now() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    return (double)best / (double)bench->iterations;
+}
+
+void bench_frame(void* data, uint32_t iterations)
+{
+    frame_bench_t* bench = (frame_bench_t*)data;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        stub_session_feed(bench->session, SWITCH_ABC_TYPE_READ_REPLACE, &bench->frame);
+    }
+}
+
+void bench_directive(void* data, uint32_t iterations)
+{
+    switch_stream_handle_t stream = { .write_function = discard_write, .raw_write_function = discard_raw_write };
+    for (uint32_t i = 0; i < iterations; ++i) jvxfs_system_exec_api(mod, "null", NULL, &stream);
+}
+
+void bench_observer(void* data, uint32_t iterations)
+{
+    jvxfs_observer_handle_t* obs = (jvxfs_observer_handle_t*)data;
+    for (uint32_t i = 0; i < iterations; ++i) jvxfs_observer_notify(obs);
+}
+
+void bench_view_console(void* data, uint32_t iterations)
+{
+    switch_stream_handle_t stream = { .write_function = discard_write, .raw_write_function = discard_raw_write };
+    jvxfs_app_t* app = NULL;
+    jvxfs_module_get_sigproc_app(mod, &app);
+    jvxfs_directive_data_t rqst = { .app = app, .session = NULL, .directive = "bench", .parameters = "" };
+    view_priv_t view = { .origin = JVXFS_VIEW_IN_CONSOLE, .dest = JVXFS_VIEW_OUT_CONSOLE, .err = err,
+        .data = &rqst, .console = &stream };
+    for (uint32_t i = 0; i < iterations; ++i) {
+        jvxfs_view_write_human_readable(&view, "frames %u, level %.1f dB\n", i, -12.5);
+    }
+}
+
+void bench_view_event(void* data, uint32_t iterations)
+{
+    jvxfs_app_t* app = NULL;
+    jvxfs_module_get_sigproc_app(mod, &app);
+    jvxfs_directive_data_t rqst = { .app = app, .session = NULL, .directive = "bench", .parameters = "" };
+    view_priv_t view = { .origin = JVXFS_VIEW_IN_CONSOLE, .dest = JVXFS_VIEW_OUT_EVENT, .err = err,
+        .data = &rqst, .console = NULL };
+    for (uint32_t i = 0; i < iterations; ++i) {
+        jvxfs_view_write_machine_readable(&view, "{\"frames\":%u,\"level_db\":%.1f}", i, -12.5);
+    }
+}
+
+void bench_error(void* data, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; ++i) {
+        jvxfs_error_set_error(err, JVXFS_STATUS_OUT_OF_BOUNDS, JVXFS_LOG_WARNING, JVXFS_COMP_NONE, "Benchmark error.");
+    }
+}
+
+void bench_histogram(void* data, uint32_t iterations)
+{
+    jvxfs_app_t* app = NULL;
+    jvxfs_module_get_sigproc_app(mod, &app);
+    jvxfs_histogram_t* stats = jvxfs_app_get_sigproc_stats(app);
+    for (uint32_t i = 0; i < iterations; ++i) jvxfs_histogram_record(stats, i & 0x3FF);
+}
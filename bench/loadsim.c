@@ -0,0 +1,402 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/*
+ * Simulates concurrent calls against the stand-in switch.h in bench/stub, to find out how many
+ * sessions a core carries with a given algorithm cost.
+ * For every combination of session count and worker thread count a module is loaded, every
+ * session gets its own media thread which loads the app and feeds a frame every 20 ms, and the
+ * main thread meanwhile fires app, session and fanned out session directives and mode changes at random sessions.
+ * The algorithm busy waits for the given time per frame to stand in for real processing.
+ * One CSV row is printed per combination:
+ *
+ *   # jvxfs-loadsim format=1 version=<library version> rate=8000 frame_ms=20 work_us=0 exec=auto duration_s=5
+ *   sessions,threads,frames,cpu_per_session_pct,sessions_per_core,p50_us,p99_us,p999_us,max_us,deadline_misses,late_frames,passthroughs
+ *
+ * The latency is the time the media bug callback takes. A deadline miss is counted by the
+ * framework for a frame taking longer than its duration, a late frame is one finished after
+ * the next tick was due, which includes waiting for a CPU.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <switch.h>
+#include "../framework.h"
+#include "../utils/atomic.h"
+
+#define LOADSIM_FORMAT 1
+#define LOADSIM_FRAME_MS 20
+#define LOADSIM_MAX_POINTS 32
+#define LOADSIM_MAX_SAMPLES 960
+#define LATE_FRAMES 0
+
+typedef struct
+{
+    uint32_t sessions[LOADSIM_MAX_POINTS];
+    uint32_t sessionPoints;
+    uint32_t threads[LOADSIM_MAX_POINTS];
+    uint32_t threadPoints;
+    uint32_t duration;
+    uint32_t work;
+    uint32_t rate;
+    uint32_t directives;
+    jvxfs_sigproc_exec_t exec;
+    const char* execName;
+} options_t;
+
+typedef struct
+{
+    switch_core_session_t* session;
+    switch_thread_t* thread;
+    uint32_t offset;
+    unsigned int seed;
+    int16_t samples[LOADSIM_MAX_SAMPLES];
+} call_t;
+
+typedef struct
+{
+    uint64_t frames;
+    uint64_t misses;
+    uint64_t late;
+    uint64_t passthroughs;
+    double cpu;
+    double p50;
+    double p99;
+    double p999;
+    double max;
+} result_t;
+
+static jvxfs_module_t* mod = NULL;
+static switch_memory_pool_t* pool = NULL;
+static jvxfs_histogram_t* latency = NULL;
+static options_t opts;
+static uint32_t running = 0;
+
+static void sim_app(switch_core_session_t* session, const char* data);
+static switch_status_t sim_api(const char* cmd, switch_core_session_t* session, switch_stream_handle_t* stream);
+static switch_status_t discard_write(switch_stream_handle_t* handle, const char* fmt, ...);
+static switch_status_t discard_raw_write(switch_stream_handle_t* handle, uint8_t* data, switch_size_t datalen);
+static void busy_construct(void** hdl, jvxfs_sigproc_media_t* media, const char* args);
+static void busy_initialize(void* hdl, jvxfs_sigproc_media_t* media);
+static void busy_process(void* hdl, jvxfs_sigproc_media_t* media);
+static void busy_terminate(void* hdl);
+static void mode_directive(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, jvxfs_app_instance_t* inst, void* data);
+static uint64_t now_ns(void);
+static double cpu_seconds(void);
+static bool parse_list(const char* arg, uint32_t* out, uint32_t* count);
+static bool parse_options(int argc, char** argv);
+static bool load_module(uint32_t threads);
+static void unload_module(void);
+static void* media_thread(switch_thread_t* thread, void* obj);
+static void fire_directive(call_t* calls, uint32_t sessions, switch_stream_handle_t* stream);
+static bool simulate(uint32_t sessions, uint32_t threads, result_t* res);
+
+
+int main(int argc, char** argv)
+{
+    if (!parse_options(argc, argv)) {
+        fprintf(stderr, "usage: %s [-s sessions,...] [-t threads,...] [-d seconds] [-w work_us] [-r rate]\n"
+            "       [-a directives_per_second] [-e auto|sync|async]\n", argv[0]);
+        return 2;
+    }
+    printf("# jvxfs-loadsim format=%d version=%s rate=%u frame_ms=%d work_us=%u exec=%s duration_s=%u\n",
+        LOADSIM_FORMAT, JVX_FS_FRAMEWORK_LIBVERSION, opts.rate, LOADSIM_FRAME_MS, opts.work, opts.execName,
+        opts.duration);
+    printf("sessions,threads,frames,cpu_per_session_pct,sessions_per_core,p50_us,p99_us,p999_us,max_us,"
+        "deadline_misses,late_frames,passthroughs\n");
+    fflush(stdout);
+    for (uint32_t t = 0; t < opts.threadPoints; ++t) {
+        for (uint32_t s = 0; s < opts.sessionPoints; ++s) {
+            result_t res;
+            if (!simulate(opts.sessions[s], opts.threads[t], &res)) {
+                fprintf(stderr, "jvxfs-loadsim: could not simulate %u sessions with %u threads.\n",
+                    opts.sessions[s], opts.threads[t]);
+                return 1;
+            }
+            double perCore = (res.cpu > 0.0) ? 100.0 / res.cpu : 0.0;
+            printf("%u,%u,%llu,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%llu,%llu,%llu\n", opts.sessions[s], opts.threads[t],
+                (unsigned long long)res.frames, res.cpu, perCore, res.p50, res.p99, res.p999, res.max,
+                (unsigned long long)res.misses, (unsigned long long)res.late, (unsigned long long)res.passthroughs);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
+
+
+void sim_app(switch_core_session_t* session, const char* data)
+{
+    jvxfs_system_load_app(mod, session, data);
+}
+
+switch_status_t sim_api(const char* cmd, switch_core_session_t* session, switch_stream_handle_t* stream)
+{
+    return jvxfs_system_exec_api(mod, cmd, session, stream);
+}
+
+switch_status_t discard_write(switch_stream_handle_t* handle, const char* fmt, ...)
+{
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t discard_raw_write(switch_stream_handle_t* handle, uint8_t* data, switch_size_t datalen)
+{
+    return SWITCH_STATUS_SUCCESS;
+}
+
+void busy_construct(void** hdl, jvxfs_sigproc_media_t* media, const char* args)
+{
+    *hdl = (void*)1;
+}
+
+void busy_initialize(void* hdl, jvxfs_sigproc_media_t* media)
+{
+}
+
+void busy_process(void* hdl, jvxfs_sigproc_media_t* media)
+{
+    uint64_t end = now_ns() + (uint64_t)opts.work * 1000;
+    while (now_ns() < end) jvxfs_cpu_relax();
+}
+
+void busy_terminate(void* hdl)
+{
+}
+
+void mode_directive(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, jvxfs_app_instance_t* inst, void* data)
+{
+    jvxfs_sigproc_set_mode(inst, (jvxfs_sigproc_algo_mode_t)atoi(rqst->parameters));
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+double cpu_seconds(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+        + (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+bool parse_list(const char* arg, uint32_t* out, uint32_t* count)
+{
+    *count = 0;
+    const char* pos = arg;
+    while (*pos && *count < LOADSIM_MAX_POINTS) {
+        char* end = NULL;
+        unsigned long value = strtoul(pos, &end, 10);
+        if (end == pos || value == 0) return false;
+        out[(*count)++] = (uint32_t)value;
+        if (*end != ',') return *end == '\0';
+        pos = end + 1;
+    }
+    return *count > 0;
+}
+
+bool parse_options(int argc, char** argv)
+{
+    const uint32_t sessions[] = { 1, 10, 50, 100 };
+    memcpy(opts.sessions, sessions, sizeof(sessions));
+    opts.sessionPoints = sizeof(sessions) / sizeof(sessions[0]);
+    opts.threads[0] = 1;
+    opts.threadPoints = 1;
+    opts.duration = 5;
+    opts.work = 0;
+    opts.rate = 8000;
+    opts.directives = 50;
+    opts.exec = JVXFS_SP_EXEC_AUTO;
+    opts.execName = "auto";
+    int c;
+    while ((c = getopt(argc, argv, "s:t:d:w:r:a:e:")) != -1) {
+        switch (c) {
+        case 's':
+            if (!parse_list(optarg, opts.sessions, &opts.sessionPoints)) return false;
+            break;
+        case 't':
+            if (!parse_list(optarg, opts.threads, &opts.threadPoints)) return false;
+            break;
+        case 'd':
+            opts.duration = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'w':
+            opts.work = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            opts.rate = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'a':
+            opts.directives = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'e':
+            if (strcmp(optarg, "auto") == 0) opts.exec = JVXFS_SP_EXEC_AUTO;
+            else if (strcmp(optarg, "sync") == 0) opts.exec = JVXFS_SP_EXEC_SYNC;
+            else if (strcmp(optarg, "async") == 0) opts.exec = JVXFS_SP_EXEC_ASYNC;
+            else return false;
+            opts.execName = optarg;
+            break;
+        default:
+            return false;
+        }
+    }
+    uint32_t samples = opts.rate * LOADSIM_FRAME_MS / 1000;
+    return opts.duration > 0 && samples > 0 && samples <= LOADSIM_MAX_SAMPLES;
+}
+
+bool load_module(uint32_t threads)
+{
+    switch_loadable_module_interface_t* modInterface = NULL;
+    pool = stub_pool_create();
+    if (!pool) return false;
+    jvxfs_status_t res = jvxfs_system_create_module(&mod, &modInterface, pool, "mod_loadsim", sim_app, sim_api);
+    if (res != JVXFS_STATUS_SUCCESS) return false;
+    jvxfs_module_set_worker_threads(mod, threads, false);
+    jvxfs_app_t* app = NULL;
+    res = jvxfs_module_create_sigproc_app(mod, &app, busy_construct, busy_initialize, busy_process,
+        busy_terminate, NULL);
+    if (res != JVXFS_STATUS_SUCCESS) return false;
+    jvxfs_sigprog_config_t* conf = NULL;
+    jvxfs_app_get_sigproc_config(app, &conf);
+    jvxfs_sigproc_set_working_channel(conf, JVXFS_SP_UPLINK, JVXFS_SP_DEFAULT);
+    jvxfs_sigproc_set_datatype(conf, JVXFS_SP_16BIT_LE);
+    jvxfs_sigproc_set_execution(conf, opts.exec);
+    jvxfs_app_add_session_directive(app, "mode", mode_directive, NULL);
+    if (jvxfs_system_init_check(mod, "mod_loadsim") != SWITCH_STATUS_SUCCESS) return false;
+    return jvxfs_histogram_create(&latency, 0, jvxfs_module_get_error_handler(mod), pool) == JVXFS_STATUS_SUCCESS;
+}
+
+void unload_module(void)
+{
+    if (mod) {
+        jvxfs_system_prepare_end(mod);
+        jvxfs_system_terminate(&mod);
+    }
+    stub_pool_destroy(pool);
+    pool = NULL;
+    latency = NULL;
+}
+
+void* media_thread(switch_thread_t* thread, void* obj)
+{
+    call_t* call = (call_t*)obj;
+    uint32_t samples = opts.rate * LOADSIM_FRAME_MS / 1000;
+    switch_frame_t frame = { .data = call->samples, .datalen = samples * sizeof(int16_t),
+        .buflen = sizeof(call->samples), .samples = samples, .rate = opts.rate, .channels = 1 };
+    /* Calls do not start in lockstep, spread their ticks over the frame. */
+    switch_yield(call->offset);
+    sim_app(call->session, "");
+    switch_timer_t timer;
+    switch_core_timer_init(&timer, "soft", LOADSIM_FRAME_MS, (int)samples, switch_core_session_get_pool(call->session));
+    while (jvxfs_atomic_load(&running)) {
+        switch_time_t due = timer.next;
+        switch_core_timer_next(&timer);
+        for (uint32_t i = 0; i < samples; ++i) call->samples[i] = (int16_t)((rand_r(&call->seed) & 0x7FFF) - 0x4000);
+        uint64_t start = now_ns();
+        stub_session_feed(call->session, SWITCH_ABC_TYPE_READ_REPLACE, &frame);
+        uint64_t end = now_ns();
+        jvxfs_histogram_record(latency, end - start);
+        if (switch_time_now() - due > LOADSIM_FRAME_MS * 1000) jvxfs_histogram_count(latency, LATE_FRAMES, 1);
+    }
+    switch_core_timer_destroy(&timer);
+    return NULL;
+}
+
+void fire_directive(call_t* calls, uint32_t sessions, switch_stream_handle_t* stream)
+{
+    char cmd[16];
+    call_t* call = &calls[rand() % sessions];
+    switch (rand() % 4) {
+    case 0:
+        sim_api("stats", NULL, stream);
+        break;
+    case 1:
+        sim_api("stats", call->session, stream);
+        break;
+    case 2:
+        sim_api("@all stats", NULL, stream);
+        break;
+    default:
+        /* Mostly on, the algorithm would not run in the other modes. */
+        snprintf(cmd, sizeof(cmd), "mode %d", (rand() % 4 == 0) ? rand() % 3 : (int)JVXFS_SP_ALGO_ON);
+        sim_app(call->session, cmd);
+        break;
+    }
+}
+
+bool simulate(uint32_t sessions, uint32_t threads, result_t* res)
+{
+    memset(res, 0, sizeof(result_t));
+    if (!load_module(threads)) {
+        unload_module();
+        return false;
+    }
+    call_t* calls = (call_t*)calloc(sessions, sizeof(call_t));
+    if (!calls) {
+        unload_module();
+        return false;
+    }
+    switch_threadattr_t* attr = NULL;
+    switch_threadattr_create(&attr, pool);
+    switch_threadattr_stacksize_set(attr, SWITCH_THREAD_STACKSIZE);
+    jvxfs_atomic_store(&running, 1);
+    double cpuStart = cpu_seconds();
+    uint32_t started = 0;
+    for (; started < sessions; ++started) {
+        call_t* call = &calls[started];
+        call->session = stub_session_create(opts.rate, opts.rate * LOADSIM_FRAME_MS / 1000, 1);
+        call->offset = started * LOADSIM_FRAME_MS * 1000 / sessions;
+        call->seed = started + 1;
+        if (!call->session) break;
+        if (switch_thread_create(&call->thread, attr, media_thread, call, pool) != SWITCH_STATUS_SUCCESS) {
+            stub_session_destroy(call->session);
+            break;
+        }
+    }
+    switch_stream_handle_t stream = { .write_function = discard_write, .raw_write_function = discard_raw_write };
+    uint64_t end = now_ns() + (uint64_t)opts.duration * 1000000000ull;
+    while (now_ns() < end) {
+        if (opts.directives) {
+            switch_yield(1000000 / opts.directives);
+            if (started) fire_directive(calls, started, &stream);
+        } else {
+            switch_yield(100000);
+        }
+    }
+    jvxfs_atomic_store(&running, 0);
+    for (uint32_t i = 0; i < started; ++i) {
+        switch_status_t status;
+        switch_thread_join(&status, calls[i].thread);
+    }
+    double cpu = cpu_seconds() - cpuStart;
+    jvxfs_histogram_snapshot_t* snap = (jvxfs_histogram_snapshot_t*)malloc(sizeof(jvxfs_histogram_snapshot_t));
+    bool read = snap != NULL;
+    if (read) {
+        jvxfs_histogram_read(latency, snap);
+        res->frames = snap->total;
+        res->late = snap->counters[LATE_FRAMES];
+        res->p50 = (double)jvxfs_histogram_percentile(snap, 50.0) / 1000.0;
+        res->p99 = (double)jvxfs_histogram_percentile(snap, 99.0) / 1000.0;
+        res->p999 = (double)jvxfs_histogram_percentile(snap, 99.9) / 1000.0;
+        res->max = (double)snap->max / 1000.0;
+        jvxfs_app_t* app = NULL;
+        jvxfs_module_get_sigproc_app(mod, &app);
+        jvxfs_histogram_read(jvxfs_app_get_sigproc_stats(app), snap);
+        res->misses = snap->counters[JVXFS_SP_STAT_DEADLINE_MISSES];
+        res->passthroughs = snap->counters[JVXFS_SP_STAT_PASSTHROUGHS];
+        free(snap);
+    }
+    res->cpu = (started) ? cpu / (double)opts.duration / (double)started * 100.0 : 0.0;
+    for (uint32_t i = 0; i < started; ++i) stub_session_destroy(calls[i].session);
+    free(calls);
+    unload_module();
+    return started == sessions && read;
+}
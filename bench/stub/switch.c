@@ -0,0 +1,616 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <errno.h>
+#include <unistd.h>
+#include <switch.h>
+
+#define MAX_PRIVATES 16
+#define MAX_BUGS 4
+#define UUID_LENGTH 37
+#define ALIGNMENT 64
+
+typedef struct block_s
+{
+    struct block_s* next;
+} block_t;
+
+struct switch_memory_pool
+{
+    block_t* blocks;
+    pthread_mutex_t lock;
+};
+
+struct switch_channel
+{
+    const char* keys[MAX_PRIVATES];
+    const void* values[MAX_PRIVATES];
+    switch_caller_profile_t profile;
+};
+
+struct switch_media_bug
+{
+    switch_core_session_t* session;
+    switch_media_bug_callback_t callback;
+    void* data;
+    switch_media_bug_flag_t flags;
+    switch_frame_t* readReplace;
+    switch_frame_t* writeReplace;
+};
+
+struct switch_core_session
+{
+    switch_memory_pool_t* pool;
+    switch_channel_t channel;
+    switch_codec_implementation_t impl;
+    switch_media_bug_t bugs[MAX_BUGS];
+    uint32_t bugCount;
+    char uuid[UUID_LENGTH];
+};
+
+struct switch_mutex
+{
+    pthread_mutex_t mutex;
+};
+
+struct switch_thread_rwlock
+{
+    pthread_rwlock_t lock;
+};
+
+struct switch_thread_cond
+{
+    pthread_cond_t cond;
+};
+
+struct switch_threadattr
+{
+    switch_size_t stacksize;
+};
+
+struct switch_thread
+{
+    pthread_t thread;
+    switch_thread_start_t func;
+    void* data;
+};
+
+typedef struct header_s
+{
+    char* name;
+    char* value;
+    struct header_s* next;
+} header_t;
+
+struct switch_event
+{
+    char* subclass;
+    header_t* headers;
+    header_t* last;
+};
+
+static uint64_t eventsFired = 0;
+static uint32_t sessionCounter = 0;
+
+static void* thread_entry(void* obj);
+static void free_event(switch_event_t* event);
+
+
+switch_memory_pool_t* stub_pool_create(void)
+{
+    switch_memory_pool_t* pool = (switch_memory_pool_t*)calloc(1, sizeof(switch_memory_pool_t));
+    if (pool) pthread_mutex_init(&pool->lock, NULL);
+    return pool;
+}
+
+void stub_pool_destroy(switch_memory_pool_t* pool)
+{
+    if (!pool) return;
+    block_t* block = pool->blocks;
+    while (block) {
+        block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+switch_core_session_t* stub_session_create(uint32_t rate, uint32_t samples, uint8_t channels)
+{
+    switch_memory_pool_t* pool = stub_pool_create();
+    if (!pool) return NULL;
+    switch_core_session_t* session = (switch_core_session_t*)switch_core_alloc(pool, sizeof(switch_core_session_t));
+    if (!session) {
+        stub_pool_destroy(pool);
+        return NULL;
+    }
+    session->pool = pool;
+    session->impl.samples_per_second = rate;
+    session->impl.actual_samples_per_second = rate;
+    session->impl.samples_per_packet = samples;
+    session->impl.microseconds_per_packet = (int)((uint64_t)samples * 1000000 / (rate ? rate : 1));
+    session->impl.number_of_channels = channels;
+    session->channel.profile.caller_id_name = "bench";
+    session->channel.profile.caller_id_number = "0000";
+    snprintf(session->uuid, UUID_LENGTH, "00000000-0000-0000-0000-%012u", ++sessionCounter);
+    return session;
+}
+
+void stub_session_destroy(switch_core_session_t* session)
+{
+    if (!session) return;
+    for (uint32_t i = 0; i < session->bugCount; ++i) {
+        switch_media_bug_t* bug = &session->bugs[i];
+        bug->callback(bug, bug->data, SWITCH_ABC_TYPE_CLOSE);
+    }
+    stub_pool_destroy(session->pool);
+}
+
+switch_status_t stub_session_feed(switch_core_session_t* session, switch_abc_type_t type, switch_frame_t* frame)
+{
+    for (uint32_t i = 0; i < session->bugCount; ++i) {
+        switch_media_bug_t* bug = &session->bugs[i];
+        if (type == SWITCH_ABC_TYPE_READ_REPLACE && !(bug->flags & SMBF_READ_REPLACE)) continue;
+        if (type == SWITCH_ABC_TYPE_WRITE_REPLACE && !(bug->flags & SMBF_WRITE_REPLACE)) continue;
+        bug->readReplace = frame;
+        bug->writeReplace = frame;
+        if (bug->callback(bug, bug->data, type) != SWITCH_TRUE) return SWITCH_STATUS_FALSE;
+    }
+    return SWITCH_STATUS_SUCCESS;
+}
+
+uint64_t stub_count_events(void)
+{
+    return __atomic_load_n(&eventsFired, __ATOMIC_RELAXED);
+}
+
+switch_loadable_module_interface_t* switch_loadable_module_create_module_interface(switch_memory_pool_t* pool, const char* name)
+{
+    switch_loadable_module_interface_t* mod = (switch_loadable_module_interface_t*)switch_core_alloc(pool,
+        sizeof(switch_loadable_module_interface_t));
+    if (!mod) return NULL;
+    mod->module_name = name;
+    mod->pool = pool;
+    return mod;
+}
+
+void* switch_loadable_module_create_interface(switch_loadable_module_interface_t* mod, switch_module_interface_name_t iname)
+{
+    switch (iname) {
+    case SWITCH_APPLICATION_INTERFACE:
+        return switch_core_alloc(mod->pool, sizeof(switch_application_interface_t));
+    case SWITCH_API_INTERFACE:
+        return switch_core_alloc(mod->pool, sizeof(switch_api_interface_t));
+    default:
+        return NULL;
+    }
+}
+
+void* switch_core_perform_alloc(switch_memory_pool_t* pool, switch_size_t memory, const char* file, const char* func, int line)
+{
+    /* Like the core, memory is zeroed and only released with its pool. */
+    block_t* block = (block_t*)calloc(1, sizeof(block_t) + ALIGNMENT + memory);
+    if (!block) return NULL;
+    pthread_mutex_lock(&pool->lock);
+    block->next = pool->blocks;
+    pool->blocks = block;
+    pthread_mutex_unlock(&pool->lock);
+    return (uint8_t*)block + ALIGNMENT;
+}
+
+void* switch_core_perform_session_alloc(switch_core_session_t* session, switch_size_t memory, const char* file,
+    const char* func, int line)
+{
+    return switch_core_perform_alloc(session->pool, memory, file, func, line);
+}
+
+char* switch_core_perform_session_strdup(switch_core_session_t* session, const char* todup, const char* file,
+    const char* func, int line)
+{
+    if (!todup) return NULL;
+    size_t len = strlen(todup) + 1;
+    char* dup = (char*)switch_core_perform_alloc(session->pool, len, file, func, line);
+    if (dup) memcpy(dup, todup, len);
+    return dup;
+}
+
+switch_memory_pool_t* switch_core_session_get_pool(switch_core_session_t* session)
+{
+    return session->pool;
+}
+
+switch_channel_t* switch_core_session_get_channel(switch_core_session_t* session)
+{
+    return &session->channel;
+}
+
+char* switch_core_session_get_uuid(switch_core_session_t* session)
+{
+    return session->uuid;
+}
+
+switch_status_t switch_core_session_get_read_impl(switch_core_session_t* session, switch_codec_implementation_t* impp)
+{
+    *impp = session->impl;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_core_session_get_write_impl(switch_core_session_t* session, switch_codec_implementation_t* impp)
+{
+    *impp = session->impl;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+void* switch_channel_get_private(switch_channel_t* channel, const char* key)
+{
+    for (int i = 0; i < MAX_PRIVATES; ++i) {
+        if (channel->keys[i] && strcmp(channel->keys[i], key) == 0) return (void*)channel->values[i];
+    }
+    return NULL;
+}
+
+switch_status_t switch_channel_set_private(switch_channel_t* channel, const char* key, const void* private_info)
+{
+    int empty = -1;
+    for (int i = 0; i < MAX_PRIVATES; ++i) {
+        if (channel->keys[i] && strcmp(channel->keys[i], key) == 0) {
+            channel->values[i] = private_info;
+            return SWITCH_STATUS_SUCCESS;
+        }
+        if (!channel->keys[i] && empty < 0) empty = i;
+    }
+    if (empty < 0) return SWITCH_STATUS_FALSE;
+    channel->keys[empty] = key;
+    channel->values[empty] = private_info;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+const char* switch_channel_get_variable_dup(switch_channel_t* channel, const char* varname, switch_bool_t dup, int idx)
+{
+    return NULL;
+}
+
+switch_caller_profile_t* switch_channel_get_caller_profile(switch_channel_t* channel)
+{
+    return &channel->profile;
+}
+
+switch_status_t switch_core_media_bug_add(switch_core_session_t* session, const char* function, const char* target,
+    switch_media_bug_callback_t callback, void* user_data, time_t stop_time, switch_media_bug_flag_t flags,
+    switch_media_bug_t** new_bug)
+{
+    if (session->bugCount == MAX_BUGS) return SWITCH_STATUS_FALSE;
+    switch_media_bug_t* bug = &session->bugs[session->bugCount++];
+    bug->session = session;
+    bug->callback = callback;
+    bug->data = user_data;
+    bug->flags = flags;
+    bug->readReplace = NULL;
+    bug->writeReplace = NULL;
+    *new_bug = bug;
+    /* The core initializes a bug right away, before the first frame. */
+    callback(bug, user_data, SWITCH_ABC_TYPE_INIT);
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_frame_t* switch_core_media_bug_get_read_replace_frame(switch_media_bug_t* bug)
+{
+    return bug->readReplace;
+}
+
+switch_frame_t* switch_core_media_bug_get_write_replace_frame(switch_media_bug_t* bug)
+{
+    return bug->writeReplace;
+}
+
+void switch_core_media_bug_set_read_replace_frame(switch_media_bug_t* bug, switch_frame_t* frame)
+{
+    bug->readReplace = frame;
+}
+
+void switch_core_media_bug_set_write_replace_frame(switch_media_bug_t* bug, switch_frame_t* frame)
+{
+    bug->writeReplace = frame;
+}
+
+uint32_t switch_atomic_read(volatile switch_atomic_t* mem)
+{
+    return __atomic_load_n(mem, __ATOMIC_SEQ_CST);
+}
+
+void switch_atomic_set(volatile switch_atomic_t* mem, uint32_t val)
+{
+    __atomic_store_n(mem, val, __ATOMIC_SEQ_CST);
+}
+
+switch_status_t switch_mutex_init(switch_mutex_t** lock, unsigned int flags, switch_memory_pool_t* pool)
+{
+    switch_mutex_t* hdl = (switch_mutex_t*)switch_core_alloc(pool, sizeof(switch_mutex_t));
+    if (!hdl) return SWITCH_STATUS_FALSE;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if (flags & SWITCH_MUTEX_NESTED) pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&hdl->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    *lock = hdl;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_mutex_destroy(switch_mutex_t* lock)
+{
+    return pthread_mutex_destroy(&lock->mutex) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_mutex_lock(switch_mutex_t* lock)
+{
+    return pthread_mutex_lock(&lock->mutex) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_mutex_unlock(switch_mutex_t* lock)
+{
+    return pthread_mutex_unlock(&lock->mutex) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_thread_rwlock_create(switch_thread_rwlock_t** rwlock, switch_memory_pool_t* pool)
+{
+    switch_thread_rwlock_t* hdl = (switch_thread_rwlock_t*)switch_core_alloc(pool, sizeof(switch_thread_rwlock_t));
+    if (!hdl || pthread_rwlock_init(&hdl->lock, NULL) != 0) return SWITCH_STATUS_FALSE;
+    *rwlock = hdl;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_thread_rwlock_destroy(switch_thread_rwlock_t* rwlock)
+{
+    return pthread_rwlock_destroy(&rwlock->lock) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_thread_rwlock_rdlock(switch_thread_rwlock_t* rwlock)
+{
+    return pthread_rwlock_rdlock(&rwlock->lock) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_thread_rwlock_wrlock(switch_thread_rwlock_t* rwlock)
+{
+    return pthread_rwlock_wrlock(&rwlock->lock) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_thread_rwlock_unlock(switch_thread_rwlock_t* rwlock)
+{
+    return pthread_rwlock_unlock(&rwlock->lock) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_thread_cond_create(switch_thread_cond_t** cond, switch_memory_pool_t* pool)
+{
+    switch_thread_cond_t* hdl = (switch_thread_cond_t*)switch_core_alloc(pool, sizeof(switch_thread_cond_t));
+    if (!hdl) return SWITCH_STATUS_FALSE;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&hdl->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    *cond = hdl;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_thread_cond_timedwait(switch_thread_cond_t* cond, switch_mutex_t* mutex, switch_interval_time_t timeout)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout / 1000000;
+    ts.tv_nsec += (long)(timeout % 1000000) * 1000;
+    if (ts.tv_nsec >= 1000000000L) {
+        ++ts.tv_sec;
+        ts.tv_nsec -= 1000000000L;
+    }
+    int res = pthread_cond_timedwait(&cond->cond, &mutex->mutex, &ts);
+    if (res == ETIMEDOUT) return SWITCH_STATUS_TIMEOUT;
+    return res == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_thread_cond_signal(switch_thread_cond_t* cond)
+{
+    return pthread_cond_signal(&cond->cond) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_thread_cond_broadcast(switch_thread_cond_t* cond)
+{
+    return pthread_cond_broadcast(&cond->cond) == 0 ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+switch_status_t switch_threadattr_create(switch_threadattr_t** new_attr, switch_memory_pool_t* pool)
+{
+    switch_threadattr_t* attr = (switch_threadattr_t*)switch_core_alloc(pool, sizeof(switch_threadattr_t));
+    if (!attr) return SWITCH_STATUS_FALSE;
+    *new_attr = attr;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_threadattr_stacksize_set(switch_threadattr_t* attr, switch_size_t stacksize)
+{
+    attr->stacksize = stacksize;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_threadattr_priority_set(switch_threadattr_t* attr, switch_thread_priority_t priority)
+{
+    /* Realtime scheduling needs privileges a benchmark usually does not have. */
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_thread_create(switch_thread_t** new_thread, switch_threadattr_t* attr, switch_thread_start_t func,
+    void* data, switch_memory_pool_t* cont)
+{
+    switch_thread_t* thd = (switch_thread_t*)switch_core_alloc(cont, sizeof(switch_thread_t));
+    if (!thd) return SWITCH_STATUS_FALSE;
+    thd->func = func;
+    thd->data = data;
+    pthread_attr_t pattr;
+    pthread_attr_init(&pattr);
+    if (attr && attr->stacksize) pthread_attr_setstacksize(&pattr, attr->stacksize);
+    int res = pthread_create(&thd->thread, &pattr, thread_entry, thd);
+    pthread_attr_destroy(&pattr);
+    if (res != 0) return SWITCH_STATUS_FALSE;
+    *new_thread = thd;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_thread_join(switch_status_t* retval, switch_thread_t* thd)
+{
+    *retval = (pthread_join(thd->thread, NULL) == 0) ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+    return *retval;
+}
+
+switch_thread_id_t switch_thread_self(void)
+{
+    return pthread_self();
+}
+
+int32_t switch_core_thread_set_cpu_affinity(int cpu)
+{
+    return 0;
+}
+
+int32_t switch_core_cpu_count(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (int32_t)cpus : 1;
+}
+
+void switch_yield(switch_interval_time_t t)
+{
+    struct timespec ts = { (time_t)(t / 1000000), (long)(t % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+switch_time_t switch_time_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (switch_time_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+switch_time_t switch_micro_time_now(void)
+{
+    return switch_time_now();
+}
+
+switch_status_t switch_core_timer_init(switch_timer_t* timer, const char* name, int interval, int samples,
+    switch_memory_pool_t* pool)
+{
+    timer->interval = interval;
+    timer->samples = (uint32_t)samples;
+    timer->samplecount = 0;
+    timer->next = switch_time_now() + (switch_time_t)interval * 1000;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_core_timer_next(switch_timer_t* timer)
+{
+    switch_time_t wait = timer->next - switch_time_now();
+    if (wait > 0) switch_yield(wait);
+    timer->next += (switch_time_t)timer->interval * 1000;
+    timer->samplecount += timer->samples;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_core_timer_destroy(switch_timer_t* timer)
+{
+    return SWITCH_STATUS_SUCCESS;
+}
+
+char* switch_vmprintf(const char* fmt, va_list ap)
+{
+    va_list copy;
+    va_copy(copy, ap);
+    int len = vsnprintf(NULL, 0, fmt, copy);
+    va_end(copy);
+    if (len < 0) return NULL;
+    char* buf = (char*)malloc((size_t)len + 1);
+    if (buf) vsnprintf(buf, (size_t)len + 1, fmt, ap);
+    return buf;
+}
+
+void switch_log_printf(switch_text_channel_t channel, const char* file, const char* func, int line,
+    const char* userdata, switch_log_level_t level, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    switch_log_vprintf(channel, file, func, line, userdata, level, fmt, args);
+    va_end(args);
+}
+
+void switch_log_vprintf(switch_text_channel_t channel, const char* file, const char* func, int line,
+    const char* userdata, switch_log_level_t level, const char* fmt, va_list ap)
+{
+    /* Formatted like the core does, but not written, the output would dominate the measurement. */
+    char buf[1024];
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+}
+
+switch_status_t switch_event_create_subclass_detailed(const char* file, const char* func, int line, switch_event_t** event,
+    switch_event_types_t event_id, const char* subclass_name)
+{
+    switch_event_t* ev = (switch_event_t*)calloc(1, sizeof(switch_event_t));
+    if (!ev) return SWITCH_STATUS_FALSE;
+    ev->subclass = strdup(subclass_name ? subclass_name : "");
+    *event = ev;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_event_add_header_string(switch_event_t* event, switch_stack_t stack, const char* header_name, const char* data)
+{
+    header_t* header = (header_t*)malloc(sizeof(header_t));
+    if (!header) return SWITCH_STATUS_FALSE;
+    header->name = strdup(header_name);
+    header->value = strdup(data ? data : "");
+    header->next = NULL;
+    if (stack == SWITCH_STACK_TOP || !event->last) {
+        header->next = event->headers;
+        event->headers = header;
+        if (!event->last) event->last = header;
+    } else {
+        event->last->next = header;
+        event->last = header;
+    }
+    return SWITCH_STATUS_SUCCESS;
+}
+
+switch_status_t switch_event_fire_detailed(const char* file, const char* func, int line, switch_event_t** event, void* user_data)
+{
+    /* Delivered to nobody, the core would queue it for the event thread. */
+    __atomic_fetch_add(&eventsFired, 1, __ATOMIC_RELAXED);
+    free_event(*event);
+    *event = NULL;
+    return SWITCH_STATUS_SUCCESS;
+}
+
+const char* switch_event_get_header_idx(switch_event_t* event, const char* header_name, int idx)
+{
+    for (header_t* header = event ? event->headers : NULL; header; header = header->next) {
+        if (strcmp(header->name, header_name) == 0) return header->value;
+    }
+    return NULL;
+}
+
+
+void* thread_entry(void* obj)
+{
+    switch_thread_t* thd = (switch_thread_t*)obj;
+    return thd->func(thd, thd->data);
+}
+
+void free_event(switch_event_t* event)
+{
+    header_t* header = event->headers;
+    while (header) {
+        header_t* next = header->next;
+        free(header->name);
+        free(header->value);
+        free(header);
+        header = next;
+    }
+    free(event->subclass);
+    free(event);
+}
@@ -0,0 +1,315 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file switch.h
+ * @brief Minimal stand-in for the FreeSWITCH API used by the library, for benchmarks without a running switch.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-21
+ * @copyright Copyright (c) 2019
+ * @note Only the declarations the library uses are provided, with the same names and semantics as far as
+ * the library relies on them. Functions prefixed @em stub_ do not exist in FreeSWITCH, they let the
+ * benchmark play the part of the core: create sessions and feed frames to media bugs.
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_BENCH_STUB_SWITCH_H
+#define LIB_JVX_FS_FRAMEWORK_BENCH_STUB_SWITCH_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <pthread.h>
+
+#define _In_
+#define _In_opt_
+#define _In_opt_z_
+#define SWITCH_DECLARE(type) type
+#define SWITCH_RECOMMENDED_BUFFER_SIZE 8192
+#define SWITCH_UUID_FORMATTED_LENGTH 36
+#define SWITCH_CURRENT_APPLICATION_VARIABLE "current_application"
+#define SWITCH_THREAD_STACKSIZE 240 * 1024
+#define SWITCH_THREAD_FUNC
+#define SWITCH_MUTEX_NESTED 0x1
+#define SAF_NONE 0
+#define zstr(x) (!(x) || !*(x))
+
+typedef enum { SWITCH_FALSE = 0, SWITCH_TRUE = 1 } switch_bool_t;
+#define switch_true(expr) stub_true(expr)
+#define switch_false(expr) stub_false(expr)
+static inline switch_bool_t stub_true(const char* expr)
+{
+    return (expr && (!strcasecmp(expr, "yes") || !strcasecmp(expr, "on") || !strcasecmp(expr, "true") ||
+        !strcasecmp(expr, "t") || !strcasecmp(expr, "enabled") || !strcasecmp(expr, "active") ||
+        !strcasecmp(expr, "allow") || (atoi(expr) != 0))) ? SWITCH_TRUE : SWITCH_FALSE;
+}
+static inline switch_bool_t stub_false(const char* expr)
+{
+    return (expr && (!strcasecmp(expr, "no") || !strcasecmp(expr, "off") || !strcasecmp(expr, "false") ||
+        !strcasecmp(expr, "f") || !strcasecmp(expr, "disabled") || !strcasecmp(expr, "inactive") ||
+        !strcasecmp(expr, "disallow") || (!strcmp(expr, "0")))) ? SWITCH_TRUE : SWITCH_FALSE;
+}
+typedef enum { SWITCH_STATUS_SUCCESS, SWITCH_STATUS_FALSE, SWITCH_STATUS_TIMEOUT, SWITCH_STATUS_NOTFOUND } switch_status_t;
+typedef int64_t switch_time_t;
+typedef int64_t switch_interval_time_t;
+typedef uint32_t switch_atomic_t;
+typedef size_t switch_size_t;
+typedef pthread_t switch_thread_id_t;
+
+typedef struct switch_memory_pool switch_memory_pool_t;
+typedef struct switch_core_session switch_core_session_t;
+typedef struct switch_channel switch_channel_t;
+typedef struct switch_media_bug switch_media_bug_t;
+typedef struct switch_mutex switch_mutex_t;
+typedef struct switch_thread_rwlock switch_thread_rwlock_t;
+typedef struct switch_thread_cond switch_thread_cond_t;
+typedef struct switch_thread switch_thread_t;
+typedef struct switch_threadattr switch_threadattr_t;
+typedef struct switch_event switch_event_t;
+typedef struct switch_stream_handle switch_stream_handle_t;
+
+typedef struct
+{
+    void* data;
+    uint32_t datalen;
+    uint32_t buflen;
+    uint32_t samples;
+    uint32_t rate;
+    uint32_t channels;
+} switch_frame_t;
+
+typedef struct
+{
+    uint32_t samples_per_second;
+    uint32_t actual_samples_per_second;
+    int microseconds_per_packet;
+    uint32_t samples_per_packet;
+    int number_of_channels;
+} switch_codec_implementation_t;
+
+typedef struct
+{
+    const char* caller_id_name;
+    const char* caller_id_number;
+} switch_caller_profile_t;
+
+typedef enum
+{
+    SWITCH_ABC_TYPE_INIT,
+    SWITCH_ABC_TYPE_READ,
+    SWITCH_ABC_TYPE_WRITE,
+    SWITCH_ABC_TYPE_WRITE_REPLACE,
+    SWITCH_ABC_TYPE_READ_REPLACE,
+    SWITCH_ABC_TYPE_CLOSE
+} switch_abc_type_t;
+
+typedef enum
+{
+    SMBF_READ_STREAM = (1 << 0),
+    SMBF_WRITE_STREAM = (1 << 1),
+    SMBF_WRITE_REPLACE = (1 << 2),
+    SMBF_READ_REPLACE = (1 << 3),
+    SMBF_PRUNE = (1 << 9)
+} switch_media_bug_flag_enum_t;
+typedef uint32_t switch_media_bug_flag_t;
+typedef switch_bool_t(*switch_media_bug_callback_t)(switch_media_bug_t*, void*, switch_abc_type_t);
+
+typedef enum
+{
+    SWITCH_LOG_CONSOLE = 0,
+    SWITCH_LOG_ALERT = 1,
+    SWITCH_LOG_CRIT = 2,
+    SWITCH_LOG_ERROR = 3,
+    SWITCH_LOG_WARNING = 4,
+    SWITCH_LOG_NOTICE = 5,
+    SWITCH_LOG_INFO = 6,
+    SWITCH_LOG_DEBUG = 7
+} switch_log_level_t;
+
+typedef enum { SWITCH_CHANNEL_ID_LOG, SWITCH_CHANNEL_ID_SESSION } switch_text_channel_t;
+#define SWITCH_CHANNEL_LOG SWITCH_CHANNEL_ID_LOG, __FILE__, __func__, __LINE__, NULL
+
+typedef enum { SWITCH_EVENT_CUSTOM } switch_event_types_t;
+typedef enum { SWITCH_STACK_BOTTOM, SWITCH_STACK_TOP } switch_stack_t;
+typedef enum { SWITCH_PRI_LOW = 1, SWITCH_PRI_NORMAL = 10, SWITCH_PRI_IMPORTANT = 50, SWITCH_PRI_REALTIME = 99 } switch_thread_priority_t;
+
+typedef switch_status_t(*switch_stream_handle_write_function_t)(switch_stream_handle_t*, const char*, ...);
+typedef switch_status_t(*switch_stream_handle_raw_write_function_t)(switch_stream_handle_t*, uint8_t*, switch_size_t);
+struct switch_stream_handle
+{
+    switch_stream_handle_write_function_t write_function;
+    switch_stream_handle_raw_write_function_t raw_write_function;
+    void* data;
+    switch_size_t data_len;
+    switch_event_t* param_event;
+};
+
+typedef void(*switch_application_function_t)(switch_core_session_t*, const char*);
+typedef switch_status_t(*switch_api_function_t)(const char*, switch_core_session_t*, switch_stream_handle_t*);
+typedef void*(*switch_thread_start_t)(switch_thread_t*, void*);
+
+typedef struct
+{
+    const char* interface_name;
+    switch_application_function_t application_function;
+    const char* long_desc;
+    const char* short_desc;
+    const char* syntax;
+    uint32_t flags;
+} switch_application_interface_t;
+
+typedef struct
+{
+    const char* interface_name;
+    const char* desc;
+    switch_api_function_t function;
+    const char* syntax;
+} switch_api_interface_t;
+
+typedef struct
+{
+    const char* module_name;
+    switch_memory_pool_t* pool;
+} switch_loadable_module_interface_t;
+
+typedef enum { SWITCH_APPLICATION_INTERFACE, SWITCH_API_INTERFACE } switch_module_interface_name_t;
+
+typedef struct
+{
+    int interval;
+    uint32_t samples;
+    uint32_t samplecount;
+    switch_time_t next;
+} switch_timer_t;
+
+#define SWITCH_MODULE_LOAD_ARGS (switch_loadable_module_interface_t** module_interface, switch_memory_pool_t* pool)
+#define SWITCH_MODULE_SHUTDOWN_ARGS (void)
+#define SWITCH_MODULE_LOAD_FUNCTION(name) switch_status_t name SWITCH_MODULE_LOAD_ARGS
+#define SWITCH_MODULE_SHUTDOWN_FUNCTION(name) switch_status_t name SWITCH_MODULE_SHUTDOWN_ARGS
+#define SWITCH_STANDARD_APP(name) static void name(switch_core_session_t* session, const char* data)
+#define SWITCH_STANDARD_API(name) static switch_status_t name(_In_opt_z_ const char* cmd, \
+    _In_opt_ switch_core_session_t* session, _In_ switch_stream_handle_t* stream)
+#define SWITCH_MODULE_DEFINITION(name, load, shutdown, runtime) \
+    static const char modname[] = #name; \
+    switch_status_t name##_load SWITCH_MODULE_LOAD_ARGS { return load(module_interface, pool); } \
+    switch_status_t name##_shutdown SWITCH_MODULE_SHUTDOWN_ARGS { return shutdown(); }
+
+#define SWITCH_ADD_APP(app_int, int_name, short_descript, long_descript, funcptr, syntax_string, app_flags) \
+    for (;;) { \
+        app_int = (switch_application_interface_t*)switch_loadable_module_create_interface(*module_interface, \
+            SWITCH_APPLICATION_INTERFACE); \
+        app_int->interface_name = int_name; \
+        app_int->application_function = funcptr; \
+        app_int->short_desc = short_descript; \
+        app_int->long_desc = long_descript; \
+        app_int->syntax = syntax_string; \
+        app_int->flags = (app_flags); \
+        break; \
+    }
+#define SWITCH_ADD_API(api_int, int_name, descript, funcptr, syntax_string) \
+    for (;;) { \
+        api_int = (switch_api_interface_t*)switch_loadable_module_create_interface(*module_interface, SWITCH_API_INTERFACE); \
+        api_int->interface_name = int_name; \
+        api_int->desc = descript; \
+        api_int->function = funcptr; \
+        api_int->syntax = syntax_string; \
+        break; \
+    }
+
+/* Modules and memory pools */
+switch_loadable_module_interface_t* switch_loadable_module_create_module_interface(switch_memory_pool_t* pool, const char* name);
+void* switch_loadable_module_create_interface(switch_loadable_module_interface_t* mod, switch_module_interface_name_t iname);
+void* switch_core_perform_alloc(switch_memory_pool_t* pool, switch_size_t memory, const char* file, const char* func, int line);
+#define switch_core_alloc(_pool, _mem) switch_core_perform_alloc(_pool, _mem, __FILE__, __func__, __LINE__)
+void* switch_core_perform_session_alloc(switch_core_session_t* session, switch_size_t memory, const char* file,
+    const char* func, int line);
+#define switch_core_session_alloc(_session, _mem) switch_core_perform_session_alloc(_session, _mem, __FILE__, __func__, __LINE__)
+char* switch_core_perform_session_strdup(switch_core_session_t* session, const char* todup, const char* file,
+    const char* func, int line);
+#define switch_core_session_strdup(_session, _todup) switch_core_perform_session_strdup(_session, _todup, __FILE__, __func__, __LINE__)
+switch_memory_pool_t* switch_core_session_get_pool(switch_core_session_t* session);
+
+/* Sessions and channels */
+switch_channel_t* switch_core_session_get_channel(switch_core_session_t* session);
+char* switch_core_session_get_uuid(switch_core_session_t* session);
+switch_status_t switch_core_session_get_read_impl(switch_core_session_t* session, switch_codec_implementation_t* impp);
+switch_status_t switch_core_session_get_write_impl(switch_core_session_t* session, switch_codec_implementation_t* impp);
+void* switch_channel_get_private(switch_channel_t* channel, const char* key);
+switch_status_t switch_channel_set_private(switch_channel_t* channel, const char* key, const void* private_info);
+const char* switch_channel_get_variable_dup(switch_channel_t* channel, const char* varname, switch_bool_t dup, int idx);
+#define switch_channel_get_variable(_c, _v) switch_channel_get_variable_dup(_c, _v, SWITCH_TRUE, -1)
+switch_caller_profile_t* switch_channel_get_caller_profile(switch_channel_t* channel);
+
+/* Media bugs */
+switch_status_t switch_core_media_bug_add(switch_core_session_t* session, const char* function, const char* target,
+    switch_media_bug_callback_t callback, void* user_data, time_t stop_time, switch_media_bug_flag_t flags,
+    switch_media_bug_t** new_bug);
+switch_frame_t* switch_core_media_bug_get_read_replace_frame(switch_media_bug_t* bug);
+switch_frame_t* switch_core_media_bug_get_write_replace_frame(switch_media_bug_t* bug);
+void switch_core_media_bug_set_read_replace_frame(switch_media_bug_t* bug, switch_frame_t* frame);
+void switch_core_media_bug_set_write_replace_frame(switch_media_bug_t* bug, switch_frame_t* frame);
+
+/* Threads and locks */
+uint32_t switch_atomic_read(volatile switch_atomic_t* mem);
+void switch_atomic_set(volatile switch_atomic_t* mem, uint32_t val);
+switch_status_t switch_mutex_init(switch_mutex_t** lock, unsigned int flags, switch_memory_pool_t* pool);
+switch_status_t switch_mutex_destroy(switch_mutex_t* lock);
+switch_status_t switch_mutex_lock(switch_mutex_t* lock);
+switch_status_t switch_mutex_unlock(switch_mutex_t* lock);
+switch_status_t switch_thread_rwlock_create(switch_thread_rwlock_t** rwlock, switch_memory_pool_t* pool);
+switch_status_t switch_thread_rwlock_destroy(switch_thread_rwlock_t* rwlock);
+switch_status_t switch_thread_rwlock_rdlock(switch_thread_rwlock_t* rwlock);
+switch_status_t switch_thread_rwlock_wrlock(switch_thread_rwlock_t* rwlock);
+switch_status_t switch_thread_rwlock_unlock(switch_thread_rwlock_t* rwlock);
+switch_status_t switch_thread_cond_create(switch_thread_cond_t** cond, switch_memory_pool_t* pool);
+switch_status_t switch_thread_cond_timedwait(switch_thread_cond_t* cond, switch_mutex_t* mutex, switch_interval_time_t timeout);
+switch_status_t switch_thread_cond_signal(switch_thread_cond_t* cond);
+switch_status_t switch_thread_cond_broadcast(switch_thread_cond_t* cond);
+switch_status_t switch_threadattr_create(switch_threadattr_t** new_attr, switch_memory_pool_t* pool);
+switch_status_t switch_threadattr_stacksize_set(switch_threadattr_t* attr, switch_size_t stacksize);
+switch_status_t switch_threadattr_priority_set(switch_threadattr_t* attr, switch_thread_priority_t priority);
+switch_status_t switch_thread_create(switch_thread_t** new_thread, switch_threadattr_t* attr, switch_thread_start_t func,
+    void* data, switch_memory_pool_t* cont);
+switch_status_t switch_thread_join(switch_status_t* retval, switch_thread_t* thd);
+switch_thread_id_t switch_thread_self(void);
+int32_t switch_core_thread_set_cpu_affinity(int cpu);
+int32_t switch_core_cpu_count(void);
+void switch_yield(switch_interval_time_t t);
+
+/* Time */
+switch_time_t switch_time_now(void);
+switch_time_t switch_micro_time_now(void);
+switch_status_t switch_core_timer_init(switch_timer_t* timer, const char* name, int interval, int samples,
+    switch_memory_pool_t* pool);
+switch_status_t switch_core_timer_next(switch_timer_t* timer);
+switch_status_t switch_core_timer_destroy(switch_timer_t* timer);
+
+/* Strings, logging and events */
+char* switch_vmprintf(const char* fmt, va_list ap);
+void switch_log_printf(switch_text_channel_t channel, const char* file, const char* func, int line,
+    const char* userdata, switch_log_level_t level, const char* fmt, ...);
+void switch_log_vprintf(switch_text_channel_t channel, const char* file, const char* func, int line,
+    const char* userdata, switch_log_level_t level, const char* fmt, va_list ap);
+switch_status_t switch_event_create_subclass_detailed(const char* file, const char* func, int line, switch_event_t** event,
+    switch_event_types_t event_id, const char* subclass_name);
+#define switch_event_create_subclass(_e, _eid, _sn) switch_event_create_subclass_detailed(__FILE__, __func__, __LINE__, _e, _eid, _sn)
+switch_status_t switch_event_add_header_string(switch_event_t* event, switch_stack_t stack, const char* header_name, const char* data);
+switch_status_t switch_event_fire_detailed(const char* file, const char* func, int line, switch_event_t** event, void* user_data);
+#define switch_event_fire(event) switch_event_fire_detailed(__FILE__, __func__, __LINE__, event, NULL)
+const char* switch_event_get_header_idx(switch_event_t* event, const char* header_name, int idx);
+#define switch_event_get_header_nil(e, h) (switch_event_get_header_idx(e, h, -1) ? switch_event_get_header_idx(e, h, -1) : "")
+
+/* Benchmark side of the core */
+switch_memory_pool_t* stub_pool_create(void);
+void stub_pool_destroy(switch_memory_pool_t* pool);
+switch_core_session_t* stub_session_create(uint32_t rate, uint32_t samples, uint8_t channels);
+void stub_session_destroy(switch_core_session_t* session);
+switch_status_t stub_session_feed(switch_core_session_t* session, switch_abc_type_t type, switch_frame_t* frame);
+uint64_t stub_count_events(void);
+
+#endif
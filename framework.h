@@ -20,6 +20,7 @@
 #include "system/error.h"
 #include "system/system.h"
 #include "system/module.h"
+#include "system/config.h"
 #include "system/app.h"
 #include "system/session.h"
 #include "system/view.h"
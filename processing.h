@@ -22,6 +22,10 @@
 #include "processing/sp_defines.h"
 #include "processing/sp_config.h"
 #include "processing/sp_channel_model.h"
+#include "processing/sp_convert.h"
+#include "processing/sp_fft.h"
+#include "processing/sp_stft.h"
+#include "processing/sp_resampler.h"
 #include "processing/sp_processor.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,259 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <string.h>
+#include "../system/error.h"
+#include "../utils/atomic.h"
+#include "sp_convert.h"
+#include "sp_batch.h"
+
+#define MAX_FRAME_VALUES (SWITCH_RECOMMENDED_BUFFER_SIZE / sizeof(int16_t))
+
+typedef struct
+{
+    jvxfs_algorithm_vtable_t* vtable;
+    jvxfs_sigproc_batch_slot_t** slots;
+    uint32_t capacity;
+    uint32_t interval;
+    size_t sampleSize;
+    uint8_t* data;
+    jvxfs_sigproc_batch_slot_t** due;
+    void** algos;
+    jvxfs_sigproc_media_t** media;
+    bool running;
+    uint32_t scanning;
+    switch_thread_t* thread;
+} collector_t;
+
+static void* SWITCH_THREAD_FUNC collector_thread(switch_thread_t* thread, void* obj);
+static void tick(collector_t* hdl);
+static void run_group(collector_t* hdl, uint32_t first, uint32_t count);
+static bool same_shape(const jvxfs_sigproc_media_t* a, const jvxfs_sigproc_media_t* b);
+static void swap_due(collector_t* hdl, uint32_t a, uint32_t b);
+static uint32_t get_stride(uint32_t count, size_t size);
+static void gather(void* dst, jvxfs_sigproc_media_t* const* media, uint32_t count, size_t values, uint32_t stride, size_t size);
+static void scatter(jvxfs_sigproc_media_t* const* media, const void* src, uint32_t count, size_t values, uint32_t stride, size_t size);
+
+
+jvxfs_status_t jvxfs_batch_create(jvxfs_sigproc_batch_collector_t** obj, jvxfs_algorithm_vtable_t* vtable,
+    jvxfs_sigproc_datatype_t type, uint32_t sessions, uint32_t interval, jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create batch collector.";
+    if (!vtable || !vtable->process_batch) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_BATCH,
+            "Batch collector needs a batch function.");
+    }
+    if (sessions == 0) sessions = JVXFS_SP_BATCH_DEFAULT_SESSIONS;
+    if (interval == 0) interval = JVXFS_SP_BATCH_DEFAULT_INTERVAL;
+    collector_t* hdl = (collector_t*)switch_core_alloc(pool, sizeof(collector_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_BATCH, error);
+    }
+    hdl->vtable = vtable;
+    hdl->capacity = sessions;
+    hdl->interval = interval;
+    hdl->sampleSize = jvxfs_convert_is_needed(type) ? jvxfs_convert_get_sample_size(type) : sizeof(int16_t);
+    if (hdl->sampleSize == 0) hdl->sampleSize = sizeof(int16_t);
+    size_t dataSize = MAX_FRAME_VALUES * get_stride(sessions, hdl->sampleSize) * hdl->sampleSize;
+    uint8_t* mem = (uint8_t*)switch_core_alloc(pool, dataSize + JVXFS_SP_MEMORY_ALIGNMENT);
+    hdl->data = mem ? (uint8_t*)(((uintptr_t)mem + JVXFS_SP_MEMORY_ALIGNMENT - 1) &
+        ~(uintptr_t)(JVXFS_SP_MEMORY_ALIGNMENT - 1)) : NULL;
+    hdl->slots = (jvxfs_sigproc_batch_slot_t**)switch_core_alloc(pool, sizeof(jvxfs_sigproc_batch_slot_t*) * sessions);
+    hdl->due = (jvxfs_sigproc_batch_slot_t**)switch_core_alloc(pool, sizeof(jvxfs_sigproc_batch_slot_t*) * sessions);
+    hdl->algos = (void**)switch_core_alloc(pool, sizeof(void*) * sessions);
+    hdl->media = (jvxfs_sigproc_media_t**)switch_core_alloc(pool, sizeof(jvxfs_sigproc_media_t*) * sessions);
+    if (!hdl->data || !hdl->slots || !hdl->due || !hdl->algos || !hdl->media) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_BATCH, error);
+    }
+    memset(hdl->slots, 0, sizeof(jvxfs_sigproc_batch_slot_t*) * sessions);
+    hdl->running = true;
+    hdl->scanning = 0;
+    hdl->thread = NULL;
+    switch_threadattr_t* attr = NULL;
+    switch_threadattr_create(&attr, pool);
+    switch_threadattr_stacksize_set(attr, SWITCH_THREAD_STACKSIZE);
+    switch_threadattr_priority_set(attr, SWITCH_PRI_REALTIME);
+    if (switch_thread_create(&hdl->thread, attr, collector_thread, hdl, pool) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_BATCH,
+            "Could not start batch thread.");
+    }
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_batch_destroy(jvxfs_sigproc_batch_collector_t** obj)
+{
+    collector_t* hdl = (collector_t*)*obj;
+    if (!hdl) return;
+    jvxfs_atomic_store(&hdl->running, false);
+    switch_status_t st;
+    if (hdl->thread) switch_thread_join(&st, hdl->thread);
+    *obj = NULL;
+}
+
+jvxfs_status_t jvxfs_batch_attach(jvxfs_sigproc_batch_collector_t* obj, jvxfs_sigproc_batch_slot_t* slot)
+{
+    collector_t* hdl = (collector_t*)obj;
+    for (uint32_t i = 0; i < hdl->capacity; ++i) {
+        jvxfs_sigproc_batch_slot_t* empty = NULL;
+        if (jvxfs_atomic_cas(&hdl->slots[i], &empty, slot)) return JVXFS_STATUS_SUCCESS;
+    }
+    return JVXFS_STATUS_OUT_OF_BOUNDS;
+}
+
+void jvxfs_batch_detach(jvxfs_sigproc_batch_collector_t* obj, jvxfs_sigproc_batch_slot_t* slot)
+{
+    collector_t* hdl = (collector_t*)obj;
+    for (uint32_t i = 0; i < hdl->capacity; ++i) {
+        jvxfs_sigproc_batch_slot_t* expected = slot;
+        if (jvxfs_atomic_cas(&hdl->slots[i], &expected, NULL)) break;
+    }
+    /* A tick which started before the slot was cleared may still use it. The fence pairs with the one of
+     * tick(), so either the tick sees the cleared slot or the scan flag is seen here. */
+    jvxfs_atomic_fence();
+    while (jvxfs_atomic_load(&hdl->scanning)) switch_yield(1000);
+}
+
+
+void* SWITCH_THREAD_FUNC collector_thread(switch_thread_t* thread, void* obj)
+{
+    collector_t* hdl = (collector_t*)obj;
+    switch_timer_t timer;
+    memset(&timer, 0, sizeof(switch_timer_t));
+    bool timed = switch_core_timer_init(&timer, "soft", (int)hdl->interval, (int)hdl->interval * 8, NULL)
+        == SWITCH_STATUS_SUCCESS;
+    while (jvxfs_atomic_load(&hdl->running)) {
+        if (timed) {
+            switch_core_timer_next(&timer);
+        } else {
+            switch_yield(hdl->interval * 1000);
+        }
+        tick(hdl);
+    }
+    if (timed) switch_core_timer_destroy(&timer);
+    return NULL;
+}
+
+void tick(collector_t* hdl)
+{
+    jvxfs_atomic_store(&hdl->scanning, 1);
+    /* Keeps the slot loads below from moving ahead of the flag, see jvxfs_batch_detach(). */
+    jvxfs_atomic_fence();
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < hdl->capacity; ++i) {
+        jvxfs_sigproc_batch_slot_t* slot = jvxfs_atomic_load(&hdl->slots[i]);
+        if (!slot || !slot->prepare(slot->data, &hdl->algos[count], &hdl->media[count])) continue;
+        hdl->due[count] = slot;
+        ++count;
+    }
+    /* Frames of the same shape are moved next to each other and processed as one group. */
+    uint32_t first = 0;
+    while (first < count) {
+        uint32_t end = first + 1;
+        for (uint32_t i = end; i < count; ++i) {
+            if (same_shape(hdl->media[first], hdl->media[i])) swap_due(hdl, i, end++);
+        }
+        run_group(hdl, first, end - first);
+        first = end;
+    }
+    jvxfs_atomic_store(&hdl->scanning, 0);
+}
+
+void run_group(collector_t* hdl, uint32_t first, uint32_t count)
+{
+    jvxfs_sigproc_media_t* const* media = &hdl->media[first];
+    size_t size = jvxfs_convert_is_needed(media[0]->type) ? jvxfs_convert_get_sample_size(media[0]->type) : sizeof(int16_t);
+    size_t values = (size_t)media[0]->samples * (media[0]->channels ? media[0]->channels : 1);
+    if (count == 1 || size > hdl->sampleSize || values > MAX_FRAME_VALUES) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            hdl->vtable->process(hdl->algos[i], hdl->media[i]);
+            hdl->due[i]->finish(hdl->due[i]->data);
+        }
+        return;
+    }
+    jvxfs_sigproc_batch_t batch;
+    batch.data = hdl->data;
+    batch.sessions = count;
+    batch.stride = get_stride(count, size);
+    batch.samples = media[0]->samples;
+    batch.rate = media[0]->rate;
+    batch.channels = media[0]->channels;
+    batch.type = media[0]->type;
+    batch.media = media;
+    gather(hdl->data, media, count, values, batch.stride, size);
+    hdl->vtable->process_batch(&hdl->algos[first], &batch);
+    scatter(media, hdl->data, count, values, batch.stride, size);
+    for (uint32_t i = first; i < first + count; ++i) hdl->due[i]->finish(hdl->due[i]->data);
+}
+
+bool same_shape(const jvxfs_sigproc_media_t* a, const jvxfs_sigproc_media_t* b)
+{
+    return a->samples == b->samples && a->channels == b->channels && a->rate == b->rate && a->type == b->type;
+}
+
+void swap_due(collector_t* hdl, uint32_t a, uint32_t b)
+{
+    if (a == b) return;
+    jvxfs_sigproc_batch_slot_t* slot = hdl->due[a];
+    void* algo = hdl->algos[a];
+    jvxfs_sigproc_media_t* media = hdl->media[a];
+    hdl->due[a] = hdl->due[b];
+    hdl->algos[a] = hdl->algos[b];
+    hdl->media[a] = hdl->media[b];
+    hdl->due[b] = slot;
+    hdl->algos[b] = algo;
+    hdl->media[b] = media;
+}
+
+uint32_t get_stride(uint32_t count, size_t size)
+{
+    uint32_t lanes = (uint32_t)(JVXFS_SP_MEMORY_ALIGNMENT / size);
+    return (count + lanes - 1) / lanes * lanes;
+}
+
+/* Row k holds value k of all frames, the frames are read as parallel streams. */
+#define DEFINE_TRANSPOSE(_type) \
+    static void gather_##_type(_type* dst, jvxfs_sigproc_media_t* const* media, uint32_t count, size_t values, uint32_t stride) \
+    { \
+        for (size_t k = 0; k < values; ++k) { \
+            _type* row = dst + k * stride; \
+            for (uint32_t s = 0; s < count; ++s) row[s] = ((const _type*)media[s]->data)[k]; \
+            for (uint32_t s = count; s < stride; ++s) row[s] = 0; \
+        } \
+    } \
+    static void scatter_##_type(jvxfs_sigproc_media_t* const* media, const _type* src, uint32_t count, size_t values, uint32_t stride) \
+    { \
+        for (size_t k = 0; k < values; ++k) { \
+            const _type* row = src + k * stride; \
+            for (uint32_t s = 0; s < count; ++s) ((_type*)media[s]->data)[k] = row[s]; \
+        } \
+    }
+
+DEFINE_TRANSPOSE(uint8_t)
+DEFINE_TRANSPOSE(uint16_t)
+DEFINE_TRANSPOSE(uint32_t)
+DEFINE_TRANSPOSE(uint64_t)
+
+void gather(void* dst, jvxfs_sigproc_media_t* const* media, uint32_t count, size_t values, uint32_t stride, size_t size)
+{
+    switch (size) {
+        case 1: gather_uint8_t((uint8_t*)dst, media, count, values, stride); break;
+        case 2: gather_uint16_t((uint16_t*)dst, media, count, values, stride); break;
+        case 4: gather_uint32_t((uint32_t*)dst, media, count, values, stride); break;
+        case 8: gather_uint64_t((uint64_t*)dst, media, count, values, stride); break;
+        default: break;
+    }
+}
+
+void scatter(jvxfs_sigproc_media_t* const* media, const void* src, uint32_t count, size_t values, uint32_t stride, size_t size)
+{
+    switch (size) {
+        case 1: scatter_uint8_t(media, (const uint8_t*)src, count, values, stride); break;
+        case 2: scatter_uint16_t(media, (const uint16_t*)src, count, values, stride); break;
+        case 4: scatter_uint32_t(media, (const uint32_t*)src, count, values, stride); break;
+        case 8: scatter_uint64_t(media, (const uint64_t*)src, count, values, stride); break;
+        default: break;
+    }
+}
@@ -0,0 +1,77 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+ 
+/**
+ * @file sp_batch.h
+ * @brief Collection of frames of all sessions of an app into batched algorithm calls.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-17
+ * @copyright Copyright (c) 2019
+ * @note The user should not call these functions himself, the app creates the collector if
+ * a batch function has been set and the processors attach to it.
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_BATCH_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <switch.h>
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+#define JVXFS_SP_BATCH_DEFAULT_SESSIONS 256
+#define JVXFS_SP_BATCH_DEFAULT_INTERVAL 10
+
+/**
+ * @brief Connection of a processor to the collector.
+ * @details @a prepare is called from the collector thread on every tick. It returns @em false if the
+ * processor has no frame due, otherwise the algorithm instance and the frame in processing format.
+ * @a finish is called once the frame has been processed.
+ */
+typedef struct
+{
+    bool(*prepare)(void* data, void** algo, jvxfs_sigproc_media_t** media);
+    void(*finish)(void* data);
+    void* data;
+} jvxfs_sigproc_batch_slot_t;
+
+/**
+ * @brief Create a collector and start its tick thread.
+ * @param[out] obj      Collector.
+ * @param[in] vtable    Algorithm functions of the app, @a process_batch must be set.
+ * @param[in] type      Datatype of the app's frames.
+ * @param[in] sessions  Maximum number of attached processors.
+ * @param[in] interval  Tick interval in ms, should not exceed the shortest packetization time.
+ * @param[in] err       Error handler.
+ * @param[in] pool      Memory pool of the module.
+ * @return Status code.
+ * @details Due frames of the same shape (samples, channels, rate) are laid out structure of arrays
+ * and handed to a single @a process_batch call, a frame without partner is handed to @a process.
+ */
+jvxfs_status_t jvxfs_batch_create(jvxfs_sigproc_batch_collector_t** obj, jvxfs_algorithm_vtable_t* vtable,
+    jvxfs_sigproc_datatype_t type, uint32_t sessions, uint32_t interval, jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Stop the tick thread. All processors must have been detached before.
+ */
+void jvxfs_batch_destroy(jvxfs_sigproc_batch_collector_t** obj);
+
+/**
+ * @brief Attach a processor, the slot must stay valid until it is detached.
+ * @return Status code, #JVXFS_STATUS_OUT_OF_BOUNDS if all slots are in use.
+ */
+jvxfs_status_t jvxfs_batch_attach(jvxfs_sigproc_batch_collector_t* obj, jvxfs_sigproc_batch_slot_t* slot);
+
+/**
+ * @brief Detach a processor.
+ * @details Returns once a running tick has finished, afterwards the collector does not touch the slot anymore.
+ */
+void jvxfs_batch_detach(jvxfs_sigproc_batch_collector_t* obj, jvxfs_sigproc_batch_slot_t* slot);
+
+JVX_FS_LIB_END
+
+#endif
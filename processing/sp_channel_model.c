@@ -0,0 +1,232 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+ 
+#include "../system/error.h"
+#include "../utils/observer.h"
+#include "sp_channel_model.h"
+#include "sp_channel_model_private.h"
+#include "sp_resampler.h"
+
+typedef struct
+{
+    uint32_t samplerate;
+    uint32_t origSamplerate;
+    uint32_t frameSize;
+    uint32_t origFrameSize;
+    uint32_t fftSize;
+    uint32_t frameDuration;
+    uint32_t resamplingDelay;
+    uint8_t channels;
+    jvxfs_sigproc_datatype_t type;
+    jvxfs_sigproc_channel_t link;
+    jvxfs_channel_fetching_t fetch;
+    jvxfs_sigprog_config_t* config;
+    switch_core_session_t* session;
+    jvxfs_observer_handle_t* obs;
+    jvxfs_error_t* err;
+} model_t;
+
+static void resolve_codec(model_t* hdl);
+static void set_parameters(model_t* hdl, uint32_t rate, uint32_t samples, uint8_t channels);
+static uint32_t next_power_of_two(uint32_t val);
+
+
+jvxfs_status_t jvxfs_channel_create_model(jvxfs_channel_model_t** mod, jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *mod = NULL;
+    model_t* hdl = (model_t*)switch_core_alloc(pool, sizeof(model_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_CHANNEL,
+            "Could not create channel model.");
+    }
+    jvxfs_status_t res = jvxfs_observer_create(&hdl->obs, hdl, err, pool);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    hdl->samplerate = 0;
+    hdl->origSamplerate = 0;
+    hdl->frameSize = 0;
+    hdl->origFrameSize = 0;
+    hdl->fftSize = 0;
+    hdl->frameDuration = 0;
+    hdl->resamplingDelay = 0;
+    hdl->channels = 0;
+    hdl->type = JVXFS_SP_NONE;
+    hdl->link = JVXFS_SP_NO_LINK;
+    hdl->fetch = JVXFS_CHANNEL_IGNORING;
+    hdl->config = NULL;
+    hdl->session = NULL;
+    hdl->err = err;
+    *mod = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_channel_destroy_model(jvxfs_channel_model_t** mod)
+{
+    model_t* hdl = (model_t*)*mod;
+    if (!hdl) return;
+    jvxfs_observer_destroy(&hdl->obs);
+    *mod = NULL;
+}
+
+jvxfs_sigproc_channel_t jvxfs_channel_which_link(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->link;
+}
+
+jvxfs_channel_fetching_t jvxfs_channel_how_fetched(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->fetch;
+}
+
+uint32_t jvxfs_channel_get_samplerate(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->samplerate;
+}
+
+uint32_t jvxfs_channel_get_original_samplerate(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->origSamplerate;
+}
+
+uint32_t jvxfs_channel_get_frame_size(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->frameSize;
+}
+
+uint32_t jvxfs_channel_get_original_frame_size(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->origFrameSize;
+}
+
+uint32_t jvxfs_channel_get_optimal_fft_size(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->fftSize;
+}
+
+uint8_t jvxfs_channel_get_number_channels(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->channels;
+}
+
+uint32_t jvxfs_channel_get_frame_duration_us(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->frameDuration;
+}
+
+uint32_t jvxfs_channel_get_resampling_delay_us(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->resamplingDelay;
+}
+
+jvxfs_sigproc_datatype_t jvxfs_channel_get_datatype(jvxfs_channel_model_t* mod)
+{
+    model_t* hdl = (model_t*)mod;
+    return hdl->type;
+}
+
+jvxfs_status_t jvxfs_channel_add_observer(jvxfs_channel_model_t* mod, jvxfs_channel_observer_t func, void* data)
+{
+    model_t* hdl = (model_t*)mod;
+    return jvxfs_observer_add(hdl->obs, func, data);
+}
+
+void jvxfs_channel_remove_observer(jvxfs_channel_model_t* mod, jvxfs_channel_observer_t func)
+{
+    model_t* hdl = (model_t*)mod;
+    jvxfs_observer_remove(hdl->obs, func);
+}
+
+void jvxfs_channel_set_config(jvxfs_channel_model_t* mod, jvxfs_sigprog_config_t* config)
+{
+    model_t* hdl = (model_t*)mod;
+    hdl->config = config;
+}
+
+jvxfs_status_t jvxfs_channel_bind(jvxfs_channel_model_t* mod, switch_core_session_t* session,
+    jvxfs_sigproc_channel_t link, jvxfs_channel_fetching_t fetch, jvxfs_sigproc_datatype_t type)
+{
+    model_t* hdl = (model_t*)mod;
+    if (!session || link == JVXFS_SP_NO_LINK) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CHANNEL,
+            "Channel model needs a session and a link.");
+    }
+    hdl->session = session;
+    hdl->link = link;
+    hdl->fetch = fetch;
+    hdl->type = type;
+    resolve_codec(hdl);
+    return JVXFS_STATUS_SUCCESS;
+}
+
+bool jvxfs_channel_refresh(jvxfs_channel_model_t* mod, const switch_frame_t* frame)
+{
+    model_t* hdl = (model_t*)mod;
+    uint8_t channels = (frame->channels > 0) ? (uint8_t)frame->channels : 1;
+    if (frame->rate == hdl->origSamplerate && frame->samples == hdl->origFrameSize && channels == hdl->channels) {
+        return false;
+    }
+    bool wasResolved = hdl->origSamplerate != 0;
+    resolve_codec(hdl);
+    if (frame->rate != hdl->origSamplerate || frame->samples != hdl->origFrameSize || channels != hdl->channels) {
+        set_parameters(hdl, frame->rate, frame->samples, channels);
+    }
+    if (wasResolved) jvxfs_observer_notify(hdl->obs);
+    return wasResolved;
+}
+
+void jvxfs_channel_describe(jvxfs_channel_model_t* mod, jvxfs_sigproc_media_t* media)
+{
+    model_t* hdl = (model_t*)mod;
+    media->samples = hdl->frameSize;
+    media->rate = hdl->samplerate;
+    media->channels = hdl->channels;
+    media->type = hdl->type;
+    media->link = hdl->link;
+}
+
+
+void resolve_codec(model_t* hdl)
+{
+    switch_codec_implementation_t impl = { 0 };
+    switch_status_t status = (hdl->link == JVXFS_SP_DOWNLINK) ?
+        switch_core_session_get_write_impl(hdl->session, &impl) :
+        switch_core_session_get_read_impl(hdl->session, &impl);
+    if (status != SWITCH_STATUS_SUCCESS || !impl.actual_samples_per_second) return;
+    set_parameters(hdl, impl.actual_samples_per_second, impl.samples_per_packet,
+        (impl.number_of_channels > 0) ? (uint8_t)impl.number_of_channels : 1);
+}
+
+void set_parameters(model_t* hdl, uint32_t rate, uint32_t samples, uint8_t channels)
+{
+    hdl->origSamplerate = rate;
+    hdl->origFrameSize = samples;
+    hdl->samplerate = hdl->config ? jvxfs_sigproc_get_processing_samplerate(hdl->config, rate, samples) : rate;
+    hdl->frameSize = (rate > 0) ? (uint32_t)(((uint64_t)samples * hdl->samplerate) / rate) : samples;
+    hdl->channels = channels;
+    hdl->fftSize = next_power_of_two(hdl->frameSize);
+    hdl->frameDuration = (rate > 0) ? (uint32_t)(((uint64_t)samples * 1000000) / rate) : 0;
+    hdl->resamplingDelay = jvxfs_resampler_get_delay_us(rate, hdl->samplerate) +
+        jvxfs_resampler_get_delay_us(hdl->samplerate, rate);
+}
+
+uint32_t next_power_of_two(uint32_t val)
+{
+    if (val <= 1) return 1;
+    --val;
+    val |= val >> 1;
+    val |= val >> 2;
+    val |= val >> 4;
+    val |= val >> 8;
+    val |= val >> 16;
+    return val + 1;
+}
@@ -30,6 +30,7 @@ typedef enum
 } jvxfs_channel_fetching_t;
 
 jvxfs_status_t jvxfs_channel_create_model(jvxfs_channel_model_t** mod, jvxfs_error_t* err, switch_memory_pool_t* pool);
+void jvxfs_channel_destroy_model(jvxfs_channel_model_t** mod);
 
 jvxfs_sigproc_channel_t jvxfs_channel_which_link(jvxfs_channel_model_t* mod);
 
@@ -38,9 +39,11 @@ jvxfs_channel_fetching_t jvxfs_channel_how_fetched(jvxfs_channel_model_t* mod);
 uint32_t jvxfs_channel_get_samplerate(jvxfs_channel_model_t* mod);
 uint32_t jvxfs_channel_get_original_samplerate(jvxfs_channel_model_t* mod);
 uint32_t jvxfs_channel_get_frame_size(jvxfs_channel_model_t* mod);
+uint32_t jvxfs_channel_get_original_frame_size(jvxfs_channel_model_t* mod);
 uint32_t jvxfs_channel_get_optimal_fft_size(jvxfs_channel_model_t* mod);
 uint8_t jvxfs_channel_get_number_channels(jvxfs_channel_model_t* mod);
 uint32_t jvxfs_channel_get_frame_duration_us(jvxfs_channel_model_t* mod);
+uint32_t jvxfs_channel_get_resampling_delay_us(jvxfs_channel_model_t* mod);
 jvxfs_sigproc_datatype_t jvxfs_channel_get_datatype(jvxfs_channel_model_t* mod);
 
 jvxfs_status_t jvxfs_channel_add_observer(jvxfs_channel_model_t* mod, jvxfs_channel_observer_t func, void* data);
@@ -0,0 +1,51 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+ 
+/**
+ * @file sp_channel_model_private.h
+ * @brief Internal functions to keep the channel model in sync with the session's codecs.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-13
+ * @copyright Copyright (c) 2019
+ * @warning Do not use functions declared in this file. No future compatibility is granted.
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_CHANNEL_MODEL_PRIVATE_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_CHANNEL_MODEL_PRIVATE_H
+
+#include <stdbool.h>
+#include "sp_config.h"
+#include "sp_channel_model.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @brief Bind model to one link of a session and read its codec parameters once.
+ */
+jvxfs_status_t jvxfs_channel_bind(jvxfs_channel_model_t* mod, switch_core_session_t* session,
+    jvxfs_sigproc_channel_t link, jvxfs_channel_fetching_t fetch, jvxfs_sigproc_datatype_t type);
+
+/**
+ * @brief Let the model run the algorithm at the samplerate the configuration chooses for the link.
+ * @details Must be set before binding. Samplerate and frame size of the model then describe the
+ * processing side, the original values describe the link.
+ */
+void jvxfs_channel_set_config(jvxfs_channel_model_t* mod, jvxfs_sigprog_config_t* config);
+
+/**
+ * @brief Compare an incoming frame against the cached parameters.
+ * @return @em true, if the codec changed. The model is updated and its observers are notified.
+ * @details Only compares plain values of the frame, the codec is queried again on mismatch only.
+ */
+bool jvxfs_channel_refresh(jvxfs_channel_model_t* mod, const switch_frame_t* frame);
+
+/**
+ * @brief Fill rate, frame size, channels and datatype of a media descriptor from the model.
+ */
+void jvxfs_channel_describe(jvxfs_channel_model_t* mod, jvxfs_sigproc_media_t* media);
+
+JVX_FS_LIB_END
+
+#endif
@@ -3,21 +3,43 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
  
 #include <stdlib.h>
+#include <string.h>
 #include "../system/error.h"
 #include "../system/module.h"
 #include "../system/system.h"
 #include "sp_config.h"
+#include "sp_fft.h"
+
+typedef struct
+{
+    uint32_t rate;
+    const void* profile;
+} rate_slot_t;
 
 typedef struct
 {
     uint32_t* arrFs;
     size_t arrFsSize;
+    rate_slot_t* rates;
+    uint32_t ratesMask;
     jvxfs_sigproc_channel_t workChan;
     jvxfs_sigproc_working_flag_t workFlag;
     jvxfs_sigproc_datatype_t type;
+    bool resample;
+    jvxfs_sigproc_exec_t exec;
+    size_t paramSize;
+    const void* paramDefaults;
+    uint32_t instPrewarm;
+    uint32_t instMaximum;
+    uint32_t blockSize;
+    uint32_t stftSize;
+    uint32_t stftHop;
+    jvxfs_sigproc_window_t stftWindow;
     jvxfs_module_t* mod;
 } conf_t;
 
+static const rate_slot_t* find_rate(conf_t* hdl, uint32_t fs);
+
 
 jvxfs_status_t jvxfs_system_create_sp_config(jvxfs_sigprog_config_t** obj, jvxfs_module_t* mod)
 {
@@ -34,9 +56,21 @@ jvxfs_status_t jvxfs_system_create_sp_config(jvxfs_sigprog_config_t** obj, jvxfs
     }
     hdl->arrFs = NULL;
     hdl->arrFsSize = 0;
+    hdl->rates = NULL;
+    hdl->ratesMask = 0;
     hdl->workChan = JVXFS_SP_NO_LINK;
     hdl->workFlag = JVXFS_SP_DEFAULT;
     hdl->type = JVXFS_SP_DATA;
+    hdl->resample = false;
+    hdl->exec = JVXFS_SP_EXEC_SYNC;
+    hdl->paramSize = 0;
+    hdl->paramDefaults = NULL;
+    hdl->instPrewarm = 0;
+    hdl->instMaximum = 0;
+    hdl->blockSize = 0;
+    hdl->stftSize = 0;
+    hdl->stftHop = 0;
+    hdl->stftWindow = JVXFS_SP_WINDOW_SQRT_HANN;
     hdl->mod = mod;
     *obj = hdl;
     return JVXFS_STATUS_SUCCESS;
@@ -49,6 +83,10 @@ jvxfs_status_t jvx_system_delete_sp_config(jvxfs_sigprog_config_t* conf)
         free(hdl->arrFs);
         hdl->arrFsSize = 0;
     }
+    if (hdl->rates) {
+        free(hdl->rates);
+        hdl->ratesMask = 0;
+    }
     return JVXFS_STATUS_SUCCESS;
 }
 
@@ -69,16 +107,29 @@ jvxfs_status_t jvxfs_sigproc_vallow_samplerates_detailed(jvxfs_sigprog_config_t*
     if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
         return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, error);
     }
+    /* At most half full, so looking up a samplerate ends after a few probes. */
+    uint32_t size = 4;
+    while (size < 2 * number) size *= 2;
     uint32_t* mem = (uint32_t*)malloc(sizeof(uint32_t) * number);
-    if (!mem) {
-        hdl->arrFsSize = 0;
+    rate_slot_t* table = (rate_slot_t*)calloc(size, sizeof(rate_slot_t));
+    if (!mem || !table) {
+        free(mem);
+        free(table);
         return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_CONFIG, error);
     }
     if (hdl->arrFs) free(hdl->arrFs);
+    if (hdl->rates) free(hdl->rates);
     hdl->arrFs = mem;
     hdl->arrFsSize = number;
+    hdl->rates = table;
+    hdl->ratesMask = size - 1;
     for (size_t i = 0; i < number; ++i) {
-        hdl->arrFs[i] = va_arg(args, uint32_t);
+        uint32_t fs = va_arg(args, uint32_t);
+        hdl->arrFs[i] = fs;
+        if (!fs) continue;
+        uint32_t pos = (fs * 2654435761u) & hdl->ratesMask;
+        while (table[pos].rate && table[pos].rate != fs) pos = (pos + 1) & hdl->ratesMask;
+        table[pos].rate = fs;
     }
     return JVXFS_STATUS_SUCCESS;
 }
@@ -86,10 +137,75 @@ jvxfs_status_t jvxfs_sigproc_vallow_samplerates_detailed(jvxfs_sigprog_config_t*
 bool jvxfs_sigproc_is_samplerate_allowed(jvxfs_sigprog_config_t* conf, uint32_t fs)
 {
     conf_t* hdl = (conf_t*)conf;
+    return find_rate(hdl, fs) != NULL;
+}
+
+const void* jvxfs_sigproc_get_profile(jvxfs_sigprog_config_t* conf, uint32_t fs)
+{
+    conf_t* hdl = (conf_t*)conf;
+    const rate_slot_t* slot = find_rate(hdl, fs);
+    return slot ? slot->profile : NULL;
+}
+
+jvxfs_status_t jvxfs_system_build_sp_profiles(jvxfs_sigprog_config_t* conf, jvxfs_algorithm_profile_t func, size_t size)
+{
+    conf_t* hdl = (conf_t*)conf;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (!hdl->rates) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_PENDING_CONFIGURATION, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG,
+            "Could not build profiles, no samplerates allowed.");
+    }
+    switch_memory_pool_t* pool = jvxfs_module_get_memory_pool(hdl->mod);
+    size_t padded = (size + JVXFS_SP_MEMORY_ALIGNMENT - 1) & ~((size_t)JVXFS_SP_MEMORY_ALIGNMENT - 1);
+    for (uint32_t i = 0; i <= hdl->ratesMask; ++i) {
+        rate_slot_t* slot = &hdl->rates[i];
+        if (!slot->rate || slot->profile) continue;
+        uint8_t* mem = (uint8_t*)switch_core_alloc(pool, padded + JVXFS_SP_MEMORY_ALIGNMENT);
+        if (!mem) {
+            return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_CONFIG,
+                "Could not build profiles.");
+        }
+        void* profile = (void*)(((uintptr_t)mem + JVXFS_SP_MEMORY_ALIGNMENT - 1) & ~((uintptr_t)JVXFS_SP_MEMORY_ALIGNMENT - 1));
+        memset(profile, 0, padded);
+        func(profile, slot->rate);
+        slot->profile = profile;
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_sigproc_set_resampling(jvxfs_sigprog_config_t* conf, bool enable)
+{
+    conf_t* hdl = (conf_t*)conf;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Could not set resampling.");
+    }
+    hdl->resample = enable;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+bool jvxfs_sigproc_is_resampling(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->resample;
+}
+
+uint32_t jvxfs_sigproc_get_processing_samplerate(jvxfs_sigprog_config_t* conf, uint32_t fs, uint32_t samples)
+{
+    conf_t* hdl = (conf_t*)conf;
+    if (!hdl->resample || !fs || !hdl->arrFsSize || jvxfs_sigproc_is_samplerate_allowed(conf, fs)) return fs;
+    uint32_t best = fs;
+    uint32_t bestDiff = UINT32_MAX;
     for (size_t i = 0; i < hdl->arrFsSize; ++i) {
-        if (hdl->arrFs[i] == fs) return true;
+        uint32_t rate = hdl->arrFs[i];
+        if (!rate || ((uint64_t)samples * rate) % fs != 0) continue;
+        uint32_t diff = (rate > fs) ? rate - fs : fs - rate;
+        if (diff < bestDiff || (diff == bestDiff && rate > best)) {
+            best = rate;
+            bestDiff = diff;
+        }
     }
-    return false;
+    return best;
 }
 
 jvxfs_status_t jvxfs_sigproc_set_working_channel(jvxfs_sigprog_config_t* conf, jvxfs_sigproc_channel_t chan, jvxfs_sigproc_working_flag_t flags)
@@ -124,6 +240,26 @@ jvxfs_sigproc_buffer_t jvxfs_sigproc_buffers_channel(jvxfs_sigprog_config_t* con
     }
 }
 
+jvxfs_status_t jvxfs_sigproc_set_execution(jvxfs_sigprog_config_t* conf, jvxfs_sigproc_exec_t exec)
+{
+    conf_t* hdl = (conf_t*)conf;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Could not set execution.");
+    }
+    if (exec < JVXFS_SP_EXEC_AUTO || exec > JVXFS_SP_EXEC_ASYNC) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Unknown execution.");
+    }
+    hdl->exec = exec;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_sigproc_exec_t jvxfs_sigproc_get_execution(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->exec;
+}
+
 jvxfs_status_t jvxfs_sigproc_set_datatype(jvxfs_sigprog_config_t* conf, jvxfs_sigproc_datatype_t type)
 {
     conf_t* hdl = (conf_t*)conf;
@@ -139,4 +275,122 @@ jvxfs_sigproc_datatype_t jvxfs_sigproc_get_datatype(jvxfs_sigprog_config_t* conf
 {
     conf_t* hdl = (conf_t*)conf;
     return hdl->type;
+}
+
+jvxfs_status_t jvxfs_sigproc_set_parameters(jvxfs_sigprog_config_t* conf, size_t size, const void* defaults)
+{
+    conf_t* hdl = (conf_t*)conf;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Could not set parameters.");
+    }
+    hdl->paramSize = size;
+    hdl->paramDefaults = defaults;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+size_t jvxfs_sigproc_get_parameter_size(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->paramSize;
+}
+
+const void* jvxfs_sigproc_get_parameter_defaults(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->paramDefaults;
+}
+
+jvxfs_status_t jvxfs_sigproc_set_block_size(jvxfs_sigprog_config_t* conf, uint32_t samples)
+{
+    conf_t* hdl = (conf_t*)conf;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Could not set block size.");
+    }
+    hdl->blockSize = samples;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+uint32_t jvxfs_sigproc_get_block_size(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->blockSize;
+}
+
+jvxfs_status_t jvxfs_sigproc_set_stft(jvxfs_sigprog_config_t* conf, uint32_t size, uint32_t hop, jvxfs_sigproc_window_t window)
+{
+    conf_t* hdl = (conf_t*)conf;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Could not set STFT.");
+    }
+    /* Tapered windows are zero at the edge of the frame, without overlap that sample can not be restored. */
+    if (size < JVXFS_FFT_MIN_SIZE || size > JVXFS_FFT_MAX_SIZE || (size & (size - 1)) || !hop || hop > size ||
+        window < JVXFS_SP_WINDOW_HANN || window > JVXFS_SP_WINDOW_RECTANGULAR ||
+        (hop == size && window != JVXFS_SP_WINDOW_RECTANGULAR)) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Invalid STFT.");
+    }
+    hdl->stftSize = size;
+    hdl->stftHop = hop;
+    hdl->stftWindow = window;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+uint32_t jvxfs_sigproc_get_stft_size(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->stftSize;
+}
+
+uint32_t jvxfs_sigproc_get_stft_hop(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->stftHop;
+}
+
+jvxfs_sigproc_window_t jvxfs_sigproc_get_stft_window(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->stftWindow;
+}
+
+jvxfs_status_t jvxfs_sigproc_set_instance_pool(jvxfs_sigprog_config_t* conf, uint32_t prewarm, uint32_t maximum)
+{
+    conf_t* hdl = (conf_t*)conf;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG, "Could not set instance pool.");
+    }
+    if (maximum < prewarm) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_CONFIG,
+            "Maximum size of instance pool must not be below prewarmed instances.");
+    }
+    hdl->instPrewarm = prewarm;
+    hdl->instMaximum = maximum;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+uint32_t jvxfs_sigproc_get_instance_prewarm(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->instPrewarm;
+}
+
+uint32_t jvxfs_sigproc_get_instance_maximum(jvxfs_sigprog_config_t* conf)
+{
+    conf_t* hdl = (conf_t*)conf;
+    return hdl->instMaximum;
+}
+
+
+const rate_slot_t* find_rate(conf_t* hdl, uint32_t fs)
+{
+    if (!hdl->rates || !fs) return NULL;
+    uint32_t pos = (fs * 2654435761u) & hdl->ratesMask;
+    while (hdl->rates[pos].rate) {
+        if (hdl->rates[pos].rate == fs) return &hdl->rates[pos];
+        pos = (pos + 1) & hdl->ratesMask;
+    }
+    return NULL;
 }
\ No newline at end of file
@@ -31,13 +31,92 @@ jvxfs_status_t jvxfs_sigproc_allow_samplerates_detailed(jvxfs_sigprog_config_t*
 jvxfs_status_t jvxfs_sigproc_vallow_samplerates_detailed(jvxfs_sigprog_config_t* conf, size_t number, va_list args);
 bool jvxfs_sigproc_is_samplerate_allowed(jvxfs_sigprog_config_t* conf, uint32_t fs);
 
+/**
+ * @brief Profile of the app for a samplerate, looked up in constant time.
+ * @return @em NULL if @a fs is not allowed or the app has no profile function.
+ * @see jvxfs_app_set_sigproc_profile_func()
+ */
+const void* jvxfs_sigproc_get_profile(jvxfs_sigprog_config_t* conf, uint32_t fs);
+
+/**
+ * @brief Resample links with a samplerate not allowed to the nearest allowed samplerate.
+ */
+jvxfs_status_t jvxfs_sigproc_set_resampling(jvxfs_sigprog_config_t* conf, bool enable);
+bool jvxfs_sigproc_is_resampling(jvxfs_sigprog_config_t* conf);
+
+/**
+ * @brief Samplerate the algorithm runs at for a link.
+ * @param[in] conf     Configuration.
+ * @param[in] fs       Samplerate of the link.
+ * @param[in] samples  Frame size of the link.
+ * @return @a fs, if it is allowed or resampling is disabled. Otherwise the nearest allowed samplerate
+ * a frame maps to an integer number of samples for, the higher one on a tie.
+ */
+uint32_t jvxfs_sigproc_get_processing_samplerate(jvxfs_sigprog_config_t* conf, uint32_t fs, uint32_t samples);
+
 jvxfs_status_t jvxfs_sigproc_set_working_channel(jvxfs_sigprog_config_t* conf, jvxfs_sigproc_channel_t chan, jvxfs_sigproc_working_flag_t flags);
 jvxfs_sigproc_channel_t jvxfs_sigproc_get_working_channel(jvxfs_sigprog_config_t* conf);
 jvxfs_sigproc_buffer_t jvxfs_sigproc_buffers_channel(jvxfs_sigprog_config_t* conf);
 
+/**
+ * @brief Choose where the algorithm runs.
+ * @details #JVXFS_SP_EXEC_SYNC and #JVXFS_SP_EXEC_AUTO process on the media thread. #JVXFS_SP_EXEC_ASYNC
+ * processes on the worker threads of the module and adds one frame of latency. A frame not processed
+ * in time is passed through unprocessed.
+ */
+jvxfs_status_t jvxfs_sigproc_set_execution(jvxfs_sigprog_config_t* conf, jvxfs_sigproc_exec_t exec);
+jvxfs_sigproc_exec_t jvxfs_sigproc_get_execution(jvxfs_sigprog_config_t* conf);
+
 jvxfs_status_t jvxfs_sigproc_set_datatype(jvxfs_sigprog_config_t* conf, jvxfs_sigproc_datatype_t type);
 jvxfs_sigproc_datatype_t jvxfs_sigproc_get_datatype(jvxfs_sigprog_config_t* conf);
 
+/**
+ * @brief Declare the parameter block every processor of the app holds.
+ * @param[in] conf      Configuration.
+ * @param[in] size      Size of the block in bytes.
+ * @param[in] defaults  Initial values, copied into every new processor. @em NULL initializes with zero.
+ * @see jvxfs_sigproc_begin_update()
+ */
+jvxfs_status_t jvxfs_sigproc_set_parameters(jvxfs_sigprog_config_t* conf, size_t size, const void* defaults);
+size_t jvxfs_sigproc_get_parameter_size(jvxfs_sigprog_config_t* conf);
+const void* jvxfs_sigproc_get_parameter_defaults(jvxfs_sigprog_config_t* conf);
+
+/**
+ * @brief Run the algorithm on blocks of a fixed number of samples instead of the frames of the link.
+ * @details The processor collects the frames and calls the process function once per complete block, so it
+ * may be called several times or not at all during one frame. The output is delayed by B - gcd(F, B) samples
+ * for blocks of B and frames of F samples, see jvxfs_sigproc_get_block_latency(). @a samples of the media
+ * is the block size when the algorithm is constructed and initialized. Cannot be combined with a batch function.
+ * @param[in] conf     Configuration.
+ * @param[in] samples  Samples per channel of a block at the processing samplerate, 0 processes the frames as they are.
+ */
+jvxfs_status_t jvxfs_sigproc_set_block_size(jvxfs_sigprog_config_t* conf, uint32_t samples);
+uint32_t jvxfs_sigproc_get_block_size(jvxfs_sigprog_config_t* conf);
+
+/**
+ * @brief Geometry of the STFT the processor runs for a spectral function, see jvxfs_app_set_sigproc_spectral_func().
+ * @param[in] conf    Configuration.
+ * @param[in] size    FFT size, power of two.
+ * @param[in] hop     Samples per channel between two transforms, at most @a size, e.g. @a size / 2.
+ * @param[in] window  Analysis window, the synthesis window is derived from it. Has to be
+ *                    #JVXFS_SP_WINDOW_RECTANGULAR if @a hop is @a size.
+ */
+jvxfs_status_t jvxfs_sigproc_set_stft(jvxfs_sigprog_config_t* conf, uint32_t size, uint32_t hop, jvxfs_sigproc_window_t window);
+uint32_t jvxfs_sigproc_get_stft_size(jvxfs_sigprog_config_t* conf);
+uint32_t jvxfs_sigproc_get_stft_hop(jvxfs_sigprog_config_t* conf);
+jvxfs_sigproc_window_t jvxfs_sigproc_get_stft_window(jvxfs_sigprog_config_t* conf);
+
+/**
+ * @brief Number of algorithm instances the app keeps constructed for new calls.
+ * @param[in] conf     Configuration.
+ * @param[in] prewarm  Instances constructed when the module is loaded and kept ready afterwards.
+ * @param[in] maximum  Instances kept at most while many calls are set up.
+ * @details Only used if the app has a reset function, see jvxfs_app_set_sigproc_reset_func().
+ */
+jvxfs_status_t jvxfs_sigproc_set_instance_pool(jvxfs_sigprog_config_t* conf, uint32_t prewarm, uint32_t maximum);
+uint32_t jvxfs_sigproc_get_instance_prewarm(jvxfs_sigprog_config_t* conf);
+uint32_t jvxfs_sigproc_get_instance_maximum(jvxfs_sigprog_config_t* conf);
+
 JVX_FS_LIB_END
 
 #endif
\ No newline at end of file
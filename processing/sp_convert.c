@@ -0,0 +1,1075 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <math.h>
+#include <string.h>
+#if defined __x86_64__ || defined __i386__
+#include <immintrin.h>
+#define CONVERT_X86
+#endif
+#include "../system/error.h"
+#include "../utils/atomic.h"
+#include "sp_convert.h"
+
+#define TYPE_COUNT (JVXFS_SP_FLOAT32_LE + 1)
+#define FLOAT_SCALE 32768.0f
+#define FLOAT_MAX 32767.0f
+#define FLOAT_MIN -32768.0f
+#define SELF_CHECK_SAMPLES 333
+#define SELF_CHECK_GUARD 64
+
+typedef void(*from_func_t)(void*, const int16_t*, size_t);
+typedef void(*to_func_t)(int16_t*, const void*, size_t);
+
+typedef enum
+{
+    ISA_SCALAR,
+    ISA_SSE2,
+    ISA_AVX2,
+    ISA_AVX512,
+    ISA_COUNT
+} isa_t;
+
+typedef struct
+{
+    from_func_t from[TYPE_COUNT];
+    to_func_t to[TYPE_COUNT];
+} kernels_t;
+
+static void from_s16(void* dst, const int16_t* src, size_t n);
+static void from_s32(void* dst, const int16_t* src, size_t n);
+static void from_s64(void* dst, const int16_t* src, size_t n);
+static void from_s8(void* dst, const int16_t* src, size_t n);
+static void from_u16(void* dst, const int16_t* src, size_t n);
+static void from_u32(void* dst, const int16_t* src, size_t n);
+static void from_u64(void* dst, const int16_t* src, size_t n);
+static void from_u8(void* dst, const int16_t* src, size_t n);
+static void from_f32(void* dst, const int16_t* src, size_t n);
+static void to_s16(int16_t* dst, const void* src, size_t n);
+static void to_s32(int16_t* dst, const void* src, size_t n);
+static void to_s64(int16_t* dst, const void* src, size_t n);
+static void to_s8(int16_t* dst, const void* src, size_t n);
+static void to_u16(int16_t* dst, const void* src, size_t n);
+static void to_u32(int16_t* dst, const void* src, size_t n);
+static void to_u64(int16_t* dst, const void* src, size_t n);
+static void to_u8(int16_t* dst, const void* src, size_t n);
+static void to_f32(int16_t* dst, const void* src, size_t n);
+#if defined CONVERT_X86
+static void from_s32_sse2(void* dst, const int16_t* src, size_t n);
+static void from_u32_sse2(void* dst, const int16_t* src, size_t n);
+static void from_s64_sse2(void* dst, const int16_t* src, size_t n);
+static void from_u64_sse2(void* dst, const int16_t* src, size_t n);
+static void from_s8_sse2(void* dst, const int16_t* src, size_t n);
+static void from_u8_sse2(void* dst, const int16_t* src, size_t n);
+static void from_u16_sse2(void* dst, const int16_t* src, size_t n);
+static void from_f32_sse2(void* dst, const int16_t* src, size_t n);
+static void to_s32_sse2(int16_t* dst, const void* src, size_t n);
+static void to_u32_sse2(int16_t* dst, const void* src, size_t n);
+static void to_s8_sse2(int16_t* dst, const void* src, size_t n);
+static void to_u8_sse2(int16_t* dst, const void* src, size_t n);
+static void to_u16_sse2(int16_t* dst, const void* src, size_t n);
+static void to_f32_sse2(int16_t* dst, const void* src, size_t n);
+static void from_s32_avx2(void* dst, const int16_t* src, size_t n);
+static void from_u32_avx2(void* dst, const int16_t* src, size_t n);
+static void from_s64_avx2(void* dst, const int16_t* src, size_t n);
+static void from_u64_avx2(void* dst, const int16_t* src, size_t n);
+static void from_s8_avx2(void* dst, const int16_t* src, size_t n);
+static void from_u8_avx2(void* dst, const int16_t* src, size_t n);
+static void from_u16_avx2(void* dst, const int16_t* src, size_t n);
+static void from_f32_avx2(void* dst, const int16_t* src, size_t n);
+static void to_s32_avx2(int16_t* dst, const void* src, size_t n);
+static void to_u32_avx2(int16_t* dst, const void* src, size_t n);
+static void to_s64_avx2(int16_t* dst, const void* src, size_t n);
+static void to_u64_avx2(int16_t* dst, const void* src, size_t n);
+static void to_s8_avx2(int16_t* dst, const void* src, size_t n);
+static void to_u8_avx2(int16_t* dst, const void* src, size_t n);
+static void to_u16_avx2(int16_t* dst, const void* src, size_t n);
+static void to_f32_avx2(int16_t* dst, const void* src, size_t n);
+static void from_s32_avx512(void* dst, const int16_t* src, size_t n);
+static void from_u32_avx512(void* dst, const int16_t* src, size_t n);
+static void from_s64_avx512(void* dst, const int16_t* src, size_t n);
+static void from_u64_avx512(void* dst, const int16_t* src, size_t n);
+static void from_s8_avx512(void* dst, const int16_t* src, size_t n);
+static void from_u8_avx512(void* dst, const int16_t* src, size_t n);
+static void from_f32_avx512(void* dst, const int16_t* src, size_t n);
+static void to_s32_avx512(int16_t* dst, const void* src, size_t n);
+static void to_u32_avx512(int16_t* dst, const void* src, size_t n);
+static void to_s64_avx512(int16_t* dst, const void* src, size_t n);
+static void to_u64_avx512(int16_t* dst, const void* src, size_t n);
+static void to_s8_avx512(int16_t* dst, const void* src, size_t n);
+static void to_u8_avx512(int16_t* dst, const void* src, size_t n);
+static void to_f32_avx512(int16_t* dst, const void* src, size_t n);
+#endif
+static isa_t detect_isa(void);
+static void select_kernels(kernels_t* k, isa_t isa);
+static bool check_isa(isa_t isa);
+static isa_t exact_isa(isa_t isa);
+static int16_t saturate(int64_t val);
+static int16_t float_to_l16(float val);
+static uint32_t next_random(uint32_t* state);
+
+/* Kernels not available for an instruction set are NULL and taken from the next lower one. */
+static const kernels_t isaKernels[ISA_COUNT] = {
+    {
+        { NULL, from_s16, from_s16, from_s32, from_s64, from_s8, from_u16, from_u32, from_u64, from_u8, from_f32 },
+        { NULL, to_s16, to_s16, to_s32, to_s64, to_s8, to_u16, to_u32, to_u64, to_u8, to_f32 }
+    },
+#if defined CONVERT_X86
+    {
+        { NULL, NULL, NULL, from_s32_sse2, from_s64_sse2, from_s8_sse2, from_u16_sse2, from_u32_sse2, from_u64_sse2,
+            from_u8_sse2, from_f32_sse2 },
+        { NULL, NULL, NULL, to_s32_sse2, NULL, to_s8_sse2, to_u16_sse2, to_u32_sse2, NULL, to_u8_sse2, to_f32_sse2 }
+    },
+    {
+        { NULL, NULL, NULL, from_s32_avx2, from_s64_avx2, from_s8_avx2, from_u16_avx2, from_u32_avx2, from_u64_avx2,
+            from_u8_avx2, from_f32_avx2 },
+        { NULL, NULL, NULL, to_s32_avx2, to_s64_avx2, to_s8_avx2, to_u16_avx2, to_u32_avx2, to_u64_avx2, to_u8_avx2,
+            to_f32_avx2 }
+    },
+    {
+        { NULL, NULL, NULL, from_s32_avx512, from_s64_avx512, from_s8_avx512, NULL, from_u32_avx512, from_u64_avx512,
+            from_u8_avx512, from_f32_avx512 },
+        { NULL, NULL, NULL, to_s32_avx512, to_s64_avx512, to_s8_avx512, NULL, to_u32_avx512, to_u64_avx512,
+            to_u8_avx512, to_f32_avx512 }
+    }
+#endif
+};
+
+static const char* const isaNames[ISA_COUNT] = { "scalar", "sse2", "avx2", "avx512" };
+static const size_t sampleSizes[TYPE_COUNT] = { 0, 2, 2, 4, 8, 1, 2, 4, 8, 1, 4 };
+
+/* Resolved once, converting threads only load the pointer to the table in use, so a fallback is one swap. */
+static kernels_t tables[ISA_COUNT];
+static const kernels_t* active = NULL;
+static isa_t activeIsa = ISA_SCALAR;
+static uint32_t initState = 0;
+
+
+jvxfs_status_t jvxfs_convert_init(void)
+{
+    uint32_t expected = 0;
+    if (jvxfs_atomic_cas(&initState, &expected, 1)) {
+        isa_t detected = detect_isa();
+        for (int isa = ISA_SCALAR; isa <= (int)detected; ++isa) select_kernels(&tables[isa], (isa_t)isa);
+        isa_t isa = detected;
+#ifndef NDEBUG
+        /* Only checked by the first module, before any session converts. */
+        isa = exact_isa(detected);
+        if (isa != detected) {
+            switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING,
+                "SIMD sample conversion is not bit exact, falling back to %s.\n", isaNames[isa]);
+        }
+#endif
+        jvxfs_atomic_store(&activeIsa, isa);
+        jvxfs_atomic_store(&active, (const kernels_t*)&tables[isa]);
+        jvxfs_atomic_store(&initState, 2);
+    } else {
+        while (jvxfs_atomic_load(&initState) != 2) jvxfs_cpu_relax();
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_convert_self_check(jvxfs_error_t* err)
+{
+    jvxfs_convert_init();
+    isa_t detected = detect_isa();
+    isa_t isa = exact_isa(detected);
+    if (isa == detected) return JVXFS_STATUS_SUCCESS;
+    if (isa < jvxfs_atomic_load(&activeIsa)) {
+        jvxfs_atomic_store(&activeIsa, isa);
+        jvxfs_atomic_store(&active, (const kernels_t*)&tables[isa]);
+    }
+    if (!err) return JVXFS_STATUS_RESOURCE_EXCEPTION;
+    return jvxfs_error_set_error(err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_CONVERT,
+        "SIMD sample conversion is not bit exact, falling back to a lower instruction set.");
+}
+
+const char* jvxfs_convert_get_isa(void)
+{
+    return isaNames[jvxfs_atomic_load(&activeIsa)];
+}
+
+size_t jvxfs_convert_get_sample_size(jvxfs_sigproc_datatype_t type)
+{
+    if ((unsigned)type >= TYPE_COUNT) return 0;
+    return sampleSizes[type];
+}
+
+bool jvxfs_convert_is_needed(jvxfs_sigproc_datatype_t type)
+{
+    return type != JVXFS_SP_DATA && type != JVXFS_SP_16BIT_LE;
+}
+
+void jvxfs_convert_from_l16(void* dst, jvxfs_sigproc_datatype_t type, const int16_t* src, size_t samples)
+{
+    if (type == JVXFS_SP_NONE || (unsigned)type >= TYPE_COUNT) return;
+    const kernels_t* k = jvxfs_atomic_load(&active);
+    from_func_t func = k ? k->from[type] : isaKernels[ISA_SCALAR].from[type];
+    func(dst, src, samples);
+}
+
+void jvxfs_convert_to_l16(int16_t* dst, const void* src, jvxfs_sigproc_datatype_t type, size_t samples)
+{
+    if (type == JVXFS_SP_NONE || (unsigned)type >= TYPE_COUNT) return;
+    const kernels_t* k = jvxfs_atomic_load(&active);
+    to_func_t func = k ? k->to[type] : isaKernels[ISA_SCALAR].to[type];
+    func(dst, src, samples);
+}
+
+
+/* Scalar reference kernels. */
+
+void from_s16(void* dst, const int16_t* src, size_t n)
+{
+    if (dst != src) memcpy(dst, src, n * sizeof(int16_t));
+}
+
+void from_s32(void* dst, const int16_t* src, size_t n)
+{
+    int32_t* out = (int32_t*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = src[i];
+}
+
+void from_s64(void* dst, const int16_t* src, size_t n)
+{
+    int64_t* out = (int64_t*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = src[i];
+}
+
+void from_s8(void* dst, const int16_t* src, size_t n)
+{
+    int8_t* out = (int8_t*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = (int8_t)(src[i] >> 8);
+}
+
+void from_u16(void* dst, const int16_t* src, size_t n)
+{
+    uint16_t* out = (uint16_t*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = (uint16_t)src[i] ^ 0x8000u;
+}
+
+void from_u32(void* dst, const int16_t* src, size_t n)
+{
+    uint32_t* out = (uint32_t*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = (uint32_t)(int32_t)src[i] ^ 0x80000000u;
+}
+
+void from_u64(void* dst, const int16_t* src, size_t n)
+{
+    uint64_t* out = (uint64_t*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = (uint64_t)(int64_t)src[i] ^ 0x8000000000000000ull;
+}
+
+void from_u8(void* dst, const int16_t* src, size_t n)
+{
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = (uint8_t)(src[i] >> 8) ^ 0x80u;
+}
+
+void from_f32(void* dst, const int16_t* src, size_t n)
+{
+    float* out = (float*)dst;
+    for (size_t i = 0; i < n; ++i) out[i] = (float)src[i] * (1.0f / FLOAT_SCALE);
+}
+
+void to_s16(int16_t* dst, const void* src, size_t n)
+{
+    if (dst != src) memcpy(dst, src, n * sizeof(int16_t));
+}
+
+void to_s32(int16_t* dst, const void* src, size_t n)
+{
+    const int32_t* in = (const int32_t*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = saturate(in[i]);
+}
+
+void to_s64(int16_t* dst, const void* src, size_t n)
+{
+    const int64_t* in = (const int64_t*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = saturate(in[i]);
+}
+
+void to_s8(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = (int16_t)(uint16_t)(in[i] << 8);
+}
+
+void to_u16(int16_t* dst, const void* src, size_t n)
+{
+    const uint16_t* in = (const uint16_t*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = (int16_t)(in[i] ^ 0x8000u);
+}
+
+void to_u32(int16_t* dst, const void* src, size_t n)
+{
+    const uint32_t* in = (const uint32_t*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = saturate((int32_t)(in[i] ^ 0x80000000u));
+}
+
+void to_u64(int16_t* dst, const void* src, size_t n)
+{
+    const uint64_t* in = (const uint64_t*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = saturate((int64_t)(in[i] ^ 0x8000000000000000ull));
+}
+
+void to_u8(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = (int16_t)(uint16_t)((in[i] ^ 0x80u) << 8);
+}
+
+void to_f32(int16_t* dst, const void* src, size_t n)
+{
+    const float* in = (const float*)src;
+    for (size_t i = 0; i < n; ++i) dst[i] = float_to_l16(in[i]);
+}
+
+#if defined CONVERT_X86
+
+/* SSE2 kernels, 8 samples per iteration (16 for 8 bit types). */
+
+__attribute__((target("sse2")))
+void from_s32_sse2(void* dst, const int16_t* src, size_t n)
+{
+    int32_t* out = (int32_t*)dst;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i sign = _mm_srai_epi16(v, 15);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(v, sign));
+        _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(v, sign));
+    }
+    from_s32(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void from_u32_sse2(void* dst, const int16_t* src, size_t n)
+{
+    uint32_t* out = (uint32_t*)dst;
+    const __m128i offset = _mm_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i sign = _mm_srai_epi16(v, 15);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(_mm_unpacklo_epi16(v, sign), offset));
+        _mm_storeu_si128((__m128i*)(out + i + 4), _mm_xor_si128(_mm_unpackhi_epi16(v, sign), offset));
+    }
+    from_u32(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void from_s64_sse2(void* dst, const int16_t* src, size_t n)
+{
+    int64_t* out = (int64_t*)dst;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i sign = _mm_srai_epi16(v, 15);
+        __m128i lo = _mm_unpacklo_epi16(v, sign);
+        __m128i hi = _mm_unpackhi_epi16(v, sign);
+        __m128i signLo = _mm_srai_epi32(lo, 31);
+        __m128i signHi = _mm_srai_epi32(hi, 31);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi32(lo, signLo));
+        _mm_storeu_si128((__m128i*)(out + i + 2), _mm_unpackhi_epi32(lo, signLo));
+        _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpacklo_epi32(hi, signHi));
+        _mm_storeu_si128((__m128i*)(out + i + 6), _mm_unpackhi_epi32(hi, signHi));
+    }
+    from_s64(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void from_u64_sse2(void* dst, const int16_t* src, size_t n)
+{
+    uint64_t* out = (uint64_t*)dst;
+    const __m128i offset = _mm_set_epi32(INT32_MIN, 0, INT32_MIN, 0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i sign = _mm_srai_epi16(v, 15);
+        __m128i lo = _mm_unpacklo_epi16(v, sign);
+        __m128i hi = _mm_unpackhi_epi16(v, sign);
+        __m128i signLo = _mm_srai_epi32(lo, 31);
+        __m128i signHi = _mm_srai_epi32(hi, 31);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(_mm_unpacklo_epi32(lo, signLo), offset));
+        _mm_storeu_si128((__m128i*)(out + i + 2), _mm_xor_si128(_mm_unpackhi_epi32(lo, signLo), offset));
+        _mm_storeu_si128((__m128i*)(out + i + 4), _mm_xor_si128(_mm_unpacklo_epi32(hi, signHi), offset));
+        _mm_storeu_si128((__m128i*)(out + i + 6), _mm_xor_si128(_mm_unpackhi_epi32(hi, signHi), offset));
+    }
+    from_u64(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void from_s8_sse2(void* dst, const int16_t* src, size_t n)
+{
+    int8_t* out = (int8_t*)dst;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)(src + i)), 8);
+        __m128i b = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)(src + i + 8)), 8);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi16(a, b));
+    }
+    from_s8(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void from_u8_sse2(void* dst, const int16_t* src, size_t n)
+{
+    uint8_t* out = (uint8_t*)dst;
+    const __m128i offset = _mm_set1_epi8((char)0x80);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)(src + i)), 8);
+        __m128i b = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)(src + i + 8)), 8);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(_mm_packs_epi16(a, b), offset));
+    }
+    from_u8(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void from_u16_sse2(void* dst, const int16_t* src, size_t n)
+{
+    uint16_t* out = (uint16_t*)dst;
+    const __m128i offset = _mm_set1_epi16(INT16_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(v, offset));
+    }
+    from_u16(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void from_f32_sse2(void* dst, const int16_t* src, size_t n)
+{
+    float* out = (float*)dst;
+    const __m128 scale = _mm_set1_ps(1.0f / FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i sign = _mm_srai_epi16(v, 15);
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, sign));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, sign));
+        _mm_storeu_ps(out + i, _mm_mul_ps(lo, scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(hi, scale));
+    }
+    from_f32(out + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void to_s32_sse2(int16_t* dst, const void* src, size_t n)
+{
+    const int32_t* in = (const int32_t*)src;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(in + i + 4));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+    }
+    to_s32(dst + i, in + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void to_u32_sse2(int16_t* dst, const void* src, size_t n)
+{
+    const uint32_t* in = (const uint32_t*)src;
+    const __m128i offset = _mm_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + i)), offset);
+        __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + i + 4)), offset);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+    }
+    to_u32(dst + i, in + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void to_s8_sse2(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpackhi_epi8(zero, v));
+    }
+    to_s8(dst + i, in + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void to_u8_sse2(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi8((char)0x80);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + i)), offset);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpackhi_epi8(zero, v));
+    }
+    to_u8(dst + i, in + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void to_u16_sse2(int16_t* dst, const void* src, size_t n)
+{
+    const uint16_t* in = (const uint16_t*)src;
+    const __m128i offset = _mm_set1_epi16(INT16_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, offset));
+    }
+    to_u16(dst + i, in + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void to_f32_sse2(int16_t* dst, const void* src, size_t n)
+{
+    const float* in = (const float*)src;
+    const __m128 scale = _mm_set1_ps(FLOAT_SCALE);
+    const __m128 maxVal = _mm_set1_ps(FLOAT_MAX);
+    const __m128 minVal = _mm_set1_ps(FLOAT_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        /* min/max return the second operand for NaN, like the comparisons in float_to_l16(). */
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), scale);
+        a = _mm_max_ps(_mm_min_ps(a, maxVal), minVal);
+        b = _mm_max_ps(_mm_min_ps(b, maxVal), minVal);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+    to_f32(dst + i, in + i, n - i);
+}
+
+/* AVX2 kernels, 16 samples per iteration (32 for 8 bit types, 8 for saturating 64 bit types). */
+
+__attribute__((target("avx2")))
+void from_s32_avx2(void* dst, const int16_t* src, size_t n)
+{
+    int32_t* out = (int32_t*)dst;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+        _mm256_storeu_si256((__m256i*)(out + i), a);
+        _mm256_storeu_si256((__m256i*)(out + i + 8), b);
+    }
+    from_s32(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void from_u32_avx2(void* dst, const int16_t* src, size_t n)
+{
+    uint32_t* out = (uint32_t*)dst;
+    const __m256i offset = _mm256_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(a, offset));
+        _mm256_storeu_si256((__m256i*)(out + i + 8), _mm256_xor_si256(b, offset));
+    }
+    from_u32(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void from_s64_avx2(void* dst, const int16_t* src, size_t n)
+{
+    int64_t* out = (int64_t*)dst;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (size_t j = 0; j < 16; j += 4) {
+            __m256i v = _mm256_cvtepi16_epi64(_mm_loadl_epi64((const __m128i*)(src + i + j)));
+            _mm256_storeu_si256((__m256i*)(out + i + j), v);
+        }
+    }
+    from_s64(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void from_u64_avx2(void* dst, const int16_t* src, size_t n)
+{
+    uint64_t* out = (uint64_t*)dst;
+    const __m256i offset = _mm256_set1_epi64x(INT64_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        for (size_t j = 0; j < 16; j += 4) {
+            __m256i v = _mm256_cvtepi16_epi64(_mm_loadl_epi64((const __m128i*)(src + i + j)));
+            _mm256_storeu_si256((__m256i*)(out + i + j), _mm256_xor_si256(v, offset));
+        }
+    }
+    from_u64(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void from_s8_avx2(void* dst, const int16_t* src, size_t n)
+{
+    int8_t* out = (int8_t*)dst;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i*)(src + i)), 8);
+        __m256i b = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i*)(src + i + 16)), 8);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+    from_s8(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void from_u8_avx2(void* dst, const int16_t* src, size_t n)
+{
+    uint8_t* out = (uint8_t*)dst;
+    const __m256i offset = _mm256_set1_epi8((char)0x80);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i*)(src + i)), 8);
+        __m256i b = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i*)(src + i + 16)), 8);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(v, offset));
+    }
+    from_u8(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void from_u16_avx2(void* dst, const int16_t* src, size_t n)
+{
+    uint16_t* out = (uint16_t*)dst;
+    const __m256i offset = _mm256_set1_epi16(INT16_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(v, offset));
+    }
+    from_u16(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void from_f32_avx2(void* dst, const int16_t* src, size_t n)
+{
+    float* out = (float*)dst;
+    const __m256 scale = _mm256_set1_ps(1.0f / FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i))));
+        __m256 b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8))));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(a, scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(b, scale));
+    }
+    from_f32(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void to_s32_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const int32_t* in = (const int32_t*)src;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(in + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(in + i + 8));
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+    to_s32(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void to_u32_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const uint32_t* in = (const uint32_t*)src;
+    const __m256i offset = _mm256_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(in + i)), offset);
+        __m256i b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(in + i + 8)), offset);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+    to_u32(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m128i saturate_s64_avx2(__m256i v)
+{
+    const __m256i maxVal = _mm256_set1_epi64x(INT16_MAX);
+    const __m256i minVal = _mm256_set1_epi64x(INT16_MIN);
+    const __m256i lowWords = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    v = _mm256_blendv_epi8(v, maxVal, _mm256_cmpgt_epi64(v, maxVal));
+    v = _mm256_blendv_epi8(v, minVal, _mm256_cmpgt_epi64(minVal, v));
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, lowWords));
+}
+
+__attribute__((target("avx2")))
+void to_s64_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const int64_t* in = (const int64_t*)src;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = saturate_s64_avx2(_mm256_loadu_si256((const __m256i*)(in + i)));
+        __m128i b = saturate_s64_avx2(_mm256_loadu_si256((const __m256i*)(in + i + 4)));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+    }
+    to_s64(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void to_u64_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const uint64_t* in = (const uint64_t*)src;
+    const __m256i offset = _mm256_set1_epi64x(INT64_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(in + i)), offset);
+        __m256i b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(in + i + 4)), offset);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(saturate_s64_avx2(a), saturate_s64_avx2(b)));
+    }
+    to_u64(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void to_s8_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(in + i)));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_slli_epi16(v, 8));
+    }
+    to_s8(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void to_u8_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    const __m128i offset = _mm_set1_epi8((char)0x80);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + i)), offset);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_slli_epi16(_mm256_cvtepi8_epi16(v), 8));
+    }
+    to_u8(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void to_u16_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const uint16_t* in = (const uint16_t*)src;
+    const __m256i offset = _mm256_set1_epi16(INT16_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(v, offset));
+    }
+    to_u16(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void to_f32_avx2(int16_t* dst, const void* src, size_t n)
+{
+    const float* in = (const float*)src;
+    const __m256 scale = _mm256_set1_ps(FLOAT_SCALE);
+    const __m256 maxVal = _mm256_set1_ps(FLOAT_MAX);
+    const __m256 minVal = _mm256_set1_ps(FLOAT_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale);
+        a = _mm256_max_ps(_mm256_min_ps(a, maxVal), minVal);
+        b = _mm256_max_ps(_mm256_min_ps(b, maxVal), minVal);
+        __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    to_f32(dst + i, in + i, n - i);
+}
+
+/* AVX-512 kernels, 16 samples per iteration, only AVX-512F instructions are used. */
+
+__attribute__((target("avx512f")))
+void from_s32_avx512(void* dst, const int16_t* src, size_t n)
+{
+    int32_t* out = (int32_t*)dst;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(src + i)));
+        _mm512_storeu_si512((void*)(out + i), v);
+    }
+    from_s32(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void from_u32_avx512(void* dst, const int16_t* src, size_t n)
+{
+    uint32_t* out = (uint32_t*)dst;
+    const __m512i offset = _mm512_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(src + i)));
+        _mm512_storeu_si512((void*)(out + i), _mm512_xor_si512(v, offset));
+    }
+    from_u32(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void from_s64_avx512(void* dst, const int16_t* src, size_t n)
+{
+    int64_t* out = (int64_t*)dst;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i a = _mm512_cvtepi16_epi64(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m512i b = _mm512_cvtepi16_epi64(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+        _mm512_storeu_si512((void*)(out + i), a);
+        _mm512_storeu_si512((void*)(out + i + 8), b);
+    }
+    from_s64(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void from_u64_avx512(void* dst, const int16_t* src, size_t n)
+{
+    uint64_t* out = (uint64_t*)dst;
+    const __m512i offset = _mm512_set1_epi64(INT64_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i a = _mm512_cvtepi16_epi64(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m512i b = _mm512_cvtepi16_epi64(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+        _mm512_storeu_si512((void*)(out + i), _mm512_xor_si512(a, offset));
+        _mm512_storeu_si512((void*)(out + i + 8), _mm512_xor_si512(b, offset));
+    }
+    from_u64(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void from_s8_avx512(void* dst, const int16_t* src, size_t n)
+{
+    int8_t* out = (int8_t*)dst;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(src + i)));
+        _mm_storeu_si128((__m128i*)(out + i), _mm512_cvtepi32_epi8(_mm512_srai_epi32(v, 8)));
+    }
+    from_s8(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void from_u8_avx512(void* dst, const int16_t* src, size_t n)
+{
+    uint8_t* out = (uint8_t*)dst;
+    const __m128i offset = _mm_set1_epi8((char)0x80);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(src + i)));
+        __m128i b = _mm512_cvtepi32_epi8(_mm512_srai_epi32(v, 8));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(b, offset));
+    }
+    from_u8(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void from_f32_avx512(void* dst, const int16_t* src, size_t n)
+{
+    float* out = (float*)dst;
+    const __m512 scale = _mm512_set1_ps(1.0f / FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(src + i))));
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(v, scale));
+    }
+    from_f32(out + i, src + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void to_s32_avx512(int16_t* dst, const void* src, size_t n)
+{
+    const int32_t* in = (const int32_t*)src;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void*)(in + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtsepi32_epi16(v));
+    }
+    to_s32(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void to_u32_avx512(int16_t* dst, const void* src, size_t n)
+{
+    const uint32_t* in = (const uint32_t*)src;
+    const __m512i offset = _mm512_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_xor_si512(_mm512_loadu_si512((const void*)(in + i)), offset);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtsepi32_epi16(v));
+    }
+    to_u32(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void to_s64_avx512(int16_t* dst, const void* src, size_t n)
+{
+    const int64_t* in = (const int64_t*)src;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i a = _mm512_loadu_si512((const void*)(in + i));
+        __m512i b = _mm512_loadu_si512((const void*)(in + i + 8));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm512_cvtsepi64_epi16(a));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm512_cvtsepi64_epi16(b));
+    }
+    to_s64(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void to_u64_avx512(int16_t* dst, const void* src, size_t n)
+{
+    const uint64_t* in = (const uint64_t*)src;
+    const __m512i offset = _mm512_set1_epi64(INT64_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i a = _mm512_xor_si512(_mm512_loadu_si512((const void*)(in + i)), offset);
+        __m512i b = _mm512_xor_si512(_mm512_loadu_si512((const void*)(in + i + 8)), offset);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm512_cvtsepi64_epi16(a));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm512_cvtsepi64_epi16(b));
+    }
+    to_u64(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void to_s8_avx512(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_slli_epi32(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(in + i))), 8);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtepi32_epi16(v));
+    }
+    to_s8(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void to_u8_avx512(int16_t* dst, const void* src, size_t n)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    const __m128i offset = _mm_set1_epi8((char)0x80);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + i)), offset);
+        __m512i v = _mm512_slli_epi32(_mm512_cvtepi8_epi32(b), 8);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtepi32_epi16(v));
+    }
+    to_u8(dst + i, in + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void to_f32_avx512(int16_t* dst, const void* src, size_t n)
+{
+    const float* in = (const float*)src;
+    const __m512 scale = _mm512_set1_ps(FLOAT_SCALE);
+    const __m512 maxVal = _mm512_set1_ps(FLOAT_MAX);
+    const __m512 minVal = _mm512_set1_ps(FLOAT_MIN);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_mul_ps(_mm512_loadu_ps(in + i), scale);
+        v = _mm512_max_ps(_mm512_min_ps(v, maxVal), minVal);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtepi32_epi16(_mm512_cvtps_epi32(v)));
+    }
+    to_f32(dst + i, in + i, n - i);
+}
+
+#endif
+
+isa_t detect_isa(void)
+{
+#if defined CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return ISA_AVX512;
+    if (__builtin_cpu_supports("avx2")) return ISA_AVX2;
+    if (__builtin_cpu_supports("sse2")) return ISA_SSE2;
+#endif
+    return ISA_SCALAR;
+}
+
+void select_kernels(kernels_t* k, isa_t isa)
+{
+    *k = isaKernels[ISA_SCALAR];
+    for (int level = ISA_SCALAR + 1; level <= (int)isa; ++level) {
+        for (int t = 0; t < TYPE_COUNT; ++t) {
+            if (isaKernels[level].from[t]) k->from[t] = isaKernels[level].from[t];
+            if (isaKernels[level].to[t]) k->to[t] = isaKernels[level].to[t];
+        }
+    }
+}
+
+isa_t exact_isa(isa_t isa)
+{
+    for (int level = ISA_SSE2; level <= (int)isa; ++level) {
+        if (!check_isa((isa_t)level)) return (isa_t)(level - 1);
+    }
+    return isa;
+}
+
+bool check_isa(isa_t isa)
+{
+    int16_t pcm[SELF_CHECK_SAMPLES];
+    uint8_t raw[SELF_CHECK_SAMPLES * sizeof(int64_t) + SELF_CHECK_GUARD] JVXFS_CACHE_ALIGNED;
+    uint8_t ref[SELF_CHECK_SAMPLES * sizeof(int64_t) + SELF_CHECK_GUARD] JVXFS_CACHE_ALIGNED;
+    uint8_t out[SELF_CHECK_SAMPLES * sizeof(int64_t) + SELF_CHECK_GUARD] JVXFS_CACHE_ALIGNED;
+    const kernels_t* simd = &isaKernels[isa];
+    const kernels_t* scalar = &isaKernels[ISA_SCALAR];
+    uint32_t seed = 0x6a766678u;
+    static const int16_t edges[] = { INT16_MIN, INT16_MIN + 1, -257, -256, -255, -1, 0, 1, 255, 256, 257,
+        INT16_MAX - 1, INT16_MAX };
+    for (size_t i = 0; i < SELF_CHECK_SAMPLES; ++i) {
+        pcm[i] = (i < sizeof(edges) / sizeof(edges[0])) ? edges[i] : (int16_t)next_random(&seed);
+    }
+    for (size_t i = 0; i < sizeof(raw); ++i) raw[i] = (uint8_t)next_random(&seed);
+    /* Half of the float input is in the audio range, the random half covers NaN, infinity and overflow. */
+    float* rawFloat = (float*)raw;
+    for (size_t i = 0; i < SELF_CHECK_SAMPLES / 2; ++i) {
+        rawFloat[i] = ((float)(int32_t)next_random(&seed) / 2147483648.0f) * 1.25f;
+    }
+    for (int t = JVXFS_SP_NONE + 1; t < TYPE_COUNT; ++t) {
+        /* All lengths from 0 cover every tail, the offset checks unaligned buffers. */
+        for (size_t n = 0; n <= SELF_CHECK_SAMPLES - 1; n += (n < 80) ? 1 : 37) {
+            size_t offset = n & 1;
+            if (simd->from[t]) {
+                memset(ref, 0xa5, sizeof(ref));
+                memset(out, 0xa5, sizeof(out));
+                scalar->from[t](ref + offset * sampleSizes[t], pcm + offset, n);
+                simd->from[t](out + offset * sampleSizes[t], pcm + offset, n);
+                if (memcmp(ref, out, sizeof(ref)) != 0) return false;
+            }
+            if (simd->to[t]) {
+                memset(ref, 0xa5, sizeof(ref));
+                memset(out, 0xa5, sizeof(out));
+                scalar->to[t]((int16_t*)ref + offset, raw + offset * sampleSizes[t], n);
+                simd->to[t]((int16_t*)out + offset, raw + offset * sampleSizes[t], n);
+                if (memcmp(ref, out, sizeof(ref)) != 0) return false;
+            }
+        }
+    }
+    return true;
+}
+
+int16_t saturate(int64_t val)
+{
+    if (val > INT16_MAX) return INT16_MAX;
+    if (val < INT16_MIN) return INT16_MIN;
+    return (int16_t)val;
+}
+
+int16_t float_to_l16(float val)
+{
+    /* Same clamping and rounding as the SIMD kernels, NaN ends up at the positive limit. */
+    float v = val * FLOAT_SCALE;
+    v = (v < FLOAT_MAX) ? v : FLOAT_MAX;
+    v = (v > FLOAT_MIN) ? v : FLOAT_MIN;
+    return (int16_t)lrintf(v);
+}
+
+uint32_t next_random(uint32_t* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return (*state >> 8) ^ (*state << 13);
+}
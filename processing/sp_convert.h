@@ -0,0 +1,96 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file sp_convert.h
+ * @brief Conversion between the L16 samples of Freeswitch and the datatypes of the algorithms.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-15
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_CONVERT_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_CONVERT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <switch.h>
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup processing Signal Processing
+ * @{
+ * @defgroup convert Sample Conversion
+ * @details Signed integer types keep the value of the L16 sample, so wider types offer headroom.
+ * Unsigned types are offset binary, 8 bit types hold the upper byte of the L16 sample and
+ * #JVXFS_SP_FLOAT32_LE is scaled to [-1, 1). Conversion back to L16 saturates.
+ * The kernels (scalar, SSE2, AVX2 or AVX-512) are selected by the features of the CPU
+ * when the first module is loaded.
+ * @{
+ */
+
+/**
+ * @brief Select the conversion kernels for this CPU.
+ * @return Status code.
+ * @details Called by the framework when a module is loaded, only the first call selects. If NDEBUG is not
+ * defined, the kernels are checked like jvxfs_convert_self_check() before they are used, a fallback is
+ * logged and does not keep the module from loading.
+ */
+jvxfs_status_t jvxfs_convert_init(void);
+
+/**
+ * @brief Check every available SIMD kernel for bit exactness against the scalar reference.
+ * @param[in] err Error handler the result is reported to, @em NULL to only return it.
+ * @return Status code.
+ * @details If a kernel fails, the conversion falls back to the highest instruction set passing the check.
+ * The fallback is published atomically, so it may be called while other threads convert.
+ */
+jvxfs_status_t jvxfs_convert_self_check(jvxfs_error_t* err);
+
+/**
+ * @brief Name of the instruction set used for conversion.
+ */
+const char* jvxfs_convert_get_isa(void);
+
+/**
+ * @brief Size of one sample in bytes, 0 if the datatype can not be converted.
+ */
+size_t jvxfs_convert_get_sample_size(jvxfs_sigproc_datatype_t type);
+
+/**
+ * @brief Check if frames have to be converted for the datatype.
+ * @return False for L16 and #JVXFS_SP_DATA, which are handed to the algorithm unchanged.
+ */
+bool jvxfs_convert_is_needed(jvxfs_sigproc_datatype_t type);
+
+/**
+ * @brief Convert L16 samples to a datatype.
+ * @param[out] dst     Destination buffer, @a samples * jvxfs_convert_get_sample_size() bytes.
+ * @param[in] type     Datatype of the destination.
+ * @param[in] src      L16 samples.
+ * @param[in] samples  Number of samples (all channels).
+ */
+void jvxfs_convert_from_l16(void* dst, jvxfs_sigproc_datatype_t type, const int16_t* src, size_t samples);
+
+/**
+ * @brief Convert samples of a datatype to L16 with saturation.
+ * @param[out] dst     L16 samples.
+ * @param[in] src      Source buffer, @a samples * jvxfs_convert_get_sample_size() bytes.
+ * @param[in] type     Datatype of the source.
+ * @param[in] samples  Number of samples (all channels).
+ */
+void jvxfs_convert_to_l16(int16_t* dst, const void* src, jvxfs_sigproc_datatype_t type, size_t samples);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
@@ -14,10 +14,14 @@
 #ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_DEFINES_H
 #define LIB_JVX_FS_FRAMEWORK_PROCESSING_DEFINES_H
 
+#include <stdint.h>
 #include "../system/defines.h"
+#include "../utils/arena.h"
 
 JVX_FS_LIB_BEGIN
 
+#define JVXFS_SP_MEMORY_ALIGNMENT 64
+
 typedef void jvxfs_channel_model_t;
 
 typedef enum
@@ -31,7 +35,8 @@ typedef enum
     JVXFS_SP_U16BIT_LE,
     JVXFS_SP_U32BIT_LE,
     JVXFS_SP_U64BIT_LE,
-    JVXFS_SP_U8BIT
+    JVXFS_SP_U8BIT,
+    JVXFS_SP_FLOAT32_LE
 } jvxfs_sigproc_datatype_t;
 
 typedef enum
@@ -62,6 +67,88 @@ typedef enum
     JVXFS_SP_ALGO_MUTE
 } jvxfs_sigproc_algo_mode_t;
 
+typedef enum
+{
+    JVXFS_SP_WINDOW_HANN,
+    JVXFS_SP_WINDOW_SQRT_HANN,
+    JVXFS_SP_WINDOW_RECTANGULAR
+} jvxfs_sigproc_window_t;
+
+/**
+ * @brief Frame descriptor handed to the algorithm functions.
+ * @details @a data points to @a samples * @a channels interleaved samples of type @a type.
+ * The buffer is aligned to #JVXFS_SP_MEMORY_ALIGNMENT bytes and padded to a multiple of it,
+ * so it can be processed in place with aligned SIMD loads and stores.
+ * If both links are buffered, @a reference holds the time aligned frame of the opposite link
+ * (read only), @a reference_delay its estimated delay in samples of the reference link and
+ * @a reference_drift the estimated clock drift of the reference link in ppm.
+ * @a parameters points to the parameter block of the session (read only), if the app declared one.
+ * It only changes between two frames.
+ * @a config points to the current configuration block of the module, see jvxfs_config_acquire(). It is
+ * read again before each frame and must not be kept longer.
+ * @a profile points to the profile of the app for @a rate (read only), see jvxfs_app_set_sigproc_profile_func().
+ * It is @em NULL if the app has no profile function or @a rate is not allowed.
+ * An algorithm needing temporary memory while processing a frame declares the number of bytes in
+ * @a scratch_size when it is constructed or initialized. @a scratch is then an arena of that size,
+ * reset before every frame, to be used instead of the heap.
+ */
+struct jvxfs_sigproc_media
+{
+    void* data;
+    uint32_t samples;
+    uint32_t rate;
+    uint8_t channels;
+    jvxfs_sigproc_datatype_t type;
+    jvxfs_sigproc_channel_t link;
+    uint64_t sequence;
+    const jvxfs_sigproc_media_t* reference;
+    int32_t reference_delay;
+    int32_t reference_drift;
+    const void* parameters;
+    const jvxfs_config_block_t* config;
+    const void* profile;
+    jvxfs_arena_t* scratch;
+    size_t scratch_size;
+};
+
+/**
+ * @brief Frames of several sessions of one app handed to the batch function in one call.
+ * @details All frames share @a samples, @a channels, @a rate and @a type. Value k of the interleaved
+ * frame of session s is stored at index k * @a stride + s of @a data, so the same sample of all sessions
+ * is contiguous and can be processed with one vector operation. @a stride is @a sessions rounded up so
+ * every row starts aligned to #JVXFS_SP_MEMORY_ALIGNMENT bytes, the padding lanes are zero.
+ * Instance s of the instance array belongs to @a media[s], whose @a data is not valid during the call.
+ */
+struct jvxfs_sigproc_batch
+{
+    void* data;
+    uint32_t sessions;
+    uint32_t stride;
+    uint32_t samples;
+    uint32_t rate;
+    uint8_t channels;
+    jvxfs_sigproc_datatype_t type;
+    jvxfs_sigproc_media_t* const* media;
+};
+
+/**
+ * @brief Spectrum of one hop handed to the spectral process function.
+ * @details @a bins holds @a count = @a size / 2 + 1 complex bins (re, im) of the windowed last @a size samples
+ * of each channel, channel c starting at @a bins + c * @a stride. The bins are modified in place and
+ * transformed back after the call. @a media describes the hop of @a hop samples in the time domain, its
+ * @a data is not valid during the call.
+ */
+struct jvxfs_sigproc_spectrum
+{
+    float* bins;
+    uint32_t count;
+    uint32_t stride;
+    uint32_t size;
+    uint32_t hop;
+    uint8_t channels;
+    const jvxfs_sigproc_media_t* media;
+};
+
 JVX_FS_LIB_END
 
 #endif
\ No newline at end of file
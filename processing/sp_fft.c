@@ -0,0 +1,521 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../system/error.h"
+#include "../utils/atomic.h"
+#include "sp_channel_model.h"
+#include "sp_fft.h"
+
+#define FFT_PI 3.14159265358979323846
+#define MAX_LOG2 16
+#define WISDOM_MIN_LOG2 4
+#define WISDOM_MAX_LOG2 12
+#define WISDOM_REPETITIONS 3
+#define WISDOM_POINTS_PER_RUN (1 << 18)
+
+typedef enum
+{
+    KERNEL_RADIX2,
+    KERNEL_RADIX4,
+#if defined __SSE2__
+    KERNEL_RADIX2_SSE2,
+    KERNEL_RADIX4_SSE2,
+#endif
+    KERNEL_COUNT
+} kernel_t;
+
+typedef struct plan_s
+{
+    uint32_t size;
+    uint32_t log2;
+    jvxfs_fft_direction_t dir;
+    jvxfs_fft_kind_t kind;
+    kernel_t kernel;
+    uint32_t* bitrev;
+    float* tw2;
+    float* tw4;
+    float* twReal;
+    struct plan_s* sub;
+    float scale;
+} plan_t;
+
+typedef void(*kernel_func_t)(const plan_t*, float*);
+
+static void radix2_scalar(const plan_t* p, float* x);
+static void radix4_scalar(const plan_t* p, float* x);
+#if defined __SSE2__
+static void radix2_sse2(const plan_t* p, float* x);
+static void radix4_sse2(const plan_t* p, float* x);
+#endif
+static plan_t* build_plan(uint32_t log2, jvxfs_fft_direction_t dir, jvxfs_fft_kind_t kind);
+static void free_plan(plan_t* p);
+static void run_complex(const plan_t* p, const float* in, float* out);
+static void run_real_forward(const plan_t* p, const float* in, float* out);
+static void run_real_inverse(const plan_t* p, const float* in, float* out);
+static void measure_wisdom(void);
+static uint32_t size_to_log2(uint32_t size);
+
+static const kernel_func_t kernels[KERNEL_COUNT] = {
+    radix2_scalar,
+    radix4_scalar,
+#if defined __SSE2__
+    radix2_sse2,
+    radix4_sse2
+#endif
+};
+
+static plan_t* cache[MAX_LOG2 + 1][2][2];
+static kernel_t wisdom[MAX_LOG2 + 1];
+static uint32_t users = 0;
+static uint32_t buildLock = 0;
+
+
+jvxfs_status_t jvxfs_fft_init(void)
+{
+    if (jvxfs_atomic_fetch_add(&users, 1) == 0) {
+        measure_wisdom();
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_fft_shutdown(void)
+{
+    if (jvxfs_atomic_fetch_sub(&users, 1) != 1) return;
+    for (size_t i = 0; i <= MAX_LOG2; ++i) {
+        for (size_t d = 0; d < 2; ++d) {
+            for (size_t k = 0; k < 2; ++k) {
+                plan_t* p = jvxfs_atomic_exchange(&cache[i][d][k], NULL);
+                if (p) free_plan(p);
+            }
+        }
+    }
+}
+
+jvxfs_status_t jvxfs_fft_get_plan(const jvxfs_fft_plan_t** plan, uint32_t size, jvxfs_fft_direction_t dir,
+    jvxfs_fft_kind_t kind, jvxfs_error_t* err)
+{
+    *plan = NULL;
+    uint32_t log2 = size_to_log2(size);
+    if (!log2 || size < JVXFS_FFT_MIN_SIZE || size > JVXFS_FFT_MAX_SIZE || dir > JVXFS_FFT_INVERSE || kind > JVXFS_FFT_REAL) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_FFT,
+            "FFT size must be a power of two within the supported range.");
+    }
+    plan_t* p = jvxfs_atomic_load(&cache[log2][dir][kind]);
+    if (p) {
+        *plan = p;
+        return JVXFS_STATUS_SUCCESS;
+    }
+    uint32_t unlocked = 0;
+    while (!jvxfs_atomic_cas(&buildLock, &unlocked, 1)) {
+        unlocked = 0;
+        jvxfs_cpu_relax();
+    }
+    p = jvxfs_atomic_load(&cache[log2][dir][kind]);
+    if (!p) {
+        p = build_plan(log2, dir, kind);
+        if (p) jvxfs_atomic_store(&cache[log2][dir][kind], p);
+    }
+    jvxfs_atomic_store(&buildLock, 0);
+    if (!p) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_FFT,
+            "Could not create FFT plan.");
+    }
+    *plan = p;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_fft_get_channel_plan(const jvxfs_fft_plan_t** plan, jvxfs_channel_model_t* mod,
+    jvxfs_fft_direction_t dir, jvxfs_fft_kind_t kind, jvxfs_error_t* err)
+{
+    uint32_t size = jvxfs_channel_get_optimal_fft_size(mod);
+    if (size < JVXFS_FFT_MIN_SIZE) size = JVXFS_FFT_MIN_SIZE;
+    return jvxfs_fft_get_plan(plan, size, dir, kind, err);
+}
+
+uint32_t jvxfs_fft_get_size(const jvxfs_fft_plan_t* plan)
+{
+    const plan_t* p = (const plan_t*)plan;
+    return p->size;
+}
+
+void jvxfs_fft_execute(const jvxfs_fft_plan_t* plan, const float* in, float* out)
+{
+    const plan_t* p = (const plan_t*)plan;
+    if (p->kind == JVXFS_FFT_COMPLEX) {
+        run_complex(p, in, out);
+    } else if (p->dir == JVXFS_FFT_FORWARD) {
+        run_real_forward(p, in, out);
+    } else {
+        run_real_inverse(p, in, out);
+    }
+}
+
+
+plan_t* build_plan(uint32_t log2, jvxfs_fft_direction_t dir, jvxfs_fft_kind_t kind)
+{
+    plan_t* p = (plan_t*)calloc(1, sizeof(plan_t));
+    if (!p) return NULL;
+    uint32_t n = 1u << log2;
+    double sign = (dir == JVXFS_FFT_FORWARD) ? -1.0 : 1.0;
+    p->size = n;
+    p->log2 = log2;
+    p->dir = dir;
+    p->kind = kind;
+    if (kind == JVXFS_FFT_REAL) {
+        uint32_t m = n / 2;
+        p->sub = build_plan(log2 - 1, dir, JVXFS_FFT_COMPLEX);
+        p->twReal = (float*)malloc(sizeof(float) * 2 * (m / 2 + 1));
+        if (!p->sub || !p->twReal) {
+            free_plan(p);
+            return NULL;
+        }
+        for (uint32_t k = 0; k <= m / 2; ++k) {
+            p->twReal[2 * k] = (float)cos(2.0 * FFT_PI * k / n);
+            p->twReal[2 * k + 1] = (float)(sign * sin(2.0 * FFT_PI * k / n));
+        }
+        return p;
+    }
+    p->kernel = wisdom[log2];
+    p->scale = (dir == JVXFS_FFT_INVERSE) ? 1.0f / n : 1.0f;
+    p->bitrev = (uint32_t*)malloc(sizeof(uint32_t) * n);
+    p->tw2 = (float*)malloc(sizeof(float) * 2 * n);
+    p->tw4 = (float*)malloc(sizeof(float) * 2 * n);
+    if (!p->bitrev || !p->tw2 || !p->tw4) {
+        free_plan(p);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < log2; ++b) {
+            if (i & (1u << b)) r |= 1u << (log2 - 1 - b);
+        }
+        p->bitrev[i] = r;
+    }
+    float* tw = p->tw2;
+    for (uint32_t h = 1; h < n; h <<= 1) {
+        for (uint32_t j = 0; j < h; ++j) {
+            *tw++ = (float)cos(FFT_PI * j / h);
+            *tw++ = (float)(sign * sin(FFT_PI * j / h));
+        }
+    }
+    tw = p->tw4;
+    for (uint32_t h = (log2 & 1) ? 2 : 1; h < n; h <<= 2) {
+        for (uint32_t j = 0; j < h; ++j) {
+            *tw++ = (float)cos(FFT_PI * j / h);
+            *tw++ = (float)(sign * sin(FFT_PI * j / h));
+        }
+        for (uint32_t j = 0; j < h; ++j) {
+            *tw++ = (float)cos(FFT_PI * j / (2 * h));
+            *tw++ = (float)(sign * sin(FFT_PI * j / (2 * h)));
+        }
+    }
+    return p;
+}
+
+void free_plan(plan_t* p)
+{
+    if (p->sub) free_plan(p->sub);
+    free(p->bitrev);
+    free(p->tw2);
+    free(p->tw4);
+    free(p->twReal);
+    free(p);
+}
+
+void run_complex(const plan_t* p, const float* in, float* out)
+{
+    uint32_t n = p->size;
+    if (in == out) {
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t r = p->bitrev[i];
+            if (i < r) {
+                float re = out[2 * i];
+                float im = out[2 * i + 1];
+                out[2 * i] = out[2 * r];
+                out[2 * i + 1] = out[2 * r + 1];
+                out[2 * r] = re;
+                out[2 * r + 1] = im;
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t r = p->bitrev[i];
+            out[2 * r] = in[2 * i];
+            out[2 * r + 1] = in[2 * i + 1];
+        }
+    }
+    kernels[p->kernel](p, out);
+    if (p->scale != 1.0f) {
+        for (uint32_t i = 0; i < 2 * n; ++i) out[i] *= p->scale;
+    }
+}
+
+void run_real_forward(const plan_t* p, const float* in, float* out)
+{
+    uint32_t m = p->size / 2;
+    run_complex(p->sub, in, out);
+    float z0r = out[0];
+    float z0i = out[1];
+    out[0] = z0r + z0i;
+    out[1] = 0.0f;
+    out[2 * m] = z0r - z0i;
+    out[2 * m + 1] = 0.0f;
+    for (uint32_t k = 1; k <= m / 2; ++k) {
+        float* zk = out + 2 * k;
+        float* zm = out + 2 * (m - k);
+        float wr = p->twReal[2 * k];
+        float wi = p->twReal[2 * k + 1];
+        float feRe = 0.5f * (zk[0] + zm[0]);
+        float feIm = 0.5f * (zk[1] - zm[1]);
+        float foRe = 0.5f * (zk[1] + zm[1]);
+        float foIm = -0.5f * (zk[0] - zm[0]);
+        float tr = wr * foRe - wi * foIm;
+        float ti = wr * foIm + wi * foRe;
+        zk[0] = feRe + tr;
+        zk[1] = feIm + ti;
+        if (k != m - k) {
+            zm[0] = feRe - tr;
+            zm[1] = -(feIm - ti);
+        }
+    }
+}
+
+void run_real_inverse(const plan_t* p, const float* in, float* out)
+{
+    uint32_t m = p->size / 2;
+    float x0 = in[0];
+    float xm = in[2 * m];
+    for (uint32_t k = 1; k <= m / 2; ++k) {
+        const float* xk = in + 2 * k;
+        const float* xn = in + 2 * (m - k);
+        float wr = p->twReal[2 * k];
+        float wi = p->twReal[2 * k + 1];
+        float feRe = 0.5f * (xk[0] + xn[0]);
+        float feIm = 0.5f * (xk[1] - xn[1]);
+        float dr = 0.5f * (xk[0] - xn[0]);
+        float di = 0.5f * (xk[1] + xn[1]);
+        float foRe = dr * wr - di * wi;
+        float foIm = dr * wi + di * wr;
+        float* zk = out + 2 * k;
+        float* zm = out + 2 * (m - k);
+        zk[0] = feRe - foIm;
+        zk[1] = feIm + foRe;
+        if (k != m - k) {
+            zm[0] = feRe + foIm;
+            zm[1] = -feIm + foRe;
+        }
+    }
+    out[0] = 0.5f * (x0 + xm);
+    out[1] = 0.5f * (x0 - xm);
+    run_complex(p->sub, out, out);
+}
+
+void radix2_scalar(const plan_t* p, float* x)
+{
+    uint32_t n = p->size;
+    const float* tw = p->tw2;
+    for (uint32_t h = 1; h < n; h <<= 1) {
+        for (uint32_t k = 0; k < n; k += 2 * h) {
+            for (uint32_t j = 0; j < h; ++j) {
+                float* a = x + 2 * (k + j);
+                float* b = a + 2 * h;
+                float wr = tw[2 * j];
+                float wi = tw[2 * j + 1];
+                float br = b[0] * wr - b[1] * wi;
+                float bi = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - br;
+                b[1] = a[1] - bi;
+                a[0] += br;
+                a[1] += bi;
+            }
+        }
+        tw += 2 * h;
+    }
+}
+
+static void radix4_stage_scalar(float* x, uint32_t n, uint32_t h, const float* w1, const float* w2, float rot)
+{
+    for (uint32_t k = 0; k < n; k += 4 * h) {
+        for (uint32_t j = 0; j < h; ++j) {
+            float* x0 = x + 2 * (k + j);
+            float* x1 = x0 + 2 * h;
+            float* x2 = x1 + 2 * h;
+            float* x3 = x2 + 2 * h;
+            float ar = w1[2 * j], ai = w1[2 * j + 1];
+            float br = w2[2 * j], bi = w2[2 * j + 1];
+            float t1r = x1[0] * ar - x1[1] * ai, t1i = x1[0] * ai + x1[1] * ar;
+            float t3r = x3[0] * ar - x3[1] * ai, t3i = x3[0] * ai + x3[1] * ar;
+            float a0r = x0[0] + t1r, a0i = x0[1] + t1i;
+            float a1r = x0[0] - t1r, a1i = x0[1] - t1i;
+            float a2r = x2[0] + t3r, a2i = x2[1] + t3i;
+            float a3r = x2[0] - t3r, a3i = x2[1] - t3i;
+            float u2r = a2r * br - a2i * bi, u2i = a2r * bi + a2i * br;
+            float v3r = a3r * br - a3i * bi, v3i = a3r * bi + a3i * br;
+            float u3r = -rot * v3i, u3i = rot * v3r;
+            x0[0] = a0r + u2r;
+            x0[1] = a0i + u2i;
+            x2[0] = a0r - u2r;
+            x2[1] = a0i - u2i;
+            x1[0] = a1r + u3r;
+            x1[1] = a1i + u3i;
+            x3[0] = a1r - u3r;
+            x3[1] = a1i - u3i;
+        }
+    }
+}
+
+static void radix2_first_stage(float* x, uint32_t n)
+{
+    for (uint32_t k = 0; k < n; k += 2) {
+        float* a = x + 2 * k;
+        float br = a[2], bi = a[3];
+        a[2] = a[0] - br;
+        a[3] = a[1] - bi;
+        a[0] += br;
+        a[1] += bi;
+    }
+}
+
+void radix4_scalar(const plan_t* p, float* x)
+{
+    uint32_t n = p->size;
+    uint32_t h = 1;
+    float rot = (p->dir == JVXFS_FFT_FORWARD) ? -1.0f : 1.0f;
+    const float* tw = p->tw4;
+    if (p->log2 & 1) {
+        radix2_first_stage(x, n);
+        h = 2;
+    }
+    for (; h < n; h <<= 2) {
+        radix4_stage_scalar(x, n, h, tw, tw + 2 * h, rot);
+        tw += 4 * h;
+    }
+}
+
+#if defined __SSE2__
+static inline __m128 cmul_sse2(__m128 a, __m128 w)
+{
+    const __m128 neg = _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+    __m128 wr = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 wi = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_add_ps(_mm_mul_ps(a, wr), _mm_xor_ps(_mm_mul_ps(as, wi), neg));
+}
+
+void radix2_sse2(const plan_t* p, float* x)
+{
+    uint32_t n = p->size;
+    const float* tw = p->tw2;
+    radix2_first_stage(x, n);
+    tw += 2;
+    for (uint32_t h = 2; h < n; h <<= 1) {
+        for (uint32_t k = 0; k < n; k += 2 * h) {
+            for (uint32_t j = 0; j < h; j += 2) {
+                float* a = x + 2 * (k + j);
+                float* b = a + 2 * h;
+                __m128 va = _mm_loadu_ps(a);
+                __m128 vb = cmul_sse2(_mm_loadu_ps(b), _mm_loadu_ps(tw + 2 * j));
+                _mm_storeu_ps(a, _mm_add_ps(va, vb));
+                _mm_storeu_ps(b, _mm_sub_ps(va, vb));
+            }
+        }
+        tw += 2 * h;
+    }
+}
+
+void radix4_sse2(const plan_t* p, float* x)
+{
+    uint32_t n = p->size;
+    uint32_t h = 1;
+    const float* tw = p->tw4;
+    const __m128 neg = (p->dir == JVXFS_FFT_FORWARD) ? _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f) : _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+    if (p->log2 & 1) {
+        radix2_first_stage(x, n);
+        h = 2;
+    } else {
+        radix4_stage_scalar(x, n, 1, tw, tw + 2, (p->dir == JVXFS_FFT_FORWARD) ? -1.0f : 1.0f);
+        tw += 4;
+        h = 4;
+    }
+    for (; h < n; h <<= 2) {
+        const float* w1 = tw;
+        const float* w2 = tw + 2 * h;
+        for (uint32_t k = 0; k < n; k += 4 * h) {
+            for (uint32_t j = 0; j < h; j += 2) {
+                float* x0 = x + 2 * (k + j);
+                float* x1 = x0 + 2 * h;
+                float* x2 = x1 + 2 * h;
+                float* x3 = x2 + 2 * h;
+                __m128 va = _mm_loadu_ps(w1 + 2 * j);
+                __m128 vb = _mm_loadu_ps(w2 + 2 * j);
+                __m128 v0 = _mm_loadu_ps(x0);
+                __m128 v2 = _mm_loadu_ps(x2);
+                __m128 t1 = cmul_sse2(_mm_loadu_ps(x1), va);
+                __m128 t3 = cmul_sse2(_mm_loadu_ps(x3), va);
+                __m128 a0 = _mm_add_ps(v0, t1);
+                __m128 a1 = _mm_sub_ps(v0, t1);
+                __m128 u2 = cmul_sse2(_mm_add_ps(v2, t3), vb);
+                __m128 v3 = cmul_sse2(_mm_sub_ps(v2, t3), vb);
+                __m128 u3 = _mm_xor_ps(_mm_shuffle_ps(v3, v3, _MM_SHUFFLE(2, 3, 0, 1)), neg);
+                _mm_storeu_ps(x0, _mm_add_ps(a0, u2));
+                _mm_storeu_ps(x2, _mm_sub_ps(a0, u2));
+                _mm_storeu_ps(x1, _mm_add_ps(a1, u3));
+                _mm_storeu_ps(x3, _mm_sub_ps(a1, u3));
+            }
+        }
+        tw += 4 * h;
+    }
+}
+#endif
+
+void measure_wisdom(void)
+{
+    for (size_t i = 0; i <= MAX_LOG2; ++i) wisdom[i] = KERNEL_RADIX2;
+    float* buf = (float*)malloc(sizeof(float) * 4 * (1u << WISDOM_MAX_LOG2));
+    if (!buf) return;
+    float* seed = buf + 2 * (1u << WISDOM_MAX_LOG2);
+    for (uint32_t i = 0; i < 2 * (1u << WISDOM_MAX_LOG2); ++i) seed[i] = (float)((i * 7919) % 1000) * 1e-3f;
+    for (uint32_t log2 = WISDOM_MIN_LOG2; log2 <= WISDOM_MAX_LOG2; ++log2) {
+        plan_t* p = build_plan(log2, JVXFS_FFT_FORWARD, JVXFS_FFT_COMPLEX);
+        if (!p) break;
+        uint32_t runs = WISDOM_POINTS_PER_RUN >> log2;
+        switch_time_t best = 0;
+        for (int k = 0; k < KERNEL_COUNT; ++k) {
+            switch_time_t fastest = 0;
+            for (int r = 0; r < WISDOM_REPETITIONS; ++r) {
+                /* Transforms are unscaled, so the input is restored before each run to keep the data finite.
+                 * The copy costs the same for every kernel. */
+                switch_time_t start = switch_time_now();
+                for (uint32_t i = 0; i < runs; ++i) {
+                    memcpy(buf, seed, sizeof(float) * 2 * p->size);
+                    kernels[k](p, buf);
+                }
+                switch_time_t elapsed = switch_time_now() - start;
+                if (r == 0 || elapsed < fastest) fastest = elapsed;
+            }
+            if (k == 0 || fastest < best) {
+                best = fastest;
+                wisdom[log2] = (kernel_t)k;
+            }
+        }
+        free_plan(p);
+    }
+    for (uint32_t log2 = 0; log2 < WISDOM_MIN_LOG2; ++log2) wisdom[log2] = KERNEL_RADIX2;
+    for (uint32_t log2 = WISDOM_MAX_LOG2 + 1; log2 <= MAX_LOG2; ++log2) wisdom[log2] = wisdom[WISDOM_MAX_LOG2];
+    free(buf);
+}
+
+uint32_t size_to_log2(uint32_t size)
+{
+    if (size < 2 || (size & (size - 1))) return 0;
+    uint32_t log2 = 0;
+    while ((1u << log2) < size) ++log2;
+    return log2;
+}
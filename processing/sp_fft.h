@@ -0,0 +1,106 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file sp_fft.h
+ * @brief Process wide cache of FFT plans shared by all sessions.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-14
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_FFT_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_FFT_H
+
+#include <stdint.h>
+#include <switch.h>
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup processing Signal Processing
+ * @{
+ * @defgroup fft FFT Plan Cache
+ * @details Plans and twiddle tables are built once per (size, direction, kind) and shared
+ * read-only by all sessions of the process. Lookups of already built plans do not take any lock.
+ * Which kernel variant (radix-2 or radix-4, scalar or SIMD) is used for a size is measured once
+ * at module load.
+ * @{
+ */
+
+#define JVXFS_FFT_MIN_SIZE 4
+#define JVXFS_FFT_MAX_SIZE 65536
+
+/**
+ * @brief Handle type of a shared FFT plan.
+ */
+typedef void jvxfs_fft_plan_t;
+
+typedef enum
+{
+    JVXFS_FFT_FORWARD,
+    JVXFS_FFT_INVERSE
+} jvxfs_fft_direction_t;
+
+typedef enum
+{
+    JVXFS_FFT_COMPLEX,
+    JVXFS_FFT_REAL
+} jvxfs_fft_kind_t;
+
+/**
+ * @brief Initialize the plan cache and measure the fastest kernels on this CPU.
+ * @return Status code.
+ * @details Called by the framework when a module is loaded. Measurement only happens for the first module.
+ */
+jvxfs_status_t jvxfs_fft_init(void);
+
+/**
+ * @brief Release the plan cache once the last module has been unloaded.
+ */
+void jvxfs_fft_shutdown(void);
+
+/**
+ * @brief Get the shared plan for a transform.
+ * @param[out] plan Shared plan, must not be modified or freed.
+ * @param[in] size  Transform size (number of complex points, or real points for #JVXFS_FFT_REAL), power of two.
+ * @param[in] dir   Transform direction.
+ * @param[in] kind  Complex or real transform.
+ * @param[in] err   Error handler of the caller.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_fft_get_plan(const jvxfs_fft_plan_t** plan, uint32_t size, jvxfs_fft_direction_t dir,
+    jvxfs_fft_kind_t kind, jvxfs_error_t* err);
+
+/**
+ * @brief Get the shared plan for the optimal FFT size of a link.
+ * @see jvxfs_channel_get_optimal_fft_size()
+ */
+jvxfs_status_t jvxfs_fft_get_channel_plan(const jvxfs_fft_plan_t** plan, jvxfs_channel_model_t* mod,
+    jvxfs_fft_direction_t dir, jvxfs_fft_kind_t kind, jvxfs_error_t* err);
+
+uint32_t jvxfs_fft_get_size(const jvxfs_fft_plan_t* plan);
+
+/**
+ * @brief Run a transform.
+ * @param[in] plan  Shared plan.
+ * @param[in] in    Input buffer.
+ * @param[out] out  Output buffer, may be equal to @a in.
+ * @details Complex data is interleaved (re, im). A real forward transform of size N reads N floats and
+ * writes N/2+1 complex bins, a real inverse transform reads N/2+1 bins and writes N floats, so real
+ * transforms need N+2 floats of space in the complex buffer. Inverse transforms are scaled by 1/N.
+ * Buffers aligned to #JVXFS_SP_MEMORY_ALIGNMENT bytes are fastest.
+ */
+void jvxfs_fft_execute(const jvxfs_fft_plan_t* plan, const float* in, float* out);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
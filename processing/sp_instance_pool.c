@@ -0,0 +1,193 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <string.h>
+#include "../system/error.h"
+#include "../utils/atomic.h"
+#include "sp_instance_pool.h"
+
+#define SHRINK_DELAY_US 10000000
+
+typedef struct
+{
+    void* algo;
+    size_t scratchSize;
+} entry_t;
+
+typedef struct
+{
+    jvxfs_algorithm_vtable_t* vtable;
+    jvxfs_sigproc_media_t media;
+    entry_t* entries;
+    uint32_t count;
+    uint32_t prewarm;
+    uint32_t maximum;
+    uint32_t target;
+    switch_time_t lastMiss;
+    uint32_t pending;
+    jvxfs_worker_pool_t* worker;
+    jvxfs_worker_task_t task;
+    switch_mutex_t* mutex;
+} inst_pool_t;
+
+static void construct(inst_pool_t* hdl, entry_t* entry);
+static void destruct(inst_pool_t* hdl, entry_t* entry);
+static void schedule(inst_pool_t* hdl);
+static void refill_task(void* data);
+
+
+jvxfs_status_t jvxfs_instance_pool_create(jvxfs_sigproc_instance_pool_t** obj, jvxfs_algorithm_vtable_t* vtable,
+    const jvxfs_sigproc_media_t* media, uint32_t prewarm, uint32_t maximum, jvxfs_worker_pool_t* worker,
+    jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create instance pool.";
+    if (!vtable || !vtable->reset || !media) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_INSTANCE_POOL,
+            "Instance pool needs a reset function.");
+    }
+    if (maximum < prewarm) maximum = prewarm;
+    inst_pool_t* hdl = (inst_pool_t*)switch_core_alloc(pool, sizeof(inst_pool_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_INSTANCE_POOL, error);
+    }
+    hdl->entries = (entry_t*)switch_core_alloc(pool, sizeof(entry_t) * (maximum ? maximum : 1));
+    if (!hdl->entries || switch_mutex_init(&hdl->mutex, SWITCH_MUTEX_NESTED, pool) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_INSTANCE_POOL, error);
+    }
+    hdl->vtable = vtable;
+    hdl->media = *media;
+    hdl->count = 0;
+    hdl->prewarm = prewarm;
+    hdl->maximum = maximum;
+    hdl->target = prewarm;
+    hdl->lastMiss = 0;
+    hdl->pending = 0;
+    hdl->worker = worker;
+    hdl->task.func = refill_task;
+    hdl->task.data = hdl;
+    /* Filled right away, so the first calls after loading the module do not construct. */
+    for (uint32_t i = 0; i < prewarm; ++i) {
+        construct(hdl, &hdl->entries[i]);
+        hdl->count = i + 1;
+    }
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_instance_pool_destroy(jvxfs_sigproc_instance_pool_t** obj)
+{
+    inst_pool_t* hdl = (inst_pool_t*)*obj;
+    if (!hdl) return;
+    jvxfs_atomic_store(&hdl->target, 0);
+    while (jvxfs_atomic_load(&hdl->pending)) switch_yield(1000);
+    switch_mutex_lock(hdl->mutex);
+    while (hdl->count > 0) destruct(hdl, &hdl->entries[--hdl->count]);
+    switch_mutex_unlock(hdl->mutex);
+    switch_mutex_destroy(hdl->mutex);
+    *obj = NULL;
+}
+
+void jvxfs_instance_pool_acquire(jvxfs_sigproc_instance_pool_t* obj, void** algo, size_t* scratchSize)
+{
+    inst_pool_t* hdl = (inst_pool_t*)obj;
+    entry_t entry = { NULL, 0 };
+    bool found = false;
+    switch_mutex_lock(hdl->mutex);
+    if (hdl->count > 0) {
+        entry = hdl->entries[--hdl->count];
+        found = true;
+    } else {
+        /* Run empty, keep twice as many ready until borrowing slows down again. */
+        uint32_t target = hdl->target ? hdl->target * 2 : 1;
+        jvxfs_atomic_store(&hdl->target, (target < hdl->maximum) ? target : hdl->maximum);
+        hdl->lastMiss = switch_micro_time_now();
+    }
+    switch_mutex_unlock(hdl->mutex);
+    if (!found) construct(hdl, &entry);
+    schedule(hdl);
+    *algo = entry.algo;
+    *scratchSize = entry.scratchSize;
+}
+
+void jvxfs_instance_pool_release(jvxfs_sigproc_instance_pool_t* obj, void* algo, size_t scratchSize)
+{
+    inst_pool_t* hdl = (inst_pool_t*)obj;
+    entry_t entry = { algo, scratchSize };
+    hdl->vtable->reset(algo);
+    switch_mutex_lock(hdl->mutex);
+    bool stored = hdl->count < hdl->maximum;
+    if (stored) hdl->entries[hdl->count++] = entry;
+    if (hdl->target > hdl->prewarm && switch_micro_time_now() - hdl->lastMiss > SHRINK_DELAY_US) {
+        jvxfs_atomic_store(&hdl->target, hdl->prewarm);
+    }
+    switch_mutex_unlock(hdl->mutex);
+    if (!stored) destruct(hdl, &entry);
+    schedule(hdl);
+}
+
+uint32_t jvxfs_instance_pool_count(jvxfs_sigproc_instance_pool_t* obj)
+{
+    inst_pool_t* hdl = (inst_pool_t*)obj;
+    switch_mutex_lock(hdl->mutex);
+    uint32_t count = hdl->count;
+    switch_mutex_unlock(hdl->mutex);
+    return count;
+}
+
+
+void construct(inst_pool_t* hdl, entry_t* entry)
+{
+    /* Every instance gets its own copy, the algorithm may store the scratch size in it. */
+    jvxfs_sigproc_media_t media = hdl->media;
+    entry->algo = NULL;
+    hdl->vtable->construct(&entry->algo, &media, "");
+    entry->scratchSize = media.scratch_size;
+}
+
+void destruct(inst_pool_t* hdl, entry_t* entry)
+{
+    if (hdl->vtable->destruct) hdl->vtable->destruct(&entry->algo);
+    entry->algo = NULL;
+}
+
+void schedule(inst_pool_t* hdl)
+{
+    switch_mutex_lock(hdl->mutex);
+    bool needed = hdl->count != hdl->target;
+    switch_mutex_unlock(hdl->mutex);
+    if (!needed || !hdl->worker) return;
+    if (jvxfs_atomic_exchange(&hdl->pending, 1) != 0) return;
+    if (!jvxfs_worker_submit(hdl->worker, &hdl->task)) jvxfs_atomic_store(&hdl->pending, 0);
+}
+
+void refill_task(void* data)
+{
+    inst_pool_t* hdl = (inst_pool_t*)data;
+    entry_t entry = { NULL, 0 };
+    /* One instance per run, so constructing does not hold up frames queued behind on the same worker. */
+    switch_mutex_lock(hdl->mutex);
+    uint32_t target = jvxfs_atomic_load(&hdl->target);
+    bool grow = hdl->count < target;
+    if (hdl->count > target) {
+        entry = hdl->entries[--hdl->count];
+    }
+    switch_mutex_unlock(hdl->mutex);
+    if (grow) {
+        construct(hdl, &entry);
+        switch_mutex_lock(hdl->mutex);
+        bool stored = hdl->count < hdl->maximum;
+        if (stored) hdl->entries[hdl->count++] = entry;
+        switch_mutex_unlock(hdl->mutex);
+        if (!stored) destruct(hdl, &entry);
+    } else if (entry.algo) {
+        destruct(hdl, &entry);
+    }
+    switch_mutex_lock(hdl->mutex);
+    bool again = hdl->count != jvxfs_atomic_load(&hdl->target);
+    switch_mutex_unlock(hdl->mutex);
+    /* Still marked pending while resubmitting, so destroying keeps waiting until the target is reached. */
+    if (again && jvxfs_worker_submit(hdl->worker, &hdl->task)) return;
+    jvxfs_atomic_store(&hdl->pending, 0);
+}
@@ -0,0 +1,72 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file sp_instance_pool.h
+ * @brief Pool of constructed algorithm instances shared by the processors of an app.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-19
+ * @copyright Copyright (c) 2019
+ * @note The user should not call these functions himself, the app creates the pool if
+ * a reset function has been set and the processors borrow their instances from it.
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_INSTANCE_POOL_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_INSTANCE_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <switch.h>
+#include "../utils/worker.h"
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @brief Create a pool and construct its initial instances.
+ * @param[out] obj       Pool.
+ * @param[in] vtable     Algorithm functions of the app, @a reset must be set.
+ * @param[in] media      Frame descriptor the instances are constructed with, copied.
+ * @param[in] prewarm    Number of instances kept ready.
+ * @param[in] maximum    Number of instances the pool may hold, at least @a prewarm.
+ * @param[in] worker     Worker pool refilling the pool in the background.
+ * @param[in] err        Error handler.
+ * @param[in] pool       Memory pool of the module.
+ * @return Status code.
+ * @details The pool starts with @a prewarm instances. If it runs empty, it keeps more instances ready
+ * up to @a maximum, and falls back to @a prewarm once borrowing slows down again.
+ */
+jvxfs_status_t jvxfs_instance_pool_create(jvxfs_sigproc_instance_pool_t** obj, jvxfs_algorithm_vtable_t* vtable,
+    const jvxfs_sigproc_media_t* media, uint32_t prewarm, uint32_t maximum, jvxfs_worker_pool_t* worker,
+    jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Destruct all pooled instances. Borrowed instances must have been returned before.
+ */
+void jvxfs_instance_pool_destroy(jvxfs_sigproc_instance_pool_t** obj);
+
+/**
+ * @brief Borrow an instance.
+ * @param[in] obj           Pool.
+ * @param[out] algo         Instance.
+ * @param[out] scratchSize  Scratch size the instance declared when it was constructed.
+ * @details If no instance is ready, one is constructed on the calling thread and the pool is grown in the background.
+ */
+void jvxfs_instance_pool_acquire(jvxfs_sigproc_instance_pool_t* obj, void** algo, size_t* scratchSize);
+
+/**
+ * @brief Reset a terminated instance and return it to the pool.
+ * @details The instance is destructed if the pool is full.
+ */
+void jvxfs_instance_pool_release(jvxfs_sigproc_instance_pool_t* obj, void* algo, size_t scratchSize);
+
+/**
+ * @brief Number of instances ready to be borrowed.
+ */
+uint32_t jvxfs_instance_pool_count(jvxfs_sigproc_instance_pool_t* obj);
+
+JVX_FS_LIB_END
+
+#endif
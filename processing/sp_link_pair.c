@@ -0,0 +1,148 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+ 
+#include <string.h>
+#include "../system/error.h"
+#include "../utils/atomic.h"
+#include "sp_link_pair.h"
+
+#define PAIR_SLOTS 4
+#define PAIR_MASK (PAIR_SLOTS - 1)
+#define PAIR_SLOT_SIZE (SWITCH_RECOMMENDED_BUFFER_SIZE)
+#define PAIR_TARGET_FILL 1
+#define FILL_FRACTION_BITS 6
+#define FILL_SMOOTHING_SHIFT 4
+#define DRIFT_MIN_FRAMES 50
+
+typedef struct
+{
+    jvxfs_sigproc_media_t media;
+    switch_time_t arrival;
+} slot_t;
+
+typedef struct
+{
+    slot_t slots[PAIR_SLOTS];
+    jvxfs_sigproc_channel_t link;
+    uint32_t tail JVXFS_CACHE_ALIGNED;
+    uint64_t produced;
+    uint64_t overflows;
+    uint32_t head JVXFS_CACHE_ALIGNED;
+    bool holding;
+    int32_t fill;
+    uint64_t frames;
+    uint64_t mainSamples;
+    uint32_t mainRate;
+    double offset;
+    uint64_t slips;
+} pair_t;
+
+static void estimate_drift(pair_t* hdl, jvxfs_sigproc_media_t* main, const slot_t* slot);
+
+
+jvxfs_status_t jvxfs_link_pair_create(jvxfs_sigproc_link_pair_t** obj, jvxfs_sigproc_channel_t refLink,
+    jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create link pairing buffer.";
+    pair_t* hdl = (pair_t*)switch_core_alloc(pool, sizeof(pair_t) + JVXFS_CACHE_LINE_SIZE);
+    uint8_t* mem = (uint8_t*)switch_core_alloc(pool, PAIR_SLOTS * PAIR_SLOT_SIZE + JVXFS_SP_MEMORY_ALIGNMENT);
+    if (!hdl || !mem) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_PROCESSOR, error);
+    }
+    hdl = (pair_t*)(((uintptr_t)hdl + JVXFS_CACHE_LINE_SIZE - 1) & ~((uintptr_t)JVXFS_CACHE_LINE_SIZE - 1));
+    mem = (uint8_t*)(((uintptr_t)mem + JVXFS_SP_MEMORY_ALIGNMENT - 1) & ~((uintptr_t)JVXFS_SP_MEMORY_ALIGNMENT - 1));
+    memset(hdl, 0, sizeof(pair_t));
+    for (size_t i = 0; i < PAIR_SLOTS; ++i) {
+        hdl->slots[i].media.data = mem + i * PAIR_SLOT_SIZE;
+        hdl->slots[i].media.type = JVXFS_SP_16BIT_LE;
+        hdl->slots[i].media.link = refLink;
+    }
+    hdl->link = refLink;
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_link_pair_push(jvxfs_sigproc_link_pair_t* obj, const switch_frame_t* frame)
+{
+    pair_t* hdl = (pair_t*)obj;
+    if (!frame || !frame->data || !frame->samples || frame->datalen > PAIR_SLOT_SIZE) return;
+    uint32_t tail = hdl->tail;
+    uint32_t head = jvxfs_atomic_load(&hdl->head);
+    if (tail - head >= PAIR_SLOTS) {
+        jvxfs_atomic_fetch_add_relaxed(&hdl->overflows, 1);
+        return;
+    }
+    slot_t* slot = &hdl->slots[tail & PAIR_MASK];
+    memcpy(slot->media.data, frame->data, frame->datalen);
+    slot->media.samples = frame->samples;
+    slot->media.rate = frame->rate;
+    slot->media.channels = (frame->channels > 0) ? (uint8_t)frame->channels : 1;
+    slot->media.sequence = hdl->produced;
+    slot->arrival = switch_micro_time_now();
+    jvxfs_atomic_store_relaxed(&hdl->produced, hdl->produced + frame->samples);
+    jvxfs_atomic_store(&hdl->tail, tail + 1);
+}
+
+const jvxfs_sigproc_media_t* jvxfs_link_pair_pop(jvxfs_sigproc_link_pair_t* obj, jvxfs_sigproc_media_t* main)
+{
+    pair_t* hdl = (pair_t*)obj;
+    uint32_t head = hdl->head;
+    uint32_t avail = jvxfs_atomic_load(&hdl->tail) - head;
+    if (hdl->holding) {
+        if (avail > 1) {
+            ++head;
+            --avail;
+        } else {
+            jvxfs_atomic_fetch_add_relaxed(&hdl->slips, 1);
+            estimate_drift(hdl, main, &hdl->slots[head & PAIR_MASK]);
+            return &hdl->slots[head & PAIR_MASK].media;
+        }
+    }
+    if (avail == 0) {
+        jvxfs_atomic_store(&hdl->head, head);
+        hdl->holding = false;
+        return NULL;
+    }
+    hdl->fill += (int32_t)(((avail << FILL_FRACTION_BITS) - hdl->fill) >> FILL_SMOOTHING_SHIFT);
+    if (avail > 1 && hdl->fill > ((PAIR_TARGET_FILL + 1) << FILL_FRACTION_BITS)) {
+        ++head;
+        --avail;
+        jvxfs_atomic_fetch_add_relaxed(&hdl->slips, 1);
+        hdl->fill = (int32_t)(avail << FILL_FRACTION_BITS);
+    }
+    jvxfs_atomic_store(&hdl->head, head);
+    hdl->holding = true;
+    slot_t* slot = &hdl->slots[head & PAIR_MASK];
+    estimate_drift(hdl, main, slot);
+    return &slot->media;
+}
+
+uint64_t jvxfs_link_pair_count_slips(jvxfs_sigproc_link_pair_t* obj)
+{
+    pair_t* hdl = (pair_t*)obj;
+    return jvxfs_atomic_load_relaxed(&hdl->slips) + jvxfs_atomic_load_relaxed(&hdl->overflows);
+}
+
+
+void estimate_drift(pair_t* hdl, jvxfs_sigproc_media_t* main, const slot_t* slot)
+{
+    uint32_t refRate = slot->media.rate;
+    if (!refRate || !main->rate) return;
+    switch_time_t delay = switch_micro_time_now() - slot->arrival;
+    main->reference_delay = (int32_t)((delay * refRate) / 1000000);
+    if (hdl->mainRate != main->rate) {
+        hdl->mainRate = main->rate;
+        hdl->frames = 0;
+        hdl->mainSamples = 0;
+    }
+    double produced = (double)jvxfs_atomic_load_relaxed(&hdl->produced) / refRate;
+    double consumed = (double)hdl->mainSamples / main->rate;
+    if (hdl->frames == 0) hdl->offset = produced - consumed;
+    hdl->mainSamples += main->samples;
+    ++(hdl->frames);
+    if (hdl->frames >= DRIFT_MIN_FRAMES && consumed > 0.0) {
+        main->reference_drift = (int32_t)((produced - consumed - hdl->offset) / consumed * 1e6);
+    }
+}
@@ -0,0 +1,59 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+ 
+/**
+ * @file sp_link_pair.h
+ * @brief Time aligned pairing of uplink and downlink frames.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-12
+ * @copyright Copyright (c) 2019
+ * @note The user should not call these functions himself, the processor uses them
+ * if an app catches both links.
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_LINK_PAIR_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_LINK_PAIR_H
+
+#include <stdint.h>
+#include <switch.h>
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+typedef void jvxfs_sigproc_link_pair_t;
+
+/**
+ * @brief Create pairing buffer for frames of the reference link.
+ * @details The buffer is a single producer single consumer ring without locks. The callback of
+ * the reference link pushes, the callback of the working link pops.
+ */
+jvxfs_status_t jvxfs_link_pair_create(jvxfs_sigproc_link_pair_t** obj, jvxfs_sigproc_channel_t refLink,
+    jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Copy a frame of the reference link into the pairing buffer.
+ * @details If the buffer is full the frame is dropped and counted as overflow.
+ */
+void jvxfs_link_pair_push(jvxfs_sigproc_link_pair_t* obj, const switch_frame_t* frame);
+
+/**
+ * @brief Fetch the reference frame aligned to the current frame of the working link.
+ * @param[in] obj   Pairing buffer.
+ * @param[in] main  Descriptor of the working link's frame, the estimated delay and drift are stored into it.
+ * @return Reference frame or @em NULL, if no reference has arrived yet.
+ * @details The returned frame stays valid until the next call. Drift and delay are compensated by
+ * dropping or repeating single reference frames, so the buffer is kept at one frame in advance.
+ */
+const jvxfs_sigproc_media_t* jvxfs_link_pair_pop(jvxfs_sigproc_link_pair_t* obj, jvxfs_sigproc_media_t* main);
+
+/**
+ * @brief Number of reference frames dropped or repeated so far, including those lost to a full buffer.
+ * @details Can be called from any thread.
+ */
+uint64_t jvxfs_link_pair_count_slips(jvxfs_sigproc_link_pair_t* obj);
+
+JVX_FS_LIB_END
+
+#endif
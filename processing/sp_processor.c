@@ -2,13 +2,58 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
  
+#include <string.h>
 #include "../system/session.h"
 #include "../system/error.h"
 #include "../system/app.h"
+#include "../system/config.h"
+#include "../system/module.h"
+#include "../utils/atomic.h"
 #include "../utils/observer.h"
 #include "sp_config.h"
+#include "sp_channel_model.h"
+#include "sp_channel_model_private.h"
+#include "sp_convert.h"
+#include "sp_batch.h"
+#include "sp_instance_pool.h"
+#include "sp_link_pair.h"
+#include "sp_reblock.h"
+#include "sp_resampler.h"
+#include "sp_stft.h"
 #include "sp_processor.h"
 
+typedef enum
+{
+    JOB_IDLE,
+    JOB_QUEUED,
+    JOB_DONE
+} job_state_t;
+
+typedef struct
+{
+    void* data;
+    size_t samples;
+    uint8_t channels;
+    int16_t* l16;
+    size_t l16Bytes;
+    bool valid;
+    bool copyBack;
+} stage_t;
+
+typedef struct
+{
+    jvxfs_worker_task_t task;
+    jvxfs_sigproc_batch_slot_t slot;
+    stage_t stage;
+    uint32_t state;
+    jvxfs_sigproc_media_t media;
+    jvxfs_sigproc_media_t reference;
+    uint32_t linkRate;
+    uint8_t* data;
+    uint8_t* refData;
+    size_t bytes;
+} async_job_t;
+
 typedef struct
 {
     jvxfs_app_t* app;
@@ -17,16 +62,84 @@ typedef struct
     jvxfs_sigproc_state_t state;
     jvxfs_error_t* err;
     jvxfs_sigprog_config_t* config;
+    jvxfs_config_t* settings;
+    const jvxfs_config_block_t* configBlock;
     jvxfs_observer_handle_t* mode_obs;
     switch_atomic_t mode;
     jvxfs_algorithm_vtable_t* vtable;
+    void* algo;
+    const char* args;
+    jvxfs_sigproc_instance_pool_t* instances;
+    size_t instScratch;
+    jvxfs_sigproc_media_t media;
+    uint8_t* bounce;
+    size_t bounceSize;
+    bool convert;
+    jvxfs_sigproc_link_pair_t* pair;
+    uint64_t pairSlips;
+    jvxfs_sigproc_reblock_t* reblock;
+    jvxfs_stft_t* stft;
+    jvxfs_channel_model_t* downlink;
+    jvxfs_channel_model_t* uplink;
+    jvxfs_resampler_t* toProcessing;
+    jvxfs_resampler_t* toLink;
+    jvxfs_resampler_t* resamplers[2];
+    uint32_t linkRate;
+    uint32_t processingRate;
+    uint32_t profileRate;
+    int16_t* resampled;
+    jvxfs_worker_pool_t* worker;
+    jvxfs_sigproc_batch_collector_t* batch;
+    async_job_t job;
+    uint8_t* delayed[2];
+    size_t delayedBytes[2];
+    uint32_t delayedIndex;
+    bool hasPrevious;
+    jvxfs_histogram_t* stats;
+    jvxfs_histogram_t* appStats;
+    uint8_t* params[3];
+    size_t paramSize;
+    uint32_t paramActive;
+    uint32_t paramBack;
+    uint32_t paramStaging;
+    uint32_t paramLatest;
+    uintptr_t paramWriter;
+    switch_mutex_t* paramMutex;
 } proc_t;
 
+#define BOUNCE_BUFFER_SIZE (SWITCH_RECOMMENDED_BUFFER_SIZE)
+#define ALIGN_UP(_n) (((_n) + JVXFS_SP_MEMORY_ALIGNMENT - 1) & ~((size_t)JVXFS_SP_MEMORY_ALIGNMENT - 1))
+#define PARAM_INDEX 3u
+#define PARAM_DIRTY 4u
+#define IS_ALIGNED(_ptr) ((((uintptr_t)(_ptr)) & (JVXFS_SP_MEMORY_ALIGNMENT - 1)) == 0)
+
 static void set_state(proc_t* hdl, jvxfs_sigproc_state_t state);
 static switch_bool_t media_bug_callback(switch_media_bug_t* bug, void* handle, switch_abc_type_t type);
 static jvxfs_status_t install_media_bug(proc_t* hdl);
+static jvxfs_status_t construct_algo(proc_t* hdl);
 static void init_algo(proc_t* hdl);
+static void handle_frame(proc_t* hdl, switch_frame_t* frame, jvxfs_sigproc_channel_t link);
+static void process_frame(proc_t* hdl, switch_frame_t* frame);
+static void process_deferred(proc_t* hdl, switch_frame_t* frame);
+static void run_job(void* data);
+static bool prepare_job(void* data, void** algo, jvxfs_sigproc_media_t** media);
+static void finish_job(void* data);
+static void run_pipeline(proc_t* hdl, jvxfs_sigproc_media_t* media, void* data, size_t bytes, size_t buflen, uint32_t linkRate);
+static void enter_pipeline(proc_t* hdl, stage_t* st, jvxfs_sigproc_media_t* media, void* data, size_t bytes, size_t buflen,
+    uint32_t linkRate);
+static void leave_pipeline(proc_t* hdl, stage_t* st, jvxfs_sigproc_media_t* media);
+static void apply_update(proc_t* hdl, jvxfs_sigproc_media_t* media);
+static void update_resampling(proc_t* hdl, uint32_t linkRate, uint32_t processingRate, uint8_t channels);
+static uint8_t* alloc_aligned(switch_core_session_t* session, size_t size);
+static void count_stat(proc_t* hdl, jvxfs_sigproc_stat_t stat, uint64_t n);
 static void destroy_processor(proc_t* hdl);
+static void destruct_algo(proc_t* hdl);
+static jvxfs_channel_model_t* working_model(proc_t* hdl);
+static void describe_media(proc_t* hdl);
+static size_t resample(jvxfs_resampler_t* rs, const int16_t* in, size_t frames, int16_t* out, size_t capacity,
+    uint8_t channels);
+static void process_spectral(void* data, jvxfs_sigproc_media_t* media);
+static uintptr_t writer_id(void);
 
 
 jvxfs_status_t jvxfs_sigproc_create_processor(jvxfs_sigproc_processor_t** obj, jvxfs_app_t* app, jvxfs_error_t* err,
@@ -43,16 +156,138 @@ jvxfs_status_t jvxfs_sigproc_create_processor(jvxfs_sigproc_processor_t** obj, j
     hdl->state = JVXFS_SP_FAILED;
     hdl->err = err;
     hdl->vtable = (jvxfs_algorithm_vtable_t*)data;
+    hdl->algo = NULL;
+    hdl->args = switch_core_session_strdup(session, args ? args : "");
+    hdl->instances = NULL;
+    hdl->instScratch = 0;
+    memset(&hdl->media, 0, sizeof(jvxfs_sigproc_media_t));
+    hdl->pair = NULL;
+    hdl->pairSlips = 0;
+    hdl->reblock = NULL;
+    hdl->stft = NULL;
     jvxfs_status_t res = jvxfs_app_get_sigproc_config(app, &hdl->config);
     if (res != JVXFS_STATUS_SUCCESS) return res;
+    hdl->settings = jvxfs_module_get_config(jvxfs_app_get_module(app));
+    hdl->configBlock = NULL;
+    jvxfs_sigproc_datatype_t type = jvxfs_sigproc_get_datatype(hdl->config);
+    hdl->convert = jvxfs_convert_is_needed(type) && jvxfs_convert_get_sample_size(type) > 0;
+    hdl->bounceSize = BOUNCE_BUFFER_SIZE;
+    if (hdl->convert && jvxfs_convert_get_sample_size(type) > sizeof(int16_t)) {
+        hdl->bounceSize = BOUNCE_BUFFER_SIZE / sizeof(int16_t) * jvxfs_convert_get_sample_size(type);
+    }
+    uint8_t* mem = (uint8_t*)switch_core_session_alloc(session, hdl->bounceSize + JVXFS_SP_MEMORY_ALIGNMENT);
+    if (!mem) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_PROCESSOR,
+            "Could not create aligned frame buffer.");
+    }
+    hdl->bounce = (uint8_t*)ALIGN_UP((uintptr_t)mem);
+    memset(&hdl->job, 0, sizeof(async_job_t));
+    hdl->worker = NULL;
+    hdl->batch = NULL;
+    hdl->delayedIndex = 0;
+    hdl->hasPrevious = false;
+    hdl->appStats = jvxfs_app_get_sigproc_stats(app);
+    res = jvxfs_histogram_create(&hdl->stats, 1, err, switch_core_session_get_pool(session));
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    hdl->toProcessing = NULL;
+    hdl->toLink = NULL;
+    hdl->resamplers[0] = NULL;
+    hdl->resamplers[1] = NULL;
+    hdl->linkRate = 0;
+    hdl->processingRate = 0;
+    hdl->profileRate = 0;
+    hdl->resampled = NULL;
+    hdl->paramSize = jvxfs_sigproc_get_parameter_size(hdl->config);
+    hdl->paramActive = 0;
+    hdl->paramBack = 1;
+    hdl->paramStaging = 2;
+    hdl->paramLatest = 0;
+    hdl->paramWriter = 0;
+    if (switch_mutex_init(&hdl->paramMutex, SWITCH_MUTEX_NESTED, switch_core_session_get_pool(session)) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_PROCESSOR,
+            "Could not create parameter lock.");
+    }
+    for (int i = 0; i < 3; ++i) {
+        hdl->params[i] = NULL;
+        if (!hdl->paramSize) continue;
+        hdl->params[i] = alloc_aligned(session, hdl->paramSize);
+        if (!hdl->params[i]) {
+            return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_PROCESSOR,
+                "Could not create parameter blocks.");
+        }
+        const void* defaults = jvxfs_sigproc_get_parameter_defaults(hdl->config);
+        if (defaults) {
+            memcpy(hdl->params[i], defaults, hdl->paramSize);
+        } else {
+            memset(hdl->params[i], 0, hdl->paramSize);
+        }
+    }
+    if (jvxfs_sigproc_is_resampling(hdl->config)) {
+        hdl->resampled = (int16_t*)alloc_aligned(session, BOUNCE_BUFFER_SIZE);
+        if (!hdl->resampled) {
+            return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_PROCESSOR,
+                "Could not create resampling buffer.");
+        }
+    }
+    jvxfs_sigproc_batch_collector_t* batch = jvxfs_app_get_sigproc_batch_collector(app);
+    if (batch || jvxfs_sigproc_get_execution(hdl->config) == JVXFS_SP_EXEC_ASYNC) {
+        hdl->job.task.func = run_job;
+        hdl->job.task.data = hdl;
+        hdl->job.slot.prepare = prepare_job;
+        hdl->job.slot.finish = finish_job;
+        hdl->job.slot.data = hdl;
+        hdl->job.data = alloc_aligned(session, BOUNCE_BUFFER_SIZE);
+        hdl->delayed[0] = alloc_aligned(session, BOUNCE_BUFFER_SIZE);
+        hdl->delayed[1] = alloc_aligned(session, BOUNCE_BUFFER_SIZE);
+        if (jvxfs_sigproc_buffers_channel(hdl->config) == JVXFS_SP_BUFFER_BOTH_LINKS) {
+            hdl->job.refData = alloc_aligned(session, BOUNCE_BUFFER_SIZE);
+        }
+        if (!hdl->job.data || !hdl->delayed[0] || !hdl->delayed[1]) {
+            return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_PROCESSOR,
+                "Could not create buffers for asynchronous processing.");
+        }
+    }
+    res = jvxfs_channel_create_model(&hdl->downlink, err, switch_core_session_get_pool(session));
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = jvxfs_channel_create_model(&hdl->uplink, err, switch_core_session_get_pool(session));
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    if (jvxfs_sigproc_buffers_channel(hdl->config) == JVXFS_SP_BUFFER_BOTH_LINKS) {
+        jvxfs_sigproc_channel_t refLink = (jvxfs_sigproc_get_working_channel(hdl->config) == JVXFS_SP_UPLINK) ?
+            JVXFS_SP_DOWNLINK : JVXFS_SP_UPLINK;
+        res = jvxfs_link_pair_create(&hdl->pair, refLink, err, switch_core_session_get_pool(session));
+        if (res != JVXFS_STATUS_SUCCESS) return res;
+    }
+    if (hdl->vtable->process_spectral) {
+        /* Hops are collected like blocks, the engine then turns each one into a spectrum. */
+        res = jvxfs_stft_create(&hdl->stft, jvxfs_sigproc_get_stft_size(hdl->config), jvxfs_sigproc_get_stft_hop(hdl->config),
+            jvxfs_sigproc_get_stft_window(hdl->config), 1, err, switch_core_session_get_pool(session));
+        if (res != JVXFS_STATUS_SUCCESS) return res;
+        res = jvxfs_reblock_create(&hdl->reblock, jvxfs_stft_get_hop(hdl->stft), err, switch_core_session_get_pool(session));
+        if (res != JVXFS_STATUS_SUCCESS) return res;
+    } else if (jvxfs_sigproc_get_block_size(hdl->config)) {
+        res = jvxfs_reblock_create(&hdl->reblock, jvxfs_sigproc_get_block_size(hdl->config), err,
+            switch_core_session_get_pool(session));
+        if (res != JVXFS_STATUS_SUCCESS) return res;
+    }
     res = jvxfs_observer_create(&hdl->mode_obs, hdl, err, switch_core_session_get_pool(session));
     if (res != JVXFS_STATUS_SUCCESS) return res;
     switch_atomic_set(&hdl->mode, JVXFS_SP_ALGO_ON);
     set_state(hdl, JVXFS_SP_CONSTRUCTING);
-//TODO: configure algorithm before media bug!
+    res = construct_algo(hdl);
+    if (res != JVXFS_STATUS_SUCCESS) {
+        set_state(hdl, JVXFS_SP_FAILED);
+        return res;
+    }
+    if (batch && jvxfs_batch_attach(batch, &hdl->job.slot) == JVXFS_STATUS_SUCCESS) {
+        hdl->batch = batch;
+    } else if (jvxfs_sigproc_get_execution(hdl->config) == JVXFS_SP_EXEC_ASYNC) {
+        hdl->worker = jvxfs_module_get_worker(jvxfs_app_get_module(app));
+    }
     res = install_media_bug(hdl);
     if (res != JVXFS_STATUS_SUCCESS) {
+        if (hdl->batch) jvxfs_batch_detach(hdl->batch, &hdl->job.slot);
         set_state(hdl, JVXFS_SP_FAILED);
+        destruct_algo(hdl);
         return res;
     }
     *obj = hdl;
@@ -68,7 +303,7 @@ switch_core_session_t* jvxfs_sigproc_get_session(jvxfs_sigproc_processor_t* proc
 jvxfs_sigproc_state_t jvxfs_sigproc_get_state(jvxfs_sigproc_processor_t* proc)
 {
     proc_t* hdl = (proc_t*)proc;
-    return hdl->state;
+    return jvxfs_atomic_load(&hdl->state);
 }
 
 jvxfs_sigproc_algo_mode_t jvxfs_sigproc_get_mode(jvxfs_sigproc_processor_t* proc)
@@ -85,7 +320,8 @@ jvxfs_status_t jvxfs_sigproc_set_mode(jvxfs_sigproc_processor_t* proc, jvxfs_sig
             "Unknown algorithm mode.");
     }
     switch_atomic_set(&hdl->mode, mode);
-    jvxfs_observer_notify(hdl->mode_obs);
+    /* Observers of asynchronously processed sessions run on the worker, the API thread does not wait for them. */
+    jvxfs_observer_notify_async(hdl->mode_obs, hdl->worker);
     return JVXFS_STATUS_SUCCESS;
 }
 
@@ -101,10 +337,80 @@ void jvxfs_sigproc_remove_mode_observer(jvxfs_sigproc_processor_t* proc, jvxfs_s
     jvxfs_observer_remove(hdl->mode_obs, func);
 }
 
+jvxfs_channel_model_t* jvxfs_sigproc_get_downlink_info(jvxfs_sigproc_processor_t* proc)
+{
+    proc_t* hdl = (proc_t*)proc;
+    return hdl->downlink;
+}
+
+jvxfs_channel_model_t* jvxfs_sigproc_get_uplink_info(jvxfs_sigproc_processor_t* proc)
+{
+    proc_t* hdl = (proc_t*)proc;
+    return hdl->uplink;
+}
+
+jvxfs_histogram_t* jvxfs_sigproc_get_stats(jvxfs_sigproc_processor_t* proc)
+{
+    proc_t* hdl = (proc_t*)proc;
+    return hdl->stats;
+}
+
+uint32_t jvxfs_sigproc_get_block_latency(jvxfs_sigproc_processor_t* proc)
+{
+    proc_t* hdl = (proc_t*)proc;
+    uint32_t latency = hdl->reblock ? jvxfs_reblock_get_latency(hdl->reblock) : 0;
+    return hdl->stft ? latency + jvxfs_stft_get_latency(hdl->stft) : latency;
+}
+
+void* jvxfs_sigproc_begin_update(jvxfs_sigproc_processor_t* proc)
+{
+    proc_t* hdl = (proc_t*)proc;
+    if (!hdl->paramSize) return NULL;
+    /* Only the flag is held until the block is handed back, the lock is taken by each call alone. */
+    uintptr_t idle = 0;
+    if (!jvxfs_atomic_cas(&hdl->paramWriter, &idle, writer_id())) return NULL;
+    return hdl->params[hdl->paramStaging];
+}
+
+void jvxfs_sigproc_update(jvxfs_sigproc_processor_t* proc)
+{
+    proc_t* hdl = (proc_t*)proc;
+    /* Called without jvxfs_sigproc_begin_update(), the unchanged staging block is published, unless another
+     * writer is filling it. */
+    uintptr_t self = writer_id();
+    uintptr_t idle = 0;
+    bool owner = hdl->paramSize &&
+        (jvxfs_atomic_load(&hdl->paramWriter) == self || jvxfs_atomic_cas(&hdl->paramWriter, &idle, self));
+    switch_mutex_lock(hdl->paramMutex);
+    if (owner || !hdl->paramSize) {
+        /* The block in back is either a stale publication or the one the processing thread released last. */
+        uint32_t published = hdl->paramStaging;
+        uint32_t old = jvxfs_atomic_exchange(&hdl->paramBack, published | PARAM_DIRTY);
+        hdl->paramStaging = old & PARAM_INDEX;
+        hdl->paramLatest = published;
+        if (hdl->paramSize) memcpy(hdl->params[hdl->paramStaging], hdl->params[published], hdl->paramSize);
+    }
+    if (hdl->vtable->update && hdl->vtable->flag == JVXFS_SP_DISABLE_SYNC_UPDATE) {
+        hdl->vtable->update(hdl->algo, JVXFS_SP_EXEC_ASYNC);
+    }
+    switch_mutex_unlock(hdl->paramMutex);
+    if (owner) jvxfs_atomic_store(&hdl->paramWriter, 0);
+}
+
+void jvxfs_sigproc_abort_update(jvxfs_sigproc_processor_t* proc)
+{
+    proc_t* hdl = (proc_t*)proc;
+    if (!hdl->paramSize || jvxfs_atomic_load(&hdl->paramWriter) != writer_id()) return;
+    switch_mutex_lock(hdl->paramMutex);
+    memcpy(hdl->params[hdl->paramStaging], hdl->params[hdl->paramLatest], hdl->paramSize);
+    switch_mutex_unlock(hdl->paramMutex);
+    jvxfs_atomic_store(&hdl->paramWriter, 0);
+}
+
 
 void set_state(proc_t* hdl, jvxfs_sigproc_state_t state)
 {
-    hdl->state = state;
+    jvxfs_atomic_store(&hdl->state, state);
 }
 
 switch_bool_t media_bug_callback(switch_media_bug_t* bug, void* handle, switch_abc_type_t type)
@@ -121,17 +427,18 @@ switch_bool_t media_bug_callback(switch_media_bug_t* bug, void* handle, switch_a
 	case SWITCH_ABC_TYPE_WRITE:
 		break;
 	case SWITCH_ABC_TYPE_READ_REPLACE:
+        {
+            switch_frame_t* frame = switch_core_media_bug_get_read_replace_frame(bug);
+            handle_frame(hdl, frame, JVXFS_SP_UPLINK);
+            switch_core_media_bug_set_read_replace_frame(bug, frame);
+        }
 		break;
 	case SWITCH_ABC_TYPE_WRITE_REPLACE:
-		//do sp stuff
-		/*{
-			switch_frame_t* frame = switch_core_media_bug_get_write_replace_frame(bug);
-			if (objHandle->isFilterOn() && frame && frame->data)
-				{	
-					objHandle->process(static_cast<short*>(frame->data));
-					switch_core_media_bug_set_write_replace_frame(bug, frame);
-				}
-		}*/
+        {
+            switch_frame_t* frame = switch_core_media_bug_get_write_replace_frame(bug);
+            handle_frame(hdl, frame, JVXFS_SP_DOWNLINK);
+            switch_core_media_bug_set_write_replace_frame(bug, frame);
+        }
 		break;
 	default:
 		break;
@@ -151,7 +458,8 @@ jvxfs_status_t install_media_bug(proc_t* hdl)
             bug_flags = SMBF_READ_REPLACE;
             break;
         case JVXFS_SP_BUFFER_BOTH_LINKS:
-
+            bug_flags = SMBF_READ_REPLACE | SMBF_WRITE_REPLACE;
+            break;
         default:
             bug_flags = SMBF_PRUNE;
     }
@@ -164,15 +472,398 @@ jvxfs_status_t install_media_bug(proc_t* hdl)
     return JVXFS_STATUS_SUCCESS;
 }
 
+jvxfs_status_t construct_algo(proc_t* hdl)
+{
+    jvxfs_sigproc_channel_t link = jvxfs_sigproc_get_working_channel(hdl->config);
+    jvxfs_channel_fetching_t fetchDown = JVXFS_CHANNEL_IGNORING;
+    jvxfs_channel_fetching_t fetchUp = JVXFS_CHANNEL_IGNORING;
+    if (link == JVXFS_SP_UPLINK) {
+        fetchUp = JVXFS_CHANNEL_REPLACING;
+        if (hdl->pair) fetchDown = JVXFS_CHANNEL_CATCHING;
+    } else {
+        fetchDown = JVXFS_CHANNEL_REPLACING;
+        if (hdl->pair) fetchUp = JVXFS_CHANNEL_CATCHING;
+    }
+    jvxfs_sigproc_datatype_t type = hdl->convert ? jvxfs_sigproc_get_datatype(hdl->config) : JVXFS_SP_16BIT_LE;
+    hdl->media.link = (link == JVXFS_SP_UPLINK) ? JVXFS_SP_UPLINK : JVXFS_SP_DOWNLINK;
+    if (hdl->resampled) jvxfs_channel_set_config(working_model(hdl), hdl->config);
+    jvxfs_status_t res = jvxfs_channel_bind(hdl->downlink, hdl->session, JVXFS_SP_DOWNLINK, fetchDown, type);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = jvxfs_channel_bind(hdl->uplink, hdl->session, JVXFS_SP_UPLINK, fetchUp, type);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    hdl->media.data = NULL;
+    describe_media(hdl);
+    /* The algorithm never sees the frames of the link, only blocks. */
+    if (hdl->reblock) hdl->media.samples = jvxfs_reblock_get_block_size(hdl->reblock);
+    hdl->media.sequence = 0;
+    hdl->media.reference = NULL;
+    hdl->media.reference_delay = 0;
+    hdl->media.reference_drift = 0;
+    hdl->media.parameters = hdl->params[hdl->paramActive];
+    hdl->configBlock = jvxfs_config_acquire(hdl->settings);
+    hdl->media.config = hdl->configBlock;
+    hdl->media.scratch = NULL;
+    hdl->media.scratch_size = 0;
+    /* Pooled instances are constructed without arguments, a call with arguments needs its own one. */
+    jvxfs_sigproc_instance_pool_t* instances = jvxfs_app_get_sigproc_instance_pool(hdl->app);
+    if (instances && hdl->args[0] == '\0') {
+        jvxfs_instance_pool_acquire(instances, &hdl->algo, &hdl->instScratch);
+        hdl->instances = instances;
+        hdl->media.scratch_size = hdl->instScratch;
+    } else {
+        hdl->vtable->construct(&hdl->algo, &hdl->media, hdl->args);
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
 void init_algo(proc_t* hdl)
 {
     set_state(hdl, JVXFS_SP_INITIALIZING);
-    hdl->vtable->initialize(NULL, NULL);
+    hdl->vtable->initialize(hdl->algo, &hdl->media);
+    /* An arena smaller than declared now is replaced, its pool memory is only returned with the session. */
+    jvxfs_arena_t* scratch = hdl->media.scratch;
+    if (hdl->media.scratch_size && (!scratch || jvxfs_arena_get_size(scratch) < hdl->media.scratch_size) &&
+        jvxfs_arena_create(&hdl->media.scratch, hdl->media.scratch_size, hdl->err,
+        switch_core_session_get_pool(hdl->session)) != JVXFS_STATUS_SUCCESS) {
+        hdl->vtable->terminate(hdl->algo);
+        set_state(hdl, JVXFS_SP_FAILED);
+        return;
+    }
+    /* A pooled instance hands the larger size on to the next session taking it. */
+    if (hdl->instances && hdl->media.scratch_size > hdl->instScratch) hdl->instScratch = hdl->media.scratch_size;
+    set_state(hdl, JVXFS_SP_PROCESSING);
+}
+
+void handle_frame(proc_t* hdl, switch_frame_t* frame, jvxfs_sigproc_channel_t link)
+{
+    if (!frame || !frame->data || !frame->samples) return;
+    jvxfs_channel_refresh((link == JVXFS_SP_UPLINK) ? hdl->uplink : hdl->downlink, frame);
+    if (hdl->pair && link != hdl->media.link) {
+        jvxfs_link_pair_push(hdl->pair, frame);
+        return;
+    }
+    describe_media(hdl);
+    if (hdl->pair) {
+        hdl->media.reference = jvxfs_link_pair_pop(hdl->pair, &hdl->media);
+        uint64_t slips = jvxfs_link_pair_count_slips(hdl->pair);
+        if (slips != hdl->pairSlips) count_stat(hdl, JVXFS_SP_STAT_REFERENCE_SLIPS, slips - hdl->pairSlips);
+        hdl->pairSlips = slips;
+    }
+    process_frame(hdl, frame);
+}
+
+void process_frame(proc_t* hdl, switch_frame_t* frame)
+{
+    jvxfs_sigproc_algo_mode_t mode = switch_atomic_read(&hdl->mode);
+    jvxfs_sigproc_state_t state = jvxfs_atomic_load(&hdl->state);
+    if (mode == JVXFS_SP_ALGO_OFF || (state != JVXFS_SP_PROCESSING && state != JVXFS_SP_UPDATING)) {
+        hdl->hasPrevious = false;
+        return;
+    }
+    size_t bytes = frame->datalen;
+    if (mode == JVXFS_SP_ALGO_MUTE) {
+        hdl->hasPrevious = false;
+        memset(frame->data, 0, bytes);
+        return;
+    }
+    switch_time_t start = switch_time_now();
+    if (hdl->batch || hdl->worker) {
+        process_deferred(hdl, frame);
+    } else {
+        run_pipeline(hdl, &hdl->media, frame->data, bytes, frame->buflen,
+            jvxfs_channel_get_original_samplerate(working_model(hdl)));
+    }
+    ++(hdl->media.sequence);
+    switch_time_t elapsed = switch_time_now() - start;
+    jvxfs_histogram_record(hdl->stats, (uint64_t)elapsed);
+    if (hdl->appStats) jvxfs_histogram_record(hdl->appStats, (uint64_t)elapsed);
+    count_stat(hdl, JVXFS_SP_STAT_FRAMES, 1);
+    uint32_t deadline = jvxfs_channel_get_frame_duration_us(working_model(hdl));
+    if (deadline && elapsed > deadline) count_stat(hdl, JVXFS_SP_STAT_DEADLINE_MISSES, 1);
+}
+
+void process_deferred(proc_t* hdl, switch_frame_t* frame)
+{
+    async_job_t* job = &hdl->job;
+    size_t bytes = (frame->datalen < BOUNCE_BUFFER_SIZE) ? frame->datalen : BOUNCE_BUFFER_SIZE;
+    uint32_t current = hdl->delayedIndex ^ 1;
+    uint32_t previous = hdl->delayedIndex;
+    hdl->delayedIndex = current;
+    memcpy(hdl->delayed[current], frame->data, bytes);
+    hdl->delayedBytes[current] = bytes;
+    /* Output of the previous frame, its input is passed through if the job missed the deadline. */
+    const void* out = NULL;
+    size_t outBytes = 0;
+    if (hdl->hasPrevious) {
+        if (jvxfs_atomic_load(&job->state) == JOB_DONE && job->media.sequence + 1 == hdl->media.sequence) {
+            out = job->data;
+            outBytes = job->bytes;
+        } else {
+            out = hdl->delayed[previous];
+            outBytes = hdl->delayedBytes[previous];
+            count_stat(hdl, JVXFS_SP_STAT_PASSTHROUGHS, 1);
+        }
+    }
+    if (outBytes > bytes) outBytes = bytes;
+    if (out) memcpy(frame->data, out, outBytes);
+    if (outBytes < frame->datalen) memset((uint8_t*)frame->data + outBytes, 0, frame->datalen - outBytes);
+    hdl->hasPrevious = true;
+    /* The algorithm runs sequentially, a job still running blocks the next one. */
+    if (jvxfs_atomic_load(&job->state) == JOB_QUEUED) return;
+    memcpy(job->data, hdl->delayed[current], bytes);
+    job->bytes = bytes;
+    job->media = hdl->media;
+    job->linkRate = jvxfs_channel_get_original_samplerate(working_model(hdl));
+    const jvxfs_sigproc_media_t* ref = hdl->media.reference;
+    if (ref && job->refData) {
+        size_t refBytes = (size_t)ref->samples * (ref->channels ? ref->channels : 1) * sizeof(int16_t);
+        if (refBytes > BOUNCE_BUFFER_SIZE) refBytes = BOUNCE_BUFFER_SIZE;
+        memcpy(job->refData, ref->data, refBytes);
+        job->reference = *ref;
+        job->reference.data = job->refData;
+        job->media.reference = &job->reference;
+    }
+    /* The batch collector picks up queued jobs on its next tick. */
+    jvxfs_atomic_store(&job->state, JOB_QUEUED);
+    if (hdl->worker && !jvxfs_worker_submit(hdl->worker, &job->task)) {
+        jvxfs_atomic_store(&job->state, JOB_IDLE);
+    }
+}
+
+void run_job(void* data)
+{
+    proc_t* hdl = (proc_t*)data;
+    async_job_t* job = &hdl->job;
+    run_pipeline(hdl, &job->media, job->data, job->bytes, BOUNCE_BUFFER_SIZE, job->linkRate);
+    jvxfs_atomic_store(&job->state, JOB_DONE);
+}
+
+bool prepare_job(void* data, void** algo, jvxfs_sigproc_media_t** media)
+{
+    proc_t* hdl = (proc_t*)data;
+    async_job_t* job = &hdl->job;
+    if (jvxfs_atomic_load(&job->state) != JOB_QUEUED) return false;
+    enter_pipeline(hdl, &job->stage, &job->media, job->data, job->bytes, BOUNCE_BUFFER_SIZE, job->linkRate);
+    if (!job->stage.valid) {
+        finish_job(hdl);
+        return false;
+    }
+    *algo = hdl->algo;
+    *media = &job->media;
+    return true;
+}
+
+void finish_job(void* data)
+{
+    proc_t* hdl = (proc_t*)data;
+    async_job_t* job = &hdl->job;
+    leave_pipeline(hdl, &job->stage, &job->media);
+    jvxfs_atomic_store(&job->state, JOB_DONE);
+}
+
+void run_pipeline(proc_t* hdl, jvxfs_sigproc_media_t* media, void* data, size_t bytes, size_t buflen, uint32_t linkRate)
+{
+    stage_t st;
+    enter_pipeline(hdl, &st, media, data, bytes, buflen, linkRate);
+    if (st.valid && hdl->reblock) {
+        size_t sampleSize = hdl->convert ? jvxfs_convert_get_sample_size(media->type) : sizeof(int16_t);
+        jvxfs_reblock_process(hdl->reblock, hdl->stft ? (void*)hdl : hdl->algo,
+            hdl->stft ? process_spectral : hdl->vtable->process, media, st.l16Bytes / (sizeof(int16_t) * st.channels), sampleSize);
+    } else if (st.valid) {
+        hdl->vtable->process(hdl->algo, media);
+    }
+    leave_pipeline(hdl, &st, media);
+}
+
+void enter_pipeline(proc_t* hdl, stage_t* st, jvxfs_sigproc_media_t* media, void* data, size_t bytes, size_t buflen,
+    uint32_t linkRate)
+{
+    apply_update(hdl, media);
+    if (media->scratch) jvxfs_arena_reset(media->scratch);
+    if (hdl->resampled) update_resampling(hdl, linkRate, media->rate, media->channels);
+    st->data = data;
+    st->channels = media->channels ? media->channels : 1;
+    st->samples = bytes / (sizeof(int16_t) * st->channels);
+    st->l16 = (int16_t*)data;
+    st->l16Bytes = bytes;
+    st->valid = false;
+    st->copyBack = false;
+    if (hdl->toProcessing) {
+        size_t capacity = BOUNCE_BUFFER_SIZE / (sizeof(int16_t) * st->channels);
+        size_t resampled = resample(hdl->toProcessing, (const int16_t*)data, st->samples, hdl->resampled, capacity,
+            st->channels);
+        st->l16 = hdl->resampled;
+        st->l16Bytes = resampled * st->channels * sizeof(int16_t);
+        buflen = BOUNCE_BUFFER_SIZE;
+    }
+    if (hdl->convert) {
+        size_t samples = st->l16Bytes / sizeof(int16_t);
+        size_t converted = samples * jvxfs_convert_get_sample_size(media->type);
+        size_t padded = ALIGN_UP(converted);
+        if (padded > hdl->bounceSize) return;
+        jvxfs_convert_from_l16(hdl->bounce, media->type, st->l16, samples);
+        if (padded > converted) memset(hdl->bounce + converted, 0, padded - converted);
+        media->data = hdl->bounce;
+        st->valid = true;
+        return;
+    }
+    size_t padded = ALIGN_UP(st->l16Bytes);
+    bool inPlace = IS_ALIGNED(st->l16) && buflen >= padded;
+    if (!inPlace && padded > hdl->bounceSize) return;
+    if (inPlace) {
+        media->data = st->l16;
+    } else {
+        memcpy(hdl->bounce, st->l16, st->l16Bytes);
+        if (padded > st->l16Bytes) memset(hdl->bounce + st->l16Bytes, 0, padded - st->l16Bytes);
+        media->data = hdl->bounce;
+        st->copyBack = true;
+    }
+    st->valid = true;
+}
+
+void leave_pipeline(proc_t* hdl, stage_t* st, jvxfs_sigproc_media_t* media)
+{
+    if (st->valid && hdl->convert) {
+        jvxfs_convert_to_l16(st->l16, hdl->bounce, media->type, st->l16Bytes / sizeof(int16_t));
+    } else if (st->valid && st->copyBack) {
+        memcpy(st->l16, hdl->bounce, st->l16Bytes);
+    }
+    if (hdl->toProcessing) {
+        resample(hdl->toLink, hdl->resampled, st->l16Bytes / (sizeof(int16_t) * st->channels), (int16_t*)st->data,
+            st->samples, st->channels);
+    }
+}
+
+void apply_update(proc_t* hdl, jvxfs_sigproc_media_t* media)
+{
+    if (jvxfs_atomic_load_relaxed(&hdl->paramBack) & PARAM_DIRTY) {
+        uint32_t back = jvxfs_atomic_exchange(&hdl->paramBack, hdl->paramActive);
+        hdl->paramActive = back & PARAM_INDEX;
+        if (hdl->vtable->update && hdl->vtable->flag == JVXFS_SP_ENABLE_SYNC_UPDATE) {
+            set_state(hdl, JVXFS_SP_UPDATING);
+            hdl->vtable->update(hdl->algo, (hdl->worker || hdl->batch) ? JVXFS_SP_EXEC_ASYNC : JVXFS_SP_EXEC_SYNC);
+            set_state(hdl, JVXFS_SP_PROCESSING);
+        }
+    }
+    media->parameters = hdl->params[hdl->paramActive];
+    /* The processor holds one block, the media of a frame only borrows it. */
+    hdl->configBlock = jvxfs_config_refresh(hdl->settings, hdl->configBlock);
+    hdl->media.config = hdl->configBlock;
+    media->config = hdl->configBlock;
+}
+
+void update_resampling(proc_t* hdl, uint32_t linkRate, uint32_t processingRate, uint8_t channels)
+{
+    if (linkRate == hdl->linkRate && processingRate == hdl->processingRate) return;
+    hdl->linkRate = linkRate;
+    hdl->processingRate = processingRate;
+    hdl->toProcessing = NULL;
+    hdl->toLink = NULL;
+    if (linkRate == processingRate) return;
+    /* Session memory is only released at hangup, so the resamplers are retargeted and only replaced if their
+     * history is too small for the new filter. */
+    switch_memory_pool_t* pool = switch_core_session_get_pool(hdl->session);
+    const uint32_t rates[2][2] = { { linkRate, processingRate }, { processingRate, linkRate } };
+    for (int i = 0; i < 2; ++i) {
+        if (hdl->resamplers[i] &&
+            jvxfs_resampler_set_rates(hdl->resamplers[i], rates[i][0], rates[i][1], channels) == JVXFS_STATUS_SUCCESS) {
+            continue;
+        }
+        jvxfs_resampler_t* rs = NULL;
+        if (jvxfs_resampler_create(&rs, rates[i][0], rates[i][1], channels, hdl->err, pool) != JVXFS_STATUS_SUCCESS) return;
+        hdl->resamplers[i] = rs;
+    }
+    hdl->toProcessing = hdl->resamplers[0];
+    hdl->toLink = hdl->resamplers[1];
 }
 
 void destroy_processor(proc_t* hdl)
 {
+    /* Unregistered first, so no fan-out of a directive reaches the processor while it is torn down. */
+    jvxfs_session_remove_app_instance(hdl->session, hdl->app);
+    if (hdl->batch) {
+        jvxfs_batch_detach(hdl->batch, &hdl->job.slot);
+    } else {
+        while (jvxfs_atomic_load(&hdl->job.state) == JOB_QUEUED) switch_yield(1000);
+    }
+    jvxfs_sigproc_state_t state = jvxfs_atomic_load(&hdl->state);
+    if (state == JVXFS_SP_PROCESSING || state == JVXFS_SP_UPDATING || state == JVXFS_SP_HIBERNATING) {
+        set_state(hdl, JVXFS_SP_TERMINATING);
+        hdl->vtable->terminate(hdl->algo);
+    }
     set_state(hdl, JVXFS_SP_DESTRUCTING);
-    if (hdl->vtable->destruct) hdl->vtable->destruct(NULL);
+    destruct_algo(hdl);
     jvxfs_observer_destroy(&hdl->mode_obs);
+    jvxfs_channel_destroy_model(&hdl->downlink);
+    jvxfs_channel_destroy_model(&hdl->uplink);
+}
+
+void destruct_algo(proc_t* hdl)
+{
+    /* Pooled instances go back to the pool, they are destructed when the app is deleted. */
+    if (hdl->instances) {
+        jvxfs_instance_pool_release(hdl->instances, hdl->algo, hdl->instScratch);
+        hdl->instances = NULL;
+    } else if (hdl->vtable->destruct) {
+        hdl->vtable->destruct(&hdl->algo);
+    }
+    hdl->algo = NULL;
+    jvxfs_config_release(hdl->settings, hdl->configBlock);
+    hdl->configBlock = NULL;
+}
+
+void count_stat(proc_t* hdl, jvxfs_sigproc_stat_t stat, uint64_t n)
+{
+    jvxfs_histogram_count(hdl->stats, stat, n);
+    if (hdl->appStats) jvxfs_histogram_count(hdl->appStats, stat, n);
+}
+
+jvxfs_channel_model_t* working_model(proc_t* hdl)
+{
+    return (hdl->media.link == JVXFS_SP_UPLINK) ? hdl->uplink : hdl->downlink;
+}
+
+uint8_t* alloc_aligned(switch_core_session_t* session, size_t size)
+{
+    uint8_t* mem = (uint8_t*)switch_core_session_alloc(session, size + JVXFS_SP_MEMORY_ALIGNMENT);
+    return mem ? (uint8_t*)ALIGN_UP((uintptr_t)mem) : NULL;
+}
+
+void describe_media(proc_t* hdl)
+{
+    jvxfs_channel_describe(working_model(hdl), &hdl->media);
+    /* The samplerate only changes with the codec, so the profile is looked up once per change. */
+    if (hdl->media.rate != hdl->profileRate) {
+        hdl->profileRate = hdl->media.rate;
+        hdl->media.profile = jvxfs_sigproc_get_profile(hdl->config, hdl->media.rate);
+    }
+}
+
+size_t resample(jvxfs_resampler_t* rs, const int16_t* in, size_t frames, int16_t* out, size_t capacity, uint8_t channels)
+{
+    /* The history takes the input in parts if it still holds samples of the previous call. */
+    size_t done = 0;
+    size_t produced = 0;
+    while (done < frames) {
+        size_t used = 0;
+        produced += jvxfs_resampler_process(rs, in + done * channels, frames - done, out + produced * channels,
+            capacity - produced, &used);
+        if (!used) break;
+        done += used;
+    }
+    if (done < frames) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Resampler dropped %u samples.\n", (unsigned)(frames - done));
+    }
+    return produced;
+}
+
+void process_spectral(void* data, jvxfs_sigproc_media_t* media)
+{
+    proc_t* hdl = (proc_t*)data;
+    jvxfs_stft_process(hdl->stft, hdl->algo, hdl->vtable->process_spectral, media);
+}
+
+uintptr_t writer_id(void)
+{
+    return (uintptr_t)switch_thread_self();
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 #define LIB_JVX_FS_FRAMEWORK_PROCESSING_PROCESSOR_H
 
 #include <switch.h>
+#include "../utils/histogram.h"
 #include "sp_defines.h"
 
 JVX_FS_LIB_BEGIN
@@ -32,6 +33,17 @@ typedef enum
     JVXFS_SP_FAILED
 } jvxfs_sigproc_state_t;
 
+/**
+ * @brief Counters of the processing statistics, see jvxfs_sigproc_get_stats().
+ */
+typedef enum
+{
+    JVXFS_SP_STAT_FRAMES,
+    JVXFS_SP_STAT_DEADLINE_MISSES,
+    JVXFS_SP_STAT_PASSTHROUGHS,
+    JVXFS_SP_STAT_REFERENCE_SLIPS
+} jvxfs_sigproc_stat_t;
+
 typedef void(*jvxfs_sigproc_mode_observer_t)(jvxfs_sigproc_processor_t*, void*);
 
 
@@ -45,6 +57,11 @@ jvxfs_sigproc_state_t jvxfs_sigproc_get_state(jvxfs_sigproc_processor_t* proc);
 jvxfs_sigproc_algo_mode_t jvxfs_sigproc_get_mode(jvxfs_sigproc_processor_t* proc);
 jvxfs_status_t jvxfs_sigproc_set_mode(jvxfs_sigproc_processor_t* proc, jvxfs_sigproc_algo_mode_t mode);
 
+/**
+ * @brief Observe changes of the algorithm mode.
+ * @details Observers of a session with asynchronous execution are called on a worker thread, otherwise on
+ * the thread setting the mode.
+ */
 jvxfs_status_t jvxfs_sigproc_add_mode_observer(jvxfs_sigproc_processor_t* proc, jvxfs_sigproc_mode_observer_t func, void* data);
 void jvxfs_sigproc_remove_mode_observer(jvxfs_sigproc_processor_t* proc, jvxfs_sigproc_mode_observer_t func);
 
@@ -52,7 +69,38 @@ jvxfs_channel_model_t* jvxfs_sigproc_get_downlink_info(jvxfs_sigproc_processor_t
 
 jvxfs_channel_model_t* jvxfs_sigproc_get_uplink_info(jvxfs_sigproc_processor_t* proc);
 
+/**
+ * @brief Start changing the parameter block of a processor.
+ * @return Staging block holding the latest parameters, @em NULL if the app declared no parameter block or
+ * another writer holds it.
+ * @details One writer at a time holds the staging block, the processing thread is never blocked. The block
+ * has to be handed back by the same thread with jvxfs_sigproc_update(), which publishes it, or
+ * jvxfs_sigproc_abort_update().
+ * A published block is swapped in before the next frame is processed, so a frame never sees a partly
+ * written block. With #JVXFS_SP_ENABLE_SYNC_UPDATE the update function of the algorithm is called right
+ * after the swap on the processing thread while the processor is in #JVXFS_SP_UPDATING, otherwise it
+ * is called on the publishing thread.
+ * @see jvxfs_sigproc_set_parameters()
+ */
+void* jvxfs_sigproc_begin_update(jvxfs_sigproc_processor_t* proc);
 void jvxfs_sigproc_update(jvxfs_sigproc_processor_t* proc);
+void jvxfs_sigproc_abort_update(jvxfs_sigproc_processor_t* proc);
+
+/**
+ * @brief Processing statistics of a processor.
+ * @details The histogram holds the time in us from receiving a frame to handing it back, the counters
+ * are indexed by #jvxfs_sigproc_stat_t. A frame taking longer than its duration is a deadline miss, a
+ * frame whose asynchronous processing was not done in time is passed through unprocessed.
+ * All processors of an app also record into jvxfs_app_get_sigproc_stats().
+ */
+jvxfs_histogram_t* jvxfs_sigproc_get_stats(jvxfs_sigproc_processor_t* proc);
+
+/**
+ * @brief Delay in samples at the processing samplerate added by collecting frames into blocks and by the STFT.
+ * @details 0 if the app has no block size or spectral function, see jvxfs_sigproc_set_block_size() and
+ * jvxfs_app_set_sigproc_spectral_func(). The part of the blocks is only known after the first frame.
+ */
+uint32_t jvxfs_sigproc_get_block_latency(jvxfs_sigproc_processor_t* proc);
 
 
 
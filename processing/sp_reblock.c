@@ -0,0 +1,219 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <string.h>
+#include "../system/error.h"
+#include "../utils/arena.h"
+#include "../utils/ringbuf.h"
+#include "sp_convert.h"
+#include "sp_reblock.h"
+
+#define ALIGN_UP(_n) (((_n) + JVXFS_SP_MEMORY_ALIGNMENT - 1) & ~((size_t)JVXFS_SP_MEMORY_ALIGNMENT - 1))
+#define MAX_SAMPLE_SIZE 8
+
+typedef struct
+{
+    uint32_t blockSize;
+    jvxfs_error_t* err;
+    switch_memory_pool_t* pool;
+    size_t frames;
+    size_t sampleSize;
+    uint8_t channels;
+    uint32_t rate;
+    jvxfs_sigproc_datatype_t type;
+    uint32_t latency;
+    uint64_t blocks;
+    uint8_t silence[MAX_SAMPLE_SIZE];
+    jvxfs_ringbuf_t in;
+    jvxfs_ringbuf_t out;
+    uint8_t* block;
+    uint8_t* mem;
+    size_t memSize;
+    uint8_t refChannels;
+    jvxfs_ringbuf_t ref;
+    jvxfs_sigproc_media_t refMedia;
+    uint8_t* refMem;
+    size_t refMemSize;
+} reblock_t;
+
+static bool configure(reblock_t* hdl, const jvxfs_sigproc_media_t* media, size_t frames, size_t sampleSize);
+static bool configure_reference(reblock_t* hdl, const jvxfs_sigproc_media_t* ref);
+static uint8_t* reserve(reblock_t* hdl, uint8_t** mem, size_t* memSize, size_t size);
+static size_t gcd(size_t a, size_t b);
+
+
+jvxfs_status_t jvxfs_reblock_create(jvxfs_sigproc_reblock_t** obj, uint32_t blockSize, jvxfs_error_t* err,
+    switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    if (!blockSize) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_REBLOCK,
+            "Block size must not be zero.");
+    }
+    reblock_t* hdl = (reblock_t*)switch_core_alloc(pool, sizeof(reblock_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_REBLOCK,
+            "Could not create reblocking stage.");
+    }
+    memset(hdl, 0, sizeof(reblock_t));
+    hdl->blockSize = blockSize;
+    hdl->err = err;
+    hdl->pool = pool;
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_reblock_process(jvxfs_sigproc_reblock_t* obj, void* algo, jvxfs_algorithm_process_t func,
+    jvxfs_sigproc_media_t* media, size_t samples, size_t sampleSize)
+{
+    reblock_t* hdl = (reblock_t*)obj;
+    if (!samples || !sampleSize || sampleSize > MAX_SAMPLE_SIZE) return;
+    if (!configure(hdl, media, samples, sampleSize)) return;
+    size_t elem = hdl->channels * hdl->sampleSize;
+    size_t frameBytes = samples * elem;
+    size_t blockBytes = hdl->blockSize * elem;
+    jvxfs_ringbuf_write(&hdl->in, media->data, frameBytes);
+    /* The reference is appended in lockstep, so its blocks cover the same samples as the blocks of the link. */
+    const jvxfs_sigproc_media_t* ref = media->reference;
+    bool hasRef = ref && ref->data && ref->samples == samples && configure_reference(hdl, ref);
+    if (hdl->refChannels) {
+        size_t refElem = hdl->refChannels * sizeof(int16_t);
+        if (hasRef) {
+            jvxfs_ringbuf_write(&hdl->ref, ref->data, samples * refElem);
+        } else {
+            static const int16_t zero = 0;
+            jvxfs_ringbuf_fill(&hdl->ref, &zero, sizeof(int16_t), samples * hdl->refChannels);
+        }
+    }
+    while (jvxfs_ringbuf_available(&hdl->in) >= blockBytes) {
+        jvxfs_sigproc_media_t block = *media;
+        jvxfs_ringbuf_read(&hdl->in, hdl->block, blockBytes);
+        block.data = hdl->block;
+        block.samples = hdl->blockSize;
+        block.sequence = hdl->blocks++;
+        block.reference = NULL;
+        if (hdl->refChannels) {
+            hdl->refMedia.samples = hdl->blockSize;
+            hdl->refMedia.rate = media->rate;
+            hdl->refMedia.sequence = block.sequence;
+            jvxfs_ringbuf_read(&hdl->ref, hdl->refMedia.data, hdl->blockSize * hdl->refChannels * sizeof(int16_t));
+            block.reference = &hdl->refMedia;
+        }
+        if (block.scratch) jvxfs_arena_reset(block.scratch);
+        func(algo, &block);
+        jvxfs_ringbuf_write(&hdl->out, hdl->block, blockBytes);
+    }
+    size_t ready = jvxfs_ringbuf_available(&hdl->out);
+    if (ready > frameBytes) ready = frameBytes;
+    jvxfs_ringbuf_read(&hdl->out, media->data, ready);
+    /* Never reached with the priming of configure(), but a frame is never left half written. */
+    for (size_t i = ready; i < frameBytes; i += hdl->sampleSize) {
+        memcpy((uint8_t*)media->data + i, hdl->silence, hdl->sampleSize);
+    }
+}
+
+uint32_t jvxfs_reblock_get_block_size(jvxfs_sigproc_reblock_t* obj)
+{
+    reblock_t* hdl = (reblock_t*)obj;
+    return hdl->blockSize;
+}
+
+uint32_t jvxfs_reblock_get_latency(jvxfs_sigproc_reblock_t* obj)
+{
+    reblock_t* hdl = (reblock_t*)obj;
+    return hdl->latency;
+}
+
+
+bool configure(reblock_t* hdl, const jvxfs_sigproc_media_t* media, size_t frames, size_t sampleSize)
+{
+    uint8_t channels = media->channels ? media->channels : 1;
+    if (hdl->block && frames == hdl->frames && sampleSize == hdl->sampleSize && channels == hdl->channels &&
+        media->rate == hdl->rate && media->type == hdl->type) {
+        return true;
+    }
+    size_t elem = channels * sampleSize;
+    /* In holds less than a block plus a frame, out never more than the priming plus a frame. */
+    size_t capacity = (hdl->blockSize + frames) * elem;
+    size_t blockBytes = ALIGN_UP(hdl->blockSize * elem);
+    size_t ringBytes = ALIGN_UP(capacity);
+    uint8_t* mem = reserve(hdl, &hdl->mem, &hdl->memSize, blockBytes + 2 * ringBytes);
+    if (!mem) {
+        hdl->block = NULL;
+        return false;
+    }
+    hdl->block = mem;
+    jvxfs_ringbuf_init(&hdl->in, mem + blockBytes, capacity);
+    jvxfs_ringbuf_init(&hdl->out, mem + blockBytes + ringBytes, capacity);
+    hdl->frames = frames;
+    hdl->sampleSize = sampleSize;
+    hdl->channels = channels;
+    hdl->rate = media->rate;
+    hdl->type = media->type;
+    memset(hdl->silence, 0, MAX_SAMPLE_SIZE);
+    if (jvxfs_convert_is_needed(media->type)) {
+        static const int16_t zero = 0;
+        jvxfs_convert_from_l16(hdl->silence, media->type, &zero, 1);
+    }
+    /* Frames of F and blocks of B samples only meet at multiples of gcd(F, B), the output is short of at most
+     * B - gcd(F, B) samples before a block completes. */
+    hdl->latency = (uint32_t)(hdl->blockSize - gcd(frames, hdl->blockSize));
+    jvxfs_ringbuf_fill(&hdl->out, hdl->silence, sampleSize, (size_t)hdl->latency * channels);
+    hdl->refChannels = 0;
+    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Reblocking frames of %u to blocks of %u samples, latency %u samples.\n",
+        (unsigned)frames, hdl->blockSize, hdl->latency);
+    return true;
+}
+
+bool configure_reference(reblock_t* hdl, const jvxfs_sigproc_media_t* ref)
+{
+    uint8_t channels = ref->channels ? ref->channels : 1;
+    if (channels == hdl->refChannels) return true;
+    size_t elem = channels * sizeof(int16_t);
+    size_t capacity = (hdl->blockSize + hdl->frames) * elem;
+    size_t blockBytes = ALIGN_UP(hdl->blockSize * elem);
+    uint8_t* mem = reserve(hdl, &hdl->refMem, &hdl->refMemSize, blockBytes + capacity);
+    if (!mem) {
+        hdl->refChannels = 0;
+        return false;
+    }
+    memset(&hdl->refMedia, 0, sizeof(jvxfs_sigproc_media_t));
+    hdl->refMedia.data = mem;
+    hdl->refMedia.channels = channels;
+    hdl->refMedia.type = JVXFS_SP_16BIT_LE;
+    hdl->refMedia.link = ref->link;
+    jvxfs_ringbuf_init(&hdl->ref, mem + blockBytes, capacity);
+    /* Start as full as the input ring, so the next block of both covers the same samples. */
+    static const int16_t zero = 0;
+    size_t pending = jvxfs_ringbuf_available(&hdl->in) / (hdl->channels * hdl->sampleSize);
+    jvxfs_ringbuf_fill(&hdl->ref, &zero, sizeof(int16_t), (pending - hdl->frames) * channels);
+    hdl->refChannels = channels;
+    return true;
+}
+
+uint8_t* reserve(reblock_t* hdl, uint8_t** mem, size_t* memSize, size_t size)
+{
+    /* Pool memory lives as long as the session, so it is only replaced when a larger format needs more. */
+    if (size > *memSize) {
+        uint8_t* raw = (uint8_t*)switch_core_alloc(hdl->pool, size + JVXFS_SP_MEMORY_ALIGNMENT);
+        if (!raw) {
+            jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_REBLOCK,
+                "Could not create reblocking buffers.");
+            return NULL;
+        }
+        *mem = (uint8_t*)ALIGN_UP((uintptr_t)raw);
+        *memSize = size;
+    }
+    return *mem;
+}
+
+size_t gcd(size_t a, size_t b)
+{
+    while (b) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
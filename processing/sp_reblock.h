@@ -0,0 +1,66 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file sp_reblock.h
+ * @brief Adaption of the frames of a link to the block size of the algorithm.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-28
+ * @copyright Copyright (c) 2019
+ * @note The user should not call these functions himself, the processor uses them
+ * if the app declared a block size, see jvxfs_sigproc_set_block_size().
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_REBLOCK_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_REBLOCK_H
+
+#include <stdint.h>
+#include <switch.h>
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+typedef void jvxfs_sigproc_reblock_t;
+
+/**
+ * @brief Create a stage running an algorithm on blocks of a fixed number of samples.
+ * @details Input samples are collected in a ring buffer, every complete block is copied into an aligned
+ * buffer, processed in place and appended to an output ring buffer, from which the frame is filled again.
+ * The output ring starts with B - gcd(F, B) silent samples for blocks of B and frames of F samples, the
+ * smallest latency for which every frame can be filled. The buffers are allocated again only if the
+ * frames of the link change, never per frame.
+ * @param[out] obj        Handle of stage.
+ * @param[in] blockSize   Samples per channel of a block.
+ * @param[in] err         Error handler.
+ * @param[in] pool        Memory pool of the session.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_reblock_create(jvxfs_sigproc_reblock_t** obj, uint32_t blockSize, jvxfs_error_t* err,
+    switch_memory_pool_t* pool);
+
+/**
+ * @brief Pass a frame through the stage.
+ * @param[in] obj         Handle of stage.
+ * @param[in] algo        Handle of algorithm.
+ * @param[in] func        Process function of the algorithm, called for every complete block.
+ * @param[in,out] media   Frame, @a data is replaced by the delayed output. The block descriptor handed to
+ *                        @a func is a copy with @a samples set to the block size. The reference is reblocked
+ *                        alongside if it has as many samples as the frame, otherwise blocks carry none.
+ * @param[in] samples     Samples per channel of the frame.
+ * @param[in] sampleSize  Bytes per sample of @a media.
+ */
+void jvxfs_reblock_process(jvxfs_sigproc_reblock_t* obj, void* algo, jvxfs_algorithm_process_t func,
+    jvxfs_sigproc_media_t* media, size_t samples, size_t sampleSize);
+
+uint32_t jvxfs_reblock_get_block_size(jvxfs_sigproc_reblock_t* obj);
+
+/**
+ * @brief Delay added by the stage in samples at the processing samplerate, 0 before the first frame.
+ */
+uint32_t jvxfs_reblock_get_latency(jvxfs_sigproc_reblock_t* obj);
+
+JVX_FS_LIB_END
+
+#endif
@@ -0,0 +1,294 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../system/error.h"
+#include "../utils/atomic.h"
+#include "sp_resampler.h"
+
+#define RESAMPLER_PI 3.14159265358979323846
+#define TAPS_PER_ZERO_CROSSINGS 32
+#define TAP_ALIGNMENT 8
+#define ROLLOFF 0.91
+#define KAISER_BETA 8.0
+#define MAX_PHASES 4096
+#define MAX_INPUT_FRAMES (SWITCH_RECOMMENDED_BUFFER_SIZE / sizeof(int16_t))
+
+typedef struct table_s
+{
+    uint32_t inRate;
+    uint32_t outRate;
+    uint32_t phases;
+    uint32_t step;
+    uint32_t taps;
+    float* coeffs;
+    struct table_s* next;
+} table_t;
+
+typedef struct
+{
+    const table_t* table;
+    uint8_t channels;
+    float* hist;
+    size_t capacity;
+    size_t fill;
+    size_t pos;
+    uint32_t phase;
+} resampler_t;
+
+static void design(uint32_t inRate, uint32_t outRate, uint32_t* phases, uint32_t* step, uint32_t* taps);
+static const table_t* get_table(uint32_t inRate, uint32_t outRate);
+static table_t* build_table(uint32_t inRate, uint32_t outRate);
+static float dot(const float* h, const float* x, uint32_t taps);
+static double bessel_i0(double x);
+static uint32_t gcd(uint32_t a, uint32_t b);
+
+static table_t* tables = NULL;
+static uint32_t users = 0;
+static uint32_t buildLock = 0;
+
+
+jvxfs_status_t jvxfs_resampler_init(void)
+{
+    jvxfs_atomic_fetch_add(&users, 1);
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_resampler_shutdown(void)
+{
+    if (jvxfs_atomic_fetch_sub(&users, 1) != 1) return;
+    table_t* t = jvxfs_atomic_exchange(&tables, NULL);
+    while (t) {
+        table_t* next = t->next;
+        free(t->coeffs);
+        free(t);
+        t = next;
+    }
+}
+
+jvxfs_status_t jvxfs_resampler_create(jvxfs_resampler_t** obj, uint32_t inRate, uint32_t outRate, uint8_t channels,
+    jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    uint32_t phases, step, taps;
+    if (!inRate || !outRate || !channels) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_RESAMPLER,
+            "Resampler needs samplerates and channels.");
+    }
+    design(inRate, outRate, &phases, &step, &taps);
+    if (phases > MAX_PHASES) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_RESAMPLER,
+            "Ratio of samplerates is not supported by the resampler.");
+    }
+    resampler_t* hdl = (resampler_t*)switch_core_alloc(pool, sizeof(resampler_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_RESAMPLER,
+            "Could not create resampler.");
+    }
+    hdl->table = get_table(inRate, outRate);
+    hdl->channels = channels;
+    hdl->capacity = taps - 1 + MAX_INPUT_FRAMES / channels;
+    hdl->hist = (float*)switch_core_alloc(pool, sizeof(float) * hdl->capacity * channels);
+    if (!hdl->table || !hdl->hist) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_RESAMPLER,
+            "Could not create resampler coefficients.");
+    }
+    jvxfs_resampler_reset(hdl);
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+size_t jvxfs_resampler_process(jvxfs_resampler_t* obj, const int16_t* in, size_t frames, int16_t* out, size_t capacity,
+    size_t* consumed)
+{
+    resampler_t* hdl = (resampler_t*)obj;
+    const table_t* t = hdl->table;
+    const uint8_t channels = hdl->channels;
+    if (frames > hdl->capacity - hdl->fill) frames = hdl->capacity - hdl->fill;
+    if (consumed) *consumed = frames;
+    for (uint8_t c = 0; c < channels; ++c) {
+        float* dst = hdl->hist + c * hdl->capacity + hdl->fill;
+        for (size_t i = 0; i < frames; ++i) dst[i] = (float)in[i * channels + c];
+    }
+    hdl->fill += frames;
+    size_t produced = 0;
+    while (hdl->pos < hdl->fill && produced < capacity) {
+        const float* h = t->coeffs + (size_t)hdl->phase * t->taps;
+        const float* x = hdl->hist + hdl->pos - (t->taps - 1);
+        for (uint8_t c = 0; c < channels; ++c) {
+            float acc = dot(h, x + c * hdl->capacity, t->taps);
+            acc = (acc < 32767.0f) ? acc : 32767.0f;
+            acc = (acc > -32768.0f) ? acc : -32768.0f;
+            out[produced * channels + c] = (int16_t)lrintf(acc);
+        }
+        ++produced;
+        hdl->phase += t->step;
+        hdl->pos += hdl->phase / t->phases;
+        hdl->phase %= t->phases;
+    }
+    size_t used = hdl->pos - (t->taps - 1);
+    if (used > hdl->fill) used = hdl->fill;
+    if (used) {
+        for (uint8_t c = 0; c < channels; ++c) {
+            float* ch = hdl->hist + c * hdl->capacity;
+            memmove(ch, ch + used, sizeof(float) * (hdl->fill - used));
+        }
+        hdl->fill -= used;
+        hdl->pos -= used;
+    }
+    return produced;
+}
+
+jvxfs_status_t jvxfs_resampler_set_rates(jvxfs_resampler_t* obj, uint32_t inRate, uint32_t outRate, uint8_t channels)
+{
+    resampler_t* hdl = (resampler_t*)obj;
+    uint32_t phases, step, taps;
+    if (!inRate || !outRate || channels != hdl->channels) return JVXFS_STATUS_OUT_OF_BOUNDS;
+    design(inRate, outRate, &phases, &step, &taps);
+    if (phases > MAX_PHASES || taps - 1 + MAX_INPUT_FRAMES / channels > hdl->capacity) return JVXFS_STATUS_OUT_OF_BOUNDS;
+    const table_t* table = get_table(inRate, outRate);
+    if (!table) return JVXFS_STATUS_ALLOCATION_FAILED;
+    hdl->table = table;
+    jvxfs_resampler_reset(hdl);
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_resampler_reset(jvxfs_resampler_t* obj)
+{
+    resampler_t* hdl = (resampler_t*)obj;
+    memset(hdl->hist, 0, sizeof(float) * hdl->capacity * hdl->channels);
+    hdl->fill = hdl->table->taps - 1;
+    hdl->pos = hdl->table->taps - 1;
+    hdl->phase = 0;
+}
+
+uint32_t jvxfs_resampler_get_delay_us(uint32_t inRate, uint32_t outRate)
+{
+    uint32_t phases, step, taps;
+    if (!inRate || !outRate || inRate == outRate) return 0;
+    design(inRate, outRate, &phases, &step, &taps);
+    /* Center of the prototype filter, which runs at inRate * phases. */
+    double center = ((double)taps * phases - 1.0) / 2.0;
+    return (uint32_t)(center * 1000000.0 / ((double)inRate * phases) + 0.5);
+}
+
+
+void design(uint32_t inRate, uint32_t outRate, uint32_t* phases, uint32_t* step, uint32_t* taps)
+{
+    uint32_t g = gcd(inRate, outRate);
+    *phases = outRate / g;
+    *step = inRate / g;
+    /* Downsampling narrows the passband relative to the input, the filter is stretched accordingly. */
+    double stretch = (inRate > outRate) ? (double)inRate / outRate : 1.0;
+    uint32_t n = (uint32_t)ceil(TAPS_PER_ZERO_CROSSINGS * stretch);
+    *taps = (n + TAP_ALIGNMENT - 1) & ~(uint32_t)(TAP_ALIGNMENT - 1);
+}
+
+const table_t* get_table(uint32_t inRate, uint32_t outRate)
+{
+    for (table_t* t = jvxfs_atomic_load(&tables); t; t = t->next) {
+        if (t->inRate == inRate && t->outRate == outRate) return t;
+    }
+    uint32_t unlocked = 0;
+    while (!jvxfs_atomic_cas(&buildLock, &unlocked, 1)) {
+        unlocked = 0;
+        jvxfs_cpu_relax();
+    }
+    table_t* t;
+    for (t = jvxfs_atomic_load(&tables); t; t = t->next) {
+        if (t->inRate == inRate && t->outRate == outRate) break;
+    }
+    if (!t) {
+        t = build_table(inRate, outRate);
+        if (t) {
+            t->next = jvxfs_atomic_load_relaxed(&tables);
+            jvxfs_atomic_store(&tables, t);
+        }
+    }
+    jvxfs_atomic_store(&buildLock, 0);
+    return t;
+}
+
+table_t* build_table(uint32_t inRate, uint32_t outRate)
+{
+    table_t* t = (table_t*)calloc(1, sizeof(table_t));
+    if (!t) return NULL;
+    t->inRate = inRate;
+    t->outRate = outRate;
+    design(inRate, outRate, &t->phases, &t->step, &t->taps);
+    size_t length = (size_t)t->phases * t->taps;
+    t->coeffs = (float*)malloc(sizeof(float) * length);
+    if (!t->coeffs) {
+        free(t);
+        return NULL;
+    }
+    /* Prototype lowpass at inRate * phases, the gain of the interpolation is restored by the factor phases. */
+    double cutoff = 0.5 * ROLLOFF * ((inRate < outRate) ? inRate : outRate) / ((double)inRate * t->phases);
+    double center = (length - 1) / 2.0;
+    double norm = bessel_i0(KAISER_BETA);
+    for (size_t n = 0; n < length; ++n) {
+        double x = n - center;
+        double sinc = (x == 0.0) ? 1.0 : sin(2.0 * RESAMPLER_PI * cutoff * x) / (2.0 * RESAMPLER_PI * cutoff * x);
+        double r = x / (center + 1.0);
+        double window = bessel_i0(KAISER_BETA * sqrt(1.0 - r * r)) / norm;
+        double h = 2.0 * cutoff * sinc * window * t->phases;
+        /* Phase p holds taps p, p + phases, ... in reversed order to run over the history forwards. */
+        uint32_t p = (uint32_t)(n % t->phases);
+        uint32_t k = (uint32_t)(n / t->phases);
+        t->coeffs[(size_t)p * t->taps + (t->taps - 1 - k)] = (float)h;
+    }
+    return t;
+}
+
+float dot(const float* h, const float* x, uint32_t taps)
+{
+#if defined __SSE2__
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (uint32_t i = 0; i < taps; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(h + i), _mm_loadu_ps(x + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(h + i + 4), _mm_loadu_ps(x + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    return _mm_cvtss_f32(acc0);
+#else
+    float acc[TAP_ALIGNMENT] = { 0.0f };
+    for (uint32_t i = 0; i < taps; i += TAP_ALIGNMENT) {
+        for (uint32_t j = 0; j < TAP_ALIGNMENT; ++j) acc[j] += h[i + j] * x[i + j];
+    }
+    float sum = 0.0f;
+    for (uint32_t j = 0; j < TAP_ALIGNMENT; ++j) sum += acc[j];
+    return sum;
+#endif
+}
+
+double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double half = x / 2.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (half / k) * (half / k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+uint32_t gcd(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
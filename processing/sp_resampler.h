@@ -0,0 +1,100 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file sp_resampler.h
+ * @brief Polyphase resampler adapting a link to the samplerate of the algorithm.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-16
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_RESAMPLER_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <switch.h>
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup processing Signal Processing
+ * @{
+ * @defgroup resampler Resampler
+ * @details Windowed sinc polyphase FIR working on L16 samples with float accumulation.
+ * The coefficient table of a rate pair is built once and shared by all sessions of the process.
+ * @{
+ */
+
+typedef void jvxfs_resampler_t;
+
+/**
+ * @brief Initialize the coefficient cache.
+ * @return Status code.
+ * @details Called by the framework when a module is loaded.
+ */
+jvxfs_status_t jvxfs_resampler_init(void);
+
+/**
+ * @brief Release the coefficient cache once the last module has been unloaded.
+ */
+void jvxfs_resampler_shutdown(void);
+
+/**
+ * @brief Create a resampler for one direction of a link.
+ * @param[out] obj      Resampler.
+ * @param[in] inRate    Samplerate of the input.
+ * @param[in] outRate   Samplerate of the output.
+ * @param[in] channels  Number of interleaved channels.
+ * @param[in] err       Error handler.
+ * @param[in] pool      Memory pool of the session.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_resampler_create(jvxfs_resampler_t** obj, uint32_t inRate, uint32_t outRate, uint8_t channels,
+    jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Resample interleaved samples.
+ * @param[in] obj       Resampler.
+ * @param[in] in        Input samples.
+ * @param[in] frames    Number of input samples per channel.
+ * @param[out] out      Output samples.
+ * @param[in] capacity  Space of @a out in samples per channel.
+ * @param[out] consumed Number of input samples per channel taken, may be @em NULL. Less than @a frames if the
+ *                      history is full, the rest has to be passed again.
+ * @return Number of output samples per channel.
+ * @details A frame of N samples yields exactly N * outRate / inRate samples if that is an integer,
+ * output exceeding @a capacity is kept for the next call.
+ */
+size_t jvxfs_resampler_process(jvxfs_resampler_t* obj, const int16_t* in, size_t frames, int16_t* out, size_t capacity,
+    size_t* consumed);
+
+/**
+ * @brief Switch the resampler to another pair of samplerates without allocating.
+ * @return #JVXFS_STATUS_OUT_OF_BOUNDS if the history is too small for the filter of the new pair or the
+ * channels differ, a new resampler is needed then. The history is cleared on success.
+ */
+jvxfs_status_t jvxfs_resampler_set_rates(jvxfs_resampler_t* obj, uint32_t inRate, uint32_t outRate, uint8_t channels);
+
+/**
+ * @brief Clear the filter history.
+ */
+void jvxfs_resampler_reset(jvxfs_resampler_t* obj);
+
+/**
+ * @brief Group delay of a resampler for a rate pair in microseconds.
+ */
+uint32_t jvxfs_resampler_get_delay_us(uint32_t inRate, uint32_t outRate);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
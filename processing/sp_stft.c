@@ -0,0 +1,226 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <math.h>
+#include <string.h>
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../system/error.h"
+#include "sp_fft.h"
+#include "sp_stft.h"
+
+#define STFT_PI 3.14159265358979323846
+#define RECONSTRUCTION_TOLERANCE 1e-5
+#define ALIGN_UP(_n) (((_n) + JVXFS_SP_MEMORY_ALIGNMENT - 1) & ~((size_t)JVXFS_SP_MEMORY_ALIGNMENT - 1))
+
+typedef struct
+{
+    uint32_t size;
+    uint32_t hop;
+    uint32_t stride;
+    const jvxfs_fft_plan_t* forward;
+    const jvxfs_fft_plan_t* inverse;
+    float* analysis;
+    float* synthesis;
+    float* time;
+    uint8_t channels;
+    float* hist;
+    float* ola;
+    float* bins;
+    jvxfs_error_t* err;
+    switch_memory_pool_t* pool;
+} stft_t;
+
+static bool alloc_channels(stft_t* hdl, uint8_t channels);
+static bool design_windows(stft_t* hdl, jvxfs_sigproc_window_t window);
+static void multiply(float* dst, const float* x, const float* w, uint32_t n);
+static void multiply_add(float* acc, const float* x, const float* w, uint32_t n);
+
+
+jvxfs_status_t jvxfs_stft_create(jvxfs_stft_t** obj, uint32_t size, uint32_t hop, jvxfs_sigproc_window_t window,
+    uint8_t channels, jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create STFT engine.";
+    if (size < JVXFS_FFT_MIN_SIZE || size > JVXFS_FFT_MAX_SIZE || (size & (size - 1)) || !hop || hop > size ||
+        window < JVXFS_SP_WINDOW_HANN || window > JVXFS_SP_WINDOW_RECTANGULAR) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_STFT, error);
+    }
+    stft_t* hdl = (stft_t*)switch_core_alloc(pool, sizeof(stft_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_STFT, error);
+    }
+    memset(hdl, 0, sizeof(stft_t));
+    hdl->size = size;
+    hdl->hop = hop;
+    /* Real transforms write size / 2 + 1 bins, two floats more than the samples. */
+    hdl->stride = (uint32_t)(ALIGN_UP((size + 2) * sizeof(float)) / sizeof(float));
+    hdl->err = err;
+    hdl->pool = pool;
+    jvxfs_status_t res = jvxfs_fft_get_plan(&hdl->forward, size, JVXFS_FFT_FORWARD, JVXFS_FFT_REAL, err);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = jvxfs_fft_get_plan(&hdl->inverse, size, JVXFS_FFT_INVERSE, JVXFS_FFT_REAL, err);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    uint8_t* mem = (uint8_t*)switch_core_alloc(pool, 3 * hdl->stride * sizeof(float) + JVXFS_SP_MEMORY_ALIGNMENT);
+    if (!mem) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_STFT, error);
+    }
+    hdl->analysis = (float*)ALIGN_UP((uintptr_t)mem);
+    hdl->synthesis = hdl->analysis + hdl->stride;
+    hdl->time = hdl->synthesis + hdl->stride;
+    if (!design_windows(hdl, window)) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_SP_STFT,
+            "Window and hop of STFT do not reconstruct the input, use the rectangular window for a hop of the FFT size.");
+    }
+    if (!alloc_channels(hdl, channels ? channels : 1)) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_STFT, error);
+    }
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_stft_process(jvxfs_stft_t* obj, void* algo, jvxfs_algorithm_process_spectral_t func,
+    jvxfs_sigproc_media_t* media)
+{
+    stft_t* hdl = (stft_t*)obj;
+    bool isFloat = media->type == JVXFS_SP_FLOAT32_LE;
+    if (media->samples != hdl->hop || (!isFloat && media->type != JVXFS_SP_16BIT_LE)) return;
+    uint8_t channels = media->channels ? media->channels : 1;
+    if (channels > hdl->channels && !alloc_channels(hdl, channels)) return;
+    uint32_t size = hdl->size;
+    uint32_t hop = hdl->hop;
+    uint32_t keep = size - hop;
+    for (uint8_t c = 0; c < channels; ++c) {
+        float* hist = hdl->hist + (size_t)c * hdl->stride;
+        memmove(hist, hist + hop, keep * sizeof(float));
+        if (isFloat) {
+            const float* in = (const float*)media->data;
+            for (uint32_t k = 0; k < hop; ++k) hist[keep + k] = in[(size_t)k * channels + c];
+        } else {
+            const int16_t* in = (const int16_t*)media->data;
+            for (uint32_t k = 0; k < hop; ++k) hist[keep + k] = in[(size_t)k * channels + c] * (1.0f / 32768.0f);
+        }
+        multiply(hdl->time, hist, hdl->analysis, size);
+        jvxfs_fft_execute(hdl->forward, hdl->time, hdl->bins + (size_t)c * hdl->stride);
+    }
+    jvxfs_sigproc_spectrum_t spectrum;
+    spectrum.bins = hdl->bins;
+    spectrum.count = size / 2 + 1;
+    spectrum.stride = hdl->stride;
+    spectrum.size = size;
+    spectrum.hop = hop;
+    spectrum.channels = channels;
+    spectrum.media = media;
+    func(algo, &spectrum);
+    for (uint8_t c = 0; c < channels; ++c) {
+        float* ola = hdl->ola + (size_t)c * hdl->stride;
+        jvxfs_fft_execute(hdl->inverse, hdl->bins + (size_t)c * hdl->stride, hdl->time);
+        multiply_add(ola, hdl->time, hdl->synthesis, size);
+        if (isFloat) {
+            float* out = (float*)media->data;
+            for (uint32_t k = 0; k < hop; ++k) out[(size_t)k * channels + c] = ola[k];
+        } else {
+            int16_t* out = (int16_t*)media->data;
+            for (uint32_t k = 0; k < hop; ++k) {
+                float v = ola[k] * 32768.0f;
+                out[(size_t)k * channels + c] = (int16_t)((v >= 32767.0f) ? 32767 : (v <= -32768.0f) ? -32768 : lrintf(v));
+            }
+        }
+        memmove(ola, ola + hop, keep * sizeof(float));
+        memset(ola + keep, 0, hop * sizeof(float));
+    }
+}
+
+uint32_t jvxfs_stft_get_size(jvxfs_stft_t* obj)
+{
+    stft_t* hdl = (stft_t*)obj;
+    return hdl->size;
+}
+
+uint32_t jvxfs_stft_get_hop(jvxfs_stft_t* obj)
+{
+    stft_t* hdl = (stft_t*)obj;
+    return hdl->hop;
+}
+
+uint32_t jvxfs_stft_get_latency(jvxfs_stft_t* obj)
+{
+    stft_t* hdl = (stft_t*)obj;
+    return hdl->size - hdl->hop;
+}
+
+
+bool alloc_channels(stft_t* hdl, uint8_t channels)
+{
+    /* History, overlap-add accumulator and bins of all channels, in one block so a new channel count
+     * allocates once. Pool memory is only replaced when more channels arrive. */
+    size_t floats = (size_t)channels * hdl->stride;
+    uint8_t* mem = (uint8_t*)switch_core_alloc(hdl->pool, 3 * floats * sizeof(float) + JVXFS_SP_MEMORY_ALIGNMENT);
+    if (!mem) {
+        jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_SP_STFT,
+            "Could not create STFT buffers.");
+        return false;
+    }
+    float* base = (float*)ALIGN_UP((uintptr_t)mem);
+    memset(base, 0, 3 * floats * sizeof(float));
+    hdl->hist = base;
+    hdl->ola = base + floats;
+    hdl->bins = base + 2 * floats;
+    hdl->channels = channels;
+    return true;
+}
+
+bool design_windows(stft_t* hdl, jvxfs_sigproc_window_t window)
+{
+    uint32_t size = hdl->size;
+    for (uint32_t n = 0; n < size; ++n) {
+        /* Periodic windows, so shifted copies add up to a constant. */
+        double hann = 0.5 - 0.5 * cos(2.0 * STFT_PI * n / size);
+        double w = 1.0;
+        if (window == JVXFS_SP_WINDOW_HANN) {
+            w = hann;
+        } else if (window == JVXFS_SP_WINDOW_SQRT_HANN) {
+            w = sqrt(hann);
+        }
+        hdl->analysis[n] = (float)w;
+    }
+    /* Least squares synthesis window: the sum of analysis times synthesis over all hops covering a sample is one. */
+    for (uint32_t n = 0; n < size; ++n) {
+        double norm = 0.0;
+        for (uint32_t m = n % hdl->hop; m < size; m += hdl->hop) norm += (double)hdl->analysis[m] * hdl->analysis[m];
+        hdl->synthesis[n] = (norm > 1e-12) ? (float)(hdl->analysis[n] / norm) : 0.0f;
+    }
+    /* A sample no window covers, e.g. the zero of a Hann window with a hop of the FFT size, is lost. */
+    for (uint32_t n = 0; n < hdl->hop; ++n) {
+        double sum = 0.0;
+        for (uint32_t m = n; m < size; m += hdl->hop) sum += (double)hdl->analysis[m] * hdl->synthesis[m];
+        if (fabs(sum - 1.0) > RECONSTRUCTION_TOLERANCE) return false;
+    }
+    return true;
+}
+
+void multiply(float* dst, const float* x, const float* w, uint32_t n)
+{
+    /* n is a power of two of at least four and all buffers are aligned. */
+#if defined __SSE2__
+    for (uint32_t i = 0; i < n; i += 4) {
+        _mm_store_ps(dst + i, _mm_mul_ps(_mm_load_ps(x + i), _mm_load_ps(w + i)));
+    }
+#else
+    for (uint32_t i = 0; i < n; ++i) dst[i] = x[i] * w[i];
+#endif
+}
+
+void multiply_add(float* acc, const float* x, const float* w, uint32_t n)
+{
+#if defined __SSE2__
+    for (uint32_t i = 0; i < n; i += 4) {
+        __m128 sum = _mm_add_ps(_mm_load_ps(acc + i), _mm_mul_ps(_mm_load_ps(x + i), _mm_load_ps(w + i)));
+        _mm_store_ps(acc + i, sum);
+    }
+#else
+    for (uint32_t i = 0; i < n; ++i) acc[i] += x[i] * w[i];
+#endif
+}
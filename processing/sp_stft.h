@@ -0,0 +1,84 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file sp_stft.h
+ * @brief Short time Fourier analysis and overlap-add synthesis for spectral algorithms.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-29
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_PROCESSING_STFT_H
+#define LIB_JVX_FS_FRAMEWORK_PROCESSING_STFT_H
+
+#include <stdint.h>
+#include <switch.h>
+#include "sp_defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup processing Signal Processing
+ * @{
+ * @defgroup stft STFT Engine
+ * @details Each hop of samples is appended to a history of FFT size samples per channel, which is weighted
+ * with the analysis window and transformed with the shared real FFT plans. After the spectral function
+ * modified the bins, they are transformed back, weighted with the synthesis window and overlap-added. The
+ * synthesis window is derived from the analysis window and the hop, so analysis and synthesis reconstruct
+ * the input exactly for any window and any hop below the FFT size. A hop of the FFT size needs the
+ * rectangular window, the other windows are zero at the edge of the frame. Engines failing the reconstruction
+ * are not created. The output is delayed by FFT size - hop samples.
+ * Apps usually do not create an engine themselves but set a spectral function with
+ * jvxfs_app_set_sigproc_spectral_func(), the processor then runs an engine per session.
+ * @{
+ */
+
+/**
+ * @brief Handle type of an STFT engine.
+ */
+typedef void jvxfs_stft_t;
+
+/**
+ * @brief Create an engine.
+ * @param[out] obj      Handle of engine.
+ * @param[in] size      FFT size, power of two between #JVXFS_FFT_MIN_SIZE and #JVXFS_FFT_MAX_SIZE.
+ * @param[in] hop       Samples per channel between two transforms, at most @a size.
+ * @param[in] window    Analysis window, #JVXFS_SP_WINDOW_RECTANGULAR if @a hop is @a size.
+ * @param[in] channels  Number of channels the engine is prepared for, more are allocated on first use.
+ * @param[in] err       Error handler.
+ * @param[in] pool      Memory pool the engine lives in.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_stft_create(jvxfs_stft_t** obj, uint32_t size, uint32_t hop, jvxfs_sigproc_window_t window,
+    uint8_t channels, jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Run one hop through the engine in place.
+ * @param[in] obj       Handle of engine.
+ * @param[in] algo      Handle of algorithm passed to @a func.
+ * @param[in] func      Spectral function, called once per hop with the bins of all channels.
+ * @param[in,out] media Hop of @a hop samples of type #JVXFS_SP_16BIT_LE or #JVXFS_SP_FLOAT32_LE, replaced by
+ *                      the output. Other sample counts or types are left unchanged.
+ */
+void jvxfs_stft_process(jvxfs_stft_t* obj, void* algo, jvxfs_algorithm_process_spectral_t func,
+    jvxfs_sigproc_media_t* media);
+
+uint32_t jvxfs_stft_get_size(jvxfs_stft_t* obj);
+uint32_t jvxfs_stft_get_hop(jvxfs_stft_t* obj);
+
+/**
+ * @brief Delay of the output in samples, FFT size - hop.
+ */
+uint32_t jvxfs_stft_get_latency(jvxfs_stft_t* obj);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
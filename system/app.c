@@ -5,10 +5,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../processing/sp_config.h"
+#include "../processing/sp_batch.h"
+#include "../processing/sp_convert.h"
+#include "../processing/sp_instance_pool.h"
+#include "../utils/atomic.h"
 #include "module.h"
 #include "session.h"
 #include "error.h"
 #include "directives.h"
+#include "command.h"
+#include "registry.h"
 #include "system.h"
 #include "view_private.h"
 #include "app.h"
@@ -21,6 +27,19 @@ typedef struct list_drct
     struct list_drct* next;
 } list_drct_t;
 
+typedef struct
+{
+    uint32_t hash;
+    size_t length;
+    list_drct_t* item;
+} slot_drct_t;
+
+typedef struct
+{
+    slot_drct_t* slots;
+    uint32_t mask;
+} table_drct_t;
+
 typedef struct
 {
     jvxfs_module_t* mod;
@@ -35,11 +54,48 @@ typedef struct
     list_drct_t* drctAppStop;
     list_drct_t* drctInstStart;
     list_drct_t* drctInstStop;
+    table_drct_t drctAppTable;
+    table_drct_t drctInstTable;
     jvxfs_algorithm_vtable_t* vtable;
+    jvxfs_sigproc_batch_collector_t* batch;
+    uint32_t batchSessions;
+    uint32_t batchInterval;
+    size_t profileSize;
+    jvxfs_sigproc_instance_pool_t* instances;
+    jvxfs_histogram_t* stats;
+    jvxfs_registry_t* registry;
 } app_t;
 
+typedef struct
+{
+    const char* str;
+    size_t length;
+    uint32_t hash;
+} target_uuid_t;
+
+typedef struct
+{
+    list_drct_t* found;
+    jvxfs_directive_data_t* data;
+    view_priv_t* view;
+    view_buffer_t* buffers;
+    const char* prefix;
+    size_t prefixLength;
+    bool byNumber;
+    target_uuid_t* uuids;
+    uint32_t uuidMask;
+    uint32_t matched;
+} fan_out_t;
+
 static jvxfs_status_t insert_list_item(app_t* hdl, const char* name, void* func, void* data, list_drct_t** start, list_drct_t** stop);
 static void add_default_directives(app_t* hdl);
+static jvxfs_status_t compile_directives(app_t* hdl, list_drct_t* start, table_drct_t* table);
+static list_drct_t* find_directive(app_t* hdl, bool session, const char* name, size_t length);
+static jvxfs_status_t call_directive(list_drct_t* found, jvxfs_directive_data_t* data, jvxfs_view_t* view);
+static uint32_t hash_name(const char* name, size_t length);
+static jvxfs_status_t parse_target(fan_out_t* fan, const char* target, size_t length);
+static bool matches_target(fan_out_t* fan, switch_core_session_t* session);
+static void fan_out_func(switch_core_session_t* session, jvxfs_app_instance_t* inst, uint32_t chunk, void* data);
 
 
 jvxfs_status_t jvx_system_create_app(jvxfs_app_t** app, jvxfs_module_t* mod, const char* name,
@@ -68,8 +124,20 @@ jvxfs_status_t jvx_system_create_app(jvxfs_app_t** app, jvxfs_module_t* mod, con
     hdl->drctAppStop = NULL;
     hdl->drctInstStart = NULL;
     hdl->drctInstStop = NULL;
+    hdl->drctAppTable.slots = NULL;
+    hdl->drctAppTable.mask = 0;
+    hdl->drctInstTable.slots = NULL;
+    hdl->drctInstTable.mask = 0;
     hdl->spConfig = NULL;
     hdl->vtable = NULL;
+    hdl->batch = NULL;
+    hdl->batchSessions = 0;
+    hdl->batchInterval = 0;
+    hdl->profileSize = 0;
+    hdl->instances = NULL;
+    hdl->stats = NULL;
+    jvxfs_status_t res = jvxfs_registry_create(&hdl->registry, err_hdl, pool);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
     add_default_directives(hdl);
     *app = hdl;
     return JVXFS_STATUS_SUCCESS;
@@ -104,17 +172,78 @@ jvxfs_status_t jvx_system_create_sigproc_app(jvxfs_app_t** app, jvxfs_module_t*
     vtbl->construct = func_cnst;
     vtbl->initialize = func_init;
     vtbl->process = func_proc;
+    vtbl->process_batch = NULL;
+    vtbl->process_spectral = NULL;
     vtbl->terminate = func_term;
     vtbl->destruct = func_dest;
     vtbl->update = NULL;
     vtbl->flag = JVXFS_SP_DISABLE_SYNC_UPDATE;
+    vtbl->reset = NULL;
+    vtbl->profile = NULL;
+    res = jvxfs_histogram_create(&hdl->stats, 0, err_hdl, pool);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    jvxfs_app_add_directive(hdl, "stats", jvxfs_directive_app_stats, NULL);
+    jvxfs_app_add_directive(hdl, "sessions", jvxfs_directive_app_sessions, NULL);
+    jvxfs_app_add_session_directive(hdl, "stats", jvxfs_directive_session_stats, NULL);
     *app = hdl;
     return JVXFS_STATUS_SUCCESS;
 }
 
+jvxfs_status_t jvx_system_start_app(jvxfs_app_t* app)
+{
+    app_t* hdl = (app_t*)app;
+    /* No directives are added after this point, so looking them up no longer walks the lists. */
+    jvxfs_status_t res = compile_directives(hdl, hdl->drctAppStart, &hdl->drctAppTable);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = compile_directives(hdl, hdl->drctInstStart, &hdl->drctInstTable);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    if (!hdl->vtable) return JVXFS_STATUS_SUCCESS;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    switch_memory_pool_t* pool = jvxfs_module_get_memory_pool(hdl->mod);
+    if (hdl->vtable->profile) {
+        res = jvxfs_system_build_sp_profiles(hdl->spConfig, hdl->vtable->profile, hdl->profileSize);
+        if (res != JVXFS_STATUS_SUCCESS) return res;
+    }
+    jvxfs_sigproc_datatype_t type = jvxfs_sigproc_get_datatype(hdl->spConfig);
+    if (hdl->vtable->process_batch && (jvxfs_sigproc_get_block_size(hdl->spConfig) || hdl->vtable->process_spectral)) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not combine batch function with block size or spectral function.");
+    }
+    if (hdl->vtable->process_spectral) {
+        if (!jvxfs_sigproc_get_stft_size(hdl->spConfig)) {
+            return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_PENDING_CONFIGURATION, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+                "Could not run spectral function without STFT.");
+        }
+        if (jvxfs_sigproc_get_block_size(hdl->spConfig) ||
+            (type != JVXFS_SP_DATA && type != JVXFS_SP_16BIT_LE && type != JVXFS_SP_FLOAT32_LE)) {
+            return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+                "Could not run spectral function with this block size or datatype.");
+        }
+    }
+    if (hdl->vtable->process_batch) {
+        res = jvxfs_batch_create(&hdl->batch, hdl->vtable, type, hdl->batchSessions, hdl->batchInterval,
+            err_hdl, pool);
+        if (res != JVXFS_STATUS_SUCCESS) return res;
+    }
+    /* Started now rather than by the first session on its media thread. */
+    if (jvxfs_sigproc_get_execution(hdl->spConfig) == JVXFS_SP_EXEC_ASYNC) jvxfs_module_get_worker(hdl->mod);
+    uint32_t maximum = jvxfs_sigproc_get_instance_maximum(hdl->spConfig);
+    if (hdl->vtable->reset && maximum > 0) {
+        jvxfs_sigproc_media_t media;
+        memset(&media, 0, sizeof(jvxfs_sigproc_media_t));
+        media.link = (jvxfs_sigproc_get_working_channel(hdl->spConfig) == JVXFS_SP_UPLINK) ? JVXFS_SP_UPLINK : JVXFS_SP_DOWNLINK;
+        media.type = (jvxfs_convert_is_needed(type) && jvxfs_convert_get_sample_size(type) > 0) ? type : JVXFS_SP_16BIT_LE;
+        return jvxfs_instance_pool_create(&hdl->instances, hdl->vtable, &media,
+            jvxfs_sigproc_get_instance_prewarm(hdl->spConfig), maximum, jvxfs_module_get_worker(hdl->mod), err_hdl, pool);
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
 jvxfs_status_t jvx_system_delete_app(jvxfs_app_t* app)
 {
     app_t* hdl = (app_t*)app;
+    jvxfs_batch_destroy(&hdl->batch);
+    jvxfs_instance_pool_destroy(&hdl->instances);
     jvxfs_app_clear_indexed_storage(app);
     if (hdl->spConfig) {
         jvx_system_delete_sp_config(hdl->spConfig);
@@ -299,25 +428,60 @@ jvxfs_status_t jvxfs_app_add_session_directive(jvxfs_app_t* app, const char* nam
 jvxfs_status_t jvxfs_app_call_directive(jvxfs_directive_data_t* data, jvxfs_view_t* view)
 {
     app_t* hdl = (app_t*)data->app;
-    list_drct_t* item = (!data->session) ? hdl->drctAppStart : hdl->drctInstStart;
-    list_drct_t* found = NULL;
-    while (item != NULL) {
-        if (strncmp(item->name, data->directive, JVXFS_DIRECTIVE_NAME_MAX_LENGTH) == 0) {
-            found = item;
-            break;
-        } else {
-            item = item->next;
+    list_drct_t* found = find_directive(hdl, data->session != NULL, data->directive, strlen(data->directive));
+    return call_directive(found, data, view);
+}
+
+jvxfs_status_t jvxfs_app_call_command(jvxfs_directive_data_t* data, const jvxfs_command_t* cmd, jvxfs_view_t* view)
+{
+    app_t* hdl = (app_t*)data->app;
+    list_drct_t* found = find_directive(hdl, data->session != NULL, cmd->name, cmd->nameLength);
+    data->directive = (found) ? found->name : NULL;
+    data->parameters = cmd->parameters;
+    data->argc = cmd->argc;
+    data->argv = cmd->argv;
+    return call_directive(found, data, view);
+}
+
+jvxfs_status_t jvxfs_app_call_targeted_command(jvxfs_directive_data_t* data, const char* target, size_t length,
+    const jvxfs_command_t* cmd, jvxfs_view_t* view)
+{
+    app_t* hdl = (app_t*)data->app;
+    view_priv_t* priv = (view_priv_t*)view;
+    fan_out_t fan;
+    memset(&fan, 0, sizeof(fan_out_t));
+    fan.found = find_directive(hdl, true, cmd->name, cmd->nameLength);
+    if (!fan.found) return JVXFS_STATUS_ELEMENT_NOT_FOUND;
+    jvxfs_status_t res = parse_target(&fan, target, length);
+    if (res != JVXFS_STATUS_SUCCESS) {
+        jvxfs_view_write_human_readable(view, "Invalid target.\n");
+        return res;
+    }
+    data->directive = fan.found->name;
+    data->parameters = cmd->parameters;
+    data->argc = cmd->argc;
+    data->argv = cmd->argv;
+    fan.data = data;
+    fan.view = priv;
+    uint32_t chunks = jvxfs_registry_count_chunks(hdl->registry);
+    /* The console is no stream several threads may write to, every chunk collects its output on its own. */
+    if (priv->console && chunks) {
+        fan.buffers = (view_buffer_t*)malloc(sizeof(view_buffer_t) * chunks);
+        if (!fan.buffers) {
+            free(fan.uuids);
+            return jvxfs_error_set_error(priv->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+                "Could not buffer output of sessions.");
         }
+        for (uint32_t i = 0; i < chunks; ++i) jvxfs_view_buffer_init(&fan.buffers[i]);
     }
-    if (!found) return JVXFS_STATUS_ELEMENT_NOT_FOUND;
-    if (!data->session) {
-        jvxfs_directive_func_app_t func = (jvxfs_directive_func_app_t)found->func;
-        func(view, data, found->data);
-        return JVXFS_STATUS_SUCCESS;
-    } else {
-        jvxfs_directive_func_session_t func = (jvxfs_directive_func_session_t)found->func; 
-        return jvxfs_session_exec_directive(data, view, func, found->data);
+    jvxfs_registry_for_each(hdl->registry, chunks, jvxfs_module_get_worker(hdl->mod), fan_out_func, &fan);
+    if (fan.buffers) {
+        for (uint32_t i = 0; i < chunks; ++i) jvxfs_view_buffer_flush(&fan.buffers[i], priv->console);
+        free(fan.buffers);
     }
+    free(fan.uuids);
+    jvxfs_view_write_human_readable(view, "Executed for %u sessions.\n", jvxfs_atomic_load(&fan.matched));
+    return JVXFS_STATUS_SUCCESS;
 }
 
 jvxfs_status_t jvxfs_app_exec_call(jvxfs_app_t* app, switch_core_session_t* session, const char* args)
@@ -328,24 +492,12 @@ jvxfs_status_t jvxfs_app_exec_call(jvxfs_app_t* app, switch_core_session_t* sess
         return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
             "Cannot execute call without session or arguments.");
     }
-    char tmp[JVXFS_DIRECTIVE_NAME_MAX_LENGTH+1] = {0};
-    const char* directive = NULL;
-    const char* params = strchr(args, ' ');
-    if (!params) {
-        directive = args;
-        params = "";
-    } else {
-        size_t len = params - args;
-        if (len > JVXFS_DIRECTIVE_NAME_MAX_LENGTH) len = JVXFS_DIRECTIVE_NAME_MAX_LENGTH;
-        strncpy(tmp, args, len);
-        directive = tmp;
-        ++params;
-    }
-    jvxfs_directive_data_t data = { .app = app, .session = session, .directive = directive,
-        .parameters = params };
+    jvxfs_command_t cmd;
+    jvxfs_command_parse(args, &cmd);
+    jvxfs_directive_data_t data = { .app = app, .session = session };
     view_priv_t view = { .origin = JVXFS_VIEW_IN_CALL, .dest = JVXFS_VIEW_OUT_CONSOLE, .err = err_hdl, 
         .data = &data, .console = NULL };
-    return jvxfs_app_call_directive(&data, &view);
+    return jvxfs_app_call_command(&data, &cmd, &view);
 }
 
 jvxfs_status_t jvxfs_app_set_instance_factory(jvxfs_app_t* app, jvxfs_app_instance_factory_t func)
@@ -409,6 +561,102 @@ jvxfs_status_t jvxfs_app_set_sigproc_update_func(jvxfs_app_t* app, jvxfs_algorit
     return JVXFS_STATUS_SUCCESS;
 }
 
+jvxfs_status_t jvxfs_app_set_sigproc_batch_func(jvxfs_app_t* app, jvxfs_algorithm_process_batch_t func, uint32_t sessions,
+    uint32_t interval)
+{
+    app_t* hdl = (app_t*)app;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not set signal processing batch function.");
+    }
+    if (!hdl->vtable) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_WRONG_APP_TYPE, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not find processing vtable.");
+    }
+    hdl->vtable->process_batch = func;
+    hdl->batchSessions = sessions;
+    hdl->batchInterval = interval;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_sigproc_batch_collector_t* jvxfs_app_get_sigproc_batch_collector(jvxfs_app_t* app)
+{
+    app_t* hdl = (app_t*)app;
+    return hdl->batch;
+}
+
+jvxfs_status_t jvxfs_app_set_sigproc_reset_func(jvxfs_app_t* app, jvxfs_algorithm_reset_t func)
+{
+    app_t* hdl = (app_t*)app;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not set signal processing reset function.");
+    }
+    if (!hdl->vtable) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_WRONG_APP_TYPE, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not find processing vtable.");
+    }
+    hdl->vtable->reset = func;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_app_set_sigproc_spectral_func(jvxfs_app_t* app, jvxfs_algorithm_process_spectral_t func)
+{
+    app_t* hdl = (app_t*)app;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not set signal processing spectral function.");
+    }
+    if (!hdl->vtable) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_WRONG_APP_TYPE, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not find processing vtable.");
+    }
+    hdl->vtable->process_spectral = func;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_app_set_sigproc_profile_func(jvxfs_app_t* app, jvxfs_algorithm_profile_t func, size_t size)
+{
+    app_t* hdl = (app_t*)app;
+    jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+    if (jvxfs_module_get_state(hdl->mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not set signal processing profile function.");
+    }
+    if (!hdl->vtable) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_WRONG_APP_TYPE, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not find processing vtable.");
+    }
+    if (func && !size) {
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_APP,
+            "Could not set signal processing profile function without profile size.");
+    }
+    hdl->vtable->profile = func;
+    hdl->profileSize = func ? size : 0;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_sigproc_instance_pool_t* jvxfs_app_get_sigproc_instance_pool(jvxfs_app_t* app)
+{
+    app_t* hdl = (app_t*)app;
+    return hdl->instances;
+}
+
+jvxfs_histogram_t* jvxfs_app_get_sigproc_stats(jvxfs_app_t* app)
+{
+    app_t* hdl = (app_t*)app;
+    return hdl->stats;
+}
+
+jvxfs_registry_t* jvxfs_app_get_registry(jvxfs_app_t* app)
+{
+    app_t* hdl = (app_t*)app;
+    return hdl->registry;
+}
+
 jvxfs_module_t* jvxfs_app_get_module(jvxfs_app_t* app)
 {
     app_t* hdl = (app_t*)app;
@@ -449,4 +697,165 @@ jvxfs_status_t insert_list_item(app_t* hdl, const char* name, void* func, void*
 void add_default_directives(app_t* hdl)
 {
     jvxfs_app_add_directive(hdl, "version", jvxfs_directive_app_version, NULL);
+    jvxfs_app_add_directive(hdl, "events", jvxfs_directive_app_events, NULL);
+    jvxfs_app_add_directive(hdl, "errors", jvxfs_directive_app_errors, NULL);
+    jvxfs_app_add_directive(hdl, "config", jvxfs_directive_app_config, NULL);
+}
+
+jvxfs_status_t compile_directives(app_t* hdl, list_drct_t* start, table_drct_t* table)
+{
+    size_t count = 0;
+    for (list_drct_t* item = start; item; item = item->next) ++count;
+    /* At most half full, so a miss ends at an empty slot after a few probes. */
+    uint32_t size = 4;
+    while (size < 2 * count) size <<= 1;
+    switch_memory_pool_t* pool = jvxfs_module_get_memory_pool(hdl->mod);
+    slot_drct_t* slots = (slot_drct_t*)switch_core_alloc(pool, sizeof(slot_drct_t) * size);
+    if (!slots) {
+        jvxfs_error_t* err_hdl = jvxfs_module_get_error_handler(hdl->mod);
+        return jvxfs_error_set_error(err_hdl, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_APP,
+            "Could not create directive table.");
+    }
+    memset(slots, 0, sizeof(slot_drct_t) * size);
+    for (list_drct_t* item = start; item; item = item->next) {
+        size_t length = strlen(item->name);
+        if (length > JVXFS_DIRECTIVE_NAME_MAX_LENGTH) length = JVXFS_DIRECTIVE_NAME_MAX_LENGTH;
+        uint32_t hash = hash_name(item->name, length);
+        uint32_t i = hash & (size - 1);
+        bool duplicate = false;
+        while (slots[i].item) {
+            if (slots[i].hash == hash && slots[i].length == length && memcmp(slots[i].item->name, item->name, length) == 0) {
+                duplicate = true;
+                break;
+            }
+            i = (i + 1) & (size - 1);
+        }
+        /* Like the list, the directive added first wins. */
+        if (duplicate) continue;
+        slots[i].hash = hash;
+        slots[i].length = length;
+        slots[i].item = item;
+    }
+    table->mask = size - 1;
+    table->slots = slots;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+list_drct_t* find_directive(app_t* hdl, bool session, const char* name, size_t length)
+{
+    if (length > JVXFS_DIRECTIVE_NAME_MAX_LENGTH) length = JVXFS_DIRECTIVE_NAME_MAX_LENGTH;
+    table_drct_t* table = (session) ? &hdl->drctInstTable : &hdl->drctAppTable;
+    if (!table->slots) {
+        /* Not started yet, the directives are only listed. */
+        list_drct_t* item = (session) ? hdl->drctInstStart : hdl->drctAppStart;
+        for (; item; item = item->next) {
+            if (strncmp(item->name, name, length) != 0) continue;
+            if (item->name[length] == '\0' || length == JVXFS_DIRECTIVE_NAME_MAX_LENGTH) return item;
+        }
+        return NULL;
+    }
+    uint32_t hash = hash_name(name, length);
+    for (uint32_t i = hash & table->mask; table->slots[i].item; i = (i + 1) & table->mask) {
+        slot_drct_t* slot = &table->slots[i];
+        if (slot->hash == hash && slot->length == length && memcmp(slot->item->name, name, length) == 0) return slot->item;
+    }
+    return NULL;
+}
+
+jvxfs_status_t call_directive(list_drct_t* found, jvxfs_directive_data_t* data, jvxfs_view_t* view)
+{
+    if (!found) return JVXFS_STATUS_ELEMENT_NOT_FOUND;
+    if (!data->session) {
+        jvxfs_directive_func_app_t func = (jvxfs_directive_func_app_t)found->func;
+        func(view, data, found->data);
+        return JVXFS_STATUS_SUCCESS;
+    } else {
+        jvxfs_directive_func_session_t func = (jvxfs_directive_func_session_t)found->func; 
+        return jvxfs_session_exec_directive(data, view, func, found->data);
+    }
+}
+
+uint32_t hash_name(const char* name, size_t length)
+{
+    /* FNV-1a, directive names are short. */
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+jvxfs_status_t parse_target(fan_out_t* fan, const char* target, size_t length)
+{
+    if (length == 3 && strncmp(target, "all", 3) == 0) return JVXFS_STATUS_SUCCESS;
+    if (length > 7 && strncmp(target, "number:", 7) == 0) {
+        fan->byNumber = true;
+        fan->prefix = target + 7;
+        fan->prefixLength = length - 7;
+        return JVXFS_STATUS_SUCCESS;
+    }
+    if (length > 5 && strncmp(target, "name:", 5) == 0) {
+        fan->prefix = target + 5;
+        fan->prefixLength = length - 5;
+        return JVXFS_STATUS_SUCCESS;
+    }
+    /* Anything else is a comma separated list of UUIDs, hashed so long lists stay cheap per session. */
+    uint32_t count = 1;
+    for (size_t i = 0; i < length; ++i) {
+        if (target[i] == ',') ++count;
+    }
+    uint32_t size = 4;
+    while (size < 2 * count) size <<= 1;
+    fan->uuids = (target_uuid_t*)calloc(size, sizeof(target_uuid_t));
+    if (!fan->uuids) return JVXFS_STATUS_ALLOCATION_FAILED;
+    fan->uuidMask = size - 1;
+    const char* end = target + length;
+    for (const char* pos = target; pos < end;) {
+        const char* next = memchr(pos, ',', end - pos);
+        if (!next) next = end;
+        size_t len = next - pos;
+        if (len) {
+            uint32_t hash = hash_name(pos, len);
+            uint32_t i = hash & fan->uuidMask;
+            while (fan->uuids[i].str) i = (i + 1) & fan->uuidMask;
+            fan->uuids[i].str = pos;
+            fan->uuids[i].length = len;
+            fan->uuids[i].hash = hash;
+        }
+        pos = next + 1;
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
+bool matches_target(fan_out_t* fan, switch_core_session_t* session)
+{
+    if (fan->prefix) {
+        const char* value = (fan->byNumber) ? jvxfs_session_get_extension_number(session) :
+            jvxfs_session_get_extension_name(session);
+        return value && strncmp(value, fan->prefix, fan->prefixLength) == 0;
+    }
+    if (!fan->uuids) return true;
+    const char* uuid = switch_core_session_get_uuid(session);
+    size_t length = strlen(uuid);
+    uint32_t hash = hash_name(uuid, length);
+    for (uint32_t i = hash & fan->uuidMask; fan->uuids[i].str; i = (i + 1) & fan->uuidMask) {
+        target_uuid_t* entry = &fan->uuids[i];
+        if (entry->hash == hash && entry->length == length && memcmp(entry->str, uuid, length) == 0) return true;
+    }
+    return false;
+}
+
+void fan_out_func(switch_core_session_t* session, jvxfs_app_instance_t* inst, uint32_t chunk, void* data)
+{
+    fan_out_t* fan = (fan_out_t*)data;
+    if (!matches_target(fan, session)) return;
+    jvxfs_directive_data_t rqst = *fan->data;
+    rqst.session = session;
+    view_priv_t view = *fan->view;
+    view.data = &rqst;
+    if (fan->buffers) view.console = &fan->buffers[chunk].stream;
+    jvxfs_directive_func_session_t func = (jvxfs_directive_func_session_t)fan->found->func;
+    func(&view, &rqst, inst, fan->found->data);
+    jvxfs_atomic_fetch_add(&fan->matched, 1);
 }
\ No newline at end of file
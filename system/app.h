@@ -18,6 +18,9 @@
 #include <stdarg.h>
 #include <switch.h>
 #include "defines.h"
+#include "command.h"
+#include "registry.h"
+#include "../utils/histogram.h"
 #include "../utils/variadic.h"
 
 JVX_FS_LIB_BEGIN
@@ -53,6 +56,21 @@ jvxfs_status_t jvxfs_app_add_session_directive(jvxfs_app_t* app, const char* nam
 
 jvxfs_status_t jvxfs_app_call_directive(jvxfs_directive_data_t* data, jvxfs_view_t* view);
 
+/**
+ * @brief Call the directive named by a parsed command.
+ * @details Sets directive name, parameters and arguments of @a data from @a cmd, app and session have to be set.
+ */
+jvxfs_status_t jvxfs_app_call_command(jvxfs_directive_data_t* data, const jvxfs_command_t* cmd, jvxfs_view_t* view);
+
+/**
+ * @brief Call a session directive for every live session of the app matching @a target.
+ * @details @a target is "all", "number:<prefix>", "name:<prefix>" or a comma separated list of UUIDs. The sessions
+ * are visited in parallel chunks on the worker pool of the module, console output is collected per chunk and
+ * written in registry order.
+ */
+jvxfs_status_t jvxfs_app_call_targeted_command(jvxfs_directive_data_t* data, const char* target, size_t length,
+    const jvxfs_command_t* cmd, jvxfs_view_t* view);
+
 jvxfs_status_t jvxfs_app_exec_call(jvxfs_app_t* app, switch_core_session_t* session, const char* args);
 
 jvxfs_status_t jvxfs_app_set_instance_factory(jvxfs_app_t* app, jvxfs_app_instance_factory_t func);
@@ -62,6 +80,42 @@ jvxfs_status_t jvxfs_app_get_sigproc_config(jvxfs_app_t* app, jvxfs_sigprog_conf
 
 jvxfs_status_t jvxfs_app_set_sigproc_update_func(jvxfs_app_t* app, jvxfs_algorithm_update_t func, jvxfs_sigproc_update_flag_t flag);
 
+jvxfs_status_t jvxfs_app_set_sigproc_batch_func(jvxfs_app_t* app, jvxfs_algorithm_process_batch_t func, uint32_t sessions,
+    uint32_t interval);
+jvxfs_sigproc_batch_collector_t* jvxfs_app_get_sigproc_batch_collector(jvxfs_app_t* app);
+
+jvxfs_status_t jvxfs_app_set_sigproc_reset_func(jvxfs_app_t* app, jvxfs_algorithm_reset_t func);
+
+/**
+ * @brief Run the algorithm in the frequency domain.
+ * @details Each processor of the app runs an STFT engine of the geometry set with jvxfs_sigproc_set_stft() and
+ * calls @a func once per hop with the spectrum, the process function is no longer called. The
+ * output is delayed by the FFT size - hop plus the delay of collecting frames into hops, see
+ * jvxfs_sigproc_get_block_latency(). The datatype must be #JVXFS_SP_16BIT_LE or #JVXFS_SP_FLOAT32_LE, a
+ * batch function or a block size cannot be set as well.
+ * @see jvxfs_stft_create()
+ */
+jvxfs_status_t jvxfs_app_set_sigproc_spectral_func(jvxfs_app_t* app, jvxfs_algorithm_process_spectral_t func);
+jvxfs_sigproc_instance_pool_t* jvxfs_app_get_sigproc_instance_pool(jvxfs_app_t* app);
+
+/**
+ * @brief Set the function building the profile of the app for a samplerate.
+ * @details When the module starts, @a func is called once for every allowed samplerate with zeroed memory of
+ * @a size bytes, aligned to #JVXFS_SP_MEMORY_ALIGNMENT. It computes what depends on the samplerate only, e.g.
+ * filter coefficients or windows. The profiles are immutable afterwards and shared by all processors of the
+ * app, which find the one for their samplerate in @a profile of the media.
+ * @see jvxfs_sigproc_allow_samplerates()
+ */
+jvxfs_status_t jvxfs_app_set_sigproc_profile_func(jvxfs_app_t* app, jvxfs_algorithm_profile_t func, size_t size);
+
+/**
+ * @brief Processing statistics of all processors of a signal processing app, @em NULL for other apps.
+ * @see jvxfs_sigproc_get_stats()
+ */
+jvxfs_histogram_t* jvxfs_app_get_sigproc_stats(jvxfs_app_t* app);
+
+jvxfs_registry_t* jvxfs_app_get_registry(jvxfs_app_t* app);
+
 jvxfs_module_t* jvxfs_app_get_module(jvxfs_app_t* app);
 
 JVX_FS_LIB_END
@@ -0,0 +1,47 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <stdbool.h>
+#include "command.h"
+
+static const char* skip_space(const char* pos);
+static bool is_space(char c);
+
+
+void jvxfs_command_parse(const char* cmd, jvxfs_command_t* out)
+{
+    const char* pos = skip_space(cmd ? cmd : "");
+    out->name = pos;
+    while (*pos && !is_space(*pos)) ++pos;
+    out->nameLength = pos - out->name;
+    pos = skip_space(pos);
+    out->parameters = pos;
+    out->argc = 0;
+    while (*pos && out->argc < JVXFS_DIRECTIVE_MAX_ARGS) {
+        jvxfs_directive_arg_t* arg = &out->argv[out->argc++];
+        if (*pos == '"') {
+            arg->str = ++pos;
+            while (*pos && *pos != '"') ++pos;
+            arg->length = pos - arg->str;
+            if (*pos) ++pos;
+        } else {
+            arg->str = pos;
+            while (*pos && !is_space(*pos)) ++pos;
+            arg->length = pos - arg->str;
+        }
+        pos = skip_space(pos);
+    }
+}
+
+
+const char* skip_space(const char* pos)
+{
+    while (is_space(*pos)) ++pos;
+    return pos;
+}
+
+bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
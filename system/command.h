@@ -0,0 +1,42 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+ 
+/**
+ * @file command.h
+ * @brief Tokenizer for directive commands of API calls and dialplan invocations.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-22
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_SYSTEM_COMMAND_H
+#define LIB_JVX_FS_FRAMEWORK_SYSTEM_COMMAND_H
+
+#include <stddef.h>
+#include "defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @brief Command split into directive name, parameters and arguments.
+ * @details Nothing is copied, all members point into the parsed string and are only valid as long as it is.
+ * @a parameters is the rest of the command after the directive name, @a argv holds the parameters split
+ * at white space, double quotes group an argument and are not part of it. Arguments beyond
+ * #JVXFS_DIRECTIVE_MAX_ARGS are only part of @a parameters.
+ */
+typedef struct
+{
+    const char* name;
+    size_t nameLength;
+    const char* parameters;
+    jvxfs_directive_arg_t argv[JVXFS_DIRECTIVE_MAX_ARGS];
+    size_t argc;
+} jvxfs_command_t;
+
+void jvxfs_command_parse(const char* cmd, jvxfs_command_t* out);
+
+JVX_FS_LIB_END
+
+#endif
@@ -0,0 +1,720 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include "../utils/atomic.h"
+#include "error.h"
+#include "config.h"
+
+#define DERIVED_ALIGNMENT 16
+#define ALIGN_UP(_n) (((_n) + DERIVED_ALIGNMENT - 1) & ~((size_t)DERIVED_ALIGNMENT - 1))
+
+typedef union
+{
+    int64_t i;
+    double f;
+    bool b;
+    const char* s;
+} value_t;
+
+typedef struct param_s
+{
+    char name[JVXFS_CONFIG_NAME_MAX_LENGTH];
+    jvxfs_config_type_t type;
+    value_t def;
+    value_t min;
+    value_t max;
+    struct param_s* next;
+} param_t;
+
+/* Published blocks are never written again except for their references, the list field only belongs to the writer. */
+typedef struct block_s
+{
+    uint32_t version;
+    uint32_t count;
+    value_t* values;
+    void* derived;
+    uint32_t refs;
+    struct block_s* next;
+} block_t;
+
+typedef struct
+{
+    jvxfs_error_t* err;
+    switch_memory_pool_t* pool;
+    param_t* paramStart;
+    param_t* paramStop;
+    param_t** params;
+    uint32_t count;
+    jvxfs_config_derive_t derive;
+    size_t derivedSize;
+    void* deriveData;
+    block_t* current;
+    block_t* retired;
+    uint32_t readers;
+    uint32_t version;
+    const char* path;
+    bool started;
+    bool running;
+    int watch;
+    int watchDir;
+    time_t seenTime;
+    int64_t seenSize;
+    switch_thread_t* thread;
+    switch_mutex_t* mutex;
+    switch_thread_cond_t* cond;
+} config_t;
+
+static jvxfs_status_t add_param(config_t* hdl, const char* name, jvxfs_config_type_t type, value_t def, value_t min,
+    value_t max, uint32_t* slot);
+static jvxfs_status_t reload(config_t* hdl);
+static jvxfs_status_t read_file(config_t* hdl, char** out);
+static jvxfs_status_t parse(config_t* hdl, char* text, value_t* values);
+static jvxfs_status_t parse_value(config_t* hdl, param_t* param, char* str, value_t* out, uint32_t line);
+static char* trim(char* str);
+static param_t* find_param(config_t* hdl, const char* name);
+static jvxfs_status_t build_block(config_t* hdl, const value_t* values, block_t** out);
+static void publish(config_t* hdl, block_t* block);
+static void free_retired(config_t* hdl, bool all);
+static void* SWITCH_THREAD_FUNC watch_thread(switch_thread_t* thread, void* obj);
+static void arm_watch(config_t* hdl);
+static bool file_changed(config_t* hdl);
+
+
+jvxfs_status_t jvxfs_config_create(jvxfs_config_t** obj, jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    config_t* hdl = (config_t*)switch_core_alloc(pool, sizeof(config_t));
+    if (!hdl || switch_mutex_init(&hdl->mutex, SWITCH_MUTEX_NESTED, pool) != SWITCH_STATUS_SUCCESS ||
+        switch_thread_cond_create(&hdl->cond, pool) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_CONFIG,
+            "Could not create configuration.");
+    }
+    hdl->err = err;
+    hdl->pool = pool;
+    hdl->paramStart = NULL;
+    hdl->paramStop = NULL;
+    hdl->params = NULL;
+    hdl->count = 0;
+    hdl->derive = NULL;
+    hdl->derivedSize = 0;
+    hdl->deriveData = NULL;
+    hdl->current = NULL;
+    hdl->retired = NULL;
+    hdl->readers = 0;
+    hdl->version = 0;
+    hdl->path = NULL;
+    hdl->started = false;
+    hdl->running = false;
+    hdl->watch = -1;
+    hdl->watchDir = -1;
+    hdl->seenTime = 0;
+    hdl->seenSize = 0;
+    hdl->thread = NULL;
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_config_start(jvxfs_config_t* obj)
+{
+    config_t* hdl = (config_t*)obj;
+    hdl->params = (param_t**)switch_core_alloc(hdl->pool, sizeof(param_t*) * (hdl->count ? hdl->count : 1));
+    if (!hdl->params) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_CONFIG,
+            "Could not start configuration.");
+    }
+    uint32_t i = 0;
+    for (param_t* param = hdl->paramStart; param; param = param->next) hdl->params[i++] = param;
+    switch_mutex_lock(hdl->mutex);
+    hdl->started = true;
+    /* Armed before loading, so a change right after loading is not missed. */
+    arm_watch(hdl);
+    jvxfs_status_t res = reload(hdl);
+    switch_mutex_unlock(hdl->mutex);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    hdl->running = true;
+    switch_threadattr_t* attr = NULL;
+    switch_threadattr_create(&attr, hdl->pool);
+    switch_threadattr_stacksize_set(attr, SWITCH_THREAD_STACKSIZE);
+    if (switch_thread_create(&hdl->thread, attr, watch_thread, hdl, hdl->pool) != SWITCH_STATUS_SUCCESS) {
+        hdl->running = false;
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_CONFIG,
+            "Could not start configuration watcher thread.");
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_config_set_file(jvxfs_config_t* obj, const char* path)
+{
+    config_t* hdl = (config_t*)obj;
+    char* copy = NULL;
+    if (!zstr(path)) {
+        size_t length = strlen(path) + 1;
+        copy = (char*)switch_core_alloc(hdl->pool, length);
+        if (!copy) {
+            return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+                "Could not change configuration file.");
+        }
+        memcpy(copy, path, length);
+    }
+    switch_mutex_lock(hdl->mutex);
+    const char* previous = hdl->path;
+    hdl->path = copy;
+    jvxfs_status_t res = JVXFS_STATUS_SUCCESS;
+    if (hdl->started) {
+        arm_watch(hdl);
+        res = reload(hdl);
+        if (res != JVXFS_STATUS_SUCCESS) {
+            hdl->path = previous;
+            arm_watch(hdl);
+        }
+    }
+    switch_mutex_unlock(hdl->mutex);
+    return res;
+}
+
+void jvxfs_config_destroy(jvxfs_config_t** obj)
+{
+    config_t* hdl = (config_t*)*obj;
+    if (!hdl) return;
+    if (hdl->thread) {
+        switch_mutex_lock(hdl->mutex);
+        jvxfs_atomic_store(&hdl->running, false);
+        switch_thread_cond_signal(hdl->cond);
+        switch_mutex_unlock(hdl->mutex);
+        switch_status_t st;
+        switch_thread_join(&st, hdl->thread);
+        hdl->thread = NULL;
+    }
+#ifdef __linux__
+    if (hdl->watch >= 0) close(hdl->watch);
+#endif
+    hdl->watch = -1;
+    free(hdl->current);
+    hdl->current = NULL;
+    free_retired(hdl, true);
+    *obj = NULL;
+}
+
+jvxfs_status_t jvxfs_config_add_int(jvxfs_config_t* obj, const char* name, int64_t def, int64_t min, int64_t max,
+    uint32_t* slot)
+{
+    value_t d = { .i = def }, lo = { .i = min }, hi = { .i = max };
+    return add_param((config_t*)obj, name, JVXFS_CONFIG_INT, d, lo, hi, slot);
+}
+
+jvxfs_status_t jvxfs_config_add_float(jvxfs_config_t* obj, const char* name, double def, double min, double max,
+    uint32_t* slot)
+{
+    value_t d = { .f = def }, lo = { .f = min }, hi = { .f = max };
+    return add_param((config_t*)obj, name, JVXFS_CONFIG_FLOAT, d, lo, hi, slot);
+}
+
+jvxfs_status_t jvxfs_config_add_bool(jvxfs_config_t* obj, const char* name, bool def, uint32_t* slot)
+{
+    value_t d = { .b = def }, none = { .i = 0 };
+    return add_param((config_t*)obj, name, JVXFS_CONFIG_BOOL, d, none, none, slot);
+}
+
+jvxfs_status_t jvxfs_config_add_string(jvxfs_config_t* obj, const char* name, const char* def, uint32_t* slot)
+{
+    config_t* hdl = (config_t*)obj;
+    size_t length = def ? strlen(def) + 1 : 1;
+    char* copy = (char*)switch_core_alloc(hdl->pool, length);
+    if (!copy) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_CONFIG,
+            "Could not add configuration parameter.");
+    }
+    memcpy(copy, def ? def : "", length);
+    value_t d = { .s = copy }, none = { .i = 0 };
+    return add_param(hdl, name, JVXFS_CONFIG_STRING, d, none, none, slot);
+}
+
+jvxfs_status_t jvxfs_config_set_derive_func(jvxfs_config_t* obj, jvxfs_config_derive_t func, size_t size, void* data)
+{
+    config_t* hdl = (config_t*)obj;
+    if (hdl->started) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not set function for derived configuration values.");
+    }
+    hdl->derive = func;
+    hdl->derivedSize = func ? size : 0;
+    hdl->deriveData = data;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+const jvxfs_config_block_t* jvxfs_config_acquire(jvxfs_config_t* obj)
+{
+    config_t* hdl = (config_t*)obj;
+    /* Registered as reader until the reference is taken, so a block replaced meanwhile is not freed. */
+    jvxfs_atomic_fetch_add(&hdl->readers, 1);
+    jvxfs_atomic_fence();
+    block_t* block = jvxfs_atomic_load(&hdl->current);
+    if (block) jvxfs_atomic_fetch_add_relaxed(&block->refs, 1);
+    jvxfs_atomic_fetch_sub(&hdl->readers, 1);
+    return block;
+}
+
+void jvxfs_config_release(jvxfs_config_t* obj, const jvxfs_config_block_t* block)
+{
+    if (block) jvxfs_atomic_fetch_sub(&((block_t*)block)->refs, 1);
+}
+
+const jvxfs_config_block_t* jvxfs_config_refresh(jvxfs_config_t* obj, const jvxfs_config_block_t* block)
+{
+    config_t* hdl = (config_t*)obj;
+    if (block && jvxfs_atomic_load(&hdl->current) == block) return block;
+    jvxfs_config_release(obj, block);
+    return jvxfs_config_acquire(obj);
+}
+
+int64_t jvxfs_config_get_int(const jvxfs_config_block_t* block, uint32_t slot)
+{
+    const block_t* blk = (const block_t*)block;
+    return (slot < blk->count) ? blk->values[slot].i : 0;
+}
+
+double jvxfs_config_get_float(const jvxfs_config_block_t* block, uint32_t slot)
+{
+    const block_t* blk = (const block_t*)block;
+    return (slot < blk->count) ? blk->values[slot].f : 0.0;
+}
+
+bool jvxfs_config_get_bool(const jvxfs_config_block_t* block, uint32_t slot)
+{
+    const block_t* blk = (const block_t*)block;
+    return (slot < blk->count) ? blk->values[slot].b : false;
+}
+
+const char* jvxfs_config_get_string(const jvxfs_config_block_t* block, uint32_t slot)
+{
+    const block_t* blk = (const block_t*)block;
+    return (slot < blk->count) ? blk->values[slot].s : "";
+}
+
+const void* jvxfs_config_get_derived(const jvxfs_config_block_t* block)
+{
+    const block_t* blk = (const block_t*)block;
+    return blk->derived;
+}
+
+uint32_t jvxfs_config_get_version(const jvxfs_config_block_t* block)
+{
+    const block_t* blk = (const block_t*)block;
+    return blk->version;
+}
+
+jvxfs_status_t jvxfs_config_reload(jvxfs_config_t* obj)
+{
+    config_t* hdl = (config_t*)obj;
+    switch_mutex_lock(hdl->mutex);
+    jvxfs_status_t res = hdl->started ? reload(hdl) : JVXFS_STATUS_PENDING_CONFIGURATION;
+    switch_mutex_unlock(hdl->mutex);
+    return res;
+}
+
+const char* jvxfs_config_get_file(jvxfs_config_t* obj)
+{
+    config_t* hdl = (config_t*)obj;
+    return hdl->path;
+}
+
+uint32_t jvxfs_config_count(jvxfs_config_t* obj)
+{
+    config_t* hdl = (config_t*)obj;
+    return hdl->count;
+}
+
+const char* jvxfs_config_get_name(jvxfs_config_t* obj, uint32_t slot)
+{
+    config_t* hdl = (config_t*)obj;
+    return (hdl->params && slot < hdl->count) ? hdl->params[slot]->name : NULL;
+}
+
+jvxfs_config_type_t jvxfs_config_get_type(jvxfs_config_t* obj, uint32_t slot)
+{
+    config_t* hdl = (config_t*)obj;
+    return (hdl->params && slot < hdl->count) ? hdl->params[slot]->type : JVXFS_CONFIG_INT;
+}
+
+
+jvxfs_status_t add_param(config_t* hdl, const char* name, jvxfs_config_type_t type, value_t def, value_t min,
+    value_t max, uint32_t* slot)
+{
+    if (hdl->started) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not add configuration parameter.");
+    }
+    if (zstr(name) || strlen(name) >= JVXFS_CONFIG_NAME_MAX_LENGTH) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not add configuration parameter, invalid name.");
+    }
+    if (find_param(hdl, name)) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_DUPLICATE_ENTRY, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not add configuration parameter, name already in use.");
+    }
+    param_t* param = (param_t*)switch_core_alloc(hdl->pool, sizeof(param_t));
+    if (!param) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_CONFIG,
+            "Could not add configuration parameter.");
+    }
+    strcpy(param->name, name);
+    param->type = type;
+    param->min = min;
+    param->max = max;
+    param->def = def;
+    if (type == JVXFS_CONFIG_INT && max.i >= min.i) {
+        if (def.i < min.i) param->def.i = min.i;
+        if (def.i > max.i) param->def.i = max.i;
+    } else if (type == JVXFS_CONFIG_FLOAT && max.f >= min.f) {
+        if (def.f < min.f) param->def.f = min.f;
+        if (def.f > max.f) param->def.f = max.f;
+    }
+    param->next = NULL;
+    if (hdl->paramStop) {
+        hdl->paramStop->next = param;
+    } else {
+        hdl->paramStart = param;
+    }
+    hdl->paramStop = param;
+    *slot = hdl->count++;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t reload(config_t* hdl)
+{
+    value_t* values = (value_t*)malloc(sizeof(value_t) * (hdl->count ? hdl->count : 1));
+    if (!values) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not load configuration.");
+    }
+    for (uint32_t i = 0; i < hdl->count; ++i) values[i] = hdl->params[i]->def;
+    char* text = NULL;
+    jvxfs_status_t res = JVXFS_STATUS_SUCCESS;
+    if (hdl->path) {
+        res = read_file(hdl, &text);
+        if (res == JVXFS_STATUS_SUCCESS) res = parse(hdl, text, values);
+    }
+    block_t* block = NULL;
+    /* Strings of the values still point into the text until the block holds copies. */
+    if (res == JVXFS_STATUS_SUCCESS) res = build_block(hdl, values, &block);
+    free(text);
+    free(values);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    publish(hdl, block);
+    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Configuration version %u loaded from \"%s\".\n",
+        block->version, hdl->path ? hdl->path : "defaults");
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t read_file(config_t* hdl, char** out)
+{
+    *out = NULL;
+    FILE* file = fopen(hdl->path, "rb");
+    if (!file) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Could not open configuration file \"%s\".\n", hdl->path);
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_NOT_FOUND, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not open configuration file.");
+    }
+    char* text = NULL;
+    long size = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) text = (char*)malloc((size_t)size + 1);
+    size_t length = text ? fread(text, 1, (size_t)size, file) : 0;
+    fclose(file);
+    if (!text) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not read configuration file.");
+    }
+    text[length] = '\0';
+    struct stat info;
+    if (stat(hdl->path, &info) == 0) {
+        hdl->seenTime = info.st_mtime;
+        hdl->seenSize = (int64_t)info.st_size;
+    }
+    *out = text;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t parse(config_t* hdl, char* text, value_t* values)
+{
+    char section[JVXFS_CONFIG_NAME_MAX_LENGTH] = "";
+    char name[2 * JVXFS_CONFIG_NAME_MAX_LENGTH];
+    uint32_t number = 0;
+    for (char* line = text; line; ) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        ++number;
+        line = trim(line);
+        if (*line == '\0' || *line == ';' || *line == '#') {
+            line = next;
+            continue;
+        }
+        if (*line == '[') {
+            char* close = strchr(line, ']');
+            if (!close || (size_t)(close - line - 1) >= sizeof(section)) {
+                switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Configuration file \"%s\", line %u: "
+                    "Invalid section.\n", hdl->path, number);
+                return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_INVALID_FORMAT, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+                    "Could not parse configuration file.");
+            }
+            *close = '\0';
+            strcpy(section, trim(line + 1));
+            line = next;
+            continue;
+        }
+        char* equals = strchr(line, '=');
+        if (!equals) {
+            switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Configuration file \"%s\", line %u: "
+                "Expected \"key = value\".\n", hdl->path, number);
+            return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_INVALID_FORMAT, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+                "Could not parse configuration file.");
+        }
+        *equals = '\0';
+        char* key = trim(line);
+        char* value = trim(equals + 1);
+        if (*value == '"') {
+            char* close = strchr(++value, '"');
+            if (close) *close = '\0';
+        } else {
+            /* Comments after the value need white space in front, so "a;b" stays one value. */
+            for (char* c = value; *c; ++c) {
+                if ((*c == ';' || *c == '#') && c > value && isspace((unsigned char)c[-1])) {
+                    *c = '\0';
+                    value = trim(value);
+                    break;
+                }
+            }
+        }
+        snprintf(name, sizeof(name), "%s%s%s", section, *section ? "." : "", key);
+        param_t* param = find_param(hdl, name);
+        if (!param) {
+            switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Configuration file \"%s\", line %u: "
+                "Ignoring unknown parameter \"%s\".\n", hdl->path, number, name);
+            line = next;
+            continue;
+        }
+        uint32_t slot = 0;
+        while (hdl->params[slot] != param) ++slot;
+        jvxfs_status_t res = parse_value(hdl, param, value, &values[slot], number);
+        if (res != JVXFS_STATUS_SUCCESS) return res;
+        line = next;
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t parse_value(config_t* hdl, param_t* param, char* str, value_t* out, uint32_t line)
+{
+    char* end = str;
+    switch (param->type) {
+    case JVXFS_CONFIG_INT:
+        out->i = strtoll(str, &end, 0);
+        break;
+    case JVXFS_CONFIG_FLOAT:
+        out->f = strtod(str, &end);
+        break;
+    case JVXFS_CONFIG_BOOL:
+        if (switch_true(str)) {
+            out->b = true;
+            end = str + strlen(str);
+        } else if (switch_false(str)) {
+            out->b = false;
+            end = str + strlen(str);
+        }
+        break;
+    case JVXFS_CONFIG_STRING:
+        out->s = str;
+        return JVXFS_STATUS_SUCCESS;
+    }
+    if (end == str || *end != '\0') {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Configuration file \"%s\", line %u: "
+            "Invalid value \"%s\" of parameter \"%s\".\n", hdl->path, line, str, param->name);
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_INVALID_FORMAT, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not parse configuration file.");
+    }
+    bool clamped = false;
+    if (param->type == JVXFS_CONFIG_INT && param->max.i >= param->min.i) {
+        if (out->i < param->min.i) { out->i = param->min.i; clamped = true; }
+        if (out->i > param->max.i) { out->i = param->max.i; clamped = true; }
+    } else if (param->type == JVXFS_CONFIG_FLOAT && param->max.f >= param->min.f) {
+        if (out->f < param->min.f) { out->f = param->min.f; clamped = true; }
+        if (out->f > param->max.f) { out->f = param->max.f; clamped = true; }
+    }
+    if (clamped) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Configuration file \"%s\", line %u: "
+            "Value of parameter \"%s\" clamped to its range.\n", hdl->path, line, param->name);
+    }
+    return JVXFS_STATUS_SUCCESS;
+}
+
+char* trim(char* str)
+{
+    while (isspace((unsigned char)*str)) ++str;
+    char* end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) --end;
+    *end = '\0';
+    return str;
+}
+
+param_t* find_param(config_t* hdl, const char* name)
+{
+    for (param_t* param = hdl->paramStart; param; param = param->next) {
+        if (strcmp(param->name, name) == 0) return param;
+    }
+    return NULL;
+}
+
+jvxfs_status_t build_block(config_t* hdl, const value_t* values, block_t** out)
+{
+    *out = NULL;
+    size_t strings = 0;
+    for (uint32_t i = 0; i < hdl->count; ++i) {
+        if (hdl->params[i]->type == JVXFS_CONFIG_STRING) strings += strlen(values[i].s) + 1;
+    }
+    /* One allocation per block, so readers touch few cache lines and retiring it is a single free. */
+    size_t head = ALIGN_UP(sizeof(block_t));
+    size_t table = ALIGN_UP(sizeof(value_t) * hdl->count);
+    size_t derived = ALIGN_UP(hdl->derivedSize);
+    uint8_t* mem = (uint8_t*)calloc(1, head + table + derived + strings);
+    if (!mem) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+            "Could not build configuration block.");
+    }
+    block_t* block = (block_t*)mem;
+    block->count = hdl->count;
+    block->values = (value_t*)(mem + head);
+    block->derived = hdl->derivedSize ? mem + head + table : NULL;
+    char* str = (char*)(mem + head + table + derived);
+    for (uint32_t i = 0; i < hdl->count; ++i) {
+        block->values[i] = values[i];
+        if (hdl->params[i]->type != JVXFS_CONFIG_STRING) continue;
+        size_t length = strlen(values[i].s) + 1;
+        memcpy(str, values[i].s, length);
+        block->values[i].s = str;
+        str += length;
+    }
+    if (hdl->derive) {
+        jvxfs_status_t res = hdl->derive(block, block->derived, hdl->deriveData);
+        if (res != JVXFS_STATUS_SUCCESS) {
+            free(mem);
+            return jvxfs_error_set_error(hdl->err, res, JVXFS_LOG_ERROR, JVXFS_COMP_CONFIG,
+                "Configuration rejected by derive function.");
+        }
+    }
+    *out = block;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void publish(config_t* hdl, block_t* block)
+{
+    block->version = ++hdl->version;
+    block->refs = 0;
+    block->next = NULL;
+    block_t* old = jvxfs_atomic_exchange(&hdl->current, block);
+    /* Pairs with the fence of jvxfs_config_acquire(), so a reader either takes the new block or is counted. */
+    jvxfs_atomic_fence();
+    if (old) {
+        old->next = hdl->retired;
+        hdl->retired = old;
+    }
+    free_retired(hdl, false);
+}
+
+void free_retired(config_t* hdl, bool all)
+{
+    /* Without readers taking a reference, no retired block gains one, those without references are unused. */
+    if (!all && jvxfs_atomic_load(&hdl->readers) != 0) return;
+    block_t** link = &hdl->retired;
+    while (*link) {
+        block_t* block = *link;
+        if (all || jvxfs_atomic_load(&block->refs) == 0) {
+            *link = block->next;
+            free(block);
+        } else {
+            link = &block->next;
+        }
+    }
+}
+
+void* SWITCH_THREAD_FUNC watch_thread(switch_thread_t* thread, void* obj)
+{
+    config_t* hdl = (config_t*)obj;
+    bool pending = false;
+    switch_mutex_lock(hdl->mutex);
+    while (jvxfs_atomic_load(&hdl->running)) {
+        switch_thread_cond_timedwait(hdl->cond, hdl->mutex, (switch_interval_time_t)JVXFS_CONFIG_POLL_MS * 1000);
+        if (!jvxfs_atomic_load(&hdl->running)) break;
+        /* Editors write in several steps, so the file is loaded once it stayed unchanged for an interval. */
+        if (file_changed(hdl)) {
+            pending = true;
+        } else if (pending) {
+            pending = false;
+            reload(hdl);
+        }
+        free_retired(hdl, false);
+    }
+    switch_mutex_unlock(hdl->mutex);
+    return NULL;
+}
+
+void arm_watch(config_t* hdl)
+{
+#ifdef __linux__
+    if (hdl->watch >= 0 && hdl->watchDir >= 0) inotify_rm_watch(hdl->watch, hdl->watchDir);
+    hdl->watchDir = -1;
+    if (!hdl->path) return;
+    if (hdl->watch < 0) hdl->watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (hdl->watch < 0) return;
+    /* The directory is watched, since editors often replace the file instead of writing it. */
+    const char* slash = strrchr(hdl->path, '/');
+    char dir[1024];
+    if (!slash) {
+        strcpy(dir, ".");
+    } else if (slash == hdl->path) {
+        strcpy(dir, "/");
+    } else if ((size_t)(slash - hdl->path) < sizeof(dir)) {
+        memcpy(dir, hdl->path, slash - hdl->path);
+        dir[slash - hdl->path] = '\0';
+    } else {
+        return;
+    }
+    hdl->watchDir = inotify_add_watch(hdl->watch, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+#endif
+}
+
+bool file_changed(config_t* hdl)
+{
+    if (!hdl->path) return false;
+#ifdef __linux__
+    if (hdl->watchDir >= 0) {
+        const char* slash = strrchr(hdl->path, '/');
+        const char* base = slash ? slash + 1 : hdl->path;
+        char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(hdl->watch, events, sizeof(events))) > 0) {
+            for (char* ptr = events; ptr < events + length; ) {
+                struct inotify_event* ev = (struct inotify_event*)ptr;
+                if (ev->len > 0 && strcmp(ev->name, base) == 0) changed = true;
+                ptr += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        return changed;
+    }
+#endif
+    /* Without inotify the file is polled. */
+    struct stat info;
+    if (stat(hdl->path, &info) != 0) return false;
+    if (info.st_mtime == hdl->seenTime && (int64_t)info.st_size == hdl->seenSize) return false;
+    hdl->seenTime = info.st_mtime;
+    hdl->seenSize = (int64_t)info.st_size;
+    return true;
+}
@@ -0,0 +1,168 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file config.h
+ * @brief Typed parameters of a module, loaded from a configuration file and reloaded on change.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-27
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_SYSTEM_CONFIG_H
+#define LIB_JVX_FS_FRAMEWORK_SYSTEM_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <switch.h>
+#include "defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @brief Interval in milliseconds in which the watcher thread looks for changes of the file.
+ */
+#define JVXFS_CONFIG_POLL_MS 250
+
+#define JVXFS_CONFIG_NAME_MAX_LENGTH 64
+
+typedef enum
+{
+    JVXFS_CONFIG_INT,
+    JVXFS_CONFIG_FLOAT,
+    JVXFS_CONFIG_BOOL,
+    JVXFS_CONFIG_STRING
+} jvxfs_config_type_t;
+
+/**
+ * @brief Compute values derived from the parameters of a new block, e.g. filter coefficients.
+ * @details Called on the thread building the block, never while processing. Any other status than
+ * #JVXFS_STATUS_SUCCESS rejects the block, the current one stays published.
+ * @param[in] block     New block, not yet published.
+ * @param[out] derived  Zeroed memory of the size given to jvxfs_config_set_derive_func(), stored in the block.
+ * @param[in] data      User data given to jvxfs_config_set_derive_func().
+ */
+typedef jvxfs_status_t(*jvxfs_config_derive_t)(const jvxfs_config_block_t* block, void* derived, void* data);
+
+/**
+ * @addtogroup config Configuration
+ * @details Apps declare their parameters while the module initializes and keep the returned slots. The file
+ * is an INI file, keys of section @em [name] are declared as @em name.key:
+ * @code
+ * ; comment
+ * level = -20
+ * [agc]
+ * enabled = yes
+ * target = -18.5
+ * @endcode
+ * The file is parsed once into an immutable block holding the typed values and the derived values. A watcher
+ * thread rebuilds the block when the file changes and publishes it atomically. A file that fails to parse
+ * keeps the current block. Readers call jvxfs_config_acquire() and read values by slot without parsing or
+ * locking. A block stays valid until it is handed back with jvxfs_config_release(), replaced blocks are freed
+ * by the watcher once nobody holds them. Processors hold the current block for their algorithm and pass it in
+ * @a config of their media at each frame.
+ * @{
+ */
+
+/**
+ * @brief Declare a parameter.
+ * @param[in] obj       Configuration of the module, see jvxfs_module_get_config().
+ * @param[in] name      Name of the parameter, copied.
+ * @param[in] def       Value if the file does not set it.
+ * @param[in] min       Minimum, smaller values are clamped.
+ * @param[in] max       Maximum, larger values are clamped.
+ * @param[out] slot     Slot to read the parameter from a block.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_config_add_int(jvxfs_config_t* obj, const char* name, int64_t def, int64_t min, int64_t max,
+    uint32_t* slot);
+jvxfs_status_t jvxfs_config_add_float(jvxfs_config_t* obj, const char* name, double def, double min, double max,
+    uint32_t* slot);
+jvxfs_status_t jvxfs_config_add_bool(jvxfs_config_t* obj, const char* name, bool def, uint32_t* slot);
+jvxfs_status_t jvxfs_config_add_string(jvxfs_config_t* obj, const char* name, const char* def, uint32_t* slot);
+
+/**
+ * @brief Set the function computing derived values of each block.
+ * @param[in] obj   Configuration.
+ * @param[in] func  Function.
+ * @param[in] size  Size of the derived values in bytes.
+ * @param[in] data  User data passed to @a func.
+ */
+jvxfs_status_t jvxfs_config_set_derive_func(jvxfs_config_t* obj, jvxfs_config_derive_t func, size_t size, void* data);
+
+/**
+ * @brief Return the current block, never @em NULL once the module is running.
+ * @details The block stays valid until it is passed to jvxfs_config_release().
+ */
+const jvxfs_config_block_t* jvxfs_config_acquire(jvxfs_config_t* obj);
+
+/**
+ * @brief Hand back a block returned by jvxfs_config_acquire() or jvxfs_config_refresh(), @em NULL is ignored.
+ */
+void jvxfs_config_release(jvxfs_config_t* obj, const jvxfs_config_block_t* block);
+
+/**
+ * @brief Return @a block if it is still current, otherwise release it and acquire the current one.
+ * @details Cheap enough to be called for every frame, references are only taken when the block changed.
+ */
+const jvxfs_config_block_t* jvxfs_config_refresh(jvxfs_config_t* obj, const jvxfs_config_block_t* block);
+
+int64_t jvxfs_config_get_int(const jvxfs_config_block_t* block, uint32_t slot);
+double jvxfs_config_get_float(const jvxfs_config_block_t* block, uint32_t slot);
+bool jvxfs_config_get_bool(const jvxfs_config_block_t* block, uint32_t slot);
+const char* jvxfs_config_get_string(const jvxfs_config_block_t* block, uint32_t slot);
+const void* jvxfs_config_get_derived(const jvxfs_config_block_t* block);
+
+/**
+ * @brief Return the version of a block, counting from 1 for the first block published.
+ */
+uint32_t jvxfs_config_get_version(const jvxfs_config_block_t* block);
+
+/**
+ * @brief Parse the file again and publish the result.
+ * @return Status code, the current block stays published on failure.
+ */
+jvxfs_status_t jvxfs_config_reload(jvxfs_config_t* obj);
+
+/**
+ * @brief Return the path of the file, @em NULL if the parameters keep their defaults.
+ */
+const char* jvxfs_config_get_file(jvxfs_config_t* obj);
+
+uint32_t jvxfs_config_count(jvxfs_config_t* obj);
+const char* jvxfs_config_get_name(jvxfs_config_t* obj, uint32_t slot);
+jvxfs_config_type_t jvxfs_config_get_type(jvxfs_config_t* obj, uint32_t slot);
+
+/**
+ * @}
+ */
+
+/**
+ * @brief Create the configuration of a module.
+ * @note Called by the module, use jvxfs_module_get_config().
+ */
+jvxfs_status_t jvxfs_config_create(jvxfs_config_t** obj, jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Publish the first block and start watching the file.
+ * @note Called by the module when it starts, parameters can no longer be declared afterwards.
+ */
+jvxfs_status_t jvxfs_config_start(jvxfs_config_t* obj);
+
+/**
+ * @brief Set the file, which is loaded right away if the configuration is started.
+ * @note Called by jvxfs_module_change_configfile().
+ */
+jvxfs_status_t jvxfs_config_set_file(jvxfs_config_t* obj, const char* path);
+
+/**
+ * @brief Stop watching and free all blocks.
+ * @note Called by the module when it terminates.
+ */
+void jvxfs_config_destroy(jvxfs_config_t** obj);
+
+JVX_FS_LIB_END
+
+#endif
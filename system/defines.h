@@ -84,6 +84,21 @@ typedef void jvxfs_app_instance_t;
 typedef void jvxfs_view_t;
 typedef void jvxfs_sigprog_config_t;
 typedef void jvxfs_sigproc_processor_t;
+typedef void jvxfs_sigproc_batch_collector_t;
+typedef void jvxfs_sigproc_instance_pool_t;
+typedef void jvxfs_config_t;
+typedef void jvxfs_config_block_t;
+
+#define JVXFS_DIRECTIVE_MAX_ARGS 16
+
+/**
+ * @brief Argument of a directive, not terminated, @a length characters starting at @a str.
+ */
+typedef struct
+{
+    const char* str;
+    size_t length;
+} jvxfs_directive_arg_t;
 
 typedef struct
 {
@@ -91,19 +106,23 @@ typedef struct
     switch_core_session_t* session;
     const char* directive;
     const char* parameters;
+    size_t argc;
+    const jvxfs_directive_arg_t* argv;
 } jvxfs_directive_data_t;
 
 typedef void(*jvxfs_directive_func_app_t)(jvxfs_view_t*, jvxfs_directive_data_t*, void*);
 typedef void(*jvxfs_directive_func_session_t)(jvxfs_view_t*, jvxfs_directive_data_t*, jvxfs_app_instance_t*, void*);
 #define JVXFS_DIRECTIVE_NAME_MAX_LENGTH 32
 
-typedef void jvxfs_sigproc_media_t;
+typedef struct jvxfs_sigproc_media jvxfs_sigproc_media_t;
+typedef struct jvxfs_sigproc_batch jvxfs_sigproc_batch_t;
+typedef struct jvxfs_sigproc_spectrum jvxfs_sigproc_spectrum_t;
 
 typedef enum
 {
     JVXFS_SP_EXEC_AUTO = 0,
-    JVXFS_SP_EXEC_ASYNC = 0,
-    JVXFS_SP_EXEC_SYNC = 1
+    JVXFS_SP_EXEC_SYNC = 1,
+    JVXFS_SP_EXEC_ASYNC = 2
 } jvxfs_sigproc_exec_t;
 
 typedef enum
@@ -115,19 +134,27 @@ typedef enum
 typedef void(*jvxfs_algorithm_construct_t)(void**, jvxfs_sigproc_media_t*, const char*);
 typedef void(*jvxfs_algorithm_initialize_t)(void*, jvxfs_sigproc_media_t*);
 typedef void(*jvxfs_algorithm_process_t)(void*, jvxfs_sigproc_media_t*);
+typedef void(*jvxfs_algorithm_process_batch_t)(void**, jvxfs_sigproc_batch_t*);
+typedef void(*jvxfs_algorithm_process_spectral_t)(void*, jvxfs_sigproc_spectrum_t*);
 typedef void(*jvxfs_algorithm_terminate_t)(void*);
 typedef void(*jvxfs_algorithm_destruct_t)(void**);
 typedef void(*jvxfs_algorithm_update_t)(void* hdl, jvxfs_sigproc_exec_t exec);
+typedef void(*jvxfs_algorithm_reset_t)(void*);
+typedef void(*jvxfs_algorithm_profile_t)(void* profile, uint32_t rate);
 
 typedef struct
 {
     jvxfs_algorithm_construct_t construct;
     jvxfs_algorithm_initialize_t initialize;
     jvxfs_algorithm_process_t process;
+    jvxfs_algorithm_process_batch_t process_batch;
+    jvxfs_algorithm_process_spectral_t process_spectral;
     jvxfs_algorithm_terminate_t terminate;
     jvxfs_algorithm_destruct_t destruct;
     jvxfs_algorithm_update_t update;
     jvxfs_sigproc_update_flag_t flag;
+    jvxfs_algorithm_reset_t reset;
+    jvxfs_algorithm_profile_t profile;
 } jvxfs_algorithm_vtable_t;
 
 JVX_FS_LIB_END
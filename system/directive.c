@@ -2,12 +2,239 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
  
+#include <stdlib.h>
+#include <string.h>
+#include "../processing/sp_processor.h"
+#include "../utils/histogram.h"
+#include "config.h"
 #include "directives.h"
+#include "error.h"
+#include "module.h"
+#include "session.h"
 #include "app.h"
 #include "view.h"
 
+typedef struct
+{
+    jvxfs_view_t* view;
+    jvxfs_histogram_snapshot_t* snap;
+} listing_t;
+
+static void write_stats(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, jvxfs_histogram_t* stats);
+static void list_session(switch_core_session_t* session, jvxfs_app_instance_t* inst, uint32_t chunk, void* data);
+static bool arg_equals(const jvxfs_directive_arg_t* arg, const char* str);
+
 void jvxfs_directive_app_version(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data)
 {
     const char* version = jvxfs_app_get_version(rqst->app);
     jvxfs_view_write_to_all(view, "%s", version);
+}
+
+void jvxfs_directive_app_stats(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data)
+{
+    write_stats(view, rqst, jvxfs_app_get_sigproc_stats(rqst->app));
+}
+
+void jvxfs_directive_session_stats(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, jvxfs_app_instance_t* inst, void* data)
+{
+    write_stats(view, rqst, jvxfs_sigproc_get_stats(inst));
+}
+
+void jvxfs_directive_app_sessions(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data)
+{
+    listing_t listing = { .view = view };
+    listing.snap = (jvxfs_histogram_snapshot_t*)malloc(sizeof(jvxfs_histogram_snapshot_t));
+    if (!listing.snap) return;
+    jvxfs_registry_t* registry = jvxfs_app_get_registry(rqst->app);
+    jvxfs_view_begin_record(view);
+    jvxfs_view_add_uint(view, "count", jvxfs_registry_count(registry));
+    jvxfs_view_begin_array(view, "sessions");
+    /* Visited on this thread only, the record is written by it. */
+    jvxfs_registry_for_each(registry, jvxfs_registry_count_chunks(registry), NULL, list_session, &listing);
+    jvxfs_view_end_array(view);
+    jvxfs_view_end_record(view);
+    free(listing.snap);
+}
+
+void jvxfs_directive_app_errors(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data)
+{
+    jvxfs_error_t* err = jvxfs_module_get_error_handler(jvxfs_app_get_module(rqst->app));
+    uint32_t max = JVXFS_DIRECTIVE_ERRORS_DEFAULT;
+    if (rqst->argc > 0) {
+        char number[12];
+        size_t length = (rqst->argv[0].length < sizeof(number)) ? rqst->argv[0].length : sizeof(number) - 1;
+        memcpy(number, rqst->argv[0].str, length);
+        number[length] = '\0';
+        max = (uint32_t)strtoul(number, NULL, 10);
+        if (max > JVXFS_DIRECTIVE_ERRORS_MAX) max = JVXFS_DIRECTIVE_ERRORS_MAX;
+    }
+    jvxfs_error_info_t* recent = (max) ? (jvxfs_error_info_t*)malloc(sizeof(jvxfs_error_info_t) * max) : NULL;
+    uint32_t count = (recent) ? jvxfs_error_read_recent(err, recent, max) : 0;
+    jvxfs_view_begin_record(view);
+    jvxfs_view_add_uint(view, "total", jvxfs_error_count(err));
+    jvxfs_view_begin_object(view, "components");
+    for (uint32_t i = 0; i < JVXFS_COMP_COUNT; ++i) {
+        uint64_t n = jvxfs_error_count_component(err, (jvxfs_component_t)i);
+        if (n) jvxfs_view_add_uint(view, jvxfs_error_component_to_name((jvxfs_component_t)i), n);
+    }
+    jvxfs_view_end_object(view);
+    jvxfs_view_begin_array(view, "states");
+    for (uint32_t i = 0; i < JVXFS_ERROR_STATES; ++i) {
+        uint64_t n = jvxfs_error_count_status(err, (jvxfs_status_t)i);
+        if (!n) continue;
+        jvxfs_view_begin_object(view, NULL);
+        jvxfs_view_add_string(view, "status", jvxfs_error_status_to_message((jvxfs_status_t)i));
+        jvxfs_view_add_uint(view, "count", n);
+        jvxfs_view_end_object(view);
+    }
+    jvxfs_view_end_array(view);
+    jvxfs_view_begin_array(view, "recent");
+    for (uint32_t i = 0; i < count; ++i) {
+        jvxfs_view_begin_object(view, NULL);
+        jvxfs_view_add_uint(view, "time_us", (uint64_t)recent[i].time);
+        jvxfs_view_add_uint(view, "level", (uint64_t)recent[i].level);
+        jvxfs_view_add_string(view, "component", jvxfs_error_component_to_name(recent[i].component));
+        jvxfs_view_add_string(view, "status", jvxfs_error_status_to_message(recent[i].status));
+        jvxfs_view_add_string(view, "message", recent[i].message);
+        jvxfs_view_add_string(view, "function", recent[i].function);
+        jvxfs_view_add_uint(view, "line", recent[i].line);
+        jvxfs_view_end_object(view);
+    }
+    jvxfs_view_end_array(view);
+    jvxfs_view_end_record(view);
+    free(recent);
+}
+
+void jvxfs_directive_app_events(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data)
+{
+    jvxfs_emitter_t* emitter = jvxfs_module_get_emitter(jvxfs_app_get_module(rqst->app));
+    if (!emitter) {
+        jvxfs_view_write_human_readable(view, "No event emitter running.\n");
+        return;
+    }
+    if (rqst->argc > 0) {
+        if (arg_equals(&rqst->argv[0], "on")) {
+            jvxfs_emitter_set_enabled(emitter, true);
+        } else if (arg_equals(&rqst->argv[0], "off")) {
+            jvxfs_emitter_set_enabled(emitter, false);
+        } else {
+            jvxfs_view_write_human_readable(view, "Unknown parameter, use \"on\" or \"off\".\n");
+            return;
+        }
+    }
+    jvxfs_emitter_stats_t stats;
+    jvxfs_emitter_read_stats(emitter, &stats);
+    jvxfs_view_begin_record(view);
+    jvxfs_view_add_string(view, "state", jvxfs_emitter_is_enabled(emitter) ? "on" : "off");
+    jvxfs_view_add_uint(view, "queued", stats.queued);
+    jvxfs_view_add_uint(view, "fired", stats.fired);
+    jvxfs_view_add_uint(view, "coalesced", stats.coalesced);
+    jvxfs_view_add_uint(view, "limited", stats.limited);
+    jvxfs_view_add_uint(view, "dropped", stats.dropped);
+    jvxfs_view_add_uint(view, "skipped", stats.skipped);
+    jvxfs_view_add_uint(view, "truncated", stats.truncated);
+    jvxfs_view_end_record(view);
+}
+
+void jvxfs_directive_app_config(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data)
+{
+    jvxfs_config_t* config = jvxfs_module_get_config(jvxfs_app_get_module(rqst->app));
+    if (rqst->argc > 0) {
+        if (!arg_equals(&rqst->argv[0], "reload")) {
+            jvxfs_view_write_human_readable(view, "Unknown parameter, use \"reload\".\n");
+            return;
+        }
+        if (jvxfs_config_reload(config) != JVXFS_STATUS_SUCCESS) {
+            jvxfs_view_write_human_readable(view, "Could not reload configuration, keeping the current one.\n");
+        }
+    }
+    const jvxfs_config_block_t* block = jvxfs_config_acquire(config);
+    if (!block) {
+        jvxfs_view_write_human_readable(view, "No configuration loaded.\n");
+        return;
+    }
+    const char* file = jvxfs_config_get_file(config);
+    jvxfs_view_begin_record(view);
+    jvxfs_view_add_string(view, "file", file ? file : "none");
+    jvxfs_view_add_uint(view, "version", jvxfs_config_get_version(block));
+    jvxfs_view_begin_object(view, "parameters");
+    for (uint32_t i = 0; i < jvxfs_config_count(config); ++i) {
+        const char* name = jvxfs_config_get_name(config, i);
+        switch (jvxfs_config_get_type(config, i)) {
+        case JVXFS_CONFIG_INT:
+            jvxfs_view_add_int(view, name, jvxfs_config_get_int(block, i));
+            break;
+        case JVXFS_CONFIG_FLOAT:
+            jvxfs_view_add_float(view, name, jvxfs_config_get_float(block, i), 6);
+            break;
+        case JVXFS_CONFIG_BOOL:
+            jvxfs_view_add_string(view, name, jvxfs_config_get_bool(block, i) ? "true" : "false");
+            break;
+        case JVXFS_CONFIG_STRING:
+            jvxfs_view_add_string(view, name, jvxfs_config_get_string(block, i));
+            break;
+        }
+    }
+    jvxfs_view_end_object(view);
+    jvxfs_view_end_record(view);
+    jvxfs_config_release(config, block);
+}
+
+
+void write_stats(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, jvxfs_histogram_t* stats)
+{
+    if (!stats) {
+        jvxfs_view_write_to_all(view, "No statistics available.");
+        return;
+    }
+    bool reset = false;
+    if (rqst->argc > 0) {
+        if (!arg_equals(&rqst->argv[0], "reset")) {
+            jvxfs_view_write_human_readable(view, "Unknown parameter, use \"reset\".\n");
+            return;
+        }
+        reset = true;
+    }
+    /* Large, but only used on the API thread, not while processing. */
+    jvxfs_histogram_snapshot_t* snap = (jvxfs_histogram_snapshot_t*)malloc(sizeof(jvxfs_histogram_snapshot_t));
+    if (!snap) return;
+    jvxfs_histogram_read(stats, snap);
+    jvxfs_view_begin_record(view);
+    jvxfs_view_add_uint(view, "frames", snap->counters[JVXFS_SP_STAT_FRAMES]);
+    jvxfs_view_add_uint(view, "deadline_misses", snap->counters[JVXFS_SP_STAT_DEADLINE_MISSES]);
+    jvxfs_view_add_uint(view, "passthroughs", snap->counters[JVXFS_SP_STAT_PASSTHROUGHS]);
+    jvxfs_view_add_uint(view, "reference_slips", snap->counters[JVXFS_SP_STAT_REFERENCE_SLIPS]);
+    jvxfs_view_add_uint(view, "p50_us", jvxfs_histogram_percentile(snap, 50.0));
+    jvxfs_view_add_uint(view, "p90_us", jvxfs_histogram_percentile(snap, 90.0));
+    jvxfs_view_add_uint(view, "p99_us", jvxfs_histogram_percentile(snap, 99.0));
+    jvxfs_view_add_uint(view, "p999_us", jvxfs_histogram_percentile(snap, 99.9));
+    jvxfs_view_add_uint(view, "max_us", snap->max);
+    jvxfs_view_add_float(view, "mean_us", snap->total ? (double)snap->sum / (double)snap->total : 0.0, 1);
+    jvxfs_view_end_record(view);
+    free(snap);
+    if (reset) jvxfs_histogram_reset(stats);
+}
+
+void list_session(switch_core_session_t* session, jvxfs_app_instance_t* inst, uint32_t chunk, void* data)
+{
+    static const char* const modes[] = { "off", "on", "mute" };
+    listing_t* listing = (listing_t*)data;
+    jvxfs_view_t* view = listing->view;
+    jvxfs_view_begin_object(view, NULL);
+    jvxfs_view_add_string(view, "uuid", switch_core_session_get_uuid(session));
+    jvxfs_view_add_string(view, "number", jvxfs_session_get_extension_number(session));
+    jvxfs_view_add_string(view, "mode", modes[jvxfs_sigproc_get_mode(inst)]);
+    jvxfs_histogram_t* stats = jvxfs_sigproc_get_stats(inst);
+    if (stats) {
+        jvxfs_histogram_read(stats, listing->snap);
+        jvxfs_view_add_uint(view, "frames", listing->snap->counters[JVXFS_SP_STAT_FRAMES]);
+        jvxfs_view_add_uint(view, "deadline_misses", listing->snap->counters[JVXFS_SP_STAT_DEADLINE_MISSES]);
+        jvxfs_view_add_uint(view, "p99_us", jvxfs_histogram_percentile(listing->snap, 99.0));
+    }
+    jvxfs_view_end_object(view);
+}
+
+bool arg_equals(const jvxfs_directive_arg_t* arg, const char* str)
+{
+    return arg->length == strlen(str) && strncmp(arg->str, str, arg->length) == 0;
 }
\ No newline at end of file
@@ -18,8 +18,44 @@
 
 JVX_FS_LIB_BEGIN
 
+#define JVXFS_DIRECTIVE_ERRORS_DEFAULT 20
+#define JVXFS_DIRECTIVE_ERRORS_MAX 256
+
 void jvxfs_directive_app_version(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data);
 
+/**
+ * @brief Report the processing statistics of a signal processing app, parameter @em reset clears them afterwards.
+ * @details Human readable as text, machine readable as a JSON object.
+ */
+void jvxfs_directive_app_stats(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data);
+
+/**
+ * @brief Report the processing statistics of the processor of a session, see jvxfs_directive_app_stats().
+ */
+void jvxfs_directive_session_stats(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, jvxfs_app_instance_t* inst, void* data);
+
+/**
+ * @brief List the live processors of a signal processing app with mode and processing statistics.
+ */
+void jvxfs_directive_app_sessions(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data);
+
+/**
+ * @brief Report the error counters per component and status and the most recent errors, newest first.
+ * @details The parameter sets the number of recent errors, default #JVXFS_DIRECTIVE_ERRORS_DEFAULT.
+ */
+void jvxfs_directive_app_errors(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data);
+
+/**
+ * @brief Report the counters of the event emitter of the module, parameter @em on or @em off switches emission.
+ * @details Emission should be switched off while nobody subscribes to the events of the framework.
+ */
+void jvxfs_directive_app_events(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data);
+
+/**
+ * @brief Report file, version and values of the configuration of the module, parameter @em reload loads the file again.
+ */
+void jvxfs_directive_app_config(jvxfs_view_t* view, jvxfs_directive_data_t* rqst, void* data);
+
 JVX_FS_LIB_END
 
 #endif
\ No newline at end of file
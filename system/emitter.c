@@ -0,0 +1,356 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "../utils/atomic.h"
+#include "error.h"
+#include "session.h"
+#include "emitter.h"
+
+#define FIELD_SIZE 64
+#define SESSION_SIZE (SWITCH_UUID_FORMATTED_LENGTH + 1)
+#define TABLE_SIZE (2 * JVXFS_EMITTER_QUEUE_DEPTH)
+#define NO_ENTRY UINT32_MAX
+
+typedef struct
+{
+    size_t seq;
+    const char* app;
+    uint32_t slot;
+    char session[SESSION_SIZE];
+    char extension[FIELD_SIZE];
+    char number[FIELD_SIZE];
+    char directive[FIELD_SIZE];
+    char text[JVXFS_EMITTER_INLINE_SIZE];
+} cell_t;
+
+/* Messages of one interval, coalesced by app, session and directive. */
+typedef struct
+{
+    const char* app;
+    char* content;
+    uint32_t hash;
+    uint32_t count;
+    char session[SESSION_SIZE];
+    char extension[FIELD_SIZE];
+    char number[FIELD_SIZE];
+    char directive[FIELD_SIZE];
+} pending_t;
+
+typedef struct
+{
+    cell_t* cells;
+    size_t enqueuePos JVXFS_CACHE_ALIGNED;
+    uint64_t queued;
+    uint64_t dropped;
+    uint64_t skipped;
+    uint64_t truncated;
+    uint32_t nextSlot;
+    size_t dequeuePos JVXFS_CACHE_ALIGNED;
+    uint64_t coalesced;
+    uint64_t limited;
+    uint64_t fired;
+    bool enabled;
+    bool running;
+    uint32_t windowMs;
+    uint32_t rate;
+    double tokens;
+    switch_time_t refilled;
+    pending_t* pending;
+    uint32_t* table;
+    char* slab;
+    uint32_t* slabBusy;
+    switch_thread_t* thread;
+    switch_mutex_t* mutex;
+    switch_thread_cond_t* cond;
+} emitter_t;
+
+static void* SWITCH_THREAD_FUNC emitter_thread(switch_thread_t* thread, void* obj);
+static void drain(emitter_t* hdl);
+static void collect(emitter_t* hdl, cell_t* cell, uint32_t* count);
+static bool take_token(emitter_t* hdl);
+static void fire(pending_t* item);
+static uint32_t acquire_slot(emitter_t* hdl);
+static void copy_field(char* dest, size_t size, const char* src);
+static char* copy_string(const char* src, size_t length);
+static uint32_t hash_key(const char* app, const char* session, const char* directive);
+
+
+jvxfs_status_t jvxfs_emitter_create(jvxfs_emitter_t** obj, uint32_t windowMs, uint32_t rate, jvxfs_error_t* err,
+    switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create event emitter.";
+    emitter_t* hdl = (emitter_t*)switch_core_alloc(pool, sizeof(emitter_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_EMITTER, error);
+    }
+    memset(hdl, 0, sizeof(emitter_t));
+    hdl->cells = (cell_t*)switch_core_alloc(pool, sizeof(cell_t) * JVXFS_EMITTER_QUEUE_DEPTH);
+    hdl->pending = (pending_t*)switch_core_alloc(pool, sizeof(pending_t) * JVXFS_EMITTER_QUEUE_DEPTH);
+    hdl->table = (uint32_t*)switch_core_alloc(pool, sizeof(uint32_t) * TABLE_SIZE);
+    hdl->slab = (char*)switch_core_alloc(pool, (size_t)JVXFS_EMITTER_SLAB_SLOTS * JVXFS_EMITTER_SLAB_SIZE);
+    hdl->slabBusy = (uint32_t*)switch_core_alloc(pool, sizeof(uint32_t) * JVXFS_EMITTER_SLAB_SLOTS);
+    if (!hdl->cells || !hdl->pending || !hdl->table || !hdl->slab || !hdl->slabBusy ||
+        switch_mutex_init(&hdl->mutex, SWITCH_MUTEX_NESTED, pool) != SWITCH_STATUS_SUCCESS ||
+        switch_thread_cond_create(&hdl->cond, pool) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_EMITTER, error);
+    }
+    for (size_t i = 0; i < JVXFS_EMITTER_QUEUE_DEPTH; ++i) hdl->cells[i].seq = i;
+    memset(hdl->slabBusy, 0, sizeof(uint32_t) * JVXFS_EMITTER_SLAB_SLOTS);
+    hdl->windowMs = windowMs ? windowMs : 1;
+    hdl->rate = rate;
+    hdl->tokens = (double)rate;
+    hdl->refilled = switch_time_now();
+    hdl->enabled = true;
+    hdl->running = true;
+    switch_threadattr_t* attr = NULL;
+    switch_threadattr_create(&attr, pool);
+    switch_threadattr_stacksize_set(attr, SWITCH_THREAD_STACKSIZE);
+    if (switch_thread_create(&hdl->thread, attr, emitter_thread, hdl, pool) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_EMITTER,
+            "Could not start event emitter thread.");
+    }
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_emitter_destroy(jvxfs_emitter_t** obj)
+{
+    emitter_t* hdl = (emitter_t*)*obj;
+    if (!hdl) return;
+    switch_mutex_lock(hdl->mutex);
+    jvxfs_atomic_store(&hdl->running, false);
+    switch_thread_cond_signal(hdl->cond);
+    switch_mutex_unlock(hdl->mutex);
+    switch_status_t st;
+    switch_thread_join(&st, hdl->thread);
+    *obj = NULL;
+}
+
+bool jvxfs_emitter_push(jvxfs_emitter_t* obj, const char* app, switch_core_session_t* session, const char* directive,
+    const char* content)
+{
+    emitter_t* hdl = (emitter_t*)obj;
+    if (!jvxfs_atomic_load_relaxed(&hdl->enabled)) {
+        jvxfs_atomic_fetch_add_relaxed(&hdl->skipped, 1);
+        return false;
+    }
+    size_t pos = jvxfs_atomic_load_relaxed(&hdl->enqueuePos);
+    cell_t* cell;
+    for (;;) {
+        cell = &hdl->cells[pos % JVXFS_EMITTER_QUEUE_DEPTH];
+        size_t seq = jvxfs_atomic_load(&cell->seq);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (jvxfs_atomic_cas_weak_relaxed(&hdl->enqueuePos, &pos, pos + 1)) break;
+        } else if (diff < 0) {
+            jvxfs_atomic_fetch_add_relaxed(&hdl->dropped, 1);
+            return false;
+        } else {
+            pos = jvxfs_atomic_load_relaxed(&hdl->enqueuePos);
+        }
+    }
+    cell->app = app;
+    size_t length = strlen(content);
+    cell->slot = NO_ENTRY;
+    if (length < JVXFS_EMITTER_INLINE_SIZE) {
+        memcpy(cell->text, content, length + 1);
+    } else {
+        /* Longer content goes to a slot allocated with the emitter, the caller may be a media thread. */
+        cell->slot = acquire_slot(hdl);
+        if (cell->slot != NO_ENTRY) {
+            copy_field(hdl->slab + (size_t)cell->slot * JVXFS_EMITTER_SLAB_SIZE, JVXFS_EMITTER_SLAB_SIZE, content);
+        } else {
+            copy_field(cell->text, JVXFS_EMITTER_INLINE_SIZE, content);
+        }
+        if (cell->slot == NO_ENTRY || length >= JVXFS_EMITTER_SLAB_SIZE) jvxfs_atomic_fetch_add_relaxed(&hdl->truncated, 1);
+    }
+    if (session) {
+        copy_field(cell->session, SESSION_SIZE, switch_core_session_get_uuid(session));
+        copy_field(cell->extension, FIELD_SIZE, jvxfs_session_get_extension_name(session));
+        copy_field(cell->number, FIELD_SIZE, jvxfs_session_get_extension_number(session));
+    } else {
+        cell->session[0] = '\0';
+    }
+    copy_field(cell->directive, FIELD_SIZE, directive);
+    jvxfs_atomic_store(&cell->seq, pos + 1);
+    jvxfs_atomic_fetch_add_relaxed(&hdl->queued, 1);
+    return true;
+}
+
+void jvxfs_emitter_set_enabled(jvxfs_emitter_t* obj, bool enabled)
+{
+    emitter_t* hdl = (emitter_t*)obj;
+    jvxfs_atomic_store(&hdl->enabled, enabled);
+}
+
+bool jvxfs_emitter_is_enabled(jvxfs_emitter_t* obj)
+{
+    emitter_t* hdl = (emitter_t*)obj;
+    return jvxfs_atomic_load(&hdl->enabled);
+}
+
+void jvxfs_emitter_read_stats(jvxfs_emitter_t* obj, jvxfs_emitter_stats_t* out)
+{
+    emitter_t* hdl = (emitter_t*)obj;
+    out->queued = jvxfs_atomic_load_relaxed(&hdl->queued);
+    out->dropped = jvxfs_atomic_load_relaxed(&hdl->dropped);
+    out->coalesced = jvxfs_atomic_load_relaxed(&hdl->coalesced);
+    out->limited = jvxfs_atomic_load_relaxed(&hdl->limited);
+    out->fired = jvxfs_atomic_load_relaxed(&hdl->fired);
+    out->skipped = jvxfs_atomic_load_relaxed(&hdl->skipped);
+    out->truncated = jvxfs_atomic_load_relaxed(&hdl->truncated);
+}
+
+
+void* SWITCH_THREAD_FUNC emitter_thread(switch_thread_t* thread, void* obj)
+{
+    emitter_t* hdl = (emitter_t*)obj;
+    switch_mutex_lock(hdl->mutex);
+    while (jvxfs_atomic_load(&hdl->running)) {
+        switch_thread_cond_timedwait(hdl->cond, hdl->mutex, (switch_interval_time_t)hdl->windowMs * 1000);
+        switch_mutex_unlock(hdl->mutex);
+        drain(hdl);
+        switch_mutex_lock(hdl->mutex);
+    }
+    switch_mutex_unlock(hdl->mutex);
+    /* Messages queued while stopping. */
+    drain(hdl);
+    return NULL;
+}
+
+void drain(emitter_t* hdl)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < TABLE_SIZE; ++i) hdl->table[i] = NO_ENTRY;
+    /* Bounded, so producers outrunning the thread cannot keep it from firing. */
+    while (count < JVXFS_EMITTER_QUEUE_DEPTH) {
+        size_t pos = hdl->dequeuePos;
+        cell_t* cell = &hdl->cells[pos % JVXFS_EMITTER_QUEUE_DEPTH];
+        if (jvxfs_atomic_load(&cell->seq) != pos + 1) break;
+        collect(hdl, cell, &count);
+        jvxfs_atomic_store(&cell->seq, pos + JVXFS_EMITTER_QUEUE_DEPTH);
+        hdl->dequeuePos = pos + 1;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        pending_t* item = &hdl->pending[i];
+        if (take_token(hdl)) {
+            fire(item);
+            jvxfs_atomic_fetch_add_relaxed(&hdl->fired, 1);
+        } else {
+            jvxfs_atomic_fetch_add_relaxed(&hdl->limited, 1);
+        }
+        free(item->content);
+        item->content = NULL;
+    }
+}
+
+void collect(emitter_t* hdl, cell_t* cell, uint32_t* count)
+{
+    char* content;
+    if (cell->slot != NO_ENTRY) {
+        const char* text = hdl->slab + (size_t)cell->slot * JVXFS_EMITTER_SLAB_SIZE;
+        content = copy_string(text, strlen(text));
+        jvxfs_atomic_store(&hdl->slabBusy[cell->slot], 0);
+    } else {
+        content = copy_string(cell->text, strlen(cell->text));
+    }
+    if (!content) return;
+    uint32_t hash = hash_key(cell->app, cell->session, cell->directive);
+    uint32_t i = hash % TABLE_SIZE;
+    for (; hdl->table[i] != NO_ENTRY; i = (i + 1) % TABLE_SIZE) {
+        pending_t* item = &hdl->pending[hdl->table[i]];
+        if (item->hash == hash && item->app == cell->app && strcmp(item->session, cell->session) == 0 &&
+            strcmp(item->directive, cell->directive) == 0) {
+            /* Only the latest state of a session is of interest, older content is replaced. */
+            free(item->content);
+            item->content = content;
+            item->count++;
+            jvxfs_atomic_fetch_add_relaxed(&hdl->coalesced, 1);
+            return;
+        }
+    }
+    pending_t* item = &hdl->pending[*count];
+    hdl->table[i] = (*count)++;
+    item->app = cell->app;
+    item->content = content;
+    item->hash = hash;
+    item->count = 1;
+    memcpy(item->session, cell->session, SESSION_SIZE);
+    memcpy(item->extension, cell->extension, FIELD_SIZE);
+    memcpy(item->number, cell->number, FIELD_SIZE);
+    memcpy(item->directive, cell->directive, FIELD_SIZE);
+}
+
+bool take_token(emitter_t* hdl)
+{
+    if (hdl->rate == 0) return true;
+    switch_time_t now = switch_time_now();
+    hdl->tokens += (double)(now - hdl->refilled) * (double)hdl->rate / 1000000.0;
+    hdl->refilled = now;
+    /* Bursts of up to one second worth of events. */
+    if (hdl->tokens > (double)hdl->rate) hdl->tokens = (double)hdl->rate;
+    if (hdl->tokens < 1.0) return false;
+    hdl->tokens -= 1.0;
+    return true;
+}
+
+void fire(pending_t* item)
+{
+    switch_event_t* event;
+    if (switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "jvxfsFramework") != SWITCH_STATUS_SUCCESS) return;
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Protocol", "1.0");
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Level", "0");
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "App", item->app);
+    if (item->session[0]) {
+        switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Session", item->session);
+        switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Extension", item->extension);
+        switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Phonenumber", item->number);
+    }
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Directive", item->directive);
+    if (item->count > 1) {
+        char count[16];
+        snprintf(count, sizeof(count), "%u", item->count);
+        switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Coalesced", count);
+    }
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Content", item->content);
+    switch_event_fire(&event);
+}
+
+uint32_t acquire_slot(emitter_t* hdl)
+{
+    uint32_t start = jvxfs_atomic_fetch_add_relaxed(&hdl->nextSlot, 1);
+    for (uint32_t i = 0; i < JVXFS_EMITTER_SLAB_SLOTS; ++i) {
+        uint32_t slot = (start + i) % JVXFS_EMITTER_SLAB_SLOTS;
+        uint32_t idle = 0;
+        if (!jvxfs_atomic_load_relaxed(&hdl->slabBusy[slot]) && jvxfs_atomic_cas(&hdl->slabBusy[slot], &idle, 1)) return slot;
+    }
+    return NO_ENTRY;
+}
+
+void copy_field(char* dest, size_t size, const char* src)
+{
+    size_t length = src ? strlen(src) : 0;
+    if (length >= size) length = size - 1;
+    if (length) memcpy(dest, src, length);
+    dest[length] = '\0';
+}
+
+char* copy_string(const char* src, size_t length)
+{
+    char* dest = (char*)malloc(length + 1);
+    if (!dest) return NULL;
+    memcpy(dest, src, length + 1);
+    return dest;
+}
+
+uint32_t hash_key(const char* app, const char* session, const char* directive)
+{
+    uint32_t hash = 2166136261u ^ (uint32_t)(uintptr_t)app;
+    for (const char* c = session; *c; ++c) hash = (hash ^ (uint8_t)*c) * 16777619u;
+    for (const char* c = directive; *c; ++c) hash = (hash ^ (uint8_t)*c) * 16777619u;
+    return hash;
+}
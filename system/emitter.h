@@ -0,0 +1,102 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file emitter.h
+ * @brief Asynchronous emission of the machine readable output of views as events.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-24
+ * @copyright Copyright (c) 2019
+ * @note The user should not call these functions himself, the emitter is owned by the module
+ * and fed by jvxfs_view_write_machine_readable().
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_SYSTEM_EMITTER_H
+#define LIB_JVX_FS_FRAMEWORK_SYSTEM_EMITTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <switch.h>
+#include "defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @brief Capacity of the queue, messages pushed while it is full are dropped.
+ */
+#define JVXFS_EMITTER_QUEUE_DEPTH 2048
+
+/**
+ * @brief Content up to this length is stored in the queue itself.
+ */
+#define JVXFS_EMITTER_INLINE_SIZE 256
+
+/**
+ * @brief Longer content is stored in one of a fixed number of slots allocated with the emitter.
+ * @details Content longer than a slot, or pushed while all slots are in use, is truncated to the slot or the
+ * inline size and counted, pushing never allocates.
+ */
+#define JVXFS_EMITTER_SLAB_SIZE 4096
+#define JVXFS_EMITTER_SLAB_SLOTS 64
+
+#define JVXFS_EMITTER_DEFAULT_WINDOW_MS 50
+#define JVXFS_EMITTER_DEFAULT_RATE 1000
+
+typedef void jvxfs_emitter_t;
+
+typedef struct
+{
+    uint64_t queued;
+    uint64_t dropped;
+    uint64_t coalesced;
+    uint64_t limited;
+    uint64_t fired;
+    uint64_t skipped;
+    uint64_t truncated;
+} jvxfs_emitter_stats_t;
+
+/**
+ * @brief Create an emitter and start its thread.
+ * @param[out] obj      Handle of emitter.
+ * @param[in] windowMs  Interval of the thread in milliseconds. Messages of the same app, session and directive
+ *                      queued within one interval are coalesced, only the latest one is fired.
+ * @param[in] rate      Maximum number of events fired per second, 0 for no limit.
+ * @param[in] err       Error handler.
+ * @param[in] pool      Memory pool.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_emitter_create(jvxfs_emitter_t** obj, uint32_t windowMs, uint32_t rate, jvxfs_error_t* err,
+    switch_memory_pool_t* pool);
+
+/**
+ * @brief Stop the thread of an emitter, queued messages are fired before.
+ * @param[in,out] obj   Handle of emitter. Will be set to @em NULL.
+ */
+void jvxfs_emitter_destroy(jvxfs_emitter_t** obj);
+
+/**
+ * @brief Queue a message, never blocks.
+ * @param[in] obj       Handle of emitter.
+ * @param[in] app       Name of the app, has to stay valid as long as the emitter.
+ * @param[in] session   Session, may be @em NULL.
+ * @param[in] directive Name of the directive, may be @em NULL.
+ * @param[in] content   Content of the event.
+ * @return @em false, if the message was dropped or emission is disabled.
+ */
+bool jvxfs_emitter_push(jvxfs_emitter_t* obj, const char* app, switch_core_session_t* session, const char* directive,
+    const char* content);
+
+/**
+ * @brief Enable or disable emission, e.g. while nobody subscribes to the events.
+ * @details Disabled emitters return right away from jvxfs_emitter_push(), without copying the message.
+ */
+void jvxfs_emitter_set_enabled(jvxfs_emitter_t* obj, bool enabled);
+bool jvxfs_emitter_is_enabled(jvxfs_emitter_t* obj);
+
+void jvxfs_emitter_read_stats(jvxfs_emitter_t* obj, jvxfs_emitter_stats_t* out);
+
+JVX_FS_LIB_END
+
+#endif
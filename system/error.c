@@ -2,13 +2,47 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
  
+#include <stdlib.h>
+#include <string.h>
+#include "../utils/atomic.h"
 #include "error.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Claimed by one writer at a time, but read by others while it is written. Odd sequences mark a write in progress. */
+typedef struct
+{
+    uint64_t seq;
+    uint64_t ticks;
+    switch_time_t time;
+    const char* message;
+    const char* function;
+    const char* file;
+    uint32_t line;
+    jvxfs_status_t status;
+    jvxfs_log_level_t level;
+    jvxfs_component_t component;
+    uint64_t occurrences;
+} entry_t;
+
+typedef struct
+{
+    uint64_t head;
+    uint64_t components[JVXFS_COMP_COUNT];
+    uint64_t states[JVXFS_ERROR_STATES];
+    uint64_t keys[JVXFS_COMP_COUNT][JVXFS_ERROR_STATES];
+    entry_t ring[JVXFS_ERROR_RING_SIZE];
+} JVXFS_CACHE_ALIGNED shard_t;
 
 typedef struct
 {
     jvxfs_error_callback_t func;
     void* func_data;
-    unsigned int number; //change to atomic
+    shard_t* shards;
+    uint32_t count;
+    uint64_t ticks;
+    switch_time_t time;
 } error_t;
 
 static const char* arrStates[] = {
@@ -33,38 +67,172 @@ static const char* arrStates[] = {
     "Installation of FS media bug failed"
 };
 
+static const char* arrComponents[] = {
+    "none",
+    "system",
+    "view",
+    "module",
+    "app",
+    "session",
+    "sp_config",
+    "sp_processor",
+    "observer",
+    "sp_channel",
+    "sp_fft",
+    "sp_convert",
+    "sp_resampler",
+    "worker",
+    "sp_batch",
+    "arena",
+    "sp_instance_pool",
+    "histogram",
+    "registry",
+    "emitter",
+    "config",
+    "sp_reblock",
+    "sp_stft"
+};
+
+/* Fails to compile when a component is added without a name. */
+typedef char check_components_t[(sizeof(arrComponents) / sizeof(arrComponents[0]) == JVXFS_COMP_COUNT) ? 1 : -1];
+
+static shard_t* get_shard(error_t* hdl);
+static uint64_t read_ticks(void);
+static bool pass_to_callback(jvxfs_log_level_t level, uint64_t occurrences);
+static int compare_newest(const void* a, const void* b);
+
 
 jvxfs_status_t jvxfs_error_create_error_handler(jvxfs_error_t** obj, switch_memory_pool_t* pool)
 {
     if (!obj || !pool) return JVXFS_STATUS_INVALID_ARGUMENT;
     error_t* hdl = (error_t*)switch_core_alloc(pool, sizeof(error_t));
     if (!hdl) return JVXFS_STATUS_ALLOCATION_FAILED;
+    int32_t cpus = switch_core_cpu_count();
+    hdl->count = (cpus > 0) ? (uint32_t)cpus : 1;
+    uint8_t* mem = (uint8_t*)switch_core_alloc(pool, sizeof(shard_t) * hdl->count + JVXFS_CACHE_LINE_SIZE);
+    if (!mem) return JVXFS_STATUS_ALLOCATION_FAILED;
+    hdl->shards = (shard_t*)(((uintptr_t)mem + JVXFS_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(JVXFS_CACHE_LINE_SIZE - 1));
+    memset(hdl->shards, 0, sizeof(shard_t) * hdl->count);
     hdl->func = jvxfs_error_default_callback_function;
     hdl->func_data = NULL;
-    hdl->number = 0;
+    hdl->ticks = read_ticks();
+    hdl->time = switch_time_now();
     *obj = hdl;
     return JVXFS_STATUS_SUCCESS;
 }
 
 bool jvxfs_error_has_happend(jvxfs_error_t* obj)
 {
-    error_t* hdl = (error_t*)obj;
-    return hdl->number > 0;
+    return jvxfs_error_count(obj) > 0;
 }
 
 jvxfs_status_t jvxfs_error_set_error_detailed(jvxfs_error_t* obj, jvxfs_status_t status, jvxfs_log_level_t level, jvxfs_component_t component,
     const char* function, const char* file, uint32_t line, switch_time_t time, const char* message)
 {
     error_t* hdl = (error_t*)obj;
-    return hdl->number = 1;
-    if (hdl->func) {
+    if ((uint32_t)component >= JVXFS_COMP_COUNT) component = JVXFS_COMP_NONE;
+    shard_t* shard = get_shard(hdl);
+    jvxfs_atomic_fetch_add_relaxed(&shard->components[component], 1);
+    /* Unknown states share the key of success, which is never reported as an error. */
+    uint32_t key = ((uint32_t)status < JVXFS_ERROR_STATES) ? (uint32_t)status : JVXFS_STATUS_SUCCESS;
+    if ((uint32_t)status < JVXFS_ERROR_STATES) jvxfs_atomic_fetch_add_relaxed(&shard->states[status], 1);
+    uint64_t occurrences = jvxfs_atomic_fetch_add_relaxed(&shard->keys[component][key], 1) + 1;
+    uint64_t index = jvxfs_atomic_fetch_add_relaxed(&shard->head, 1);
+    entry_t* entry = &shard->ring[index % JVXFS_ERROR_RING_SIZE];
+    /* Threads of one shard a ring apart meet in the same slot. Only one of them claims it, an error losing
+     * the slot to a newer or unfinished write is only counted. */
+    uint64_t seq = jvxfs_atomic_load_relaxed(&entry->seq);
+    if (!(seq & 1) && seq < 2 * index + 1 && jvxfs_atomic_cas(&entry->seq, &seq, 2 * index + 1)) {
+        jvxfs_atomic_fence_release();
+        entry->ticks = read_ticks();
+        entry->time = time;
+        entry->message = message;
+        entry->function = function;
+        entry->file = file;
+        entry->line = line;
+        entry->status = status;
+        entry->level = level;
+        entry->component = component;
+        entry->occurrences = occurrences;
+        jvxfs_atomic_store(&entry->seq, 2 * index + 2);
+    }
+    /* Callbacks usually log, an error repeated by every frame must not flood the log. */
+    if (hdl->func && pass_to_callback(level, occurrences)) {
         jvxfs_error_info_t info = { .status = status, .level = level, .component = component, . message = message,
-            .function = function, .file = file, .line = line, .time = time };
+            .function = function, .file = file, .line = line, .time = time ? time : switch_time_now(),
+            .occurrences = occurrences };
         hdl->func(&info, hdl->func_data);
     }
     return status;
 }
 
+uint64_t jvxfs_error_count(jvxfs_error_t* obj)
+{
+    error_t* hdl = (error_t*)obj;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < hdl->count; ++i) count += jvxfs_atomic_load_relaxed(&hdl->shards[i].head);
+    return count;
+}
+
+uint64_t jvxfs_error_count_component(jvxfs_error_t* obj, jvxfs_component_t component)
+{
+    error_t* hdl = (error_t*)obj;
+    if ((uint32_t)component >= JVXFS_COMP_COUNT) return 0;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < hdl->count; ++i) count += jvxfs_atomic_load_relaxed(&hdl->shards[i].components[component]);
+    return count;
+}
+
+uint64_t jvxfs_error_count_status(jvxfs_error_t* obj, jvxfs_status_t status)
+{
+    error_t* hdl = (error_t*)obj;
+    if ((uint32_t)status >= JVXFS_ERROR_STATES) return 0;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < hdl->count; ++i) count += jvxfs_atomic_load_relaxed(&hdl->shards[i].states[status]);
+    return count;
+}
+
+uint32_t jvxfs_error_read_recent(jvxfs_error_t* obj, jvxfs_error_info_t* out, uint32_t max)
+{
+    error_t* hdl = (error_t*)obj;
+    entry_t* entries = (entry_t*)malloc(sizeof(entry_t) * JVXFS_ERROR_RING_SIZE * hdl->count);
+    if (!entries) return 0;
+    uint32_t found = 0;
+    for (uint32_t s = 0; s < hdl->count; ++s) {
+        for (uint32_t i = 0; i < JVXFS_ERROR_RING_SIZE; ++i) {
+            entry_t* entry = &hdl->shards[s].ring[i];
+            uint64_t seq = jvxfs_atomic_load(&entry->seq);
+            if (seq == 0 || (seq & 1)) continue;
+            entries[found] = *entry;
+            jvxfs_atomic_fence_acquire();
+            /* Skipped, if it was overwritten while copying. */
+            if (jvxfs_atomic_load_relaxed(&entry->seq) == seq) ++found;
+        }
+    }
+    qsort(entries, found, sizeof(entry_t), compare_newest);
+    if (found > max) found = max;
+    /* Cycles are converted into time only now, measured against the rate since the handler was created. */
+    uint64_t ticks = read_ticks();
+    switch_time_t now = switch_time_now();
+    double perUs = (now > hdl->time && ticks > hdl->ticks) ?
+        (double)(ticks - hdl->ticks) / (double)(now - hdl->time) : 1.0;
+    for (uint32_t i = 0; i < found; ++i) {
+        entry_t* entry = &entries[i];
+        switch_time_t age = (ticks > entry->ticks) ? (switch_time_t)((double)(ticks - entry->ticks) / perUs) : 0;
+        out[i].status = entry->status;
+        out[i].level = entry->level;
+        out[i].component = entry->component;
+        out[i].message = entry->message;
+        out[i].function = entry->function;
+        out[i].file = entry->file;
+        out[i].line = entry->line;
+        out[i].time = entry->time ? entry->time : now - age;
+        out[i].occurrences = entry->occurrences;
+    }
+    free(entries);
+    return found;
+}
+
 jvxfs_status_t jvxfs_error_set_callback(jvxfs_error_t* obj, jvxfs_error_callback_t func, void* data)
 {
     error_t* hdl = (error_t*)obj;
@@ -83,7 +251,13 @@ void jvxfs_error_remove_callback(jvxfs_error_t* obj)
 void jvxfs_error_default_callback_function(const jvxfs_error_info_t* info, void* data)
 {
     if (info->level == JVXFS_LOG_CRITICAL) {
-        switch_log_printf(SWITCH_CHANNEL_ID_LOG, info->file, info->function, info->line, NULL, SWITCH_LOG_CRIT, info->message);
+        if (info->occurrences > JVXFS_ERROR_CALLBACK_BURST) {
+            switch_log_printf(SWITCH_CHANNEL_ID_LOG, info->file, info->function, info->line, NULL, SWITCH_LOG_CRIT,
+                "%s (%llu times)\n", info->message, (unsigned long long)info->occurrences);
+        } else {
+            switch_log_printf(SWITCH_CHANNEL_ID_LOG, info->file, info->function, info->line, NULL, SWITCH_LOG_CRIT,
+                "%s\n", info->message);
+        }
     }
 }
 
@@ -91,4 +265,41 @@ const char* jvxfs_error_status_to_message(jvxfs_status_t stat)
 {
     if (stat < 0 || stat > JVXFS_STATUS_MEDIABUG_ERROR) return "";
     return arrStates[stat];
+}
+
+const char* jvxfs_error_component_to_name(jvxfs_component_t comp)
+{
+    if ((uint32_t)comp >= JVXFS_COMP_COUNT) return "";
+    return arrComponents[comp];
+}
+
+
+shard_t* get_shard(error_t* hdl)
+{
+    if (hdl->count == 1) return hdl->shards;
+    uint64_t id = (uint64_t)(uintptr_t)switch_thread_self();
+    id ^= id >> 12;
+    id *= 0x9E3779B97F4A7C15ull;
+    return &hdl->shards[(id >> 32) % hdl->count];
+}
+
+uint64_t read_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)switch_time_now();
+#endif
+}
+
+bool pass_to_callback(jvxfs_log_level_t level, uint64_t occurrences)
+{
+    return level == JVXFS_LOG_CRITICAL || occurrences <= JVXFS_ERROR_CALLBACK_BURST || (occurrences & (occurrences - 1)) == 0;
+}
+
+int compare_newest(const void* a, const void* b)
+{
+    uint64_t ta = ((const entry_t*)a)->ticks;
+    uint64_t tb = ((const entry_t*)b)->ticks;
+    return (ta < tb) ? 1 : (ta > tb) ? -1 : 0;
 }
\ No newline at end of file
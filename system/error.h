@@ -21,7 +21,24 @@
 
 JVX_FS_LIB_BEGIN
 
-#define jvxfs_error_set_error(_obj, _stat, _level, _comp, _msg) jvxfs_error_set_error_detailed(_obj, _stat, _level, _comp, __func__, __FILE__, __LINE__, switch_time_now(), _msg)
+/**
+ * @brief Report an error, @a _msg has to stay valid as long as the error handler, e.g. a string literal.
+ * @details Time 0 lets the error handler stamp the error itself, see jvxfs_error_set_error_detailed().
+ */
+#define jvxfs_error_set_error(_obj, _stat, _level, _comp, _msg) jvxfs_error_set_error_detailed(_obj, _stat, _level, _comp, __func__, __FILE__, __LINE__, 0, _msg)
+
+/**
+ * @brief Number of recent errors kept per shard of an error handler.
+ */
+#define JVXFS_ERROR_RING_SIZE 64
+
+/**
+ * @brief Errors of a component with the same status are passed to the callback this many times, afterwards
+ * only every time their count reaches a power of two. Critical errors are always passed.
+ */
+#define JVXFS_ERROR_CALLBACK_BURST 8
+
+#define JVXFS_ERROR_STATES (JVXFS_STATUS_MEDIABUG_ERROR + 1)
 
 typedef enum
 {
@@ -33,7 +50,22 @@ typedef enum
     JVXFS_COMP_SESSION,
     JVXFS_COMP_SP_CONFIG,
     JVXFS_COMP_SP_PROCESSOR,
-    JVXFS_COMP_OBSERVER
+    JVXFS_COMP_OBSERVER,
+    JVXFS_COMP_SP_CHANNEL,
+    JVXFS_COMP_SP_FFT,
+    JVXFS_COMP_SP_CONVERT,
+    JVXFS_COMP_SP_RESAMPLER,
+    JVXFS_COMP_WORKER,
+    JVXFS_COMP_SP_BATCH,
+    JVXFS_COMP_ARENA,
+    JVXFS_COMP_SP_INSTANCE_POOL,
+    JVXFS_COMP_HISTOGRAM,
+    JVXFS_COMP_REGISTRY,
+    JVXFS_COMP_EMITTER,
+    JVXFS_COMP_CONFIG,
+    JVXFS_COMP_SP_REBLOCK,
+    JVXFS_COMP_SP_STFT,
+    JVXFS_COMP_COUNT /* Number of components, keep last. */
 } jvxfs_component_t;
 
 typedef struct
@@ -46,6 +78,7 @@ typedef struct
     const char* file;
     uint32_t line;
     switch_time_t time;
+    uint64_t occurrences;
 } jvxfs_error_info_t;
 
 typedef void(*jvxfs_error_callback_t)(const jvxfs_error_info_t*, void* data);
@@ -54,9 +87,29 @@ jvxfs_status_t jvxfs_error_create_error_handler(jvxfs_error_t** obj, switch_memo
 
 bool jvxfs_error_has_happend(jvxfs_error_t* obj);
 
+/**
+ * @brief Count an error and keep it in the ring of recent errors.
+ * @details Takes a few relaxed atomic additions and no lock, the ring and the counters are sharded per thread.
+ * No clock is read for errors of a component and status past #JVXFS_ERROR_CALLBACK_BURST, unless they are
+ * passed to the callback. An error whose ring slot is still being written by another thread is only counted. Their time is derived from a cycle counter when they are read.
+ * @param[in] time  Time of the error, 0 to derive it.
+ * @return @a status
+ */
 jvxfs_status_t jvxfs_error_set_error_detailed(jvxfs_error_t* obj, jvxfs_status_t status, jvxfs_log_level_t level, jvxfs_component_t component,
     const char* function, const char* file, uint32_t line, switch_time_t time, const char* message);
 
+uint64_t jvxfs_error_count(jvxfs_error_t* obj);
+uint64_t jvxfs_error_count_component(jvxfs_error_t* obj, jvxfs_component_t component);
+uint64_t jvxfs_error_count_status(jvxfs_error_t* obj, jvxfs_status_t status);
+
+/**
+ * @brief Read the most recent errors, newest first.
+ * @details Errors reported meanwhile may be missed. @em occurrences is the count of the component and status in
+ * the shard the error was recorded in.
+ * @return Number of errors written to @a out.
+ */
+uint32_t jvxfs_error_read_recent(jvxfs_error_t* obj, jvxfs_error_info_t* out, uint32_t max);
+
 jvxfs_status_t jvxfs_error_set_callback(jvxfs_error_t* obj, jvxfs_error_callback_t func, void* data);
 
 void jvxfs_error_remove_callback(jvxfs_error_t* obj); 
@@ -64,6 +117,7 @@ void jvxfs_error_remove_callback(jvxfs_error_t* obj);
 void jvxfs_error_default_callback_function(const jvxfs_error_info_t* info, void* data);
 
 const char* jvxfs_error_status_to_message(jvxfs_status_t stat);
+const char* jvxfs_error_component_to_name(jvxfs_component_t comp);
 
 JVX_FS_LIB_END
 
@@ -3,24 +3,53 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include <string.h>
+#include "../processing/sp_convert.h"
+#include "../processing/sp_fft.h"
+#include "../processing/sp_resampler.h"
 #include "../processing/sp_processor.h"
+#include "../utils/atomic.h"
 #include "app.h"
+#include "command.h"
+#include "config.h"
+#include "emitter.h"
 #include "system.h"
 #include "error.h"
 #include "view_private.h"
 #include "session.h"
 #include "module.h"
 
+typedef struct app_entry_s
+{
+    jvxfs_app_t* app;
+    const char* name;
+    struct app_entry_s* next;
+} app_entry_t;
+
 typedef struct
 {
     switch_loadable_module_interface_t* interface;
     switch_application_function_t appFunc;
     switch_api_function_t apiFunc;
-    jvxfs_app_t* app;
+    app_entry_t* appStart;
+    app_entry_t* appStop;
+    uint32_t appCount;
     jvxfs_error_t* err;
     jvxfs_module_state_t state;
+    jvxfs_worker_pool_t* worker;
+    uint32_t workerThreads;
+    bool workerPinned;
+    bool workerEnabled;
+    uint32_t workerLock;
+    jvxfs_emitter_t* emitter;
+    uint32_t eventWindow;
+    uint32_t eventRate;
+    jvxfs_config_t* config;
 } module_t;
 
+#define WORKER_QUEUE_DEPTH 1024
+
+static jvxfs_app_t* find_app(module_t* hdl, const char* name);
+
 
 jvxfs_status_t jvxfs_system_create_module(jvxfs_module_t** mod, switch_loadable_module_interface_t** module_interface,
     switch_memory_pool_t* pool, const char* name, switch_application_function_t ptrApp, switch_api_function_t ptrApi)
@@ -30,12 +59,30 @@ jvxfs_status_t jvxfs_system_create_module(jvxfs_module_t** mod, switch_loadable_
     if (!hdl) return JVXFS_STATUS_ALLOCATION_FAILED;
     jvxfs_status_t res = jvxfs_error_create_error_handler(&hdl->err, pool);
     if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = jvxfs_fft_init();
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = jvxfs_resampler_init();
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = jvxfs_convert_init();
+    if (res != JVXFS_STATUS_SUCCESS) return res;
+    res = jvxfs_config_create(&hdl->config, hdl->err, pool);
+    if (res != JVXFS_STATUS_SUCCESS) return res;
     *module_interface = switch_loadable_module_create_module_interface(pool, name);
     hdl->interface = *module_interface;
     hdl->appFunc = ptrApp;
     hdl->apiFunc = ptrApi;
-    hdl->app = NULL;
+    hdl->appStart = NULL;
+    hdl->appStop = NULL;
+    hdl->appCount = 0;
     hdl->state = JVXFS_MODULE_INITIALIZING;
+    hdl->worker = NULL;
+    hdl->workerThreads = 0;
+    hdl->workerPinned = false;
+    hdl->workerEnabled = false;
+    hdl->workerLock = 0;
+    hdl->emitter = NULL;
+    hdl->eventWindow = JVXFS_EMITTER_DEFAULT_WINDOW_MS;
+    hdl->eventRate = JVXFS_EMITTER_DEFAULT_RATE;
     *mod = hdl;
     return JVXFS_STATUS_SUCCESS;
 }
@@ -52,10 +99,30 @@ switch_status_t jvxfs_system_init_check(jvxfs_module_t* mod, const char* name)
         switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Aborting start of module due to error.\n");
         hdl->state = JVXFS_MODULE_FAILED;
         return SWITCH_STATUS_FALSE;
-    } else {
-        hdl->state = JVXFS_MODULE_RUNNING;
-        return SWITCH_STATUS_SUCCESS;
     }
+    /* Worker threads are only started by the first app that needs them, see jvxfs_module_get_worker(). */
+    hdl->workerEnabled = true;
+    jvxfs_status_t res = jvxfs_emitter_create(&hdl->emitter, hdl->eventWindow, hdl->eventRate, hdl->err, hdl->interface->pool);
+    if (res != JVXFS_STATUS_SUCCESS) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Aborting start of module, no event emitter.\n");
+        hdl->state = JVXFS_MODULE_FAILED;
+        return SWITCH_STATUS_FALSE;
+    }
+    if (jvxfs_config_start(hdl->config) != JVXFS_STATUS_SUCCESS) {
+        switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Aborting start of module, configuration could not be loaded.\n");
+        hdl->state = JVXFS_MODULE_FAILED;
+        return SWITCH_STATUS_FALSE;
+    }
+    for (app_entry_t* entry = hdl->appStart; entry; entry = entry->next) {
+        if (jvx_system_start_app(entry->app) != JVXFS_STATUS_SUCCESS) {
+            switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Aborting start of module, app \"%s\" could not be started.\n",
+                entry->name);
+            hdl->state = JVXFS_MODULE_FAILED;
+            return SWITCH_STATUS_FALSE;
+        }
+    }
+    hdl->state = JVXFS_MODULE_RUNNING;
+    return SWITCH_STATUS_SUCCESS;
 }
 
 switch_status_t jvxfs_system_prepare_end(jvxfs_module_t* mod)
@@ -69,10 +136,18 @@ switch_status_t jvxfs_system_terminate(jvxfs_module_t** mod)
 {
     if (!*mod) return SWITCH_STATUS_SUCCESS;
     module_t* hdl = (module_t*)*mod;
-    if (hdl->app) {
-        jvx_system_delete_app(hdl->app);
-        hdl->app = NULL;
+    for (app_entry_t* entry = hdl->appStart; entry; entry = entry->next) {
+        jvx_system_delete_app(entry->app);
     }
+    hdl->appStart = NULL;
+    hdl->appStop = NULL;
+    hdl->appCount = 0;
+    jvxfs_config_destroy(&hdl->config);
+    jvxfs_emitter_destroy(&hdl->emitter);
+    hdl->workerEnabled = false;
+    jvxfs_worker_destroy_pool(&hdl->worker);
+    jvxfs_fft_shutdown();
+    jvxfs_resampler_shutdown();
     *mod = NULL;
     return SWITCH_STATUS_SUCCESS;
 }
@@ -80,22 +155,22 @@ switch_status_t jvxfs_system_terminate(jvxfs_module_t** mod)
 void jvxfs_system_load_app(jvxfs_module_t* mod, switch_core_session_t* session, const char* data)
 {
     module_t* hdl = (module_t*)mod;
-    if (!hdl->app) {
-        jvxfs_error_set_error(hdl->err, JVXFS_STATUS_PENDING_CONFIGURATION, JVXFS_LOG_ERROR, JVXFS_COMP_SYSTEM,
+    switch_channel_t* channel = switch_core_session_get_channel(session);
+    jvxfs_app_t* app = find_app(hdl, switch_channel_get_variable(channel, SWITCH_CURRENT_APPLICATION_VARIABLE));
+    if (!app) {
+        jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ELEMENT_NOT_FOUND, JVXFS_LOG_ERROR, JVXFS_COMP_SYSTEM,
             "Trying to create instance of non-existing app.");
         return;
     }
-    //switch_channel_t* channel = switch_core_session_get_channel(session);
-    //const char* appName = switch_channel_get_variable(channel, SWITCH_CURRENT_APPLICATION_VARIABLE);
-    if (jvxfs_session_has_app_instance(session, hdl->app)) {
+    if (jvxfs_session_has_app_instance(session, app)) {
         if (zstr(data)) {
             jvxfs_error_set_error(hdl->err, JVXFS_STATUS_APP_INSTANCE_EXISTING, JVXFS_LOG_ERROR, JVXFS_COMP_SYSTEM,
                 "Trying to overwrite existing app.");
             return;
         }
-        jvxfs_app_exec_call(hdl->app, session, data);
+        jvxfs_app_exec_call(app, session, data);
     } else {
-        jvxfs_app_produce_instance(hdl->app, session, data);
+        jvxfs_app_produce_instance(app, session, data);
     }
 }
 
@@ -103,25 +178,27 @@ switch_status_t jvxfs_system_exec_api(jvxfs_module_t* mod, _In_opt_z_ const char
     _In_opt_ switch_core_session_t *session, _In_ switch_stream_handle_t *stream)
 {
     module_t* hdl = (module_t*)mod;
-    //const char* apiName = switch_event_get_header_nil(stream->param_event, "API-Command");
-    char tmp[JVXFS_DIRECTIVE_NAME_MAX_LENGTH+1] = {0};
-    const char* directive = NULL;
-    const char* params = strchr(cmd, ' ');
-    if (!params) {
-        directive = cmd;
-        params = "";
-    } else {
-        size_t len = params - cmd;
-        if (len > JVXFS_DIRECTIVE_NAME_MAX_LENGTH) len = JVXFS_DIRECTIVE_NAME_MAX_LENGTH;
-        strncpy(tmp, cmd, len);
-        directive = tmp;
-        ++params;
-    }
-    jvxfs_directive_data_t data = { .app = hdl->app, .session = session, .directive = directive,
-        .parameters = params };
+    const char* apiName = stream->param_event ? switch_event_get_header_nil(stream->param_event, "API-Command") : NULL;
+    jvxfs_command_t command;
+    jvxfs_command_parse(cmd, &command);
+    jvxfs_directive_data_t data = { .app = find_app(hdl, apiName), .session = session };
     view_priv_t view = { .origin = JVXFS_VIEW_IN_CONSOLE, .dest = JVXFS_VIEW_OUT_CONSOLE, .err = hdl->err, 
         .data = &data, .console = stream };
-    jvxfs_status_t res = jvxfs_app_call_directive(&data, &view);
+    if (!data.app) {
+        jvxfs_view_write_human_readable(&view, "Unknown app \"%s\".\n", apiName ? apiName : "");
+        jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ELEMENT_NOT_FOUND, JVXFS_LOG_ERROR, JVXFS_COMP_SYSTEM,
+            "Trying to call API of non-existing app.");
+        return SWITCH_STATUS_FALSE;
+    }
+    jvxfs_status_t res;
+    if (command.nameLength > 1 && command.name[0] == '@') {
+        /* "@<target> <directive> [args]" runs a session directive for several sessions at once. */
+        jvxfs_command_t inner;
+        jvxfs_command_parse(command.parameters, &inner);
+        res = jvxfs_app_call_targeted_command(&data, command.name + 1, command.nameLength - 1, &inner, &view);
+    } else {
+        res = jvxfs_app_call_command(&data, &command, &view);
+    }
     return (res == JVXFS_STATUS_SUCCESS) ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
 }
 
@@ -135,34 +212,90 @@ jvxfs_status_t jvxfs_module_create_sigproc_app(jvxfs_module_t* mod, jvxfs_app_t*
     jvxfs_algorithm_construct_t func_cnst, jvxfs_algorithm_initialize_t func_init,
     jvxfs_algorithm_process_t func_proc, jvxfs_algorithm_terminate_t func_term,
     jvxfs_algorithm_destruct_t func_dest)
+{
+    module_t* hdl = (module_t*)mod;
+    return jvxfs_module_create_named_sigproc_app(mod, out, &(hdl->interface->module_name[4]),
+        func_cnst, func_init, func_proc, func_term, func_dest);
+}
+
+jvxfs_status_t jvxfs_module_create_named_sigproc_app(jvxfs_module_t* mod, jvxfs_app_t** out, const char* name,
+    jvxfs_algorithm_construct_t func_cnst, jvxfs_algorithm_initialize_t func_init,
+    jvxfs_algorithm_process_t func_proc, jvxfs_algorithm_terminate_t func_term,
+    jvxfs_algorithm_destruct_t func_dest)
 {
     *out = NULL;
     module_t* hdl = (module_t*)mod;
-    const char* appName = &(hdl->interface->module_name[4]);
+    if (zstr(name)) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_MODULE,
+            "Could not create signal processing app without name.");
+    }
+    jvxfs_app_t* existing;
+    if (jvxfs_module_find_app(mod, name, &existing) == JVXFS_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_INVALID_ARGUMENT, JVXFS_LOG_ERROR, JVXFS_COMP_MODULE,
+            "Could not create signal processing app, name already in use.");
+    }
+    size_t length = strlen(name) + 1;
+    app_entry_t* entry = (app_entry_t*)switch_core_alloc(hdl->interface->pool, sizeof(app_entry_t) + length);
+    if (!entry) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_MODULE,
+            "Could not create signal processing app.");
+    }
+    /* The interfaces keep a pointer to the name, so it lives as long as the module. */
+    char* appName = (char*)(entry + 1);
+    memcpy(appName, name, length);
     switch_loadable_module_interface_t** module_interface = &(hdl->interface);
     switch_application_interface_t* app_interface;
 	switch_api_interface_t* api_interface;
     SWITCH_ADD_APP(app_interface, appName, "", "", hdl->appFunc, "", SAF_NONE);
 	SWITCH_ADD_API(api_interface, appName, "", hdl->apiFunc, "");
-    jvxfs_status_t res = jvx_system_create_sigproc_app(&hdl->app, mod, appName, app_interface, api_interface,
+    jvxfs_status_t res = jvx_system_create_sigproc_app(&entry->app, mod, appName, app_interface, api_interface,
         func_cnst, func_init, func_proc, func_term, func_dest);
     if (res != JVXFS_STATUS_SUCCESS) return res;
-    res = jvxfs_app_set_instance_factory(hdl->app, jvxfs_sigproc_create_processor);
-    *out = hdl->app;
+    res = jvxfs_app_set_instance_factory(entry->app, jvxfs_sigproc_create_processor);
+    entry->name = appName;
+    entry->next = NULL;
+    if (hdl->appStop) {
+        hdl->appStop->next = entry;
+    } else {
+        hdl->appStart = entry;
+    }
+    hdl->appStop = entry;
+    hdl->appCount++;
+    *out = entry->app;
     return res;
 }
 
 jvxfs_status_t jvxfs_module_get_sigproc_app(jvxfs_module_t* mod, jvxfs_app_t** out)
 {
     module_t* hdl = (module_t*)mod;
-    *out = hdl->app;
+    *out = hdl->appStart ? hdl->appStart->app : NULL;
     return JVXFS_STATUS_SUCCESS;
 }
 
+jvxfs_status_t jvxfs_module_find_app(jvxfs_module_t* mod, const char* name, jvxfs_app_t** out)
+{
+    module_t* hdl = (module_t*)mod;
+    *out = NULL;
+    if (zstr(name)) return JVXFS_STATUS_INVALID_ARGUMENT;
+    for (app_entry_t* entry = hdl->appStart; entry; entry = entry->next) {
+        if (strcmp(entry->name, name) == 0) {
+            *out = entry->app;
+            return JVXFS_STATUS_SUCCESS;
+        }
+    }
+    return JVXFS_STATUS_ELEMENT_NOT_FOUND;
+}
+
 bool jvxfs_module_has_apps(jvxfs_module_t* mod)
 {
     module_t* hdl = (module_t*)mod;
-    return hdl->app != NULL;
+    return hdl->appStart != NULL;
+}
+
+uint32_t jvxfs_module_count_apps(jvxfs_module_t* mod)
+{
+    module_t* hdl = (module_t*)mod;
+    return hdl->appCount;
 }
 
 jvxfs_error_t* jvxfs_module_get_error_handler(jvxfs_module_t* mod)
@@ -175,4 +308,84 @@ jvxfs_module_state_t jvxfs_module_get_state(jvxfs_module_t* mod)
 {
     module_t* hdl = (module_t*)mod;
     return hdl->state;
+}
+
+jvxfs_status_t jvxfs_module_set_worker_threads(jvxfs_module_t* mod, uint32_t threads, bool pinned)
+{
+    module_t* hdl = (module_t*)mod;
+    if (hdl->state != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_MODULE,
+            "Could not set number of worker threads.");
+    }
+    hdl->workerThreads = threads;
+    hdl->workerPinned = pinned;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_worker_pool_t* jvxfs_module_get_worker(jvxfs_module_t* mod)
+{
+    module_t* hdl = (module_t*)mod;
+    jvxfs_worker_pool_t* worker = jvxfs_atomic_load(&hdl->worker);
+    if (worker || !jvxfs_atomic_load(&hdl->workerEnabled)) return worker;
+    uint32_t unlocked = 0;
+    while (!jvxfs_atomic_cas(&hdl->workerLock, &unlocked, 1)) {
+        unlocked = 0;
+        jvxfs_cpu_relax();
+    }
+    worker = hdl->worker;
+    if (!worker && hdl->workerEnabled && hdl->state != JVXFS_MODULE_TERMINATING && hdl->state != JVXFS_MODULE_FAILED) {
+        if (jvxfs_worker_create_pool(&worker, hdl->workerThreads, WORKER_QUEUE_DEPTH, hdl->workerPinned, hdl->err,
+            hdl->interface->pool) == JVXFS_STATUS_SUCCESS) {
+            jvxfs_atomic_store(&hdl->worker, worker);
+        } else {
+            /* Callers run without helpers, the creation is not retried for every call. */
+            switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Could not start worker threads, running without.\n");
+            jvxfs_atomic_store(&hdl->workerEnabled, false);
+        }
+    }
+    jvxfs_atomic_store(&hdl->workerLock, 0);
+    return worker;
+}
+
+jvxfs_status_t jvxfs_module_set_event_emission(jvxfs_module_t* mod, uint32_t windowMs, uint32_t rate)
+{
+    module_t* hdl = (module_t*)mod;
+    if (jvxfs_module_get_state(mod) != JVXFS_MODULE_INITIALIZING) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_NOT_INITIALIZING, JVXFS_LOG_ERROR, JVXFS_COMP_MODULE,
+            "Could not set event emission.");
+    }
+    hdl->eventWindow = windowMs;
+    hdl->eventRate = rate;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_emitter_t* jvxfs_module_get_emitter(jvxfs_module_t* mod)
+{
+    module_t* hdl = (module_t*)mod;
+    return hdl->emitter;
+}
+
+jvxfs_status_t jvxfs_module_change_configfile(jvxfs_module_t* mod, const char* name)
+{
+    module_t* hdl = (module_t*)mod;
+    return jvxfs_config_set_file(hdl->config, name);
+}
+
+jvxfs_config_t* jvxfs_module_get_config(jvxfs_module_t* mod)
+{
+    module_t* hdl = (module_t*)mod;
+    return hdl->config;
+}
+
+
+jvxfs_app_t* find_app(module_t* hdl, const char* name)
+{
+    if (!hdl->appStart) return NULL;
+    /* A missing name, e.g. if the core did not pass on the invoked name, goes to the first app. So does any
+     * name while there is only one app, an unknown name of several apps can not be routed. */
+    if (zstr(name) || !hdl->appStart->next) return hdl->appStart->app;
+    for (app_entry_t* entry = hdl->appStart; entry; entry = entry->next) {
+        if (strcmp(entry->name, name) == 0) return entry->app;
+    }
+    return NULL;
 }
\ No newline at end of file
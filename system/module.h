@@ -17,6 +17,9 @@
 #include <stdbool.h>
 #include <switch.h>
 #include "defines.h"
+#include "../utils/worker.h"
+#include "config.h"
+#include "emitter.h"
 
 JVX_FS_LIB_BEGIN
 
@@ -30,19 +33,81 @@ typedef enum
 
 switch_memory_pool_t* jvxfs_module_get_memory_pool(jvxfs_module_t* mod);
 
+/**
+ * @brief Create the signal processing app named after the module, without its "mod_" prefix.
+ */
 jvxfs_status_t jvxfs_module_create_sigproc_app(jvxfs_module_t* mod, jvxfs_app_t** out,
     jvxfs_algorithm_construct_t func_cnst, jvxfs_algorithm_initialize_t func_init,
     jvxfs_algorithm_process_t func_proc, jvxfs_algorithm_terminate_t func_term,
     jvxfs_algorithm_destruct_t func_dest);
+
+/**
+ * @brief Create a further signal processing app in the same module.
+ * @details Each app registers its own dialplan app and API under @a name and has its own configuration, vtable
+ * and directives. Memory pool, worker threads, event emitter and lookup tables belong to the module and are
+ * shared. Calls of jvxfs_system_load_app() and jvxfs_system_exec_api() are routed by the invoked name, the
+ * first app created takes calls without a name. Calls of an unknown name are rejected while there are several
+ * apps.
+ * @param[in] mod       Module, still initializing.
+ * @param[out] out      Created app.
+ * @param[in] name      Unique name of the app, copied.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_module_create_named_sigproc_app(jvxfs_module_t* mod, jvxfs_app_t** out, const char* name,
+    jvxfs_algorithm_construct_t func_cnst, jvxfs_algorithm_initialize_t func_init,
+    jvxfs_algorithm_process_t func_proc, jvxfs_algorithm_terminate_t func_term,
+    jvxfs_algorithm_destruct_t func_dest);
+
+/**
+ * @brief Return the first app created, @em NULL if there is none.
+ */
 jvxfs_status_t jvxfs_module_get_sigproc_app(jvxfs_module_t* mod, jvxfs_app_t** out);
+
+/**
+ * @brief Look up an app by name.
+ * @return #JVXFS_STATUS_INVALID_ARGUMENT for an empty name, #JVXFS_STATUS_ELEMENT_NOT_FOUND if no app has
+ * that name.
+ */
+jvxfs_status_t jvxfs_module_find_app(jvxfs_module_t* mod, const char* name, jvxfs_app_t** out);
 bool jvxfs_module_has_apps(jvxfs_module_t* mod);
+uint32_t jvxfs_module_count_apps(jvxfs_module_t* mod);
 
 jvxfs_error_t* jvxfs_module_get_error_handler(jvxfs_module_t* mod);
 
 jvxfs_module_state_t jvxfs_module_get_state(jvxfs_module_t* mod);
 
+jvxfs_status_t jvxfs_module_set_worker_threads(jvxfs_module_t* mod, uint32_t threads, bool pinned);
+
+/**
+ * @brief Return the worker pool of the module, started on the first call after jvxfs_system_init_check().
+ * @details Modules whose apps neither process asynchronously, keep an instance pool nor fan out directives
+ * never start worker threads. Returns @em NULL before the module is started or if the threads could not
+ * be started, callers then do the work themselves.
+ */
+jvxfs_worker_pool_t* jvxfs_module_get_worker(jvxfs_module_t* mod);
+
+/**
+ * @brief Set how machine readable output is fired as events, see jvxfs_emitter_create().
+ * @details Defaults to JVXFS_EMITTER_DEFAULT_WINDOW_MS and JVXFS_EMITTER_DEFAULT_RATE.
+ */
+jvxfs_status_t jvxfs_module_set_event_emission(jvxfs_module_t* mod, uint32_t windowMs, uint32_t rate);
+jvxfs_emitter_t* jvxfs_module_get_emitter(jvxfs_module_t* mod);
+
+/**
+ * @brief Set the configuration file of the module.
+ * @details While the module initializes, the file is loaded when it starts. A running module loads it
+ * right away and keeps the previous file and parameters if that fails. The file is reloaded whenever it
+ * changes, see config.h.
+ * @param[in] mod   Module.
+ * @param[in] name  Path of the file, @em NULL to keep the defaults.
+ * @return Status code.
+ */
 jvxfs_status_t jvxfs_module_change_configfile(jvxfs_module_t* mod, const char* name);
-void* jvxfs_module_get_config(jvxfs_module_t* mod);
+
+/**
+ * @brief Return the configuration of the module, to declare parameters while it initializes.
+ */
+jvxfs_config_t* jvxfs_module_get_config(jvxfs_module_t* mod);
 
 JVX_FS_LIB_END
 
@@ -0,0 +1,220 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "../utils/atomic.h"
+#include "error.h"
+#include "registry.h"
+
+#define MAX_CHUNKS 256
+#define NO_SLOT UINT32_MAX
+
+typedef struct
+{
+    jvxfs_app_instance_t* inst;
+    switch_core_session_t* session;
+    uint32_t users;
+    uint32_t nextFree;
+} slot_t;
+
+typedef struct
+{
+    slot_t* chunks[MAX_CHUNKS];
+    uint32_t used;
+    uint32_t live;
+    uint32_t freeSlot;
+    jvxfs_error_t* err;
+    switch_memory_pool_t* pool;
+    switch_mutex_t* mutex;
+} registry_t;
+
+struct job_s;
+
+typedef struct
+{
+    jvxfs_worker_task_t task;
+    struct job_s* job;
+} helper_t;
+
+typedef struct job_s
+{
+    registry_t* hdl;
+    uint32_t chunks;
+    uint32_t next;
+    uint32_t visited;
+    uint32_t active;
+    jvxfs_registry_func_t func;
+    void* data;
+} job_t;
+
+static slot_t* get_slot(registry_t* hdl, uint32_t index);
+static void run_chunks(job_t* job);
+static void helper_task(void* data);
+
+
+jvxfs_status_t jvxfs_registry_create(jvxfs_registry_t** obj, jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    registry_t* hdl = (registry_t*)switch_core_alloc(pool, sizeof(registry_t));
+    if (!hdl || switch_mutex_init(&hdl->mutex, SWITCH_MUTEX_NESTED, pool) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_REGISTRY,
+            "Could not create instance registry.");
+    }
+    for (uint32_t i = 0; i < MAX_CHUNKS; ++i) hdl->chunks[i] = NULL;
+    hdl->used = 0;
+    hdl->live = 0;
+    hdl->freeSlot = NO_SLOT;
+    hdl->err = err;
+    hdl->pool = pool;
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_registry_add(jvxfs_registry_t* obj, switch_core_session_t* session, jvxfs_app_instance_t* inst)
+{
+    registry_t* hdl = (registry_t*)obj;
+    switch_mutex_lock(hdl->mutex);
+    uint32_t index = hdl->freeSlot;
+    if (index != NO_SLOT) {
+        hdl->freeSlot = get_slot(hdl, index)->nextFree;
+    } else {
+        index = hdl->used;
+        uint32_t chunk = index / JVXFS_REGISTRY_CHUNK_SIZE;
+        if (chunk >= MAX_CHUNKS) {
+            switch_mutex_unlock(hdl->mutex);
+            return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_OUT_OF_BOUNDS, JVXFS_LOG_ERROR, JVXFS_COMP_REGISTRY,
+                "Instance registry is full.");
+        }
+        if (!hdl->chunks[chunk]) {
+            /* Chunks stay until the module is unloaded, so readers never see one disappear. */
+            slot_t* slots = (slot_t*)switch_core_alloc(hdl->pool, sizeof(slot_t) * JVXFS_REGISTRY_CHUNK_SIZE);
+            if (!slots) {
+                switch_mutex_unlock(hdl->mutex);
+                return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL,
+                    JVXFS_COMP_REGISTRY, "Could not grow instance registry.");
+            }
+            memset(slots, 0, sizeof(slot_t) * JVXFS_REGISTRY_CHUNK_SIZE);
+            jvxfs_atomic_store(&hdl->chunks[chunk], slots);
+        }
+    }
+    slot_t* slot = get_slot(hdl, index);
+    slot->session = session;
+    slot->nextFree = NO_SLOT;
+    jvxfs_atomic_store(&slot->inst, inst);
+    if (index == hdl->used) jvxfs_atomic_store(&hdl->used, index + 1);
+    jvxfs_atomic_fetch_add(&hdl->live, 1);
+    switch_mutex_unlock(hdl->mutex);
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_registry_remove(jvxfs_registry_t* obj, jvxfs_app_instance_t* inst)
+{
+    registry_t* hdl = (registry_t*)obj;
+    slot_t* slot = NULL;
+    uint32_t index = 0;
+    switch_mutex_lock(hdl->mutex);
+    for (; index < hdl->used; ++index) {
+        slot = get_slot(hdl, index);
+        if (slot->inst == inst) break;
+    }
+    if (index == hdl->used) {
+        switch_mutex_unlock(hdl->mutex);
+        return;
+    }
+    jvxfs_atomic_store(&slot->inst, NULL);
+    jvxfs_atomic_fetch_sub(&hdl->live, 1);
+    switch_mutex_unlock(hdl->mutex);
+    /* Visitors pin the slot before checking the instance again, see run_chunks(). */
+    jvxfs_atomic_fence();
+    while (jvxfs_atomic_load(&slot->users)) switch_yield(100);
+    switch_mutex_lock(hdl->mutex);
+    slot->session = NULL;
+    slot->nextFree = hdl->freeSlot;
+    hdl->freeSlot = index;
+    switch_mutex_unlock(hdl->mutex);
+}
+
+uint32_t jvxfs_registry_count(jvxfs_registry_t* obj)
+{
+    registry_t* hdl = (registry_t*)obj;
+    return jvxfs_atomic_load(&hdl->live);
+}
+
+uint32_t jvxfs_registry_count_chunks(jvxfs_registry_t* obj)
+{
+    registry_t* hdl = (registry_t*)obj;
+    uint32_t used = jvxfs_atomic_load(&hdl->used);
+    return (used + JVXFS_REGISTRY_CHUNK_SIZE - 1) / JVXFS_REGISTRY_CHUNK_SIZE;
+}
+
+uint32_t jvxfs_registry_for_each(jvxfs_registry_t* obj, uint32_t chunks, jvxfs_worker_pool_t* worker,
+    jvxfs_registry_func_t func, void* data)
+{
+    registry_t* hdl = (registry_t*)obj;
+    uint32_t available = jvxfs_registry_count_chunks(hdl);
+    job_t job = { .hdl = hdl, .chunks = (chunks < available) ? chunks : available, .next = 0, .visited = 0,
+        .active = 0, .func = func, .data = data };
+    if (job.chunks == 0) return 0;
+    uint32_t helpers = (worker && job.chunks > 1) ? jvxfs_worker_count_threads(worker) : 0;
+    if (helpers > job.chunks - 1) helpers = job.chunks - 1;
+    helper_t* tasks = (helpers) ? (helper_t*)malloc(sizeof(helper_t) * helpers) : NULL;
+    if (!tasks) helpers = 0;
+    for (uint32_t i = 0; i < helpers; ++i) {
+        tasks[i].task.func = helper_task;
+        tasks[i].task.data = &tasks[i];
+        tasks[i].job = &job;
+        jvxfs_atomic_fetch_add(&job.active, 1);
+        if (!jvxfs_worker_submit(worker, &tasks[i].task)) {
+            jvxfs_atomic_fetch_sub(&job.active, 1);
+            break;
+        }
+    }
+    run_chunks(&job);
+    /* The tasks live on this stack, wait for helpers that started late and found nothing left. */
+    while (jvxfs_atomic_load(&job.active)) jvxfs_cpu_relax();
+    free(tasks);
+    return jvxfs_atomic_load(&job.visited);
+}
+
+
+slot_t* get_slot(registry_t* hdl, uint32_t index)
+{
+    slot_t* chunk = jvxfs_atomic_load(&hdl->chunks[index / JVXFS_REGISTRY_CHUNK_SIZE]);
+    return &chunk[index % JVXFS_REGISTRY_CHUNK_SIZE];
+}
+
+void run_chunks(job_t* job)
+{
+    registry_t* hdl = job->hdl;
+    uint32_t chunk;
+    while ((chunk = jvxfs_atomic_fetch_add(&job->next, 1)) < job->chunks) {
+        uint32_t visited = 0;
+        uint32_t begin = chunk * JVXFS_REGISTRY_CHUNK_SIZE;
+        uint32_t end = jvxfs_atomic_load(&hdl->used);
+        if (end > begin + JVXFS_REGISTRY_CHUNK_SIZE) end = begin + JVXFS_REGISTRY_CHUNK_SIZE;
+        for (uint32_t i = begin; i < end; ++i) {
+            slot_t* slot = get_slot(hdl, i);
+            jvxfs_app_instance_t* inst = jvxfs_atomic_load(&slot->inst);
+            if (!inst) continue;
+            jvxfs_atomic_fetch_add(&slot->users, 1);
+            jvxfs_atomic_fence();
+            /* Removed or replaced meanwhile, the remover may not have seen the pin. */
+            if (jvxfs_atomic_load(&slot->inst) == inst) {
+                job->func(slot->session, inst, chunk, job->data);
+                ++visited;
+            }
+            jvxfs_atomic_fetch_sub(&slot->users, 1);
+        }
+        jvxfs_atomic_fetch_add(&job->visited, visited);
+    }
+}
+
+void helper_task(void* data)
+{
+    helper_t* helper = (helper_t*)data;
+    job_t* job = helper->job;
+    run_chunks(job);
+    jvxfs_atomic_fetch_sub(&job->active, 1);
+}
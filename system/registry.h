@@ -0,0 +1,73 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+ 
+/**
+ * @file registry.h
+ * @brief Registry of the live app instances of an app.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-23
+ * @copyright Copyright (c) 2019
+ * @note The user should not call these functions himself, instances are registered
+ * by jvxfs_session_add_app_instance() and jvxfs_session_remove_app_instance().
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_SYSTEM_REGISTRY_H
+#define LIB_JVX_FS_FRAMEWORK_SYSTEM_REGISTRY_H
+
+#include <stdbool.h>
+#include <switch.h>
+#include "defines.h"
+#include "../utils/worker.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @brief Number of instances visited by one task of jvxfs_registry_for_each().
+ */
+#define JVXFS_REGISTRY_CHUNK_SIZE 256
+
+typedef void jvxfs_registry_t;
+
+/**
+ * @brief Function called for every instance by jvxfs_registry_for_each().
+ * @param[in] session   Session of the instance.
+ * @param[in] inst      Instance, it is not removed before the function returns.
+ * @param[in] chunk     Index of the chunk the instance is in, functions of the same chunk are called one after the other.
+ * @param[in] data      User data.
+ */
+typedef void(*jvxfs_registry_func_t)(switch_core_session_t* session, jvxfs_app_instance_t* inst, uint32_t chunk, void* data);
+
+jvxfs_status_t jvxfs_registry_create(jvxfs_registry_t** obj, jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Add an instance, the registry does not check for duplicates.
+ */
+jvxfs_status_t jvxfs_registry_add(jvxfs_registry_t* obj, switch_core_session_t* session, jvxfs_app_instance_t* inst);
+
+/**
+ * @brief Remove an instance, waits for functions of jvxfs_registry_for_each() still running on it.
+ */
+void jvxfs_registry_remove(jvxfs_registry_t* obj, jvxfs_app_instance_t* inst);
+
+uint32_t jvxfs_registry_count(jvxfs_registry_t* obj);
+
+/**
+ * @brief Number of chunks the instances are spread over at the moment.
+ */
+uint32_t jvxfs_registry_count_chunks(jvxfs_registry_t* obj);
+
+/**
+ * @brief Call a function for every instance of the first @a chunks chunks.
+ * @details The chunks are shared by the calling thread and the threads of @a worker, if given. Instances added
+ * meanwhile may be missed, removed ones are skipped. Returns after the function was called for all instances.
+ * Adding and removing instances takes a lock, visiting them does not.
+ * @return Number of visited instances.
+ */
+uint32_t jvxfs_registry_for_each(jvxfs_registry_t* obj, uint32_t chunks, jvxfs_worker_pool_t* worker,
+    jvxfs_registry_func_t func, void* data);
+
+JVX_FS_LIB_END
+
+#endif
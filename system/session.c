@@ -21,7 +21,9 @@ jvxfs_status_t jvxfs_session_add_app_instance(switch_core_session_t* session, jv
             "Cannot overwrite existing app instance, stop creating new one.");
     }
     switch_channel_set_private(channel, name, instance);
-    return JVXFS_STATUS_SUCCESS;    
+    jvxfs_status_t res = jvxfs_registry_add(jvxfs_app_get_registry(app), session, instance);
+    if (res != JVXFS_STATUS_SUCCESS) switch_channel_set_private(channel, name, NULL);
+    return res;
 }
 
 jvxfs_app_instance_t* jvxfs_session_remove_app_instance(switch_core_session_t* session, jvxfs_app_t* app)
@@ -30,6 +32,7 @@ jvxfs_app_instance_t* jvxfs_session_remove_app_instance(switch_core_session_t* s
     const char* name = jvxfs_app_get_name(app);
     jvxfs_app_instance_t* tmp = switch_channel_get_private(channel, name);
     switch_channel_set_private(channel, name, NULL);
+    if (tmp) jvxfs_registry_remove(jvxfs_app_get_registry(app), tmp);
     return tmp;   
 }
 
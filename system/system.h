@@ -44,12 +44,16 @@ jvxfs_status_t jvx_system_create_sigproc_app(jvxfs_app_t** app, jvxfs_module_t*
     jvxfs_algorithm_process_t func_proc, jvxfs_algorithm_terminate_t func_term,
     jvxfs_algorithm_destruct_t func_dest);
 
+jvxfs_status_t jvx_system_start_app(jvxfs_app_t* app);
+
 jvxfs_status_t jvx_system_delete_app(jvxfs_app_t* app);
 
 jvxfs_status_t jvxfs_system_create_sp_config(jvxfs_sigprog_config_t** obj, jvxfs_module_t* mod);
 
 jvxfs_status_t jvx_system_delete_sp_config(jvxfs_sigprog_config_t* conf);
 
+jvxfs_status_t jvxfs_system_build_sp_profiles(jvxfs_sigprog_config_t* conf, jvxfs_algorithm_profile_t func, size_t size);
+
 JVX_FS_LIB_END
 
 #endif
\ No newline at end of file
@@ -2,16 +2,61 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <math.h>
 #include <string.h>
 #include <switch.h>
+#include "../utils/strbuf.h"
 #include "error.h"
 #include "app.h"
+#include "module.h"
 #include "session.h"
 #include "view_private.h"
 #include "view.h"
 
-static void print_2_human(view_priv_t* hdl, const char* data);
+#define STORAGE_SIZE 2048
+#define MAX_DEPTH 8
+
+typedef struct
+{
+    bool array;
+    bool inArray;
+    bool bracket;
+    bool lines;
+    uint32_t count;
+} level_t;
+
+/* Record being written by a thread, rendered as text and JSON at once while fields are added. */
+typedef struct
+{
+    view_priv_t* owner;
+    bool text;
+    bool json;
+    uint32_t depth;
+    uint32_t skip;
+    level_t levels[MAX_DEPTH];
+    jvxfs_strbuf_t textBuf;
+    jvxfs_strbuf_t jsonBuf;
+    char textStorage[STORAGE_SIZE];
+    char jsonStorage[STORAGE_SIZE];
+} record_t;
+
+typedef struct
+{
+    jvxfs_strbuf_t buf;
+    char storage[STORAGE_SIZE];
+} format_t;
+
+static thread_local record_t record;
+static thread_local format_t format;
+
+static jvxfs_strbuf_t* format_args(const char* fmt, va_list args);
+static record_t* active_record(view_priv_t* hdl);
+static bool add_key(record_t* rec, const char* key);
+static void push_level(record_t* rec, bool array, bool inArray, bool bracket);
+static void print_2_human(view_priv_t* hdl, const char* data, size_t length);
 static switch_status_t print_2_machine(view_priv_t* hdl, const char* data);
+static switch_status_t buffer_write(switch_stream_handle_t* handle, const char* fmt, ...);
+static switch_status_t buffer_raw_write(switch_stream_handle_t* handle, uint8_t* data, switch_size_t datalen);
 
 jvxfs_view_input_t jvxfs_view_get_origin(jvxfs_view_t* view)
 {
@@ -49,13 +94,14 @@ jvxfs_status_t jvxfs_view_write_human_readable(jvxfs_view_t* view, const char* f
 jvxfs_status_t jvxfs_view_vwrite_human_readable(jvxfs_view_t* view, const char* fmt, va_list args)
 {
     view_priv_t* hdl = (view_priv_t*)view;
-    char *data = switch_vmprintf(fmt, args);
+    if (!(hdl->dest & JVXFS_VIEW_OUT_CONSOLE)) return JVXFS_STATUS_SUCCESS;
+    jvxfs_strbuf_t* data = format_args(fmt, args);
     if (!data) {
         return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_VIEW,
             "Could not buffer string.");
     }
-    print_2_human(hdl, data);
-    free(data);
+    print_2_human(hdl, data->data, data->used);
+    jvxfs_strbuf_reset(data);
     return JVXFS_STATUS_SUCCESS;
 }
 
@@ -71,13 +117,14 @@ jvxfs_status_t jvxfs_view_write_machine_readable(jvxfs_view_t* view, const char*
 jvxfs_status_t jvxfs_view_vwrite_machine_readable(jvxfs_view_t* view, const char* fmt, va_list args)
 {
     view_priv_t* hdl = (view_priv_t*)view;
-    char *data = switch_vmprintf(fmt, args);
+    if (!(hdl->dest & JVXFS_VIEW_OUT_EVENT)) return JVXFS_STATUS_SUCCESS;
+    jvxfs_strbuf_t* data = format_args(fmt, args);
     if (!data) {
         return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_VIEW,
             "Could not buffer string.");
     }
-    jvxfs_status_t res = print_2_machine(hdl, data);
-    free(data);
+    jvxfs_status_t res = print_2_machine(hdl, data->data);
+    jvxfs_strbuf_reset(data);
     return res;
 }
 
@@ -93,26 +140,285 @@ jvxfs_status_t jvxfs_view_write_to_all(jvxfs_view_t* view, const char* fmt, ...)
 jvxfs_status_t jvxfs_view_vwrite_to_all(jvxfs_view_t* view, const char* fmt, va_list args)
 {
     view_priv_t* hdl = (view_priv_t*)view;
-    char *data = switch_vmprintf(fmt, args);
+    jvxfs_strbuf_t* data = format_args(fmt, args);
     if (!data) {
         return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_VIEW,
             "Could not buffer string.");
     }
-    print_2_human(hdl, data);
-    jvxfs_status_t res = print_2_machine(hdl, data);
-    free(data);
+    print_2_human(hdl, data->data, data->used);
+    jvxfs_status_t res = print_2_machine(hdl, data->data);
+    jvxfs_strbuf_reset(data);
     return res;
 }
 
+jvxfs_status_t jvxfs_view_begin_record(jvxfs_view_t* view)
+{
+    view_priv_t* hdl = (view_priv_t*)view;
+    record_t* rec = &record;
+    if (rec->owner) {
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_EXISTING, JVXFS_LOG_ERROR, JVXFS_COMP_VIEW,
+            "Record of this thread not ended yet.");
+    }
+    if (!rec->textBuf.storage) {
+        jvxfs_strbuf_init(&rec->textBuf, rec->textStorage, STORAGE_SIZE);
+        jvxfs_strbuf_init(&rec->jsonBuf, rec->jsonStorage, STORAGE_SIZE);
+    }
+    rec->owner = hdl;
+    rec->text = (hdl->dest & JVXFS_VIEW_OUT_CONSOLE) != 0;
+    rec->json = (hdl->dest & JVXFS_VIEW_OUT_EVENT) != 0;
+    rec->depth = 0;
+    rec->skip = 0;
+    rec->levels[0].array = false;
+    rec->levels[0].inArray = false;
+    rec->levels[0].bracket = false;
+    rec->levels[0].lines = false;
+    rec->levels[0].count = 0;
+    if (rec->json) jvxfs_strbuf_append_char(&rec->jsonBuf, '{');
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_view_end_record(jvxfs_view_t* view)
+{
+    view_priv_t* hdl = (view_priv_t*)view;
+    record_t* rec = active_record(hdl);
+    if (!rec) return JVXFS_STATUS_RESOURCE_UNINITIALIZED;
+    rec->owner = NULL;
+    jvxfs_status_t res = JVXFS_STATUS_SUCCESS;
+    if (jvxfs_strbuf_failed(&rec->textBuf) || jvxfs_strbuf_failed(&rec->jsonBuf)) {
+        res = jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_ERROR, JVXFS_COMP_VIEW,
+            "Could not buffer record.");
+    } else {
+        if (rec->text) {
+            jvxfs_strbuf_append_char(&rec->textBuf, '\n');
+            print_2_human(hdl, rec->textBuf.data, rec->textBuf.used);
+        }
+        if (rec->json) {
+            jvxfs_strbuf_append_char(&rec->jsonBuf, '}');
+            res = print_2_machine(hdl, rec->jsonBuf.data);
+        }
+    }
+    jvxfs_strbuf_reset(&rec->textBuf);
+    jvxfs_strbuf_reset(&rec->jsonBuf);
+    return res;
+}
 
-void print_2_human(view_priv_t* hdl, const char* data)
+void jvxfs_view_add_int(jvxfs_view_t* view, const char* key, int64_t value)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec || !add_key(rec, key)) return;
+    if (rec->text) jvxfs_strbuf_printf(&rec->textBuf, "%lld", (long long)value);
+    if (rec->json) jvxfs_strbuf_printf(&rec->jsonBuf, "%lld", (long long)value);
+}
+
+void jvxfs_view_add_uint(jvxfs_view_t* view, const char* key, uint64_t value)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec || !add_key(rec, key)) return;
+    if (rec->text) jvxfs_strbuf_printf(&rec->textBuf, "%llu", (unsigned long long)value);
+    if (rec->json) jvxfs_strbuf_printf(&rec->jsonBuf, "%llu", (unsigned long long)value);
+}
+
+void jvxfs_view_add_float(jvxfs_view_t* view, const char* key, double value, int precision)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec || !add_key(rec, key)) return;
+    if (rec->text) jvxfs_strbuf_printf(&rec->textBuf, "%.*f", precision, value);
+    if (rec->json) {
+        /* JSON knows neither infinity nor NaN. */
+        if (isfinite(value)) {
+            jvxfs_strbuf_printf(&rec->jsonBuf, "%.*f", precision, value);
+        } else {
+            jvxfs_strbuf_append(&rec->jsonBuf, "null", 4);
+        }
+    }
+}
+
+void jvxfs_view_add_string(jvxfs_view_t* view, const char* key, const char* value)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec || !add_key(rec, key)) return;
+    if (!value) value = "";
+    if (rec->text) jvxfs_strbuf_append_str(&rec->textBuf, value);
+    if (rec->json) jvxfs_strbuf_append_json(&rec->jsonBuf, value);
+}
+
+void jvxfs_view_begin_array(jvxfs_view_t* view, const char* key)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec) return;
+    if (rec->skip || rec->depth + 1 >= MAX_DEPTH) {
+        rec->skip++;
+        return;
+    }
+    if (!add_key(rec, NULL)) return;
+    /* add_key() wrote the separator only, arrays are introduced by "key:", nameless ones are bracketed. */
+    bool bracket = !key || rec->levels[rec->depth].array;
+    if (rec->text) {
+        if (bracket) {
+            jvxfs_strbuf_append_char(&rec->textBuf, '[');
+        } else {
+            jvxfs_strbuf_append_str(&rec->textBuf, key);
+            jvxfs_strbuf_append_char(&rec->textBuf, ':');
+        }
+    }
+    if (rec->json) {
+        if (key && !rec->levels[rec->depth].array) {
+            jvxfs_strbuf_append_json(&rec->jsonBuf, key);
+            jvxfs_strbuf_append_char(&rec->jsonBuf, ':');
+        }
+        jvxfs_strbuf_append_char(&rec->jsonBuf, '[');
+    }
+    push_level(rec, true, false, bracket);
+}
+
+void jvxfs_view_end_array(jvxfs_view_t* view)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec) return;
+    if (rec->skip) {
+        rec->skip--;
+        return;
+    }
+    if (rec->depth == 0 || !rec->levels[rec->depth].array) return;
+    if (rec->text && rec->levels[rec->depth].bracket) jvxfs_strbuf_append_char(&rec->textBuf, ']');
+    if (rec->json) jvxfs_strbuf_append_char(&rec->jsonBuf, ']');
+    bool lines = rec->levels[rec->depth].lines;
+    rec->depth--;
+    /* Whatever follows a list of lines starts on a new line. */
+    if (lines) rec->levels[rec->depth].lines = true;
+}
+
+void jvxfs_view_begin_object(jvxfs_view_t* view, const char* key)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec) return;
+    if (rec->skip || rec->depth + 1 >= MAX_DEPTH) {
+        rec->skip++;
+        return;
+    }
+    bool inArray = rec->levels[rec->depth].array;
+    if (inArray) {
+        /* Objects of an array are listed one per line in text. */
+        level_t* level = &rec->levels[rec->depth];
+        if (rec->text) {
+            jvxfs_strbuf_append_char(&rec->textBuf, '\n');
+            for (uint32_t i = 0; i < rec->depth; ++i) jvxfs_strbuf_append(&rec->textBuf, "  ", 2);
+        }
+        if (rec->json && level->count) jvxfs_strbuf_append_char(&rec->jsonBuf, ',');
+        level->count++;
+        level->lines = true;
+    } else {
+        if (!add_key(rec, key)) return;
+        if (rec->text) jvxfs_strbuf_append(&rec->textBuf, "{", 1);
+    }
+    if (rec->json) jvxfs_strbuf_append_char(&rec->jsonBuf, '{');
+    push_level(rec, false, inArray, false);
+}
+
+void jvxfs_view_end_object(jvxfs_view_t* view)
+{
+    record_t* rec = active_record((view_priv_t*)view);
+    if (!rec) return;
+    if (rec->skip) {
+        rec->skip--;
+        return;
+    }
+    if (rec->depth == 0 || rec->levels[rec->depth].array) return;
+    if (rec->text && !rec->levels[rec->depth].inArray) jvxfs_strbuf_append_char(&rec->textBuf, '}');
+    if (rec->json) jvxfs_strbuf_append_char(&rec->jsonBuf, '}');
+    bool lines = rec->levels[rec->depth].lines && !rec->levels[rec->depth].inArray;
+    rec->depth--;
+    if (lines) rec->levels[rec->depth].lines = true;
+}
+
+void jvxfs_view_buffer_init(view_buffer_t* buf)
+{
+    memset(buf, 0, sizeof(view_buffer_t));
+    buf->stream.write_function = buffer_write;
+    buf->stream.raw_write_function = buffer_raw_write;
+}
+
+void jvxfs_view_buffer_flush(view_buffer_t* buf, switch_stream_handle_t* dest)
+{
+    if (dest && buf->used) dest->raw_write_function(dest, (uint8_t*)buf->data, buf->used);
+    free(buf->data);
+    buf->data = NULL;
+    buf->used = 0;
+    buf->size = 0;
+}
+
+
+jvxfs_strbuf_t* format_args(const char* fmt, va_list args)
+{
+    jvxfs_strbuf_t* buf = &format.buf;
+    if (!buf->storage) jvxfs_strbuf_init(buf, format.storage, STORAGE_SIZE);
+    jvxfs_strbuf_vprintf(buf, fmt, args);
+    if (jvxfs_strbuf_failed(buf)) {
+        jvxfs_strbuf_reset(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+record_t* active_record(view_priv_t* hdl)
+{
+    return (record.owner == hdl) ? &record : NULL;
+}
+
+bool add_key(record_t* rec, const char* key)
+{
+    if (rec->skip) return false;
+    level_t* level = &rec->levels[rec->depth];
+    if (rec->text) {
+        if (level->array) {
+            if (level->count) {
+                jvxfs_strbuf_append(&rec->textBuf, ", ", 2);
+            } else if (!level->bracket) {
+                jvxfs_strbuf_append_char(&rec->textBuf, ' ');
+            }
+        } else {
+            if (level->count && level->lines) {
+                jvxfs_strbuf_append_char(&rec->textBuf, '\n');
+                for (uint32_t i = 0; i < rec->depth; ++i) jvxfs_strbuf_append(&rec->textBuf, "  ", 2);
+                level->lines = false;
+            } else if (level->count) {
+                jvxfs_strbuf_append(&rec->textBuf, ", ", 2);
+            }
+            if (key) {
+                jvxfs_strbuf_append_str(&rec->textBuf, key);
+                jvxfs_strbuf_append_char(&rec->textBuf, ' ');
+            }
+        }
+    }
+    if (rec->json) {
+        if (level->count) jvxfs_strbuf_append_char(&rec->jsonBuf, ',');
+        if (key && !level->array) {
+            jvxfs_strbuf_append_json(&rec->jsonBuf, key);
+            jvxfs_strbuf_append_char(&rec->jsonBuf, ':');
+        }
+    }
+    level->count++;
+    return true;
+}
+
+void push_level(record_t* rec, bool array, bool inArray, bool bracket)
+{
+    level_t* level = &rec->levels[++rec->depth];
+    level->array = array;
+    level->inArray = inArray;
+    level->bracket = bracket;
+    level->lines = false;
+    level->count = 0;
+}
+
+void print_2_human(view_priv_t* hdl, const char* data, size_t length)
 {
     jvxfs_view_multi_output_t dest = jvxfs_view_get_destinations(hdl);
     if (dest & JVXFS_VIEW_OUT_CONSOLE) {
         if (hdl->console) {
-            hdl->console->raw_write_function(hdl->console, (uint8_t*)data, strlen(data));
+            hdl->console->raw_write_function(hdl->console, (uint8_t*)data, length);
         } else {
-            switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, data);
+            switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "%.*s", (int)length, data);
         }
     }
 }
@@ -121,6 +427,13 @@ switch_status_t print_2_machine(view_priv_t* hdl, const char* data)
 {
     jvxfs_view_multi_output_t dest = jvxfs_view_get_destinations(hdl);
     if (dest & JVXFS_VIEW_OUT_EVENT) {
+        jvxfs_emitter_t* emitter = jvxfs_module_get_emitter(jvxfs_app_get_module(hdl->data->app));
+        if (emitter) {
+            /* Dropped messages are counted by the emitter, the caller must not wait for the event system. */
+            jvxfs_emitter_push(emitter, jvxfs_app_get_name(hdl->data->app), hdl->data->session, hdl->data->directive,
+                data);
+            return JVXFS_STATUS_SUCCESS;
+        }
         switch_event_t* event;
 		switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "jvxfsFramework");
 		switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Protocol", "1.0");
@@ -141,4 +454,32 @@ switch_status_t print_2_machine(view_priv_t* hdl, const char* data)
         }
     }
     return JVXFS_STATUS_SUCCESS;
+}
+
+switch_status_t buffer_write(switch_stream_handle_t* handle, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    char* data = switch_vmprintf(fmt, args);
+    va_end(args);
+    if (!data) return SWITCH_STATUS_FALSE;
+    switch_status_t res = buffer_raw_write(handle, (uint8_t*)data, strlen(data));
+    free(data);
+    return res;
+}
+
+switch_status_t buffer_raw_write(switch_stream_handle_t* handle, uint8_t* data, switch_size_t datalen)
+{
+    view_buffer_t* buf = (view_buffer_t*)handle;
+    if (buf->used + datalen > buf->size) {
+        size_t size = buf->size ? buf->size : 1024;
+        while (size < buf->used + datalen) size *= 2;
+        char* grown = (char*)realloc(buf->data, size);
+        if (!grown) return SWITCH_STATUS_FALSE;
+        buf->data = grown;
+        buf->size = size;
+    }
+    memcpy(buf->data + buf->used, data, datalen);
+    buf->used += datalen;
+    return SWITCH_STATUS_SUCCESS;
 }
\ No newline at end of file
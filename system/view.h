@@ -51,6 +51,30 @@ jvxfs_status_t jvxfs_view_vwrite_machine_readable(jvxfs_view_t* view, const char
 jvxfs_status_t jvxfs_view_write_to_all(jvxfs_view_t* view, const char* fmt, ...);
 jvxfs_status_t jvxfs_view_vwrite_to_all(jvxfs_view_t* view, const char* fmt, va_list args);
 
+/**
+ * @brief Start a record of typed fields.
+ * @details Fields are rendered into buffers of the calling thread while they are added, as text for the console
+ * and as JSON object for events, and written once by jvxfs_view_end_record(). The buffers only allocate memory
+ * if a record outgrows them. One record per thread can be open at a time. Arrays and objects nest up to
+ * 7 levels, deeper ones are left out.
+ */
+jvxfs_status_t jvxfs_view_begin_record(jvxfs_view_t* view);
+jvxfs_status_t jvxfs_view_end_record(jvxfs_view_t* view);
+
+void jvxfs_view_add_int(jvxfs_view_t* view, const char* key, int64_t value);
+void jvxfs_view_add_uint(jvxfs_view_t* view, const char* key, uint64_t value);
+void jvxfs_view_add_float(jvxfs_view_t* view, const char* key, double value, int precision);
+void jvxfs_view_add_string(jvxfs_view_t* view, const char* key, const char* value);
+
+/**
+ * @brief Start an array, @a key is ignored for values of arrays and so are the keys of its values.
+ * @details In text, the values of an array follow its key, objects of an array are listed one per line.
+ */
+void jvxfs_view_begin_array(jvxfs_view_t* view, const char* key);
+void jvxfs_view_end_array(jvxfs_view_t* view);
+void jvxfs_view_begin_object(jvxfs_view_t* view, const char* key);
+void jvxfs_view_end_object(jvxfs_view_t* view);
+
 JVX_FS_LIB_END
 
 #endif
\ No newline at end of file
@@ -28,6 +28,18 @@ typedef struct
     switch_stream_handle_t* console;
 } view_priv_t;
 
+/* Console output collected in memory, for directives running on several threads at once. */
+typedef struct
+{
+    switch_stream_handle_t stream;
+    char* data;
+    size_t used;
+    size_t size;
+} view_buffer_t;
+
+void jvxfs_view_buffer_init(view_buffer_t* buf);
+void jvxfs_view_buffer_flush(view_buffer_t* buf, switch_stream_handle_t* dest);
+
 JVX_FS_LIB_END
 
 #endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <string.h>
+#include "../system/error.h"
+#include "arena.h"
+
+#define ALIGN_UP(_n) (((_n) + JVXFS_ARENA_ALIGNMENT - 1) & ~((size_t)JVXFS_ARENA_ALIGNMENT - 1))
+
+#ifndef NDEBUG
+/* Every allocation is preceded by a header holding its size and followed by a canary. */
+#define HEADER_SIZE JVXFS_ARENA_ALIGNMENT
+#define CANARY_SIZE sizeof(uint64_t)
+#define CANARY 0xDEADC0DEFEEDFACEull
+/* An allocation of at least one alignment unit grows by the header and at most one unit for the canary,
+ * an arena of n units holds at most n such allocations. */
+#define DEBUG_RESERVE(_size) ((_size) / JVXFS_ARENA_ALIGNMENT * (HEADER_SIZE + ALIGN_UP(CANARY_SIZE)))
+#else
+#define HEADER_SIZE 0
+#define CANARY_SIZE 0
+#define DEBUG_RESERVE(_size) 0
+#endif
+
+typedef struct
+{
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    size_t capacity;
+    size_t nominal;
+    size_t highWater;
+    uint64_t failures;
+    jvxfs_error_t* err;
+} arena_t;
+
+#ifndef NDEBUG
+static void check_canaries(arena_t* hdl);
+#endif
+
+
+jvxfs_status_t jvxfs_arena_create(jvxfs_arena_t** obj, size_t size, jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create scratch arena.";
+    arena_t* hdl = (arena_t*)switch_core_alloc(pool, sizeof(arena_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_ARENA, error);
+    }
+    hdl->size = ALIGN_UP(size);
+    hdl->capacity = hdl->size + DEBUG_RESERVE(hdl->size);
+    uint8_t* mem = (uint8_t*)switch_core_alloc(pool, hdl->capacity + JVXFS_ARENA_ALIGNMENT);
+    if (!mem) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_ARENA, error);
+    }
+    hdl->base = (uint8_t*)ALIGN_UP((uintptr_t)mem);
+    hdl->used = 0;
+    hdl->nominal = 0;
+    hdl->highWater = 0;
+    hdl->failures = 0;
+    hdl->err = err;
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void* jvxfs_arena_alloc(jvxfs_arena_t* obj, size_t size)
+{
+    arena_t* hdl = (arena_t*)obj;
+    size_t need = ALIGN_UP(HEADER_SIZE + size + CANARY_SIZE);
+    /* Debug builds fail exactly where release builds do, the checks only use the reserve. */
+    if (ALIGN_UP(size) > hdl->size - hdl->nominal || need > hdl->capacity - hdl->used) {
+        ++(hdl->failures);
+        return NULL;
+    }
+    uint8_t* ptr = hdl->base + hdl->used + HEADER_SIZE;
+#ifndef NDEBUG
+    uint64_t canary = CANARY;
+    memcpy(ptr - HEADER_SIZE, &size, sizeof(size_t));
+    memcpy(ptr + size, &canary, CANARY_SIZE);
+#endif
+    hdl->used += need;
+    hdl->nominal += ALIGN_UP(size);
+    return ptr;
+}
+
+void jvxfs_arena_reset(jvxfs_arena_t* obj)
+{
+    arena_t* hdl = (arena_t*)obj;
+#ifndef NDEBUG
+    check_canaries(hdl);
+#endif
+    if (hdl->nominal > hdl->highWater) hdl->highWater = hdl->nominal;
+    hdl->used = 0;
+    hdl->nominal = 0;
+}
+
+size_t jvxfs_arena_get_size(jvxfs_arena_t* obj)
+{
+    arena_t* hdl = (arena_t*)obj;
+    return hdl->size;
+}
+
+size_t jvxfs_arena_get_high_water(jvxfs_arena_t* obj)
+{
+    arena_t* hdl = (arena_t*)obj;
+    return (hdl->nominal > hdl->highWater) ? hdl->nominal : hdl->highWater;
+}
+
+uint64_t jvxfs_arena_count_failures(jvxfs_arena_t* obj)
+{
+    arena_t* hdl = (arena_t*)obj;
+    return hdl->failures;
+}
+
+
+#ifndef NDEBUG
+void check_canaries(arena_t* hdl)
+{
+    size_t offset = 0;
+    while (offset < hdl->used) {
+        size_t size;
+        uint64_t canary;
+        memcpy(&size, hdl->base + offset, sizeof(size_t));
+        if (size > hdl->used - offset - HEADER_SIZE - CANARY_SIZE) break;
+        memcpy(&canary, hdl->base + offset + HEADER_SIZE + size, CANARY_SIZE);
+        if (canary != CANARY) break;
+        offset += ALIGN_UP(HEADER_SIZE + size + CANARY_SIZE);
+    }
+    if (offset != hdl->used) {
+        jvxfs_error_set_error(hdl->err, JVXFS_STATUS_OUT_OF_BOUNDS, JVXFS_LOG_CRITICAL, JVXFS_COMP_ARENA,
+            "Scratch memory was written beyond its allocation.");
+    }
+}
+#endif
@@ -0,0 +1,87 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file arena.h
+ * @brief Bump allocator for scratch memory of a single frame.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-18
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_UTILS_ARENA_H
+#define LIB_JVX_FS_FRAMEWORK_UTILS_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <switch.h>
+#include "../system/defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup utils Utilities
+ * @{
+ * @defgroup arena Scratch Arena
+ * @details The arena is allocated once. Allocations only move an offset forward and are all released
+ * at once by jvxfs_arena_reset(), so allocating never takes a lock or calls the heap. The arena is not
+ * threadsafe, it belongs to the thread processing a frame.
+ * Unless @em NDEBUG is defined, every allocation is followed by a canary which is checked on reset,
+ * writing beyond an allocation is reported to the error handler. The room for the canaries is reserved on top
+ * of the size, so both builds fail the same allocations and report the same high water mark.
+ * @{
+ */
+
+#define JVXFS_ARENA_ALIGNMENT 64
+
+/**
+ * @brief Handle type of an arena.
+ */
+typedef void jvxfs_arena_t;
+
+/**
+ * @brief Create an arena.
+ * @param[out] obj  Handle of arena.
+ * @param[in] size  Number of bytes available per frame.
+ * @param[in] err   Error handler of the owner.
+ * @param[in] pool  Memory pool of the owner.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_arena_create(jvxfs_arena_t** obj, size_t size, jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Allocate scratch memory.
+ * @param[in] obj   Handle of arena.
+ * @param[in] size  Number of bytes.
+ * @return Memory aligned to #JVXFS_ARENA_ALIGNMENT bytes, valid until the next reset, or @em NULL
+ * if the arena is exhausted.
+ */
+void* jvxfs_arena_alloc(jvxfs_arena_t* obj, size_t size);
+
+/**
+ * @brief Release all allocations, called by the framework at every frame boundary.
+ */
+void jvxfs_arena_reset(jvxfs_arena_t* obj);
+
+size_t jvxfs_arena_get_size(jvxfs_arena_t* obj);
+
+/**
+ * @brief Largest number of bytes used within one frame so far.
+ */
+size_t jvxfs_arena_get_high_water(jvxfs_arena_t* obj);
+
+/**
+ * @brief Number of allocations which failed because the arena was exhausted.
+ */
+uint64_t jvxfs_arena_count_failures(jvxfs_arena_t* obj);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
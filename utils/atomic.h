@@ -0,0 +1,70 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file atomic.h
+ * @brief Atomic operations and memory ordering helpers for lock-free modules.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-12
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_UTILS_ATOMIC_H
+#define LIB_JVX_FS_FRAMEWORK_UTILS_ATOMIC_H
+
+#include <stdbool.h>
+
+/**
+ * @addtogroup utils Utilities
+ * @{
+ * @defgroup atomic Atomic Operations
+ * @details Thin wrappers around the compiler's atomic builtins. Freeswitch's switch_atomic_t
+ * only offers 32 bit counters, these macros work on any naturally aligned integer or pointer.
+ * Loads use acquire, stores use release and read-modify-write operations use acquire-release
+ * semantics unless the name says otherwise.
+ * @{
+ */
+
+/**
+ * @brief Size of a cache line, used to separate data written by different threads.
+ */
+#define JVXFS_CACHE_LINE_SIZE 64
+
+#if defined __GNUC__ || defined __clang__
+
+#define JVXFS_CACHE_ALIGNED __attribute__((aligned(JVXFS_CACHE_LINE_SIZE)))
+
+#define jvxfs_atomic_load(_ptr) __atomic_load_n(_ptr, __ATOMIC_ACQUIRE)
+#define jvxfs_atomic_load_relaxed(_ptr) __atomic_load_n(_ptr, __ATOMIC_RELAXED)
+#define jvxfs_atomic_store(_ptr, _val) __atomic_store_n(_ptr, _val, __ATOMIC_RELEASE)
+#define jvxfs_atomic_store_relaxed(_ptr, _val) __atomic_store_n(_ptr, _val, __ATOMIC_RELAXED)
+#define jvxfs_atomic_exchange(_ptr, _val) __atomic_exchange_n(_ptr, _val, __ATOMIC_ACQ_REL)
+#define jvxfs_atomic_cas(_ptr, _expected, _val) \
+    __atomic_compare_exchange_n(_ptr, _expected, _val, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define jvxfs_atomic_cas_weak_relaxed(_ptr, _expected, _val) \
+    __atomic_compare_exchange_n(_ptr, _expected, _val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define jvxfs_atomic_fetch_add(_ptr, _val) __atomic_fetch_add(_ptr, _val, __ATOMIC_ACQ_REL)
+#define jvxfs_atomic_fetch_add_relaxed(_ptr, _val) __atomic_fetch_add(_ptr, _val, __ATOMIC_RELAXED)
+#define jvxfs_atomic_fetch_sub(_ptr, _val) __atomic_fetch_sub(_ptr, _val, __ATOMIC_ACQ_REL)
+#define jvxfs_atomic_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define jvxfs_atomic_fence_acquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define jvxfs_atomic_fence_release() __atomic_thread_fence(__ATOMIC_RELEASE)
+
+#if defined __x86_64__ || defined __i386__
+#define jvxfs_cpu_relax() __builtin_ia32_pause()
+#else
+#define jvxfs_cpu_relax() ((void)0)
+#endif
+
+#else
+#error "jvxfsFramework needs a compiler providing __atomic builtins (gcc or clang)."
+#endif
+
+/**
+ * @}
+ * @}
+ */
+
+#endif
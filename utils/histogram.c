@@ -0,0 +1,146 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <math.h>
+#include <string.h>
+#include "../system/error.h"
+#include "atomic.h"
+#include "histogram.h"
+
+typedef struct
+{
+    uint64_t buckets[JVXFS_HISTOGRAM_BUCKETS];
+    uint64_t counters[JVXFS_HISTOGRAM_COUNTERS];
+    uint64_t sum;
+    uint64_t max;
+} JVXFS_CACHE_ALIGNED shard_t;
+
+typedef struct
+{
+    shard_t* shards;
+    uint32_t count;
+} histogram_t;
+
+static shard_t* get_shard(histogram_t* hdl);
+static uint32_t bucket_index(uint32_t value);
+static uint64_t bucket_upper(uint32_t index);
+
+
+jvxfs_status_t jvxfs_histogram_create(jvxfs_histogram_t** obj, uint32_t shards, jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create histogram.";
+    if (shards == 0) {
+        int32_t cpus = switch_core_cpu_count();
+        shards = (cpus > 0) ? (uint32_t)cpus : 1;
+    }
+    histogram_t* hdl = (histogram_t*)switch_core_alloc(pool, sizeof(histogram_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_HISTOGRAM, error);
+    }
+    uint8_t* mem = (uint8_t*)switch_core_alloc(pool, sizeof(shard_t) * shards + JVXFS_CACHE_LINE_SIZE);
+    if (!mem) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_HISTOGRAM, error);
+    }
+    hdl->shards = (shard_t*)(((uintptr_t)mem + JVXFS_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(JVXFS_CACHE_LINE_SIZE - 1));
+    hdl->count = shards;
+    jvxfs_histogram_reset(hdl);
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_histogram_record(jvxfs_histogram_t* obj, uint64_t value)
+{
+    histogram_t* hdl = (histogram_t*)obj;
+    shard_t* shard = get_shard(hdl);
+    uint32_t v = (value < UINT32_MAX) ? (uint32_t)value : UINT32_MAX;
+    jvxfs_atomic_fetch_add_relaxed(&shard->buckets[bucket_index(v)], 1);
+    jvxfs_atomic_fetch_add_relaxed(&shard->sum, v);
+    uint64_t max = jvxfs_atomic_load_relaxed(&shard->max);
+    while (v > max && !jvxfs_atomic_cas_weak_relaxed(&shard->max, &max, v)) {}
+}
+
+void jvxfs_histogram_count(jvxfs_histogram_t* obj, uint32_t index, uint64_t n)
+{
+    histogram_t* hdl = (histogram_t*)obj;
+    if (index >= JVXFS_HISTOGRAM_COUNTERS) return;
+    jvxfs_atomic_fetch_add_relaxed(&get_shard(hdl)->counters[index], n);
+}
+
+void jvxfs_histogram_read(jvxfs_histogram_t* obj, jvxfs_histogram_snapshot_t* out)
+{
+    histogram_t* hdl = (histogram_t*)obj;
+    memset(out, 0, sizeof(jvxfs_histogram_snapshot_t));
+    for (uint32_t s = 0; s < hdl->count; ++s) {
+        shard_t* shard = &hdl->shards[s];
+        for (uint32_t i = 0; i < JVXFS_HISTOGRAM_BUCKETS; ++i) {
+            out->buckets[i] += jvxfs_atomic_load_relaxed(&shard->buckets[i]);
+        }
+        for (uint32_t i = 0; i < JVXFS_HISTOGRAM_COUNTERS; ++i) {
+            out->counters[i] += jvxfs_atomic_load_relaxed(&shard->counters[i]);
+        }
+        out->sum += jvxfs_atomic_load_relaxed(&shard->sum);
+        uint64_t max = jvxfs_atomic_load_relaxed(&shard->max);
+        if (max > out->max) out->max = max;
+    }
+    /* Counted from the buckets, so percentiles stay consistent with a concurrent recording. */
+    for (uint32_t i = 0; i < JVXFS_HISTOGRAM_BUCKETS; ++i) out->total += out->buckets[i];
+}
+
+void jvxfs_histogram_reset(jvxfs_histogram_t* obj)
+{
+    histogram_t* hdl = (histogram_t*)obj;
+    for (uint32_t s = 0; s < hdl->count; ++s) {
+        shard_t* shard = &hdl->shards[s];
+        for (uint32_t i = 0; i < JVXFS_HISTOGRAM_BUCKETS; ++i) jvxfs_atomic_store(&shard->buckets[i], 0);
+        for (uint32_t i = 0; i < JVXFS_HISTOGRAM_COUNTERS; ++i) jvxfs_atomic_store(&shard->counters[i], 0);
+        jvxfs_atomic_store(&shard->sum, 0);
+        jvxfs_atomic_store(&shard->max, 0);
+    }
+}
+
+uint64_t jvxfs_histogram_percentile(const jvxfs_histogram_snapshot_t* snap, double percent)
+{
+    if (snap->total == 0) return 0;
+    if (percent < 0.0) percent = 0.0;
+    if (percent > 100.0) percent = 100.0;
+    uint64_t rank = (uint64_t)ceil(percent / 100.0 * (double)snap->total);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < JVXFS_HISTOGRAM_BUCKETS; ++i) {
+        seen += snap->buckets[i];
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            return (upper < snap->max) ? upper : snap->max;
+        }
+    }
+    return snap->max;
+}
+
+
+shard_t* get_shard(histogram_t* hdl)
+{
+    if (hdl->count == 1) return hdl->shards;
+    /* Thread ids are aligned addresses on most platforms, the low bits carry no information. */
+    uint64_t id = (uint64_t)(uintptr_t)switch_thread_self();
+    id ^= id >> 12;
+    id *= 0x9E3779B97F4A7C15ull;
+    return &hdl->shards[(id >> 32) % hdl->count];
+}
+
+uint32_t bucket_index(uint32_t value)
+{
+    if (value < JVXFS_HISTOGRAM_SUB_BUCKETS) return value;
+    uint32_t msb = 31 - (uint32_t)__builtin_clz(value);
+    uint32_t shift = msb - JVXFS_HISTOGRAM_SUB_BITS;
+    return (shift + 1) * JVXFS_HISTOGRAM_SUB_BUCKETS + ((value >> shift) - JVXFS_HISTOGRAM_SUB_BUCKETS);
+}
+
+uint64_t bucket_upper(uint32_t index)
+{
+    if (index < JVXFS_HISTOGRAM_SUB_BUCKETS) return index;
+    uint32_t shift = index / JVXFS_HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(JVXFS_HISTOGRAM_SUB_BUCKETS + index % JVXFS_HISTOGRAM_SUB_BUCKETS) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
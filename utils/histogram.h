@@ -0,0 +1,102 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file histogram.h
+ * @brief Log bucketed histogram with counters, sharded per thread.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-20
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_UTILS_HISTOGRAM_H
+#define LIB_JVX_FS_FRAMEWORK_UTILS_HISTOGRAM_H
+
+#include <stdint.h>
+#include <switch.h>
+#include "../system/defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup utils Utilities
+ * @{
+ * @defgroup histogram Histogram
+ * @details Values are sorted into buckets whose width doubles every #JVXFS_HISTOGRAM_SUB_BUCKETS buckets,
+ * so every bucket is at most 1 / #JVXFS_HISTOGRAM_SUB_BUCKETS of its value wide, independent of the
+ * magnitude. Recording takes a few relaxed atomic additions and no lock. Every thread records into one
+ * of several shards chosen by its id, so threads recording at the same time do not share cache lines.
+ * Reading sums up all shards and may miss values recorded meanwhile.
+ * @{
+ */
+
+#define JVXFS_HISTOGRAM_SUB_BITS 4
+#define JVXFS_HISTOGRAM_SUB_BUCKETS (1 << JVXFS_HISTOGRAM_SUB_BITS)
+#define JVXFS_HISTOGRAM_BUCKETS ((32 - JVXFS_HISTOGRAM_SUB_BITS + 1) * JVXFS_HISTOGRAM_SUB_BUCKETS)
+#define JVXFS_HISTOGRAM_COUNTERS 4
+
+/**
+ * @brief Handle type of a histogram.
+ */
+typedef void jvxfs_histogram_t;
+
+/**
+ * @brief Summed up content of a histogram.
+ */
+typedef struct
+{
+    uint64_t buckets[JVXFS_HISTOGRAM_BUCKETS];
+    uint64_t counters[JVXFS_HISTOGRAM_COUNTERS];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t max;
+} jvxfs_histogram_snapshot_t;
+
+/**
+ * @brief Create a histogram.
+ * @param[out] obj    Handle of histogram.
+ * @param[in] shards  Number of shards, 0 uses the number of CPUs. A histogram written by a single thread needs 1.
+ * @param[in] err     Error handler of the owner.
+ * @param[in] pool    Memory pool of the owner.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_histogram_create(jvxfs_histogram_t** obj, uint32_t shards, jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Record a value, values above @em UINT32_MAX are counted as @em UINT32_MAX.
+ */
+void jvxfs_histogram_record(jvxfs_histogram_t* obj, uint64_t value);
+
+/**
+ * @brief Add @a n to the counter @a index, below #JVXFS_HISTOGRAM_COUNTERS.
+ */
+void jvxfs_histogram_count(jvxfs_histogram_t* obj, uint32_t index, uint64_t n);
+
+/**
+ * @brief Sum up all shards.
+ * @param[in] obj   Handle of histogram.
+ * @param[out] out  Content of the histogram.
+ */
+void jvxfs_histogram_read(jvxfs_histogram_t* obj, jvxfs_histogram_snapshot_t* out);
+
+/**
+ * @brief Set all buckets and counters to zero.
+ */
+void jvxfs_histogram_reset(jvxfs_histogram_t* obj);
+
+/**
+ * @brief Value below which @a percent percent of the recorded values are.
+ * @return Upper bound of the bucket holding the value, 0 if nothing was recorded.
+ */
+uint64_t jvxfs_histogram_percentile(const jvxfs_histogram_snapshot_t* snap, double percent);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
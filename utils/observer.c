@@ -1,9 +1,10 @@
 /* This Source Code Form is subject to the terms of the Mozilla Public
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
- 
+
 #include <stdlib.h>
 #include "../system/error.h"
+#include "atomic.h"
 #include "observer.h"
 
 typedef struct
@@ -12,16 +13,41 @@ typedef struct
     void* data;
 } callback_t;
 
+#define MIN_CAPACITY 4
+
+/* Immutable while published, changes always publish another copy. Readers may still increment the count of
+ * a snapshot they loaded just before it was replaced, so snapshots are recycled and only freed on destroy. */
+typedef struct snapshot_s
+{
+    struct snapshot_s* next;
+    uint32_t readers;
+    size_t capacity;
+    size_t used;
+    callback_t observer[];
+} snapshot_t;
+
 typedef struct
 {
     jvxfs_error_t* err;
-    size_t size;
-    size_t used;
-    callback_t* observer;
+    snapshot_t* current;
+    snapshot_t* retired;
+    snapshot_t* spare;
+    uint32_t pending;
+    uint32_t tasks;
+    jvxfs_worker_task_t task;
     jvxfs_observable_t* observerable;
-    switch_thread_rwlock_t* lock;
+    switch_mutex_t* lock;
 } obs_t;
 
+static jvxfs_status_t publish(obs_t* hdl, snapshot_t* next);
+static snapshot_t* create_snapshot(obs_t* hdl, size_t used);
+static void reclaim(obs_t* hdl);
+static void free_list(snapshot_t* snap);
+static snapshot_t* acquire(obs_t* hdl);
+static void release(snapshot_t* snap);
+static void notify_task(void* data);
+static void call_observers(obs_t* hdl);
+
 jvxfs_status_t jvxfs_observer_create(jvxfs_observer_handle_t** obs, jvxfs_observable_t* obj, jvxfs_error_t* err, switch_memory_pool_t* pool)
 {
     *obs = NULL;
@@ -30,16 +56,20 @@ jvxfs_status_t jvxfs_observer_create(jvxfs_observer_handle_t** obs, jvxfs_observ
         return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
             "Could not create observerable object.");
     }
-    switch_status_t res = switch_thread_rwlock_create(&hdl->lock, pool);
+    switch_status_t res = switch_mutex_init(&hdl->lock, SWITCH_MUTEX_NESTED, pool);
     if (res != SWITCH_STATUS_SUCCESS) {
         return jvxfs_error_set_error(err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
-            "Could not create rwlock.");
+            "Could not create mutex.");
     }
     hdl->err = err;
-    hdl->used = 0;
+    hdl->current = NULL;
+    hdl->retired = NULL;
+    hdl->spare = NULL;
+    hdl->pending = 0;
+    hdl->tasks = 0;
+    hdl->task.func = notify_task;
+    hdl->task.data = hdl;
     hdl->observerable = obj;
-    hdl->observer = NULL;
-    hdl->size = 0;
     *obs = hdl;
     return JVXFS_STATUS_SUCCESS;
 }
@@ -47,10 +77,18 @@ jvxfs_status_t jvxfs_observer_create(jvxfs_observer_handle_t** obs, jvxfs_observ
 jvxfs_status_t jvxfs_observer_destroy(jvxfs_observer_handle_t** obs)
 {
     obs_t* hdl = (obs_t*)*obs;
-    if (hdl->observer) free(hdl->observer);
-    hdl->size = 0;
-    hdl->used = 0;
-    switch_thread_rwlock_destroy(hdl->lock);
+    while (jvxfs_atomic_load(&hdl->pending)) switch_yield(1000);
+    while (jvxfs_atomic_load(&hdl->tasks)) switch_yield(1000);
+    switch_mutex_lock(hdl->lock);
+    publish(hdl, NULL);
+    while (hdl->retired) {
+        jvxfs_cpu_relax();
+        reclaim(hdl);
+    }
+    free_list(hdl->spare);
+    hdl->spare = NULL;
+    switch_mutex_unlock(hdl->lock);
+    switch_mutex_destroy(hdl->lock);
     *obs = NULL;
     return JVXFS_STATUS_SUCCESS;
 }
@@ -58,95 +96,191 @@ jvxfs_status_t jvxfs_observer_destroy(jvxfs_observer_handle_t** obs)
 jvxfs_status_t jvxfs_observer_add(jvxfs_observer_handle_t* obs, jvxfs_observer_t func, void* data)
 {
     obs_t* hdl = (obs_t*)obs;
-    switch_status_t res = switch_thread_rwlock_wrlock(hdl->lock);
-    if (res != SWITCH_STATUS_SUCCESS) {
-        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
-            "Could not activate rwlock.");
+    switch_mutex_lock(hdl->lock);
+    snapshot_t* prev = jvxfs_atomic_load_relaxed(&hdl->current);
+    size_t used = prev ? prev->used : 0;
+    snapshot_t* next = create_snapshot(hdl, used + 1);
+    if (!next) {
+        switch_mutex_unlock(hdl->lock);
+        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
+            "Could not add observer.");
     }
-    if (hdl->used == hdl->size) {
-        void* new = realloc(hdl->observer, sizeof(callback_t) * (hdl->size + 2));
-        if (!new) {
-            return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
-                "Could not add observer.");
-        }
-        hdl->observer = new;
-        hdl->size = hdl->size + 2;
-    }
-    hdl->observer[hdl->used].func = func;
-    hdl->observer[hdl->used].data = data;
-    ++(hdl->used);
-    switch_thread_rwlock_unlock(hdl->lock);
-    return JVXFS_STATUS_SUCCESS;
+    for (size_t i = 0; i < used; ++i) next->observer[i] = prev->observer[i];
+    next->observer[used].func = func;
+    next->observer[used].data = data;
+    jvxfs_status_t res = publish(hdl, next);
+    switch_mutex_unlock(hdl->lock);
+    return res;
 }
 
 jvxfs_status_t jvxfs_observer_remove(jvxfs_observer_handle_t* obs, jvxfs_observer_t func)
 {
     obs_t* hdl = (obs_t*)obs;
-    bool wasFound = false;
-    size_t i = 0;
-    switch_status_t res = switch_thread_rwlock_wrlock(hdl->lock);
-    if (res != SWITCH_STATUS_SUCCESS) {
-        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
-            "Could not activate rwlock.");
-    }
-    for (i = 0; i < hdl->used; ++i) {
-        if (hdl->observer[i].func == func) {
-            wasFound = true;
-        } else if (wasFound) {
-            hdl->observer[i-1] = hdl->observer[i];
+    switch_mutex_lock(hdl->lock);
+    snapshot_t* prev = jvxfs_atomic_load_relaxed(&hdl->current);
+    size_t found = prev ? prev->used : 0;
+    for (size_t i = 0; prev && i < prev->used; ++i) {
+        if (prev->observer[i].func == func) {
+            found = i;
+            break;
         }
     }
-    if (wasFound) {
-        hdl->observer[i-1].func = NULL;
-        hdl->observer[i-1].data = NULL;
-        --(hdl->used);
+    if (!prev || found == prev->used) {
+        switch_mutex_unlock(hdl->lock);
+        return JVXFS_STATUS_SUCCESS;
     }
-    switch_thread_rwlock_unlock(hdl->lock);
-    return JVXFS_STATUS_SUCCESS;
+    snapshot_t* next = NULL;
+    if (prev->used > 1) {
+        next = create_snapshot(hdl, prev->used - 1);
+        if (!next) {
+            switch_mutex_unlock(hdl->lock);
+            return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
+                "Could not remove observer.");
+        }
+        for (size_t i = 0, j = 0; i < prev->used; ++i) {
+            if (i != found) next->observer[j++] = prev->observer[i];
+        }
+    }
+    jvxfs_status_t res = publish(hdl, next);
+    switch_mutex_unlock(hdl->lock);
+    return res;
 }
 
 jvxfs_status_t jvxfs_observer_delete_all(jvxfs_observer_handle_t* obs)
 {
     obs_t* hdl = (obs_t*)obs;
-    switch_status_t res = switch_thread_rwlock_wrlock(hdl->lock);
-    if (res != SWITCH_STATUS_SUCCESS) {
-        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
-            "Could not activate rwlock.");
-    }
-    for (size_t i = 0; i < hdl->used; ++i) {
-        hdl->observer[i].func = NULL;
-        hdl->observer[i].data = NULL;
-    }
-    hdl->used = 0;
-    switch_thread_rwlock_unlock(hdl->lock);
-    return JVXFS_STATUS_SUCCESS;
+    switch_mutex_lock(hdl->lock);
+    jvxfs_status_t res = publish(hdl, NULL);
+    switch_mutex_unlock(hdl->lock);
+    return res;
 }
 
 size_t jvxfs_observer_count(jvxfs_observer_handle_t* obs)
 {
     obs_t* hdl = (obs_t*)obs;
-    switch_status_t res = switch_thread_rwlock_rdlock(hdl->lock);
-    if (res != SWITCH_STATUS_SUCCESS) {
-        jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
-            "Could not activate rwlock.");
-        return 0;
-    }
-    size_t tmp = hdl->used;
-    switch_thread_rwlock_unlock(hdl->lock);
+    snapshot_t* snap = acquire(hdl);
+    if (!snap) return 0;
+    size_t tmp = snap->used;
+    release(snap);
     return tmp;
 }
 
 jvxfs_status_t jvxfs_observer_notify(jvxfs_observer_handle_t* obs)
 {
     obs_t* hdl = (obs_t*)obs;
-    switch_status_t res = switch_thread_rwlock_rdlock(hdl->lock);
-    if (res != SWITCH_STATUS_SUCCESS) {
-        return jvxfs_error_set_error(hdl->err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_OBSERVER,
-            "Could not activate rwlock.");
+    call_observers(hdl);
+    return JVXFS_STATUS_SUCCESS;
+}
+
+jvxfs_status_t jvxfs_observer_notify_async(jvxfs_observer_handle_t* obs, jvxfs_worker_pool_t* worker)
+{
+    obs_t* hdl = (obs_t*)obs;
+    if (!worker) return jvxfs_observer_notify(obs);
+    /* Notifications requested while one is still queued are merged into it. */
+    if (jvxfs_atomic_exchange(&hdl->pending, 1) != 0) return JVXFS_STATUS_SUCCESS;
+    if (!jvxfs_worker_submit(worker, &hdl->task)) {
+        jvxfs_atomic_store(&hdl->pending, 0);
+        call_observers(hdl);
     }
-    for (size_t i = 0; i < hdl->used; ++i) {
-        hdl->observer[i].func(hdl->observerable, hdl->observer[i].data);
+    return JVXFS_STATUS_SUCCESS;
+}
+
+
+jvxfs_status_t publish(obs_t* hdl, snapshot_t* next)
+{
+    snapshot_t* prev = jvxfs_atomic_exchange(&hdl->current, next);
+    /* Pairs with the fence of the readers, so a reader either sees the replacement or is counted by reclaim(). */
+    jvxfs_atomic_fence();
+    if (prev) {
+        prev->next = hdl->retired;
+        hdl->retired = prev;
     }
-    switch_thread_rwlock_unlock(hdl->lock);
+    reclaim(hdl);
     return JVXFS_STATUS_SUCCESS;
-}
\ No newline at end of file
+}
+
+snapshot_t* create_snapshot(obs_t* hdl, size_t used)
+{
+    for (snapshot_t** link = &hdl->spare; *link; link = &(*link)->next) {
+        snapshot_t* snap = *link;
+        /* A reader counted in a spare snapshot backs off, as it is not current, and never reads it. */
+        if (snap->capacity >= used && jvxfs_atomic_load(&snap->readers) == 0) {
+            *link = snap->next;
+            snap->next = NULL;
+            snap->used = used;
+            return snap;
+        }
+    }
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < used) capacity <<= 1;
+    snapshot_t* snap = (snapshot_t*)malloc(sizeof(snapshot_t) + sizeof(callback_t) * capacity);
+    if (!snap) return NULL;
+    snap->next = NULL;
+    snap->readers = 0;
+    snap->capacity = capacity;
+    snap->used = used;
+    return snap;
+}
+
+void reclaim(obs_t* hdl)
+{
+    /* Each replaced snapshot becomes spare as soon as its own readers are gone. */
+    snapshot_t** link = &hdl->retired;
+    while (*link) {
+        snapshot_t* snap = *link;
+        if (jvxfs_atomic_load(&snap->readers) == 0) {
+            *link = snap->next;
+            snap->next = hdl->spare;
+            hdl->spare = snap;
+        } else {
+            link = &snap->next;
+        }
+    }
+}
+
+void free_list(snapshot_t* snap)
+{
+    while (snap) {
+        snapshot_t* next = snap->next;
+        free(snap);
+        snap = next;
+    }
+}
+
+snapshot_t* acquire(obs_t* hdl)
+{
+    for (;;) {
+        snapshot_t* snap = jvxfs_atomic_load(&hdl->current);
+        if (!snap) return NULL;
+        jvxfs_atomic_fetch_add(&snap->readers, 1);
+        jvxfs_atomic_fence();
+        /* Still current after being counted, so reclaim() sees the count before it may recycle it. */
+        if (jvxfs_atomic_load(&hdl->current) == snap) return snap;
+        jvxfs_atomic_fetch_sub(&snap->readers, 1);
+    }
+}
+
+void release(snapshot_t* snap)
+{
+    jvxfs_atomic_fetch_sub(&snap->readers, 1);
+}
+
+void notify_task(void* data)
+{
+    obs_t* hdl = (obs_t*)data;
+    /* Counted before the request is cleared, so destroying waits for this call. */
+    jvxfs_atomic_fetch_add(&hdl->tasks, 1);
+    jvxfs_atomic_store(&hdl->pending, 0);
+    call_observers(hdl);
+    jvxfs_atomic_fetch_sub(&hdl->tasks, 1);
+}
+
+void call_observers(obs_t* hdl)
+{
+    snapshot_t* snap = acquire(hdl);
+    if (!snap) return;
+    for (size_t i = 0; i < snap->used; ++i) {
+        snap->observer[i].func(hdl->observerable, snap->observer[i].data);
+    }
+    release(snap);
+}
@@ -17,6 +17,7 @@
 #include <stddef.h>
 #include <switch.h>
 #include "../system/defines.h"
+#include "worker.h"
 
 JVX_FS_LIB_BEGIN
 
@@ -24,7 +25,10 @@ JVX_FS_LIB_BEGIN
  * @addtogroup utils Utilities
  * @{
  * @defgroup observer Observer Module
- * @details Threadsafe implementation of observer pattern in C.
+ * @details Threadsafe implementation of observer pattern in C. The observing functions are kept in
+ * immutable snapshots published through an atomic pointer. Notifying only loads the current snapshot and
+ * iterates it without any lock, so it is safe on media threads. Adding and removing copy the snapshot,
+ * a replaced snapshot is reused as soon as the notifications reading it have finished.
  * @{
  */
 
@@ -81,6 +85,7 @@ jvxfs_status_t jvxfs_observer_add(jvxfs_observer_handle_t* obs, jvxfs_observer_t
  * @param[in] func  Observing function. 
  * @return Status code.
  * @details This function is threadsafe and can be called simultaneously to other functions of this module.
+ * A notification which started before may still call the removed function.
  */
 jvxfs_status_t jvxfs_observer_remove(jvxfs_observer_handle_t* obs, jvxfs_observer_t func);
 
@@ -108,6 +113,16 @@ size_t jvxfs_observer_count(jvxfs_observer_handle_t* obs);
  */
 jvxfs_status_t jvxfs_observer_notify(jvxfs_observer_handle_t* obs);
 
+/**
+ * @brief Notify observing functions on a worker thread.
+ * @param[in] obs     Handle of observer module.
+ * @param[in] worker  Worker pool running the observing functions, @em NULL notifies inline.
+ * @return Status code.
+ * @details Returns without waiting. Notifications requested while a previous one is still queued are merged
+ * into it. If the worker pool does not accept the notification, the functions are called inline.
+ */
+jvxfs_status_t jvxfs_observer_notify_async(jvxfs_observer_handle_t* obs, jvxfs_worker_pool_t* worker);
+
 /**
  * @}
  * @}
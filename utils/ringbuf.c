@@ -0,0 +1,76 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <string.h>
+#include "ringbuf.h"
+
+
+void jvxfs_ringbuf_init(jvxfs_ringbuf_t* buf, uint8_t* storage, size_t capacity)
+{
+    buf->data = storage;
+    buf->capacity = capacity;
+    buf->head = 0;
+    buf->used = 0;
+}
+
+void jvxfs_ringbuf_reset(jvxfs_ringbuf_t* buf)
+{
+    buf->head = 0;
+    buf->used = 0;
+}
+
+size_t jvxfs_ringbuf_available(const jvxfs_ringbuf_t* buf)
+{
+    return buf->used;
+}
+
+size_t jvxfs_ringbuf_space(const jvxfs_ringbuf_t* buf)
+{
+    return buf->capacity - buf->used;
+}
+
+bool jvxfs_ringbuf_write(jvxfs_ringbuf_t* buf, const void* src, size_t length)
+{
+    if (length > buf->capacity - buf->used) return false;
+    size_t tail = buf->head + buf->used;
+    if (tail >= buf->capacity) tail -= buf->capacity;
+    size_t first = buf->capacity - tail;
+    if (first >= length) {
+        memcpy(buf->data + tail, src, length);
+    } else {
+        memcpy(buf->data + tail, src, first);
+        memcpy(buf->data, (const uint8_t*)src + first, length - first);
+    }
+    buf->used += length;
+    return true;
+}
+
+bool jvxfs_ringbuf_fill(jvxfs_ringbuf_t* buf, const void* pattern, size_t size, size_t count)
+{
+    if (count * size > buf->capacity - buf->used) return false;
+    for (size_t i = 0; i < count; ++i) jvxfs_ringbuf_write(buf, pattern, size);
+    return true;
+}
+
+void jvxfs_ringbuf_consume(jvxfs_ringbuf_t* buf, size_t length)
+{
+    if (length > buf->used) length = buf->used;
+    buf->head += length;
+    if (buf->head >= buf->capacity) buf->head -= buf->capacity;
+    buf->used -= length;
+}
+
+bool jvxfs_ringbuf_read(jvxfs_ringbuf_t* buf, void* dst, size_t length)
+{
+    if (length > buf->used) return false;
+    size_t first = buf->capacity - buf->head;
+    if (first >= length) {
+        memcpy(dst, buf->data + buf->head, length);
+    } else {
+        memcpy(dst, buf->data + buf->head, first);
+        memcpy((uint8_t*)dst + first, buf->data, length - first);
+    }
+    jvxfs_ringbuf_consume(buf, length);
+    return true;
+}
@@ -0,0 +1,85 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file ringbuf.h
+ * @brief Byte ring buffer for reblocking streams.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-28
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_UTILS_RINGBUF_H
+#define LIB_JVX_FS_FRAMEWORK_UTILS_RINGBUF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../system/defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup utils Utilities
+ * @{
+ * @defgroup ringbuf Ring Buffer
+ * @details Writes and reads copy in at most two parts where the ring wraps, callers always work on their own
+ * contiguous buffers. The buffer is meant for a single thread, e.g. the media thread of a session, and never
+ * allocates.
+ * @{
+ */
+
+typedef struct
+{
+    uint8_t* data;
+    size_t capacity;
+    size_t head;
+    size_t used;
+} jvxfs_ringbuf_t;
+
+/**
+ * @brief Initialize an empty buffer.
+ * @param[out] buf      Buffer.
+ * @param[in] storage   Storage of @a capacity bytes.
+ * @param[in] capacity  Capacity in bytes.
+ */
+void jvxfs_ringbuf_init(jvxfs_ringbuf_t* buf, uint8_t* storage, size_t capacity);
+
+void jvxfs_ringbuf_reset(jvxfs_ringbuf_t* buf);
+
+size_t jvxfs_ringbuf_available(const jvxfs_ringbuf_t* buf);
+size_t jvxfs_ringbuf_space(const jvxfs_ringbuf_t* buf);
+
+/**
+ * @brief Append bytes.
+ * @return @em false without writing anything, if less than @a length bytes are free.
+ */
+bool jvxfs_ringbuf_write(jvxfs_ringbuf_t* buf, const void* src, size_t length);
+
+/**
+ * @brief Append @a count copies of a pattern of @a size bytes, e.g. a silent sample.
+ * @return @em false without writing anything, if less than @a count * @a size bytes are free.
+ */
+bool jvxfs_ringbuf_fill(jvxfs_ringbuf_t* buf, const void* pattern, size_t size, size_t count);
+
+/**
+ * @brief Drop bytes from the start of the content.
+ */
+void jvxfs_ringbuf_consume(jvxfs_ringbuf_t* buf, size_t length);
+
+/**
+ * @brief Copy bytes from the start of the content and drop them.
+ * @return @em false without reading anything, if less than @a length bytes are available.
+ */
+bool jvxfs_ringbuf_read(jvxfs_ringbuf_t* buf, void* dst, size_t length);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
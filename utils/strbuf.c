@@ -0,0 +1,131 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strbuf.h"
+
+static bool reserve(jvxfs_strbuf_t* buf, size_t length);
+
+
+void jvxfs_strbuf_init(jvxfs_strbuf_t* buf, char* storage, size_t size)
+{
+    buf->storage = storage;
+    buf->storageSize = size;
+    buf->data = storage;
+    buf->size = size;
+    buf->used = 0;
+    buf->failed = false;
+    buf->data[0] = '\0';
+}
+
+void jvxfs_strbuf_reset(jvxfs_strbuf_t* buf)
+{
+    if (buf->data != buf->storage) free(buf->data);
+    jvxfs_strbuf_init(buf, buf->storage, buf->storageSize);
+}
+
+bool jvxfs_strbuf_failed(const jvxfs_strbuf_t* buf)
+{
+    return buf->failed;
+}
+
+void jvxfs_strbuf_append(jvxfs_strbuf_t* buf, const char* str, size_t length)
+{
+    if (!reserve(buf, length)) return;
+    memcpy(buf->data + buf->used, str, length);
+    buf->used += length;
+    buf->data[buf->used] = '\0';
+}
+
+void jvxfs_strbuf_append_str(jvxfs_strbuf_t* buf, const char* str)
+{
+    jvxfs_strbuf_append(buf, str, strlen(str));
+}
+
+void jvxfs_strbuf_append_char(jvxfs_strbuf_t* buf, char c)
+{
+    if (!reserve(buf, 1)) return;
+    buf->data[buf->used++] = c;
+    buf->data[buf->used] = '\0';
+}
+
+void jvxfs_strbuf_printf(jvxfs_strbuf_t* buf, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    jvxfs_strbuf_vprintf(buf, fmt, args);
+    va_end(args);
+}
+
+void jvxfs_strbuf_vprintf(jvxfs_strbuf_t* buf, const char* fmt, va_list args)
+{
+    if (buf->failed) return;
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(buf->data + buf->used, buf->size - buf->used, fmt, copy);
+    va_end(copy);
+    if (length < 0) {
+        buf->data[buf->used] = '\0';
+        return;
+    }
+    /* Formatted once more only if the content did not fit. */
+    if (buf->used + (size_t)length >= buf->size) {
+        if (!reserve(buf, (size_t)length)) return;
+        vsnprintf(buf->data + buf->used, buf->size - buf->used, fmt, args);
+    }
+    buf->used += (size_t)length;
+}
+
+void jvxfs_strbuf_append_json(jvxfs_strbuf_t* buf, const char* str)
+{
+    static const char hex[] = "0123456789abcdef";
+    jvxfs_strbuf_append_char(buf, '"');
+    const char* run = str;
+    for (const char* c = str; *c; ++c) {
+        unsigned char u = (unsigned char)*c;
+        if (u >= 0x20 && u != '"' && u != '\\') continue;
+        jvxfs_strbuf_append(buf, run, c - run);
+        run = c + 1;
+        switch (u) {
+        case '"': jvxfs_strbuf_append(buf, "\\\"", 2); break;
+        case '\\': jvxfs_strbuf_append(buf, "\\\\", 2); break;
+        case '\n': jvxfs_strbuf_append(buf, "\\n", 2); break;
+        case '\r': jvxfs_strbuf_append(buf, "\\r", 2); break;
+        case '\t': jvxfs_strbuf_append(buf, "\\t", 2); break;
+        default:
+            {
+                char esc[6] = { '\\', 'u', '0', '0', hex[u >> 4], hex[u & 0xF] };
+                jvxfs_strbuf_append(buf, esc, sizeof(esc));
+            }
+            break;
+        }
+    }
+    jvxfs_strbuf_append_str(buf, run);
+    jvxfs_strbuf_append_char(buf, '"');
+}
+
+
+bool reserve(jvxfs_strbuf_t* buf, size_t length)
+{
+    if (buf->failed) return false;
+    if (buf->used + length < buf->size) return true;
+    size_t size = buf->size * 2;
+    while (size <= buf->used + length) size *= 2;
+    char* grown;
+    if (buf->data == buf->storage) {
+        grown = (char*)malloc(size);
+        if (grown) memcpy(grown, buf->data, buf->used + 1);
+    } else {
+        grown = (char*)realloc(buf->data, size);
+    }
+    if (!grown) {
+        buf->failed = true;
+        return false;
+    }
+    buf->data = grown;
+    buf->size = size;
+    return true;
+}
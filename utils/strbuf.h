@@ -0,0 +1,79 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file strbuf.h
+ * @brief Growable string buffer starting in storage of the caller.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-26
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_UTILS_STRBUF_H
+#define LIB_JVX_FS_FRAMEWORK_UTILS_STRBUF_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../system/defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup utils Utilities
+ * @{
+ * @defgroup strbuf String Buffer
+ * @details The buffer writes into the storage given to jvxfs_strbuf_init() and only allocates once
+ * the content outgrows it. jvxfs_strbuf_reset() frees the allocation again, so a buffer on the stack
+ * or in thread local storage costs no allocation as long as its content fits. The content is always
+ * null terminated. After an allocation failed, appending is a no-op and jvxfs_strbuf_failed() is true
+ * until the next reset.
+ * @{
+ */
+
+typedef struct
+{
+    char* data;
+    size_t used;
+    size_t size;
+    char* storage;
+    size_t storageSize;
+    bool failed;
+} jvxfs_strbuf_t;
+
+/**
+ * @brief Initialize a buffer.
+ * @param[out] buf      Buffer.
+ * @param[in] storage   Storage used as long as the content fits.
+ * @param[in] size      Size of @a storage in bytes, at least 1.
+ */
+void jvxfs_strbuf_init(jvxfs_strbuf_t* buf, char* storage, size_t size);
+
+/**
+ * @brief Empty a buffer and free memory allocated for it.
+ */
+void jvxfs_strbuf_reset(jvxfs_strbuf_t* buf);
+
+bool jvxfs_strbuf_failed(const jvxfs_strbuf_t* buf);
+
+void jvxfs_strbuf_append(jvxfs_strbuf_t* buf, const char* str, size_t length);
+void jvxfs_strbuf_append_str(jvxfs_strbuf_t* buf, const char* str);
+void jvxfs_strbuf_append_char(jvxfs_strbuf_t* buf, char c);
+void jvxfs_strbuf_printf(jvxfs_strbuf_t* buf, const char* fmt, ...);
+void jvxfs_strbuf_vprintf(jvxfs_strbuf_t* buf, const char* fmt, va_list args);
+
+/**
+ * @brief Append a string as JSON string literal, including the quotes.
+ */
+void jvxfs_strbuf_append_json(jvxfs_strbuf_t* buf, const char* str);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif
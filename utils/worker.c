@@ -0,0 +1,265 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <stdint.h>
+#include "../system/error.h"
+#include "atomic.h"
+#include "worker.h"
+
+#define SPIN_ROUNDS 64
+#define IDLE_TIMEOUT_US 10000
+#define MIN_DEPTH 2
+
+/* Every module of the process may have a pinned pool, the next one starts on the CPU after the last. */
+static uint32_t nextCpu = 0;
+
+typedef struct
+{
+    size_t seq;
+    jvxfs_worker_task_t* task;
+} cell_t;
+
+/* Bounded multi producer multi consumer queue after Dmitry Vyukov. */
+typedef struct
+{
+    cell_t* cells;
+    size_t mask;
+    size_t enqueuePos JVXFS_CACHE_ALIGNED;
+    size_t dequeuePos JVXFS_CACHE_ALIGNED;
+} queue_t;
+
+struct pool_s;
+
+typedef struct
+{
+    struct pool_s* pool;
+    queue_t queue;
+    uint32_t index;
+    switch_thread_t* thread;
+} worker_t;
+
+typedef struct pool_s
+{
+    worker_t* workers;
+    uint32_t count;
+    bool pinned;
+    uint32_t firstCpu;
+    uint32_t cpus;
+    bool running;
+    uint32_t submitting;
+    uint32_t next;
+    uint32_t sleeping;
+    switch_mutex_t* mutex;
+    switch_thread_cond_t* cond;
+} pool_t;
+
+static void* SWITCH_THREAD_FUNC worker_thread(switch_thread_t* thread, void* obj);
+static jvxfs_worker_task_t* find_task(pool_t* hdl, uint32_t self);
+static bool queue_init(queue_t* q, size_t depth, switch_memory_pool_t* pool);
+static bool queue_push(queue_t* q, jvxfs_worker_task_t* task);
+static jvxfs_worker_task_t* queue_pop(queue_t* q);
+
+
+jvxfs_status_t jvxfs_worker_create_pool(jvxfs_worker_pool_t** obj, uint32_t threads, uint32_t depth, bool pinned,
+    jvxfs_error_t* err, switch_memory_pool_t* pool)
+{
+    *obj = NULL;
+    const char* const error = "Could not create worker pool.";
+    int32_t cpus = switch_core_cpu_count();
+    if (threads == 0) threads = (cpus > 0) ? (uint32_t)cpus : 1;
+    size_t size = MIN_DEPTH;
+    while (size < depth) size <<= 1;
+    pool_t* hdl = (pool_t*)switch_core_alloc(pool, sizeof(pool_t));
+    if (!hdl) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_WORKER, error);
+    }
+    uint8_t* mem = (uint8_t*)switch_core_alloc(pool, sizeof(worker_t) * threads + JVXFS_CACHE_LINE_SIZE);
+    hdl->workers = mem ? (worker_t*)(((uintptr_t)mem + JVXFS_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(JVXFS_CACHE_LINE_SIZE - 1)) : NULL;
+    if (!hdl->workers || switch_mutex_init(&hdl->mutex, SWITCH_MUTEX_NESTED, pool) != SWITCH_STATUS_SUCCESS ||
+        switch_thread_cond_create(&hdl->cond, pool) != SWITCH_STATUS_SUCCESS) {
+        return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_WORKER, error);
+    }
+    hdl->count = 0;
+    hdl->pinned = pinned;
+    hdl->cpus = (cpus > 0) ? (uint32_t)cpus : 1;
+    hdl->firstCpu = pinned ? jvxfs_atomic_fetch_add_relaxed(&nextCpu, threads) % hdl->cpus : 0;
+    hdl->running = true;
+    hdl->submitting = 0;
+    hdl->next = 0;
+    hdl->sleeping = 0;
+    for (uint32_t i = 0; i < threads; ++i) {
+        worker_t* w = &hdl->workers[i];
+        w->pool = hdl;
+        w->index = i;
+        w->thread = NULL;
+        if (!queue_init(&w->queue, size, pool)) {
+            jvxfs_worker_destroy_pool((jvxfs_worker_pool_t**)&hdl);
+            return jvxfs_error_set_error(err, JVXFS_STATUS_ALLOCATION_FAILED, JVXFS_LOG_CRITICAL, JVXFS_COMP_WORKER, error);
+        }
+    }
+    for (uint32_t i = 0; i < threads; ++i) {
+        switch_threadattr_t* attr = NULL;
+        switch_threadattr_create(&attr, pool);
+        switch_threadattr_stacksize_set(attr, SWITCH_THREAD_STACKSIZE);
+        if (switch_thread_create(&hdl->workers[i].thread, attr, worker_thread, &hdl->workers[i], pool) != SWITCH_STATUS_SUCCESS) {
+            jvxfs_worker_destroy_pool((jvxfs_worker_pool_t**)&hdl);
+            return jvxfs_error_set_error(err, JVXFS_STATUS_RESOURCE_EXCEPTION, JVXFS_LOG_CRITICAL, JVXFS_COMP_WORKER,
+                "Could not start worker thread.");
+        }
+        hdl->count = i + 1;
+    }
+    *obj = hdl;
+    return JVXFS_STATUS_SUCCESS;
+}
+
+void jvxfs_worker_destroy_pool(jvxfs_worker_pool_t** obj)
+{
+    pool_t* hdl = (pool_t*)*obj;
+    if (!hdl) return;
+    jvxfs_atomic_store(&hdl->running, false);
+    jvxfs_atomic_fence();
+    switch_mutex_lock(hdl->mutex);
+    switch_thread_cond_broadcast(hdl->cond);
+    switch_mutex_unlock(hdl->mutex);
+    for (uint32_t i = 0; i < hdl->count; ++i) {
+        switch_status_t st;
+        if (hdl->workers[i].thread) switch_thread_join(&st, hdl->workers[i].thread);
+    }
+    /* A submit that passed the check of running before it was cleared may still be pushing its task. */
+    while (jvxfs_atomic_load(&hdl->submitting) > 0) jvxfs_cpu_relax();
+    jvxfs_worker_task_t* task;
+    while ((task = find_task(hdl, 0)) != NULL) task->func(task->data);
+    *obj = NULL;
+}
+
+bool jvxfs_worker_submit(jvxfs_worker_pool_t* obj, jvxfs_worker_task_t* task)
+{
+    pool_t* hdl = (pool_t*)obj;
+    /* Pairs with the fence after clearing running, so either the pool is seen stopping or it waits for us. */
+    jvxfs_atomic_fetch_add(&hdl->submitting, 1);
+    jvxfs_atomic_fence();
+    if (!jvxfs_atomic_load_relaxed(&hdl->running)) {
+        jvxfs_atomic_fetch_sub(&hdl->submitting, 1);
+        return false;
+    }
+    uint32_t start = jvxfs_atomic_fetch_add_relaxed(&hdl->next, 1);
+    bool queued = false;
+    for (uint32_t i = 0; i < hdl->count && !queued; ++i) {
+        queued = queue_push(&hdl->workers[(start + i) % hdl->count].queue, task);
+    }
+    if (!queued) {
+        jvxfs_atomic_fetch_sub(&hdl->submitting, 1);
+        return false;
+    }
+    /* Pairs with the fence of a worker going to sleep, so either the worker sees the task or we see the sleeper. */
+    jvxfs_atomic_fence();
+    if (jvxfs_atomic_load_relaxed(&hdl->sleeping) > 0) {
+        switch_mutex_lock(hdl->mutex);
+        switch_thread_cond_signal(hdl->cond);
+        switch_mutex_unlock(hdl->mutex);
+    }
+    jvxfs_atomic_fetch_sub(&hdl->submitting, 1);
+    return true;
+}
+
+uint32_t jvxfs_worker_count_threads(jvxfs_worker_pool_t* obj)
+{
+    pool_t* hdl = (pool_t*)obj;
+    return hdl->count;
+}
+
+
+void* SWITCH_THREAD_FUNC worker_thread(switch_thread_t* thread, void* obj)
+{
+    worker_t* self = (worker_t*)obj;
+    pool_t* hdl = self->pool;
+    if (hdl->pinned) switch_core_thread_set_cpu_affinity((int)((hdl->firstCpu + self->index) % hdl->cpus));
+    while (jvxfs_atomic_load(&hdl->running)) {
+        jvxfs_worker_task_t* task = NULL;
+        for (int spin = 0; spin < SPIN_ROUNDS && !task; ++spin) {
+            task = find_task(hdl, self->index);
+            if (!task) jvxfs_cpu_relax();
+        }
+        if (task) {
+            task->func(task->data);
+            continue;
+        }
+        switch_mutex_lock(hdl->mutex);
+        jvxfs_atomic_fetch_add(&hdl->sleeping, 1);
+        jvxfs_atomic_fence();
+        task = find_task(hdl, self->index);
+        if (!task && jvxfs_atomic_load(&hdl->running)) {
+            switch_thread_cond_timedwait(hdl->cond, hdl->mutex, IDLE_TIMEOUT_US);
+        }
+        jvxfs_atomic_fetch_sub(&hdl->sleeping, 1);
+        switch_mutex_unlock(hdl->mutex);
+        if (task) task->func(task->data);
+    }
+    return NULL;
+}
+
+jvxfs_worker_task_t* find_task(pool_t* hdl, uint32_t self)
+{
+    for (uint32_t i = 0; i < hdl->count; ++i) {
+        jvxfs_worker_task_t* task = queue_pop(&hdl->workers[(self + i) % hdl->count].queue);
+        if (task) return task;
+    }
+    return NULL;
+}
+
+bool queue_init(queue_t* q, size_t depth, switch_memory_pool_t* pool)
+{
+    q->cells = (cell_t*)switch_core_alloc(pool, sizeof(cell_t) * depth);
+    if (!q->cells) return false;
+    for (size_t i = 0; i < depth; ++i) {
+        q->cells[i].seq = i;
+        q->cells[i].task = NULL;
+    }
+    q->mask = depth - 1;
+    q->enqueuePos = 0;
+    q->dequeuePos = 0;
+    return true;
+}
+
+bool queue_push(queue_t* q, jvxfs_worker_task_t* task)
+{
+    size_t pos = jvxfs_atomic_load_relaxed(&q->enqueuePos);
+    cell_t* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = jvxfs_atomic_load(&cell->seq);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (jvxfs_atomic_cas_weak_relaxed(&q->enqueuePos, &pos, pos + 1)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = jvxfs_atomic_load_relaxed(&q->enqueuePos);
+        }
+    }
+    cell->task = task;
+    jvxfs_atomic_store(&cell->seq, pos + 1);
+    return true;
+}
+
+jvxfs_worker_task_t* queue_pop(queue_t* q)
+{
+    size_t pos = jvxfs_atomic_load_relaxed(&q->dequeuePos);
+    cell_t* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = jvxfs_atomic_load(&cell->seq);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (jvxfs_atomic_cas_weak_relaxed(&q->dequeuePos, &pos, pos + 1)) break;
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = jvxfs_atomic_load_relaxed(&q->dequeuePos);
+        }
+    }
+    jvxfs_worker_task_t* task = cell->task;
+    jvxfs_atomic_store(&cell->seq, pos + q->mask + 1);
+    return task;
+}
@@ -0,0 +1,98 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+/**
+ * @file worker.h
+ * @brief Work stealing pool of worker threads.
+ * @author Christian Thierfeld
+ * @version 1.0
+ * @date 2019-12-17
+ * @copyright Copyright (c) 2019
+ */
+
+#ifndef LIB_JVX_FS_FRAMEWORK_UTILS_WORKER_H
+#define LIB_JVX_FS_FRAMEWORK_UTILS_WORKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <switch.h>
+#include "../system/defines.h"
+
+JVX_FS_LIB_BEGIN
+
+/**
+ * @addtogroup utils Utilities
+ * @{
+ * @defgroup worker Worker Pool
+ * @details Every worker thread owns a bounded lock-free queue. Tasks are spread over the queues
+ * round robin, idle workers steal from the queues of the others. Submitting never blocks,
+ * so it can be called from media threads.
+ * @{
+ */
+
+/**
+ * @brief Handle type of a worker pool.
+ */
+typedef void jvxfs_worker_pool_t;
+
+/**
+ * @brief Function executed by a worker.
+ * @param[in] data  User data of the task.
+ */
+typedef void(*jvxfs_worker_func_t)(void* data);
+
+/**
+ * @brief Task to be executed by a worker.
+ * @details The pool does not copy tasks. The memory of a task has to stay valid until
+ * its function has been called, it may be submitted again from within the function.
+ */
+typedef struct
+{
+    jvxfs_worker_func_t func;
+    void* data;
+} jvxfs_worker_task_t;
+
+/**
+ * @brief Create a worker pool and start its threads.
+ * @param[out] obj      Handle of worker pool.
+ * @param[in] threads   Number of threads, 0 for one per CPU.
+ * @param[in] depth     Capacity of the queue of every thread, rounded up to a power of two.
+ * @param[in] pinned    Pin each thread to a CPU. Pinned pools of the process continue on the CPU after the
+ *                      last one pinned, so the pools of several modules do not share the first CPUs.
+ * @param[in] err       Error handler.
+ * @param[in] pool      Memory pool.
+ * @return Status code.
+ */
+jvxfs_status_t jvxfs_worker_create_pool(jvxfs_worker_pool_t** obj, uint32_t threads, uint32_t depth, bool pinned,
+    jvxfs_error_t* err, switch_memory_pool_t* pool);
+
+/**
+ * @brief Stop all threads of a worker pool.
+ * @param[in,out] obj   Handle of worker pool. Will be set to @em NULL.
+ * @details Tasks still queued, also those of submits racing with the stop, are executed after the threads are joined.
+ */
+void jvxfs_worker_destroy_pool(jvxfs_worker_pool_t** obj);
+
+/**
+ * @brief Queue a task.
+ * @param[in] obj   Handle of worker pool.
+ * @param[in] task  Task to execute.
+ * @return @em false, if all queues are full or the pool is stopping. The task is not executed then.
+ * @details This function is lock-free and can be called from any thread.
+ */
+bool jvxfs_worker_submit(jvxfs_worker_pool_t* obj, jvxfs_worker_task_t* task);
+
+/**
+ * @brief Number of threads of a worker pool.
+ */
+uint32_t jvxfs_worker_count_threads(jvxfs_worker_pool_t* obj);
+
+/**
+ * @}
+ * @}
+ */
+
+JVX_FS_LIB_END
+
+#endif